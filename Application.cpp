@@ -2,8 +2,12 @@
 #include "imgui/imgui.h"
 #include "classes/TicTacToe.h"
 #include "classes/Checkers.h"
+#include "classes/Chess.h"
 #include "classes/Othello.h"
 #include "classes/ConnectFour.h"
+#include "classes/JobSystem.h"
+#include "classes/ProofPanel.h"
+#include "classes/Simul.h"
 
 namespace ClassGame {
         //
@@ -13,6 +17,22 @@ namespace ClassGame {
         Game *game = nullptr;
         bool gameOver = false;
         int gameWinner = -1;
+        Simul *simul = nullptr;
+        ProofPanel proofPanel;
+
+        struct SimulGame
+        {
+            const char *name;
+            Game *(*create)();
+        };
+        const SimulGame SIMUL_GAMES[] = {
+            { "Tic-Tac-Toe", [] () -> Game* { return new TicTacToe(); } },
+            { "Connect Four", [] () -> Game* { return new ConnectFour(); } },
+            { "Othello", [] () -> Game* { return new Othello(); } },
+            { "Checkers", [] () -> Game* { return new Checkers(); } },
+            { "International Draughts", [] () -> Game* { return new InternationalDraughts(); } },
+        };
+        const int SIMUL_GAME_COUNT = sizeof(SIMUL_GAMES) / sizeof(SIMUL_GAMES[0]);
 
         //
         // game starting point
@@ -21,6 +41,21 @@ namespace ClassGame {
         void GameStartUp() 
         {
             game = nullptr;
+            JobSystem::instance(); // the workers are up before anything wants them
+        }
+
+        //
+        // called once the main loop has ended, before the window goes
+        // stops the analysis, lets the queued jobs (cache and log writes) finish and joins the workers
+        //
+        void GameShutDown()
+        {
+            proofPanel.cancel();
+            if (simul) {
+                delete simul;
+                simul = nullptr;
+            }
+            JobSystem::instance().shutdown();
         }
 
         //
@@ -53,7 +88,13 @@ namespace ClassGame {
                         gameWinner = -1;
                     }
                 }
-                if (!game) {
+                if (simul) {
+                    simul->drawSettings();
+                    if (ImGui::Button("End Simul")) {
+                        delete simul;
+                        simul = nullptr;
+                    }
+                } else if (!game) {
                     if (ImGui::Button("Start Tic-Tac-Toe")) {
                         game = new TicTacToe();
                         game->setUpBoard();
@@ -62,22 +103,59 @@ namespace ClassGame {
                         game = new Checkers();
                         game->setUpBoard();
                     }
+                    if (ImGui::Button("Start International Draughts 10x10")) {
+                        game = new InternationalDraughts();
+                        game->setUpBoard();
+                    }
+                    if (ImGui::Button("Start Chess")) {
+                        game = new Chess();
+                        game->setUpBoard();
+                    }
                     if (ImGui::Button("Start Othello")) {
                         game = new Othello();
                         game->setUpBoard();
                     }
+                    if (ImGui::Button("Start Othello 6x6")) {
+                        game = new Othello6x6();
+                        game->setUpBoard();
+                    }
+                    if (ImGui::Button("Start Grand Othello 10x10")) {
+                        game = new GrandOthello();
+                        game->setUpBoard();
+                    }
                     if (ImGui::Button("Start Connect Four")) {
                         game = new ConnectFour();
                         game->setUpBoard();
                     }
+
+                    // one AI against you on many boards at once
+                    static int simulGame = 1;
+                    static int simulBoards = 8;
+                    static int simulMoveTime = 500;
+                    ImGui::Separator();
+                    ImGui::Combo("Simul Game", &simulGame, [](void *, int index) {
+                        return SIMUL_GAMES[index].name;
+                    }, nullptr, SIMUL_GAME_COUNT);
+                    ImGui::SliderInt("Boards", &simulBoards, 2, 32);
+                    ImGui::SliderInt("AI ms per move", &simulMoveTime, 50, 5000);
+                    if (ImGui::Button("Start Simul")) {
+                        simul = new Simul(SIMUL_GAMES[simulGame].name, SIMUL_GAMES[simulGame].create, simulBoards, simulMoveTime);
+                    }
                 } else {
                     ImGui::Text("Current Player Number: %d", game->getCurrentPlayer()->playerNumber());
                     ImGui::Text("Current Board State: %s", game->stateString().c_str());
+                    if (game->gameHasMCTS()) ImGui::Checkbox("AI uses MCTS", &game->_gameOptions.AIUseMCTS);
+                    if (game->gameHasNNUE()) ImGui::Checkbox("AI uses NNUE evaluation", &game->_gameOptions.AIUseNNUE);
+                    if (game->gameHasPersistentCache()) ImGui::Checkbox("AI keeps its table between sessions", &game->_gameOptions.AIPersistentCache);
+                    if (game->gameHasSlicedSearch()) ImGui::SliderInt("AI us per frame", &game->_gameOptions.AIFrameBudgetUs, 1000, 16000);
                 }
                 ImGui::End();
 
                 ImGui::Begin("GameWindow");
-                if (game) {
+                if (simul) {
+                    simul->update();
+                    simul->drawFocusedBoard();
+                } else if (game) {
                     if (game->gameHasAI() && (game->getCurrentPlayer()->isAIPlayer() || game->_gameOptions.AIvsAI))
                     {
                         game->updateAI();
@@ -85,14 +163,24 @@ namespace ClassGame {
                     game->drawFrame();
                 }
                 ImGui::End();
+
+                proofPanel.draw(simul ? nullptr : game);
+
+                if (simul) {
+                    ImGui::Begin("Simul Boards");
+                    simul->drawThumbnails();
+                    ImGui::End();
+                }
         }
 
         //
         // end turn is called by the game code at the end of each turn
         // this is where we check for a winner
         //
-        void EndOfTurn() 
+        void EndOfTurn(Game *ended) 
         {
+            // the simul boards keep their own results
+            if (ended != game) return;
             Player *winner = game->checkForWinner();
             if (winner)
             {
@@ -1,7 +1,10 @@
 #pragma once
 
+class Game;
+
 namespace ClassGame {
     void GameStartUp();
     void RenderGame();
-    void EndOfTurn();
+    void GameShutDown();
+    void EndOfTurn(Game *game);
 }
@@ -76,6 +76,27 @@ Player *Bit::getOwner()
 	return _owner;
 }
 
+//
+// a piece that changes in place, a crowned man say, rehashes itself in its holder's position key
+//
+void Bit::setOwner(Player *player)
+{
+	_owner = player;
+	if (BitHolder *holder = getHolder())
+	{
+		holder->updatePositionKey();
+	}
+}
+
+void Bit::setGameTag(int tag)
+{
+	_gameTag = tag;
+	if (BitHolder *holder = getHolder())
+	{
+		holder->updatePositionKey();
+	}
+}
+
 void Bit::moveTo(const ImVec2 &point)
 {
 	_destinationPosition = point;
@@ -41,13 +41,13 @@ public:
 	BitHolder *getHolder();
 	// which player owns me
 	Player *getOwner();
-	void setOwner(Player *player) { _owner = player; };
+	void setOwner(Player *player);
 	// helper functions
 	bool friendly();
 	bool unfriendly();
 	// game defined game tags
 	const int gameTag() const { return _gameTag; };
-	void setGameTag(int tag) { _gameTag = tag; };
+	void setGameTag(int tag);
 	// move to a position
 	void moveTo(const ImVec2 &point);
 	void update();
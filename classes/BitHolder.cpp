@@ -1,5 +1,7 @@
 #include "BitHolder.h"
 #include "Bit.h"
+#include "Grid.h"
+#include "Player.h"
 
 BitHolder::~BitHolder()
 {
@@ -18,6 +20,7 @@ Bit *BitHolder::bit()
 	if (_bit && _bit->getParent() != this && !_bit->getPickedUp())
 	{
 		_bit = nullptr;
+		updatePositionKey();
 	}
 	return _bit;
 }
@@ -36,6 +39,7 @@ void BitHolder::setBit(Bit *abit)
 		{
 			_bit->setParent(this);
 		}
+		updatePositionKey();
 	}
 }
 
@@ -45,9 +49,26 @@ void BitHolder::destroyBit()
 	{
 		delete _bit;
 		_bit = nullptr;
+		updatePositionKey();
 	}
 }
 
+void BitHolder::updatePositionKey()
+{
+	if (!_positionKey)
+	{
+		return;
+	}
+	*_positionKey ^= _bitKey;
+	_bitKey = 0;
+	if (_bit)
+	{
+		Player *owner = _bit->getOwner();
+		_bitKey = Grid::pieceKey(_keyIndex, _bit->gameTag(), owner ? owner->playerNumber() : -1);
+	}
+	*_positionKey ^= _bitKey;
+}
+
 Bit *BitHolder::canDragBit(Bit *bit)
 {
 	if (bit->getParent() == this && bit->friendly())
@@ -1,6 +1,7 @@
 #pragma once
 #include "Sprite.h"
 #include "Bit.h"
+#include <cstdint>
 
 class BitHolder : public Sprite
 {
@@ -10,6 +11,9 @@ public:
 		_bit = nullptr;
 		_gameTag = 0;
 		_entityType = EntityBitHolder;
+		_positionKey = nullptr;
+		_keyIndex = 0;
+		_bitKey = 0;
 	};
 	~BitHolder();
 
@@ -26,6 +30,10 @@ public:
 	void setGameTag(int tag) { _gameTag = tag; };
 	// convenience function to see if the holder is empty
 	virtual bool empty() { return _bit == nullptr; };
+	// the Grid key this holder's piece is hashed into, as square index
+	void setPositionKey(uint64_t *key, int index) { _positionKey = key; _keyIndex = index; };
+	// rehash the current piece, called when its tag or owner changes in place
+	void updatePositionKey();
 
 	// can you drag this bit from this holder? if not, return a different bit to drag instead, or nullptr if not allowed
 	// cancelDragBit or draggedBitTo must be called next
@@ -61,4 +69,7 @@ public:
 protected:
 	Bit *_bit;
 	int _gameTag;
+	uint64_t *_positionKey;
+	int _keyIndex;
+	uint64_t _bitKey; // what the current piece put into the key
 };
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstdint>
+#include <bit>
+#include <concepts>
+
+//
+// small helpers shared by the bitboard based game cores
+// everything here is constexpr so masks can be built at compile time
+//
+
+//
+// a 128-bit mask made of two 64-bit lanes, used for boards with more than 64 squares
+// (10x10 Grand Othello, padded draughts boards, ...)
+//
+struct Bits128
+{
+    uint64_t lo;
+    uint64_t hi;
+
+    constexpr Bits128() : lo(0), hi(0) {}
+    constexpr Bits128(uint64_t low) : lo(low), hi(0) {}
+    constexpr Bits128(uint64_t low, uint64_t high) : lo(low), hi(high) {}
+
+    constexpr Bits128 operator&(const Bits128 &o) const { return Bits128(lo & o.lo, hi & o.hi); }
+    constexpr Bits128 operator|(const Bits128 &o) const { return Bits128(lo | o.lo, hi | o.hi); }
+    constexpr Bits128 operator^(const Bits128 &o) const { return Bits128(lo ^ o.lo, hi ^ o.hi); }
+    constexpr Bits128 operator~() const { return Bits128(~lo, ~hi); }
+
+    constexpr Bits128 operator<<(int n) const
+    {
+        if (n == 0) return *this;
+        if (n >= 64) return Bits128(0, lo << (n - 64));
+        return Bits128(lo << n, (hi << n) | (lo >> (64 - n)));
+    }
+    constexpr Bits128 operator>>(int n) const
+    {
+        if (n == 0) return *this;
+        if (n >= 64) return Bits128(hi >> (n - 64), 0);
+        return Bits128((lo >> n) | (hi << (64 - n)), hi >> n);
+    }
+
+    constexpr Bits128 &operator&=(const Bits128 &o) { lo &= o.lo; hi &= o.hi; return *this; }
+    constexpr Bits128 &operator|=(const Bits128 &o) { lo |= o.lo; hi |= o.hi; return *this; }
+    constexpr Bits128 &operator^=(const Bits128 &o) { lo ^= o.lo; hi ^= o.hi; return *this; }
+
+    constexpr bool operator==(const Bits128 &o) const { return lo == o.lo && hi == o.hi; }
+    constexpr bool operator!=(const Bits128 &o) const { return !(*this == o); }
+    constexpr explicit operator bool() const { return (lo | hi) != 0; }
+};
+
+namespace Bitboard
+{
+    // single bit helpers
+    template <typename Mask>
+    constexpr Mask bit(int index) { return Mask(1) << index; }
+
+    template <std::unsigned_integral T>
+    constexpr int popCount(T m) { return std::popcount(m); }
+    constexpr int popCount(const Bits128 &m) { return std::popcount(m.lo) + std::popcount(m.hi); }
+
+    // index of the lowest set bit, mask must not be empty
+    template <std::unsigned_integral T>
+    constexpr int lowestBit(T m) { return std::countr_zero(m); }
+    constexpr int lowestBit(const Bits128 &m) { return m.lo ? std::countr_zero(m.lo) : 64 + std::countr_zero(m.hi); }
+
+    // clear and return the lowest set bit
+    template <std::unsigned_integral T>
+    constexpr int popLowestBit(T &m)
+    {
+        int index = std::countr_zero(m);
+        m &= m - 1;
+        return index;
+    }
+    constexpr int popLowestBit(Bits128 &m)
+    {
+        if (m.lo) {
+            int index = std::countr_zero(m.lo);
+            m.lo &= m.lo - 1;
+            return index;
+        }
+        int index = 64 + std::countr_zero(m.hi);
+        m.hi &= m.hi - 1;
+        return index;
+    }
+
+    // mirror the bit order of a 32-bit mask, bit 0 swaps with bit 31
+    constexpr uint32_t reverseBits(uint32_t m)
+    {
+        m = ((m >> 1) & 0x55555555u) | ((m & 0x55555555u) << 1);
+        m = ((m >> 2) & 0x33333333u) | ((m & 0x33333333u) << 2);
+        m = ((m >> 4) & 0x0F0F0F0Fu) | ((m & 0x0F0F0F0Fu) << 4);
+        m = ((m >> 8) & 0x00FF00FFu) | ((m & 0x00FF00FFu) << 8);
+        return (m >> 16) | (m << 16);
+    }
+
+    //
+    // the 8x8 board symmetries on a mask with square = y * 8 + x, all delta swaps
+    //
+    // y -> 7 - y, a byte swap
+    constexpr uint64_t flipVertical(uint64_t m)
+    {
+        m = ((m >> 8) & 0x00FF00FF00FF00FFull) | ((m & 0x00FF00FF00FF00FFull) << 8);
+        m = ((m >> 16) & 0x0000FFFF0000FFFFull) | ((m & 0x0000FFFF0000FFFFull) << 16);
+        return (m >> 32) | (m << 32);
+    }
+
+    // x -> 7 - x, the bits of every byte reversed
+    constexpr uint64_t mirrorHorizontal(uint64_t m)
+    {
+        m = ((m >> 1) & 0x5555555555555555ull) | ((m & 0x5555555555555555ull) << 1);
+        m = ((m >> 2) & 0x3333333333333333ull) | ((m & 0x3333333333333333ull) << 2);
+        return ((m >> 4) & 0x0F0F0F0F0F0F0F0Full) | ((m & 0x0F0F0F0F0F0F0F0Full) << 4);
+    }
+
+    // x <-> y, a transpose about the a1-h8 diagonal
+    constexpr uint64_t transpose(uint64_t m)
+    {
+        uint64_t t = 0x0F0F0F0F00000000ull & (m ^ (m << 28));
+        m ^= t ^ (t >> 28);
+        t = 0x3333000033330000ull & (m ^ (m << 14));
+        m ^= t ^ (t >> 14);
+        t = 0x5500550055005500ull & (m ^ (m << 7));
+        return m ^ t ^ (t >> 7);
+    }
+
+    // deterministic 64-bit generator, used to build zobrist tables at compile time
+    constexpr uint64_t splitMix64(uint64_t &state)
+    {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    template <std::unsigned_integral T>
+    constexpr bool test(T m, int index) { return (m >> index) & 1; }
+    constexpr bool test(const Bits128 &m, int index) { return index < 64 ? ((m.lo >> index) & 1) : ((m.hi >> (index - 64)) & 1); }
+}
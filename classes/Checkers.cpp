@@ -1,47 +1,63 @@
 #include "Checkers.h"
-
-Checkers::Checkers() : Game() {
-    _grid = new Grid(8, 8);
-    _mustContinueJumping = false;
-    _jumpingPiece = nullptr;
-    _redPieces = 12;
-    _yellowPieces = 12;
+#include "JobSystem.h"
+#include <algorithm>
+#include <type_traits>
+
+template <class Board>
+DraughtsGame<Board>::DraughtsGame() : Game() {
+    _grid = new Grid(Board::WIDTH, Board::WIDTH);
+    _board = Board::initial();
+    resetTurn();
+
+    if constexpr (std::is_same_v<Board, CheckersBoard>) {
+        if (_database.open(DATABASE_DIRECTORY) > 0) {
+            _engine.setDatabase(&_database);
+        }
+    }
 }
 
-Checkers::~Checkers() {
+template <class Board>
+DraughtsGame<Board>::~DraughtsGame() {
+    cancelAISearch();
     delete _grid;
 }
 
-void Checkers::setUpBoard() {
+template <class Board>
+void DraughtsGame<Board>::setUpBoard() {
     setNumberOfPlayers(2);
-    _gameOptions.rowX = 8;
-    _gameOptions.rowY = 8;
+    _gameOptions.rowX = Board::WIDTH;
+    _gameOptions.rowY = Board::WIDTH;
 
     // Initialize all squares
     _grid->initializeSquares(80, "boardsquare.png");
 
     // Enable only dark squares and place pieces
+    _board = Board::initial();
     _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
         bool isDark = (x + y) % 2 == 1;
         _grid->setEnabled(x, y, isDark);
 
         if (isDark) {
-            if (y < 3) {
-                Bit* piece = createPiece(RED_PIECE);
-                piece->setPosition(square->getPosition());
-                square->setBit(piece);
-            } else if (y > 4) {
-                Bit* piece = createPiece(YELLOW_PIECE);
+            int pieceType = _board.pieceAt(Board::squareAt(x, y));
+            if (pieceType != EMPTY) {
+                Bit* piece = createPiece(pieceType);
                 piece->setPosition(square->getPosition());
                 square->setBit(piece);
             }
         }
     });
+    resetTurn();
+
+    if (gameHasAI()) {
+        setAIPlayer(AI_PLAYER);
+    }
 
     startGame();
+    resetRepetitions();
 }
 
-Bit* Checkers::createPiece(int pieceType) {
+template <class Board>
+Bit* DraughtsGame<Board>::createPiece(int pieceType) {
     Bit* bit = new Bit();
     bool isRed = (pieceType == RED_PIECE || pieceType == RED_KING);
     bit->LoadTextureFromFile(isRed ? "red.png" : "yellow.png");
@@ -52,243 +68,337 @@ Bit* Checkers::createPiece(int pieceType) {
     return bit;
 }
 
-bool Checkers::actionForEmptyHolder(BitHolder &holder) {
-    return false; // Checkers doesn't place new pieces
+//
+// conversions between grid squares and the dark squares of the bitboard
+//
+template <class Board>
+int DraughtsGame<Board>::boardSquare(BitHolder &holder) const {
+    ChessSquare* square = static_cast<ChessSquare*>(&holder);
+    return Board::squareAt(square->getColumn(), square->getRow());
 }
 
-bool Checkers::canBitMoveFrom(Bit &bit, BitHolder &src) {
-    if (!src.bit() || bit.getOwner() != getCurrentPlayer()) return false;
-    if (_mustContinueJumping && &src != _jumpingPiece) return false;
+template <class Board>
+ChessSquare* DraughtsGame<Board>::gridSquare(int square) const {
+    return _grid->getSquare(Board::squareX(square), Board::squareY(square));
+}
 
-    ChessSquare* square = static_cast<ChessSquare*>(&src);
-    int x = square->getColumn();
-    int y = square->getRow();
+template <class Board>
+void DraughtsGame<Board>::resetTurn() {
+    _mustContinueJumping = false;
+    _jumpingPiece = nullptr;
+    _turnFrom = -1;
+    _turnSteps = 0;
+}
 
-    // Must jump if available
-    if (hasJumpAvailable(bit.getOwner())) {
-        return canJumpFrom(*square);
+//
+// find a legal move from the turn's starting square that follows the hops made so far and then lands on nextStep
+// a move that ends on nextStep is preferred, jump sequences have to be completed
+//
+template <class Board>
+bool DraughtsGame<Board>::findTurnMove(int from, int nextStep, Move &found) const {
+    Move moves[Board::MAX_MOVES];
+    int count = _board.generateMoves(moves);
+    bool matched = false;
+
+    for (int i = 0; i < count; i++) {
+        const Move &move = moves[i];
+        if (move.from != from || move.steps <= _turnSteps) continue;
+
+        bool samePath = true;
+        for (int step = 0; step < _turnSteps && samePath; step++) {
+            samePath = move.path[step] == _turnPath[step];
+        }
+        if (!samePath || move.path[_turnSteps] != nextStep) continue;
+
+        found = move;
+        matched = true;
+        if (move.steps == _turnSteps + 1) break;
     }
-    return true;
+    return matched;
 }
 
-bool Checkers::canBitMoveFromTo(Bit& bit, BitHolder& src, BitHolder& dst) {
-    if (!src.bit() || dst.bit()) return false;
+template <class Board>
+bool DraughtsGame<Board>::actionForEmptyHolder(BitHolder &holder) {
+    return false; // Draughts doesn't place new pieces
+}
 
-    ChessSquare* srcSquare = static_cast<ChessSquare*>(&src);
-    ChessSquare* dstSquare = static_cast<ChessSquare*>(&dst);
+template <class Board>
+bool DraughtsGame<Board>::canBitMoveFrom(Bit &bit, BitHolder &src) {
+    if (!src.bit() || bit.getOwner() != getCurrentPlayer()) return false;
+    if (_mustContinueJumping) return &src == _jumpingPiece;
+
+    // Must jump if available, the board only generates captures then
+    int square = boardSquare(src);
+    Move moves[Board::MAX_MOVES];
+    int count = _board.generateMoves(moves);
+    for (int i = 0; i < count; i++) {
+        if (moves[i].from == square) return true;
+    }
+    return false;
+}
 
-    int srcX = srcSquare->getColumn();
-    int srcY = srcSquare->getRow();
+template <class Board>
+bool DraughtsGame<Board>::canBitMoveFromTo(Bit& bit, BitHolder& src, BitHolder& dst) {
+    if (!src.bit() || dst.bit()) return false;
+    if (_mustContinueJumping && &src != _jumpingPiece) return false;
 
+    ChessSquare* dstSquare = static_cast<ChessSquare*>(&dst);
     if (!_grid->isEnabled(dstSquare->getColumn(), dstSquare->getRow())) return false;
 
-    bool isKing = (bit.gameTag() == RED_KING || bit.gameTag() == YELLOW_KING);
-    bool isRed = (bit.getOwner() == getPlayerAt(RED_PLAYER));
+    int from = _mustContinueJumping ? _turnFrom : boardSquare(src);
+    Move move;
+    return findTurnMove(from, boardSquare(dst), move);
+}
 
-    // Simple moves (if no jumps required)
-    if (!_mustContinueJumping && !hasJumpAvailable(bit.getOwner())) {
-        if (isKing) {
-            return dstSquare == _grid->getFL(srcX, srcY) || dstSquare == _grid->getFR(srcX, srcY) ||
-                   dstSquare == _grid->getBL(srcX, srcY) || dstSquare == _grid->getBR(srcX, srcY);
-        }
-        return isRed ? (dstSquare == _grid->getBL(srcX, srcY) || dstSquare == _grid->getBR(srcX, srcY)) :
-                       (dstSquare == _grid->getFL(srcX, srcY) || dstSquare == _grid->getFR(srcX, srcY));
-    }
+template <class Board>
+void DraughtsGame<Board>::bitMovedFromTo(Bit &bit, BitHolder &src, BitHolder &dst) {
+    ChessSquare* srcSquare = static_cast<ChessSquare*>(&src);
+    ChessSquare* dstSquare = static_cast<ChessSquare*>(&dst);
 
-    // Jump moves
-    if (_mustContinueJumping && &src != _jumpingPiece) return false;
+    if (!_mustContinueJumping) {
+        _turnFrom = boardSquare(src);
+        _turnSteps = 0;
+    }
 
-    // Check all jump directions
-    auto checkJump = [&](ChessSquare* middle, ChessSquare* target) -> bool {
-        if (!middle || !target || !middle->bit()) return false;
-        if (middle->bit()->getOwner() == bit.getOwner()) return false;
-        return dstSquare == target;
-    };
+    Move move;
+    if (!findTurnMove(_turnFrom, boardSquare(dst), move)) return;
 
-    if (isKing || !isRed) {
-        if (checkJump(_grid->getFL(srcX, srcY), _grid->getFLFL(srcX, srcY))) return true;
-        if (checkJump(_grid->getFR(srcX, srcY), _grid->getFRFR(srcX, srcY))) return true;
+    // Capture the piece jumped over on this hop
+    if (move.isCapture()) {
+        removeJumpedPiece(*srcSquare, *dstSquare, move.captured);
     }
-    if (isKing || isRed) {
-        if (checkJump(_grid->getBL(srcX, srcY), _grid->getBLBL(srcX, srcY))) return true;
-        if (checkJump(_grid->getBR(srcX, srcY), _grid->getBRBR(srcX, srcY))) return true;
+    _turnPath[_turnSteps++] = (uint8_t)boardSquare(dst);
+
+    // Check for more jumps
+    if (move.steps > _turnSteps) {
+        _mustContinueJumping = true;
+        _jumpingPiece = &dst;
+        return;
     }
 
-    return false;
+    finishTurn(move);
 }
 
-void Checkers::bitMovedFromTo(Bit &bit, BitHolder &src, BitHolder &dst) {
-    ChessSquare* srcSquare = static_cast<ChessSquare*>(&src);
-    ChessSquare* dstSquare = static_cast<ChessSquare*>(&dst);
-
-    int srcX = srcSquare->getColumn();
-    int srcY = srcSquare->getRow();
-    int dstX = dstSquare->getColumn();
-    int dstY = dstSquare->getRow();
-
-    // Check for jump
-    ChessSquare* jumped = nullptr;
-    if (dstSquare == _grid->getFLFL(srcX, srcY)) jumped = _grid->getFL(srcX, srcY);
-    else if (dstSquare == _grid->getFRFR(srcX, srcY)) jumped = _grid->getFR(srcX, srcY);
-    else if (dstSquare == _grid->getBLBL(srcX, srcY)) jumped = _grid->getBL(srcX, srcY);
-    else if (dstSquare == _grid->getBRBR(srcX, srcY)) jumped = _grid->getBR(srcX, srcY);
-
-    if (jumped && jumped->bit()) {
-        // Capture
-        (jumped->bit()->getOwner() == getPlayerAt(RED_PLAYER)) ? _redPieces-- : _yellowPieces--;
-        jumped->destroyBit();
-
-        // Promotion check
-        if ((bit.gameTag() == RED_PIECE && dstY == 7) || (bit.gameTag() == YELLOW_PIECE && dstY == 0)) {
-            bit.setGameTag(bit.gameTag() == RED_PIECE ? RED_KING : YELLOW_KING);
-            bit.setScale(1.3f);
-        }
-
-        // Check for more jumps
-        if (canJumpFrom(*dstSquare)) {
-            _mustContinueJumping = true;
-            _jumpingPiece = &dst;
+//
+// a short jump takes the piece in the middle, a flying king can take one anywhere along the diagonal
+//
+template <class Board>
+void DraughtsGame<Board>::removeJumpedPiece(ChessSquare &src, ChessSquare &dst, Mask captured) {
+    int dx = dst.getColumn() > src.getColumn() ? 1 : -1;
+    int dy = dst.getRow() > src.getRow() ? 1 : -1;
+    for (int x = src.getColumn() + dx, y = src.getRow() + dy; x != dst.getColumn(); x += dx, y += dy) {
+        if (captured & Bitboard::bit<Mask>(Board::squareAt(x, y))) {
+            _grid->getSquare(x, y)->destroyBit();
             return;
         }
-    } else {
-        // Regular move - promotion check
-        if ((bit.gameTag() == RED_PIECE && dstY == 7) || (bit.gameTag() == YELLOW_PIECE && dstY == 0)) {
-            bit.setGameTag(bit.gameTag() == RED_PIECE ? RED_KING : YELLOW_KING);
-            bit.setScale(1.3f);
-        }
     }
-
-    _mustContinueJumping = false;
-    _jumpingPiece = nullptr;
-    endTurn();
 }
 
-bool Checkers::canJumpFrom(ChessSquare& square) const {
-    Bit* piece = square.bit();
-    if (!piece) return false;
-
-    int x = square.getColumn();
-    int y = square.getRow();
-    bool isKing = (piece->gameTag() == RED_KING || piece->gameTag() == YELLOW_KING);
-    bool isRed = (piece->getOwner() == getPlayerAt(RED_PLAYER));
-    Player* player = piece->getOwner();
-
-    auto checkJumpDir = [&](ChessSquare* middle, ChessSquare* target) -> bool {
-        return middle && middle->bit() && middle->bit()->getOwner() != player &&
-               target && !target->bit();
-    };
-
-    if (isKing || !isRed) {
-        if (checkJumpDir(_grid->getFL(x, y), _grid->getFLFL(x, y))) return true;
-        if (checkJumpDir(_grid->getFR(x, y), _grid->getFRFR(x, y))) return true;
-    }
-    if (isKing || isRed) {
-        if (checkJumpDir(_grid->getBL(x, y), _grid->getBLBL(x, y))) return true;
-        if (checkJumpDir(_grid->getBR(x, y), _grid->getBRBR(x, y))) return true;
+//
+// match the piece's tag and size to the board after a move, men are crowned on the far row
+// the square rehashes its piece so the grid key sees the king and not the man it was
+//
+template <class Board>
+void DraughtsGame<Board>::crownIfNeeded(Bit &bit, int square) {
+    int pieceType = _board.pieceAt(square);
+    if (pieceType != EMPTY && pieceType != bit.gameTag()) {
+        bit.setGameTag(pieceType);
+        gridSquare(square)->updatePositionKey();
+        if (pieceType == RED_KING || pieceType == YELLOW_KING)
+            bit.setScale(1.3f);
     }
-    return false;
 }
 
-bool Checkers::hasJumpAvailable(Player* player) const {
-    bool hasJump = false;
-    _grid->forEachEnabledSquare([&](ChessSquare* square, int x, int y) {
-        if (hasJump) return;
-        Bit* piece = square->bit();
-        if (piece && piece->getOwner() == player) {
-            Checkers* self = const_cast<Checkers*>(this);
-            if (self->canJumpFrom(*square)) {
-                hasJump = true;
-            }
-        }
-    });
-    return hasJump;
+//
+// the grid already shows the move, the board and its repetition history catch up here
+//
+template <class Board>
+void DraughtsGame<Board>::finishTurn(const Move &move) {
+    _repetitions.play(_board, move);
+    Bit* bit = gridSquare(move.to())->bit();
+    if (bit) crownIfNeeded(*bit, move.to());
+    resetTurn();
+    endTurn();
 }
 
-Player* Checkers::checkForWinner() {
-    if (_redPieces == 0) return getPlayerAt(YELLOW_PLAYER);
-    if (_yellowPieces == 0) return getPlayerAt(RED_PLAYER);
-
-    // Check if current player has any moves
-    Player* current = getCurrentPlayer();
-    bool hasMove = false;
+//
+// play a whole move on the grid at once, used by the AI
+//
+template <class Board>
+void DraughtsGame<Board>::applyMove(const Move &move) {
+    ChessSquare* src = gridSquare(move.from);
+    ChessSquare* dst = gridSquare(move.to());
+    Bit* bit = src->bit();
+    if (!bit) return;
+
+    Mask taken = move.captured;
+    while (taken) {
+        gridSquare(Bitboard::popLowestBit(taken))->destroyBit();
+    }
 
-    _grid->forEachEnabledSquare([&](ChessSquare* square, int x, int y) {
-        if (hasMove) return;
-        Bit* piece = square->bit();
-        if (piece && piece->getOwner() == current) {
-            bool isKing = (piece->gameTag() == RED_KING || piece->gameTag() == YELLOW_KING);
-            bool isRed = (current == getPlayerAt(RED_PLAYER));
-
-            // Check for any valid move
-            auto checkMove = [&](ChessSquare* target) {
-                if (target && !target->bit()) hasMove = true;
-            };
-
-            if (isKing) {
-                checkMove(_grid->getFL(x, y));
-                checkMove(_grid->getFR(x, y));
-                checkMove(_grid->getBL(x, y));
-                checkMove(_grid->getBR(x, y));
-            } else if (isRed) {
-                checkMove(_grid->getBL(x, y));
-                checkMove(_grid->getBR(x, y));
-            } else {
-                checkMove(_grid->getFL(x, y));
-                checkMove(_grid->getFR(x, y));
-            }
-        }
-    });
+    // a king can jump in a circle back to where it started
+    if (src != dst) {
+        dst->setBit(bit);
+        src->setBit(nullptr);
+        bit->moveTo(dst->getPosition());
+    }
+    finishTurn(move);
+}
 
-    if (!hasMove) {
-        return current == getPlayerAt(RED_PLAYER) ? getPlayerAt(YELLOW_PLAYER) : getPlayerAt(RED_PLAYER);
+template <class Board>
+Player* DraughtsGame<Board>::checkForWinner() {
+    // The side to move loses when it has no pieces or no legal moves
+    Move moves[Board::MAX_MOVES];
+    if (_board.generateMoves(moves) == 0) {
+        return getPlayerAt(_board.sideToMove() == RED_PLAYER ? YELLOW_PLAYER : RED_PLAYER);
     }
     return nullptr;
 }
 
-bool Checkers::checkForDraw() {
-    return false;
+template <class Board>
+bool DraughtsGame<Board>::checkForDraw() {
+    return _repetitions.occurrences(_board) >= DRAW_REPETITIONS;
+}
+
+template <class Board>
+void DraughtsGame<Board>::resetRepetitions() {
+    _repetitions.reset(_board);
 }
 
-void Checkers::stopGame() {
+template <class Board>
+void DraughtsGame<Board>::stopGame() {
+    cancelAISearch();
     _grid->forEachSquare([](ChessSquare* square, int x, int y) {
         square->destroyBit();
     });
-    _mustContinueJumping = false;
-    _jumpingPiece = nullptr;
-    _redPieces = 12;
-    _yellowPieces = 12;
+    _board = Board::initial();
+    resetTurn();
+    _repetitions.clear();
 }
 
-std::string Checkers::initialStateString() {
-    return "111111111111--------333333333333";
+template <class Board>
+std::string DraughtsGame<Board>::initialStateString() {
+    return Board::initial().toString();
 }
 
-std::string Checkers::stateString() {
-    return _grid->getStateString();
+template <class Board>
+std::string DraughtsGame<Board>::stateString() {
+    return _board.toString();
 }
 
-void Checkers::setStateString(const std::string &s) {
-    if (s.length() != 32) return;
-
-    _redPieces = 0;
-    _yellowPieces = 0;
+template <class Board>
+void DraughtsGame<Board>::setStateString(const std::string &s) {
+    cancelAISearch();
+    if (!_board.fromString(s, getCurrentPlayer()->playerNumber())) return;
 
     _grid->setStateString(s);
+    resetTurn();
 
     // Recreate pieces from state
-    size_t index = 0;
     _grid->forEachEnabledSquare([&](ChessSquare* square, int x, int y) {
-        if (index < s.length()) {
-            int pieceType = s[index++] - '0';
-            if (pieceType != 0) {
-                Bit* piece = createPiece(pieceType);
-                piece->setPosition(square->getPosition());
-                square->setBit(piece);
-                (pieceType == RED_PIECE || pieceType == RED_KING) ? _redPieces++ : _yellowPieces++;
-            }
+        int pieceType = _board.pieceAt(Board::squareAt(x, y));
+        if (pieceType != EMPTY) {
+            Bit* piece = createPiece(pieceType);
+            piece->setPosition(square->getPosition());
+            square->setBit(piece);
         }
     });
+    resetRepetitions();
+}
+
+template <class Board>
+void DraughtsGame<Board>::updateAI() {
+    if (_mustContinueJumping) return;
+
+    if (_gameOptions.AIUseMCTS) {
+        // playouts for a slice of the frame, the node budget means nothing to them
+        DraughtsPosition<Board> current = position();
+        if (!_mcts.searching() || _mcts.searchRoot().hash() != current.hash()) {
+            MctsLimits limits;
+            limits.timeMs = AI_TIME_BUDGET_MS;
+            _mcts.start(current, limits);
+        }
+        if (!_mcts.advance(0, _gameOptions.AIFrameBudgetUs)) return;
+        const typename MctsEngine<DraughtsTraits<Board>>::Result &result = _mcts.result();
+        if (result.hasMove) applyMove(result.bestMove);
+        return;
+    }
+
+    // the alpha-beta search checked on once a frame so the board keeps drawing while the AI thinks
+    if (!_aiSearch.valid()) startAISearch();
+    if (_aiSearch.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+
+    typename DraughtsEngine<Board>::Result result = _aiSearch.get();
+    if (!result.hasMove || _board.hash() != _aiSearchHash) return;
+    applyMove(result.bestMove);
+}
+
+//
+// the job owns a copy of the board, only the engine is shared and nothing else uses it while a
+// search is out. without worker threads the job runs here before submit returns
+//
+template <class Board>
+void DraughtsGame<Board>::startAISearch() {
+    CheckersSearchLimits limits;
+    limits.timeMs = AI_TIME_BUDGET_MS;
+    _aiStopRequested = false;
+    limits.stop = &_aiStopRequested;
+    _aiSearchHash = _board.hash();
+
+    auto result = std::make_shared<std::promise<typename DraughtsEngine<Board>::Result>>();
+    _aiSearch = result->get_future();
+    JobSystem::instance().submit([this, board = _board, limits, result]() {
+        result->set_value(_engine.search(board, limits));
+    }, JobPriority::HIGH);
 }
 
-void Checkers::updateAI() {}
+template <class Board>
+void DraughtsGame<Board>::cancelAISearch() {
+    if (!_aiSearch.valid()) return;
+    _aiStopRequested = true;
+    _aiSearch.wait();
+    _aiSearch = std::future<typename DraughtsEngine<Board>::Result>();
+}
+
+template <class Board>
+DraughtsPosition<Board> DraughtsGame<Board>::position() const {
+    DraughtsPosition<Board> position;
+    position.board = _board;
+    return position;
+}
+
+// setStateString reads the side to move from the turn counter, so that goes first
+template <class Board>
+void DraughtsGame<Board>::setPosition(const DraughtsPosition<Board> &position) {
+    setSideToMove(position.sideToMove());
+    setStateString(position.toString());
+}
+
+template <class Board>
+std::unique_ptr<ProtocolGame> DraughtsGame<Board>::aiPosition() {
+    std::unique_ptr<ProtocolGame> position = ProtocolGame::create(std::is_same_v<Board, CheckersBoard> ? "checkers" : "international");
+    if (!position->setState(_board.toString(), _board.sideToMove())) return nullptr;
+    return position;
+}
+
+//
+// the protocol lists its moves in the board's generation order, so the name's index picks the move
+//
+template <class Board>
+bool DraughtsGame<Board>::applyAIMove(const std::string &move) {
+    if (_mustContinueJumping) return false;
+    std::unique_ptr<ProtocolGame> position = aiPosition();
+    std::vector<std::string> names = position->legalMoves();
+    Move moves[Board::MAX_MOVES];
+    int count = _board.generateMoves(moves);
+    for (int i = 0; i < count && i < (int)names.size(); i++) {
+        if (names[i] == move) {
+            applyMove(moves[i]);
+            return true;
+        }
+    }
+    return false;
+}
 
+template class DraughtsGame<CheckersBoard>;
+template class DraughtsGame<InternationalBoard>;
@@ -1,14 +1,26 @@
 #pragma once
 #include "Game.h"
+#include "CheckersBoard.h"
+#include "CheckersEngine.h"
+#include "DraughtsPosition.h"
+#include "InternationalBoard.h"
+#include "Mcts.h"
+#include <atomic>
+#include <future>
 
 // NOTE: If Square class needs modifications to support colored squares for checkerboard pattern,
 // add a method like setColor(ImVec4 color) to Square class
 
-class Checkers : public Game
+//
+// draughts on a Board x Board grid, the rules run on the bitboard and the Grid mirrors it for drawing and dragging
+// instantiated in Checkers.cpp for 8x8 checkers (CheckersBoard) and 10x10 international draughts (InternationalBoard)
+//
+template <class Board>
+class DraughtsGame : public Game
 {
 public:
-    Checkers();
-    ~Checkers();
+    DraughtsGame();
+    ~DraughtsGame();
 
     // Required virtual methods from Game base class
     void        setUpBoard() override;
@@ -25,40 +37,76 @@ public:
 
     // AI methods
     void        updateAI() override;
-    bool        gameHasAI() override { return false; } // Set to true when AI is implemented
+    bool        gameHasAI() override { return true; }
+    bool        gameHasMCTS() override { return true; }
+    std::unique_ptr<ProtocolGame> aiPosition() override;
+    bool        applyAIMove(const std::string &move) override;
     Grid* getGrid() override { return _grid; }
 
+    const Board& getBoard() const { return _board; }
+
+    // the board as a GamePosition and back
+    DraughtsPosition<Board> position() const;
+    void        setPosition(const DraughtsPosition<Board> &position);
+
 private:
+    using Move = typename Board::Move;
+    using Mask = typename Board::Mask;
+
     // Constants for piece types
-    static const int EMPTY = 0;
-    static const int RED_PIECE = 1;
-    static const int RED_KING = 2;
-    static const int YELLOW_PIECE = 3;
-    static const int YELLOW_KING = 4;
+    static const int EMPTY = Board::EMPTY;
+    static const int RED_PIECE = Board::RED_PIECE;
+    static const int RED_KING = Board::RED_KING;
+    static const int YELLOW_PIECE = Board::YELLOW_PIECE;
+    static const int YELLOW_KING = Board::YELLOW_KING;
 
     // Player constants
     static const int RED_PLAYER = 0;
     static const int YELLOW_PLAYER = 1;
 
+    // AI thinking time per move
+    static const int AI_TIME_BUDGET_MS = 1000;
+
+    // the same position with the same side to move this many times is a draw
+    static const int DRAW_REPETITIONS = 3;
+
+    // endgame database built by tools/checkers_egdb, optional
+    static constexpr const char *DATABASE_DIRECTORY = "egdb/checkers";
+
     // Helper methods
     Bit*        createPiece(int pieceType);
-    int         getPieceType(const Bit& bit) const;
-    bool        isKing(const Bit& bit) const;
-    bool        isValidMove(int srcX, int srcY, int dstX, int dstY, Player* player) const;
-    bool        isJumpMove(int srcX, int srcY, int dstX, int dstY) const;
-    bool        hasJumpAvailable(Player* player) const;
-    bool        canJumpFrom(ChessSquare& square) const;
-    void        performJump(int srcX, int srcY, int dstX, int dstY);
-    void        promoteToKing(Bit& bit, int y);
-    void        getBoardPosition(BitHolder &holder, int &x, int &y) const;
-    bool        isValidSquare(int x, int y) const;
+    int         boardSquare(BitHolder &holder) const;
+    ChessSquare* gridSquare(int square) const;
+    bool        findTurnMove(int from, int nextStep, Move &found) const;
+    void        removeJumpedPiece(ChessSquare &src, ChessSquare &dst, Mask captured);
+    void        crownIfNeeded(Bit &bit, int square);
+    void        finishTurn(const Move &move);
+    void        applyMove(const Move &move);
+    void        resetTurn();
+    void        resetRepetitions();
+    void        startAISearch();
+    void        cancelAISearch();
 
     // Board representation
-    Grid*        _grid;
-
-    // Game state
-    bool        _mustContinueJumping;
-    BitHolder*  _jumpingPiece;
-    int         _redPieces;
-    int         _yellowPieces;
-};
\ No newline at end of file
+    Grid*           _grid;
+    Board           _board;
+    DraughtsEngine<Board> _engine;
+    MctsEngine<DraughtsTraits<Board>> _mcts;
+    CheckersDatabase _database;     // 8x8 only
+    DraughtsRepetitions<Board> _repetitions;
+
+    // Game state for a jump sequence the player is dragging one hop at a time
+    bool            _mustContinueJumping;
+    BitHolder*      _jumpingPiece;
+    int             _turnFrom;
+    int             _turnSteps;
+    uint8_t         _turnPath[Move::MAX_STEPS];
+
+    // the AI's search runs as a job on a copy of the board, updateAI plays its move once it is done
+    std::future<typename DraughtsEngine<Board>::Result> _aiSearch;
+    std::atomic<bool> _aiStopRequested{ false };
+    uint64_t        _aiSearchHash = 0;  // the board the search is for
+};
+
+using Checkers = DraughtsGame<CheckersBoard>;
+using InternationalDraughts = DraughtsGame<InternationalBoard>;
@@ -0,0 +1,244 @@
+#include "CheckersBoard.h"
+
+namespace {
+    //
+    // zobrist keys for (piece type, square) and the side to move, built at compile time
+    //
+    struct CheckersZobrist
+    {
+        uint64_t piece[5][CheckersBoard::SQUARES];
+        uint64_t side;
+    };
+
+    constexpr CheckersZobrist makeZobrist()
+    {
+        CheckersZobrist z{};
+        uint64_t state = 0xC4EC4E55ull;
+        for (int p = 1; p < 5; p++) {
+            for (int s = 0; s < CheckersBoard::SQUARES; s++) {
+                z.piece[p][s] = Bitboard::splitMix64(state);
+            }
+        }
+        z.side = Bitboard::splitMix64(state);
+        return z;
+    }
+
+    constexpr CheckersZobrist ZOBRIST = makeZobrist();
+}
+
+bool CheckersMove::operator==(const CheckersMove &o) const
+{
+    if (from != o.from || steps != o.steps || captured != o.captured) return false;
+    for (int i = 0; i < steps; i++) {
+        if (path[i] != o.path[i]) return false;
+    }
+    return true;
+}
+
+CheckersBoard::CheckersBoard()
+{
+    _men[RED] = _men[YELLOW] = 0;
+    _kings[RED] = _kings[YELLOW] = 0;
+    _side = RED;
+    _hash = 0;
+}
+
+CheckersBoard CheckersBoard::initial()
+{
+    CheckersBoard board;
+    for (int square = 0; square < 12; square++) board.setPiece(square, RED_PIECE);
+    for (int square = 20; square < 32; square++) board.setPiece(square, YELLOW_PIECE);
+    return board;
+}
+
+void CheckersBoard::setSideToMove(int side)
+{
+    if (side != _side) {
+        _side = side;
+        _hash ^= ZOBRIST.side;
+    }
+}
+
+int CheckersBoard::pieceAt(int square) const
+{
+    uint32_t bit = 1u << square;
+    if (_men[RED] & bit) return RED_PIECE;
+    if (_kings[RED] & bit) return RED_KING;
+    if (_men[YELLOW] & bit) return YELLOW_PIECE;
+    if (_kings[YELLOW] & bit) return YELLOW_KING;
+    return EMPTY;
+}
+
+void CheckersBoard::updateHash(int square, int pieceType)
+{
+    if (pieceType != EMPTY) _hash ^= ZOBRIST.piece[pieceType][square];
+}
+
+//
+// replace whatever is on square with pieceType (EMPTY clears it)
+//
+void CheckersBoard::setPiece(int square, int pieceType)
+{
+    uint32_t bit = 1u << square;
+    updateHash(square, pieceAt(square));
+    for (int side = 0; side < 2; side++) {
+        _men[side] &= ~bit;
+        _kings[side] &= ~bit;
+    }
+    switch (pieceType) {
+        case RED_PIECE:    _men[RED] |= bit; break;
+        case RED_KING:     _kings[RED] |= bit; break;
+        case YELLOW_PIECE: _men[YELLOW] |= bit; break;
+        case YELLOW_KING:  _kings[YELLOW] |= bit; break;
+    }
+    updateHash(square, pieceType);
+}
+
+uint32_t CheckersBoard::movers() const
+{
+    uint32_t open = empty();
+    uint32_t result = 0;
+    for (int dir = 0; dir < 4; dir++) {
+        uint32_t pieceSet = _kings[_side] | (forward(_side, dir) ? _men[_side] : 0);
+        result |= step(open, opposite(dir)) & pieceSet;
+    }
+    return result;
+}
+
+uint32_t CheckersBoard::jumpers() const
+{
+    uint32_t open = empty();
+    uint32_t opp = pieces(_side ^ 1);
+    uint32_t result = 0;
+    for (int dir = 0; dir < 4; dir++) {
+        uint32_t pieceSet = _kings[_side] | (forward(_side, dir) ? _men[_side] : 0);
+        uint32_t takeable = step(open, opposite(dir)) & opp;
+        result |= step(takeable, opposite(dir)) & pieceSet;
+    }
+    return result;
+}
+
+//
+// depth first walk of every jump sequence from one piece
+// captured pieces stay on the board until the move is over, so they block landings but can't be taken twice
+// a man that reaches the crown row stops there
+//
+void CheckersBoard::addJumps(int side, bool king, uint8_t from, uint32_t square, uint32_t capturable, uint32_t open,
+                             CheckersMove &current, CheckersMove *moves, int &count) const
+{
+    bool extended = false;
+    for (int dir = 0; dir < 4; dir++) {
+        if (!king && !forward(side, dir)) continue;
+        uint32_t middle = step(square, dir) & capturable;
+        if (!middle) continue;
+        uint32_t landing = step(middle, dir) & open;
+        if (!landing) continue;
+        if (current.steps >= CheckersMove::MAX_STEPS) continue;
+
+        extended = true;
+        current.path[current.steps++] = (uint8_t)Bitboard::lowestBit(landing);
+        current.captured |= middle;
+        if (!king && (landing & crownRow(side))) {
+            if (count < MAX_MOVES) moves[count++] = current;
+        } else {
+            addJumps(side, king, from, landing, capturable & ~middle, open, current, moves, count);
+        }
+        current.steps--;
+        current.captured &= ~middle;
+    }
+    if (!extended && current.steps > 0 && count < MAX_MOVES) {
+        moves[count++] = current;
+    }
+}
+
+int CheckersBoard::generateCaptures(CheckersMove *moves) const
+{
+    int count = 0;
+    uint32_t jumping = jumpers();
+    uint32_t opp = pieces(_side ^ 1);
+    while (jumping) {
+        int from = Bitboard::popLowestBit(jumping);
+        uint32_t fromBit = 1u << from;
+        CheckersMove current{};
+        current.from = (uint8_t)from;
+        addJumps(_side, (_kings[_side] & fromBit) != 0, (uint8_t)from, fromBit, opp, empty() | fromBit, current, moves, count);
+    }
+    return count;
+}
+
+int CheckersBoard::generateMoves(CheckersMove *moves) const
+{
+    // captures are mandatory
+    int count = generateCaptures(moves);
+    if (count) return count;
+
+    uint32_t open = empty();
+    for (int dir = 0; dir < 4; dir++) {
+        uint32_t pieceSet = _kings[_side] | (forward(_side, dir) ? _men[_side] : 0);
+        uint32_t targets = step(pieceSet, dir) & open;
+        while (targets && count < MAX_MOVES) {
+            int to = Bitboard::popLowestBit(targets);
+            CheckersMove &move = moves[count++];
+            move.from = (uint8_t)Bitboard::lowestBit(step(1u << to, opposite(dir)));
+            move.steps = 1;
+            move.path[0] = (uint8_t)to;
+            move.captured = 0;
+        }
+    }
+    return count;
+}
+
+void CheckersBoard::makeMove(const CheckersMove &move)
+{
+    int pieceType = pieceAt(move.from);
+    int to = move.to();
+
+    uint32_t taken = move.captured;
+    while (taken) {
+        setPiece(Bitboard::popLowestBit(taken), EMPTY);
+    }
+    setPiece(move.from, EMPTY);
+
+    // men are crowned on the far row
+    if (pieceType == RED_PIECE && ((1u << to) & RED_CROWN)) pieceType = RED_KING;
+    if (pieceType == YELLOW_PIECE && ((1u << to) & YELLOW_CROWN)) pieceType = YELLOW_KING;
+    setPiece(to, pieceType);
+
+    setSideToMove(_side ^ 1);
+}
+
+CheckersBoard CheckersBoard::flipped() const
+{
+    // rotating the board maps square s to 31 - s, which is a bit reversal
+    CheckersBoard board;
+    for (int side = 0; side < 2; side++) {
+        uint32_t men = Bitboard::reverseBits(_men[side]);
+        uint32_t kings = Bitboard::reverseBits(_kings[side]);
+        int other = side ^ 1;
+        while (men) board.setPiece(Bitboard::popLowestBit(men), other == RED ? RED_PIECE : YELLOW_PIECE);
+        while (kings) board.setPiece(Bitboard::popLowestBit(kings), other == RED ? RED_KING : YELLOW_KING);
+    }
+    board.setSideToMove(_side ^ 1);
+    return board;
+}
+
+std::string CheckersBoard::toString() const
+{
+    std::string state(SQUARES, '0');
+    for (int square = 0; square < SQUARES; square++) {
+        state[square] = (char)('0' + pieceAt(square));
+    }
+    return state;
+}
+
+bool CheckersBoard::fromString(const std::string &state, int sideToMove)
+{
+    if (state.length() != SQUARES) return false;
+    *this = CheckersBoard();
+    for (int square = 0; square < SQUARES; square++) {
+        int pieceType = state[square] - '0';
+        if (pieceType > EMPTY && pieceType <= YELLOW_KING) setPiece(square, pieceType);
+    }
+    setSideToMove(sideToMove);
+    return true;
+}
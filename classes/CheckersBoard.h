@@ -0,0 +1,129 @@
+#pragma once
+
+#include "Bitboard.h"
+#include <cstdint>
+#include <string>
+
+//
+// 32-square bitboard for 8x8 checkers
+// only the dark squares are stored, square index is y * 4 + x / 2 which matches the
+// order of Grid::getStateString() over the enabled squares
+// side 0 is red (starts at the top, moves down the board), side 1 is yellow
+//
+struct CheckersMove
+{
+    static const int MAX_STEPS = 12;
+
+    uint8_t     from;
+    uint8_t     steps;                  // 1 for a simple move, number of hops for a jump
+    uint8_t     path[MAX_STEPS];        // landing square of every step, path[steps - 1] is the destination
+    uint32_t    captured;               // squares of the pieces taken by this move
+
+    uint8_t     to() const { return path[steps - 1]; }
+    bool        isCapture() const { return captured != 0; }
+    bool        operator==(const CheckersMove &o) const;
+};
+
+class CheckersBoard
+{
+public:
+    using Mask = uint32_t;
+    using Move = CheckersMove;
+
+    static const int WIDTH = 8;
+    static const int SQUARES = 32;
+    static const int BITS = 32;
+    static const int MAX_MOVES = 128;
+    static const int RED = 0;
+    static const int YELLOW = 1;
+
+    // 0 = empty, then the piece types used by the Checkers game tags
+    static const int EMPTY = 0;
+    static const int RED_PIECE = 1;
+    static const int RED_KING = 2;
+    static const int YELLOW_PIECE = 3;
+    static const int YELLOW_KING = 4;
+
+    CheckersBoard();
+
+    static CheckersBoard initial();
+
+    // square helpers
+    static int      squareAt(int x, int y) { return y * 4 + x / 2; }
+    static int      squareX(int square) { return (square % 4) * 2 + ((square / 4) % 2 == 0 ? 1 : 0); }
+    static int      squareY(int square) { return square / 4; }
+
+    uint32_t        pieces(int side) const { return _men[side] | _kings[side]; }
+    uint32_t        men(int side) const { return _men[side]; }
+    uint32_t        kings(int side) const { return _kings[side]; }
+    uint32_t        occupied() const { return pieces(RED) | pieces(YELLOW); }
+    uint32_t        empty() const { return ~occupied(); }
+    int             sideToMove() const { return _side; }
+    void            setSideToMove(int side);
+    uint64_t        hash() const { return _hash; }
+    int             pieceAt(int square) const;
+    void            setPiece(int square, int pieceType);
+
+    // pieces of the side to move that can make a simple move or a jump
+    uint32_t        movers() const;
+    uint32_t        jumpers() const;
+    bool            hasCapture() const { return jumpers() != 0; }
+
+    // legal moves for the side to move with mandatory capture, full jump sequences only
+    // returns the number of moves written into moves (at most MAX_MOVES)
+    int             generateMoves(CheckersMove *moves) const;
+    int             generateCaptures(CheckersMove *moves) const;
+
+    void            makeMove(const CheckersMove &move);
+
+    // the same position seen from the other side: board rotated 180 degrees, colours and side to move swapped
+    CheckersBoard   flipped() const;
+
+    // 32 characters using the piece types above plus the side to move
+    std::string     toString() const;
+    bool            fromString(const std::string &state, int sideToMove);
+
+    //
+    // one diagonal step for every bit in m, the step size depends on the row parity
+    // even rows sit one column right of odd rows
+    //
+    static constexpr uint32_t EVEN_ROWS = 0x0F0F0F0Fu;
+    static constexpr uint32_t ODD_ROWS = 0xF0F0F0F0u;
+    static constexpr uint32_t LEFT_EDGE = 0x11111111u;     // k == 0 in every row
+    static constexpr uint32_t RIGHT_EDGE = 0x88888888u;    // k == 3 in every row
+    static constexpr uint32_t RED_CROWN = 0xF0000000u;     // red promotes on row 7
+    static constexpr uint32_t YELLOW_CROWN = 0x0000000Fu;  // yellow promotes on row 0
+
+    enum Direction { DOWN_LEFT, DOWN_RIGHT, UP_LEFT, UP_RIGHT };
+
+    static constexpr uint32_t step(uint32_t m, int direction)
+    {
+        switch (direction) {
+            case DOWN_LEFT:  return ((m & EVEN_ROWS) << 4) | ((m & ODD_ROWS & ~LEFT_EDGE) << 3);
+            case DOWN_RIGHT: return ((m & EVEN_ROWS & ~RIGHT_EDGE) << 5) | ((m & ODD_ROWS) << 4);
+            case UP_LEFT:    return ((m & EVEN_ROWS) >> 4) | ((m & ODD_ROWS & ~LEFT_EDGE) >> 5);
+            case UP_RIGHT:   return ((m & EVEN_ROWS & ~RIGHT_EDGE) >> 3) | ((m & ODD_ROWS) >> 4);
+        }
+        return 0;
+    }
+
+    // the direction that undoes a step
+    static constexpr int opposite(int direction) { return direction ^ 3; }
+
+    // red men move down, yellow men move up, kings move both ways
+    static constexpr bool forward(int side, int direction) { return side == RED ? direction <= DOWN_RIGHT : direction >= UP_LEFT; }
+
+    static constexpr uint32_t rowMask(int y) { return 0xFu << (y * 4); }
+
+    static constexpr uint32_t crownRow(int side) { return side == RED ? RED_CROWN : YELLOW_CROWN; }
+
+private:
+    void            addJumps(int side, bool king, uint8_t from, uint32_t square, uint32_t capturable, uint32_t open,
+                             CheckersMove &current, CheckersMove *moves, int &count) const;
+    void            updateHash(int square, int pieceType);
+
+    uint32_t        _men[2];
+    uint32_t        _kings[2];
+    int             _side;
+    uint64_t        _hash;
+};
@@ -0,0 +1,301 @@
+#include "CheckersDatabase.h"
+#include <filesystem>
+#include <fstream>
+
+namespace {
+    // squares a man can stand on: red never sits on row 7, yellow never on row 0
+    const uint32_t ROW_0 = 0x0000000Fu;
+    const uint32_t MIDDLE = 0x0FFFFFF0u;
+    const uint32_t ROW_7 = 0xF0000000u;
+
+    struct Binomials
+    {
+        uint64_t c[33][33];
+    };
+
+    constexpr Binomials makeBinomials()
+    {
+        Binomials b{};
+        for (int n = 0; n <= 32; n++) {
+            b.c[n][0] = 1;
+            for (int k = 1; k <= n; k++) b.c[n][k] = b.c[n - 1][k - 1] + (k < n ? b.c[n - 1][k] : 0);
+        }
+        return b;
+    }
+
+    constexpr Binomials BINOMIALS = makeBinomials();
+
+    uint64_t choose(int n, int k)
+    {
+        if (k < 0 || n < 0 || k > n) return 0;
+        return BINOMIALS.c[n][k];
+    }
+
+    //
+    // colex rank of the chosen squares, counted among the available squares only
+    //
+    uint64_t rankSubset(uint32_t chosen, uint32_t available)
+    {
+        uint64_t rank = 0;
+        int i = 1;
+        while (chosen) {
+            int square = Bitboard::popLowestBit(chosen);
+            int position = Bitboard::popCount(available & ((1u << square) - 1));
+            rank += choose(position, i++);
+        }
+        return rank;
+    }
+
+    uint32_t nthSquare(uint32_t available, int n)
+    {
+        while (n--) available &= available - 1;
+        return available & (0u - available);
+    }
+
+    uint32_t unrankSubset(uint64_t rank, int k, uint32_t available)
+    {
+        uint32_t chosen = 0;
+        int limit = Bitboard::popCount(available);
+        for (int i = k; i >= 1; i--) {
+            int position = i - 1;
+            while (position + 1 < limit && choose(position + 1, i) <= rank) position++;
+            rank -= choose(position, i);
+            chosen |= nthSquare(available, position);
+            limit = position;
+        }
+        return chosen;
+    }
+
+    //
+    // a slice is split into blocks by how many red men stand on row 0 and yellow men on row 7,
+    // which fixes the number of free middle squares so every block is a plain product of binomials
+    //
+    struct BlockSizes
+    {
+        uint64_t n[6];
+        uint64_t total() const { return n[0] * n[1] * n[2] * n[3] * n[4] * n[5]; }
+    };
+
+    BlockSizes blockSizes(const CheckersMaterial &m, int redBack, int yellowBack)
+    {
+        int redMiddle = m.redMen - redBack;
+        int yellowMiddle = m.yellowMen - yellowBack;
+        int men = m.redMen + m.yellowMen;
+        BlockSizes sizes;
+        sizes.n[0] = choose(4, redBack);
+        sizes.n[1] = choose(24, redMiddle);
+        sizes.n[2] = choose(4, yellowBack);
+        sizes.n[3] = choose(24 - redMiddle, yellowMiddle);
+        sizes.n[4] = choose(32 - men, m.redKings);
+        sizes.n[5] = choose(32 - men - m.redKings, m.yellowKings);
+        return sizes;
+    }
+
+    uint64_t blockOffset(const CheckersMaterial &m, int redBack, int yellowBack)
+    {
+        uint64_t offset = 0;
+        for (int r = 0; r <= 4; r++) {
+            for (int y = 0; y <= 4; y++) {
+                if (r == redBack && y == yellowBack) return offset;
+                offset += blockSizes(m, r, y).total();
+            }
+        }
+        return offset;
+    }
+}
+
+std::string CheckersMaterial::name() const
+{
+    return std::to_string(redMen) + std::to_string(redKings) + std::to_string(yellowMen) + std::to_string(yellowKings);
+}
+
+CheckersMaterial CheckersMaterial::of(const CheckersBoard &board)
+{
+    CheckersMaterial m;
+    m.redMen = Bitboard::popCount(board.men(CheckersBoard::RED));
+    m.redKings = Bitboard::popCount(board.kings(CheckersBoard::RED));
+    m.yellowMen = Bitboard::popCount(board.men(CheckersBoard::YELLOW));
+    m.yellowKings = Bitboard::popCount(board.kings(CheckersBoard::YELLOW));
+    return m;
+}
+
+CheckersDatabase::CheckersDatabase()
+{
+    _maxPieces = 0;
+}
+
+uint64_t CheckersDatabase::sliceSize(const CheckersMaterial &material)
+{
+    uint64_t size = 0;
+    for (int r = 0; r <= 4; r++) {
+        for (int y = 0; y <= 4; y++) {
+            size += blockSizes(material, r, y).total();
+        }
+    }
+    return size;
+}
+
+uint64_t CheckersDatabase::indexOf(const CheckersBoard &board)
+{
+    CheckersMaterial m = CheckersMaterial::of(board);
+    uint32_t redMen = board.men(CheckersBoard::RED);
+    uint32_t yellowMen = board.men(CheckersBoard::YELLOW);
+    uint32_t redKings = board.kings(CheckersBoard::RED);
+    uint32_t yellowKings = board.kings(CheckersBoard::YELLOW);
+    uint32_t men = redMen | yellowMen;
+
+    int redBack = Bitboard::popCount(redMen & ROW_0);
+    int yellowBack = Bitboard::popCount(yellowMen & ROW_7);
+    BlockSizes sizes = blockSizes(m, redBack, yellowBack);
+
+    uint64_t digits[6];
+    digits[0] = rankSubset(redMen & ROW_0, ROW_0);
+    digits[1] = rankSubset(redMen & MIDDLE, MIDDLE);
+    digits[2] = rankSubset(yellowMen & ROW_7, ROW_7);
+    digits[3] = rankSubset(yellowMen & MIDDLE, MIDDLE & ~redMen);
+    digits[4] = rankSubset(redKings, ~men);
+    digits[5] = rankSubset(yellowKings, ~(men | redKings));
+
+    uint64_t index = 0;
+    for (int i = 0; i < 6; i++) index = index * sizes.n[i] + digits[i];
+    return blockOffset(m, redBack, yellowBack) + index;
+}
+
+CheckersBoard CheckersDatabase::positionAt(const CheckersMaterial &m, uint64_t index)
+{
+    // find the block holding index
+    int redBack = 0, yellowBack = 0;
+    BlockSizes sizes{};
+    bool found = false;
+    for (int r = 0; r <= 4 && !found; r++) {
+        for (int y = 0; y <= 4 && !found; y++) {
+            sizes = blockSizes(m, r, y);
+            uint64_t total = sizes.total();
+            if (index < total) {
+                redBack = r;
+                yellowBack = y;
+                found = true;
+            } else {
+                index -= total;
+            }
+        }
+    }
+
+    uint64_t digits[6];
+    for (int i = 5; i >= 0; i--) {
+        digits[i] = index % sizes.n[i];
+        index /= sizes.n[i];
+    }
+
+    uint32_t redMen = unrankSubset(digits[0], redBack, ROW_0) | unrankSubset(digits[1], m.redMen - redBack, MIDDLE);
+    uint32_t yellowMen = unrankSubset(digits[2], yellowBack, ROW_7) | unrankSubset(digits[3], m.yellowMen - yellowBack, MIDDLE & ~redMen);
+    uint32_t men = redMen | yellowMen;
+    uint32_t redKings = unrankSubset(digits[4], m.redKings, ~men);
+    uint32_t yellowKings = unrankSubset(digits[5], m.yellowKings, ~(men | redKings));
+
+    CheckersBoard board;
+    while (redMen) board.setPiece(Bitboard::popLowestBit(redMen), CheckersBoard::RED_PIECE);
+    while (redKings) board.setPiece(Bitboard::popLowestBit(redKings), CheckersBoard::RED_KING);
+    while (yellowMen) board.setPiece(Bitboard::popLowestBit(yellowMen), CheckersBoard::YELLOW_PIECE);
+    while (yellowKings) board.setPiece(Bitboard::popLowestBit(yellowKings), CheckersBoard::YELLOW_KING);
+    return board;
+}
+
+std::vector<CheckersMaterial> CheckersDatabase::slicesWith(int pieces)
+{
+    std::vector<CheckersMaterial> slices;
+    for (int red = 1; red < pieces; red++) {
+        int yellow = pieces - red;
+        if (red > 12 || yellow > 12) continue;
+        for (int redMen = 0; redMen <= red; redMen++) {
+            for (int yellowMen = 0; yellowMen <= yellow; yellowMen++) {
+                slices.push_back({ redMen, red - redMen, yellowMen, yellow - yellowMen });
+            }
+        }
+    }
+    return slices;
+}
+
+std::string CheckersDatabase::slicePath(const std::string &directory, const CheckersMaterial &material)
+{
+    return (std::filesystem::path(directory) / ("checkers_" + material.name() + ".cdb")).string();
+}
+
+bool CheckersDatabase::writeSlice(const std::string &directory, const CheckersMaterial &material, const std::vector<uint8_t> &values)
+{
+    std::filesystem::create_directories(directory);
+    std::ofstream file(slicePath(directory, material), std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+
+    FileHeader header{};
+    header.magic = FILE_MAGIC;
+    header.version = FILE_VERSION;
+    header.material[0] = (uint8_t)material.redMen;
+    header.material[1] = (uint8_t)material.redKings;
+    header.material[2] = (uint8_t)material.yellowMen;
+    header.material[3] = (uint8_t)material.yellowKings;
+    header.positions = values.size();
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // four 2-bit values per byte
+    std::vector<uint8_t> packed((values.size() + 3) / 4, 0);
+    for (size_t i = 0; i < values.size(); i++) {
+        packed[i >> 2] |= (uint8_t)((values[i] & 3) << ((i & 3) * 2));
+    }
+    file.write(reinterpret_cast<const char*>(packed.data()), (std::streamsize)packed.size());
+    return (bool)file;
+}
+
+int CheckersDatabase::open(const std::string &directory, int maxPieces)
+{
+    close();
+    bool allComplete = true;
+    for (int pieces = 2; pieces <= maxPieces; pieces++) {
+        bool complete = true;
+        for (const CheckersMaterial &material : slicesWith(pieces)) {
+            auto slice = std::make_unique<Slice>();
+            if (!slice->file.open(slicePath(directory, material)) || slice->file.size() < sizeof(FileHeader)) {
+                complete = false;
+                continue;
+            }
+
+            const FileHeader *header = reinterpret_cast<const FileHeader*>(slice->file.data());
+            uint64_t positions = sliceSize(material);
+            if (header->magic != FILE_MAGIC || header->version != FILE_VERSION || header->positions != positions ||
+                slice->file.size() < sizeof(FileHeader) + (positions + 3) / 4) {
+                complete = false;
+                continue;
+            }
+
+            slice->values = slice->file.data() + sizeof(FileHeader);
+            slice->positions = positions;
+            _slices[material.key()] = std::move(slice);
+        }
+        allComplete = allComplete && complete;
+        if (allComplete) _maxPieces = pieces;
+    }
+    return (int)_slices.size();
+}
+
+void CheckersDatabase::close()
+{
+    _slices.clear();
+    _maxPieces = 0;
+}
+
+CheckersDatabase::Value CheckersDatabase::probe(const CheckersBoard &board) const
+{
+    // with yellow to move, look up the mirrored position instead
+    CheckersBoard red = board.sideToMove() == CheckersBoard::RED ? board : board.flipped();
+    if (!red.pieces(CheckersBoard::RED)) return LOSS;
+    if (!red.pieces(CheckersBoard::YELLOW)) return WIN;
+
+    CheckersMaterial material = CheckersMaterial::of(red);
+    auto found = _slices.find(material.key());
+    if (found == _slices.end()) return UNKNOWN;
+
+    uint64_t index = indexOf(red);
+    const Slice &slice = *found->second;
+    if (index >= slice.positions) return UNKNOWN;
+    return (Value)((slice.values[index >> 2] >> ((index & 3) * 2)) & 3);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "CheckersBoard.h"
+#include "MappedFile.h"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//
+// piece counts of a database slice, always seen from the side to move (stored as red)
+//
+struct CheckersMaterial
+{
+    int redMen = 0;
+    int redKings = 0;
+    int yellowMen = 0;
+    int yellowKings = 0;
+
+    int                 total() const { return redMen + redKings + yellowMen + yellowKings; }
+    int                 key() const { return redMen | (redKings << 4) | (yellowMen << 8) | (yellowKings << 12); }
+    CheckersMaterial    flipped() const { return { yellowMen, yellowKings, redMen, redKings }; }
+    std::string         name() const;
+    bool                operator==(const CheckersMaterial &o) const { return key() == o.key(); }
+
+    static CheckersMaterial of(const CheckersBoard &board);
+};
+
+//
+// win/loss/draw endgame database built offline by tools/checkers_egdb.cpp
+// one file per material slice holding 2 bits per position, only red to move is stored
+// since a position with yellow to move is the flipped position with red to move
+// positions are indexed by a perfect (gap free) ranking of the piece placements
+//
+class CheckersDatabase
+{
+public:
+    enum Value : uint8_t { UNKNOWN = 0, WIN = 1, LOSS = 2, DRAW = 3 };
+
+    static const int MAX_PIECES = 8;
+    static const uint32_t FILE_MAGIC = 0x42444B43;     // "CKDB"
+    static const uint32_t FILE_VERSION = 1;
+
+    struct FileHeader
+    {
+        uint32_t    magic;
+        uint32_t    version;
+        uint8_t     material[4];
+        uint32_t    reserved;
+        uint64_t    positions;
+    };
+
+    CheckersDatabase();
+
+    // slice indexing, boards must have red to move
+    static uint64_t         sliceSize(const CheckersMaterial &material);
+    static uint64_t         indexOf(const CheckersBoard &board);
+    static CheckersBoard    positionAt(const CheckersMaterial &material, uint64_t index);
+
+    // every slice with exactly pieces pieces and both sides on the board
+    static std::vector<CheckersMaterial> slicesWith(int pieces);
+
+    static std::string      slicePath(const std::string &directory, const CheckersMaterial &material);
+    static bool             writeSlice(const std::string &directory, const CheckersMaterial &material, const std::vector<uint8_t> &values);
+
+    // maps every slice file found in directory, returns the number of slices loaded
+    int                     open(const std::string &directory, int maxPieces = MAX_PIECES);
+    void                    close();
+
+    // largest piece count for which every slice is loaded
+    int                     maxPieces() const { return _maxPieces; }
+    int                     sliceCount() const { return (int)_slices.size(); }
+
+    // game theoretic value for the side to move, UNKNOWN when the position isn't covered
+    Value                   probe(const CheckersBoard &board) const;
+
+private:
+    struct Slice
+    {
+        MappedFile      file;
+        const uint8_t*  values;
+        uint64_t        positions;
+    };
+
+    std::unordered_map<int, std::unique_ptr<Slice>>    _slices;
+    int                                                 _maxPieces;
+};
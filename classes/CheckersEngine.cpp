@@ -0,0 +1,431 @@
+#include "CheckersEngine.h"
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+namespace {
+    //
+    // evaluation weights per variant, flying kings are worth far more than short ones
+    //
+    template <class Board>
+    struct Weights;
+
+    template <>
+    struct Weights<CheckersBoard>
+    {
+        static const int MAN_VALUE = 100;
+        static const int KING_VALUE = 140;
+        static const int ADVANCE_BONUS = 3;
+        static const int BACK_RANK_BONUS = 10;
+        static const int CENTER_BONUS = 5;
+        static const int START_PIECES = 24;
+        static constexpr uint32_t CENTER_SQUARES = (1u << 13) | (1u << 14) | (1u << 17) | (1u << 18);
+    };
+
+    template <>
+    struct Weights<InternationalBoard>
+    {
+        using B = InternationalBoard;
+        static const int MAN_VALUE = 100;
+        static const int KING_VALUE = 300;
+        static const int ADVANCE_BONUS = 2;
+        static const int BACK_RANK_BONUS = 8;
+        static const int CENTER_BONUS = 4;
+        static const int START_PIECES = 40;
+        static constexpr uint64_t CENTER_SQUARES = Bitboard::bit<uint64_t>(B::squareAt(3, 4)) | Bitboard::bit<uint64_t>(B::squareAt(5, 4)) |
+                                                   Bitboard::bit<uint64_t>(B::squareAt(4, 5)) | Bitboard::bit<uint64_t>(B::squareAt(6, 5));
+    };
+
+    // number of rows a man of side has advanced from its own back rank
+    template <class Board>
+    int advancement(typename Board::Mask men, int side)
+    {
+        const int last = Board::WIDTH - 1;
+        int total = 0;
+        for (int y = 1; y < last; y++) {
+            int rows = side == Board::RED ? y : last - y;
+            total += Bitboard::popCount(men & Board::rowMask(y)) * rows;
+        }
+        return total;
+    }
+}
+
+template <class Board>
+DraughtsEngine<Board>::DraughtsEngine(int tableSizeMB)
+{
+    resizeTable((size_t)tableSizeMB * 1024 * 1024);
+    _database = nullptr;
+    _probePieces = 0;
+    _stop = false;
+    _nodes = 0;
+    _tableHits = 0;
+    clearTable();
+}
+
+template <class Board>
+void DraughtsEngine<Board>::resizeTable(size_t bytes)
+{
+    size_t entries = 1;
+    while (entries * 2 * sizeof(TableEntry) <= bytes) entries *= 2;
+    _table.assign(entries, TableEntry{});
+    _table.shrink_to_fit();
+    _tableMask = entries - 1;
+}
+
+template <class Board>
+void DraughtsEngine<Board>::clearTable()
+{
+    std::fill(_table.begin(), _table.end(), TableEntry{});
+    std::memset(_history, 0, sizeof(_history));
+}
+
+//
+// material, advancement of men, back rank guard and center control
+// when ahead, trading down is encouraged by scaling the material lead with the number of pieces gone
+//
+template <class Board>
+int DraughtsEngine<Board>::evaluate(const Board &board)
+{
+    using W = Weights<Board>;
+    int score[2];
+    int material[2];
+    int total = Bitboard::popCount(board.occupied());
+
+    for (int side = 0; side < 2; side++) {
+        auto men = board.men(side);
+        auto kings = board.kings(side);
+        auto backRank = side == Board::RED ? Board::rowMask(0) : Board::rowMask(Board::WIDTH - 1);
+
+        material[side] = Bitboard::popCount(men) * W::MAN_VALUE + Bitboard::popCount(kings) * W::KING_VALUE;
+        score[side] = material[side];
+        score[side] += advancement<Board>(men, side) * W::ADVANCE_BONUS;
+        if (board.men(side ^ 1)) score[side] += Bitboard::popCount(men & backRank) * W::BACK_RANK_BONUS;
+        score[side] += Bitboard::popCount((men | kings) & W::CENTER_SQUARES) * W::CENTER_BONUS;
+    }
+
+    int us = board.sideToMove();
+    int them = us ^ 1;
+    int result = score[us] - score[them];
+    result += (material[us] - material[them]) * (W::START_PIECES - total) / (W::START_PIECES * 2);
+    return result;
+}
+
+template <class Board>
+typename DraughtsEngine<Board>::TableEntry* DraughtsEngine<Board>::probe(uint64_t key)
+{
+    TableEntry *entry = &_table[key & _tableMask];
+    return entry->key == key ? entry : nullptr;
+}
+
+//
+// win scores, the database ones included, are stored relative to the node so they stay valid from any ply
+//
+template <class Board>
+void DraughtsEngine<Board>::store(uint64_t key, int depth, int ply, int score, Bound bound, int move)
+{
+    TableEntry &entry = _table[key & _tableMask];
+    if (entry.key == key && entry.depth > depth && bound != BOUND_EXACT) return;
+
+    if (isDecidedScore(score)) score += score > 0 ? ply : -ply;
+
+    entry.key = key;
+    entry.score = (int16_t)score;
+    entry.depth = (uint8_t)std::max(depth, 0);
+    entry.bound = bound;
+    entry.move = (uint8_t)move;
+}
+
+template <class Board>
+bool DraughtsEngine<Board>::checkLimits()
+{
+    if (_limits.stop && *_limits.stop) _stop = true;
+    if ((_nodes & 2047) != 0) return _stop;
+    if (_limits.maxNodes && _nodes >= _limits.maxNodes) _stop = true;
+    if (_limits.timeMs > 0) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _startTime).count();
+        if (elapsed >= _limits.timeMs) _stop = true;
+    }
+    return _stop;
+}
+
+//
+// database scores sit below real win scores, so a found conversion still prefers the shortest
+// win the search can actually see
+//
+template <class Board>
+bool DraughtsEngine<Board>::probeDatabase(const Board &board, int ply, int &score)
+{
+    if constexpr (std::is_same_v<Board, CheckersBoard>) {
+        if (!_database || Bitboard::popCount(board.occupied()) > _probePieces) return false;
+
+        CheckersDatabase::Value value = _database->probe(board);
+        if (value == CheckersDatabase::UNKNOWN) return false;
+
+        _tableHits++;
+        if (value == CheckersDatabase::WIN) score = DATABASE_WIN_SCORE - ply;
+        else if (value == CheckersDatabase::LOSS) score = -DATABASE_WIN_SCORE + ply;
+        else score = 0;
+        return true;
+    }
+    return false;
+}
+
+//
+// keeps only the moves that hold the root's database value, returns the new count
+//
+template <class Board>
+int DraughtsEngine<Board>::filterByDatabase(const Board &board, Move *moves, int count)
+{
+    if constexpr (std::is_same_v<Board, CheckersBoard>) {
+        CheckersDatabase::Value rootValue = _database->probe(board);
+        if (rootValue == CheckersDatabase::UNKNOWN || rootValue == CheckersDatabase::LOSS) return count;
+
+        // the child's value is for the opponent, so a win needs a lost child and a draw a drawn one
+        CheckersDatabase::Value wanted = rootValue == CheckersDatabase::WIN ? CheckersDatabase::LOSS : CheckersDatabase::DRAW;
+        int kept = 0;
+        for (int i = 0; i < count; i++) {
+            Board child = board;
+            child.makeMove(moves[i]);
+            if (_database->probe(child) == wanted) moves[kept++] = moves[i];
+        }
+        if (kept > 0) return kept;
+    }
+    return count;
+}
+
+//
+// table move first, then bigger captures, then quiet moves by history
+//
+template <class Board>
+void DraughtsEngine<Board>::orderMoves(Move *moves, int *scores, int count, int tableMove) const
+{
+    for (int i = 0; i < count; i++) {
+        if (i == tableMove) scores[i] = 1 << 30;
+        else if (moves[i].isCapture()) scores[i] = (1 << 20) + Bitboard::popCount(moves[i].captured);
+        else scores[i] = _history[moves[i].from][moves[i].to()];
+    }
+}
+
+template <class Board>
+int DraughtsEngine<Board>::quiesce(const Board &board, int ply, int alpha, int beta)
+{
+    _nodes++;
+    if (checkLimits()) return 0;
+
+    // captures are forced in checkers, so there is no stand pat while one is available
+    if (!board.hasCapture()) {
+        if (!board.movers()) return -WIN_SCORE + ply;
+        return evaluate(board);
+    }
+    if (ply >= MAX_PLY - 1) return evaluate(board);
+
+    int tableScore;
+    if (probeDatabase(board, ply, tableScore)) return tableScore;
+
+    Move moves[Board::MAX_MOVES];
+    int count = board.generateCaptures(moves);
+    int best = -WIN_SCORE;
+    for (int i = 0; i < count; i++) {
+        Board child = board;
+        child.makeMove(moves[i]);
+        int score = -quiesce(child, ply + 1, -beta, -alpha);
+        if (_stop) return 0;
+        if (score > best) {
+            best = score;
+            if (score > alpha) {
+                alpha = score;
+                if (alpha >= beta) break;
+            }
+        }
+    }
+    return best;
+}
+
+template <class Board>
+int DraughtsEngine<Board>::negamax(const Board &board, int depth, int ply, int alpha, int beta)
+{
+    if (depth <= 0) return quiesce(board, ply, alpha, beta);
+
+    _nodes++;
+    if (checkLimits()) return 0;
+    if (ply >= MAX_PLY - 1) return evaluate(board);
+
+    int tableScore;
+    if (probeDatabase(board, ply, tableScore)) return tableScore;
+
+    int tableMove = -1;
+    TableEntry *entry = probe(board.hash());
+    if (entry) {
+        tableMove = entry->move;
+        if (entry->depth >= depth) {
+            int score = entry->score;
+            if (isDecidedScore(score)) score -= score > 0 ? ply : -ply;
+            if (entry->bound == BOUND_EXACT) return score;
+            if (entry->bound == BOUND_LOWER && score >= beta) return score;
+            if (entry->bound == BOUND_UPPER && score <= alpha) return score;
+        }
+    }
+
+    Move moves[Board::MAX_MOVES];
+    int count = board.generateMoves(moves);
+    if (count == 0) return -WIN_SCORE + ply;
+
+    int scores[Board::MAX_MOVES];
+    orderMoves(moves, scores, count, tableMove);
+
+    // forced moves don't cost depth
+    int childDepth = count == 1 ? depth : depth - 1;
+
+    // generator order of every move, the table stores that index
+    int order[Board::MAX_MOVES];
+    for (int i = 0; i < count; i++) order[i] = i;
+
+    int alphaStart = alpha;
+    int best = -WIN_SCORE;
+    int bestIndex = 0;
+    for (int i = 0; i < count; i++) {
+        // pick the best remaining move
+        int pick = i;
+        for (int j = i + 1; j < count; j++) {
+            if (scores[j] > scores[pick]) pick = j;
+        }
+        std::swap(moves[i], moves[pick]);
+        std::swap(scores[i], scores[pick]);
+        std::swap(order[i], order[pick]);
+
+        Board child = board;
+        child.makeMove(moves[i]);
+        int score = -negamax(child, childDepth, ply + 1, -beta, -alpha);
+        if (_stop) return 0;
+
+        if (score > best) {
+            best = score;
+            bestIndex = i;
+            if (score > alpha) {
+                alpha = score;
+                if (alpha >= beta) {
+                    if (!moves[i].isCapture()) _history[moves[i].from][moves[i].to()] += depth * depth;
+                    break;
+                }
+            }
+        }
+    }
+
+    Bound bound = best >= beta ? BOUND_LOWER : (best > alphaStart ? BOUND_EXACT : BOUND_UPPER);
+    store(board.hash(), depth, ply, best, bound, order[bestIndex]);
+    return best;
+}
+
+//
+// follows the table's best moves from board, stops at a missing entry or a repeated position
+//
+template <class Board>
+std::vector<typename DraughtsEngine<Board>::Move> DraughtsEngine<Board>::principalVariation(const Board &board, int maxLength)
+{
+    std::vector<Move> pv;
+    std::vector<uint64_t> seen;
+    Board position = board;
+    Move moves[Board::MAX_MOVES];
+    while ((int)pv.size() < maxLength) {
+        TableEntry *entry = probe(position.hash());
+        if (!entry || std::find(seen.begin(), seen.end(), position.hash()) != seen.end()) break;
+        int count = position.generateMoves(moves);
+        if (entry->move >= count) break;
+        seen.push_back(position.hash());
+        pv.push_back(moves[entry->move]);
+        position.makeMove(moves[entry->move]);
+    }
+    return pv;
+}
+
+//
+// iterative deepening driver, returns the best move of the deepest completed iteration
+//
+template <class Board>
+typename DraughtsEngine<Board>::Result DraughtsEngine<Board>::search(const Board &board, const CheckersSearchLimits &limits)
+{
+    Result result;
+    _limits = limits;
+    _startTime = std::chrono::steady_clock::now();
+    _nodes = 0;
+    _tableHits = 0;
+    _stop = false;
+    std::memset(_history, 0, sizeof(_history));
+
+    Move moves[Board::MAX_MOVES];
+    int count = board.generateMoves(moves);
+    if (count == 0) return result;
+
+    // inside the database, play only moves that keep the result and let the search pick among
+    // them without probing positions of the same size, so it keeps heading for a conversion
+    _probePieces = _database ? _database->maxPieces() : 0;
+    int rootPieces = Bitboard::popCount(board.occupied());
+    if (_database && rootPieces <= _probePieces) {
+        count = filterByDatabase(board, moves, count);
+        _probePieces = rootPieces - 1;
+    }
+
+    result.bestMove = moves[0];
+    result.hasMove = true;
+    if (count == 1) {
+        result.depth = 1;
+        result.pv.assign(1, moves[0]);
+        return result;
+    }
+
+    int maxDepth = std::min(limits.maxDepth > 0 ? limits.maxDepth : MAX_PLY, MAX_PLY - 1);
+    for (int depth = 1; depth <= maxDepth; depth++) {
+        int alpha = -WIN_SCORE;
+        int beta = WIN_SCORE;
+        int bestScore = -WIN_SCORE;
+        int bestIndex = -1;
+
+        for (int i = 0; i < count; i++) {
+            Board child = board;
+            child.makeMove(moves[i]);
+            int score = -negamax(child, depth - 1, 1, -beta, -alpha);
+            if (_stop) break;
+            if (score > bestScore) {
+                bestScore = score;
+                bestIndex = i;
+                alpha = std::max(alpha, score);
+            }
+        }
+        if (_stop) {
+            // a move that beat the previous best in an unfinished iteration is still an improvement
+            if (bestIndex > 0) {
+                result.bestMove = moves[bestIndex];
+                result.score = bestScore;
+                result.pv.assign(1, moves[bestIndex]);
+            }
+            break;
+        }
+
+        // search the best move first next iteration
+        std::rotate(moves, moves + bestIndex, moves + bestIndex + 1);
+        result.bestMove = moves[0];
+        result.score = bestScore;
+        result.depth = depth;
+
+        Board child = board;
+        child.makeMove(moves[0]);
+        result.pv = principalVariation(child, depth - 1);
+        result.pv.insert(result.pv.begin(), moves[0]);
+        if (_onIteration) {
+            result.nodes = _nodes;
+            result.tableHits = _tableHits;
+            result.timeMs = (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _startTime).count();
+            _onIteration(result);
+        }
+
+        if (isWinScore(bestScore)) break;
+    }
+
+    result.nodes = _nodes;
+    result.tableHits = _tableHits;
+    result.timeMs = (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _startTime).count();
+    return result;
+}
+
+template class DraughtsEngine<CheckersBoard>;
+template class DraughtsEngine<InternationalBoard>;
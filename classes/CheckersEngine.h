@@ -0,0 +1,118 @@
+#pragma once
+
+#include "CheckersBoard.h"
+#include "CheckersDatabase.h"
+#include "InternationalBoard.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+//
+// limits for a single search, zero means unlimited
+//
+struct CheckersSearchLimits
+{
+    int         maxDepth = 64;
+    int         timeMs = 1000;
+    uint64_t    maxNodes = 0;
+    const std::atomic<bool> *stop = nullptr;    // the caller's, a stop set before the search starts still counts
+};
+
+template <class Board>
+struct DraughtsSearchResult
+{
+    using Move = typename Board::Move;
+
+    Move            bestMove;
+    bool            hasMove = false;
+    int             score = 0;
+    int             depth = 0;
+    uint64_t        nodes = 0;
+    uint64_t        tableHits = 0;
+    int             timeMs = 0;
+    std::vector<Move> pv;
+};
+
+//
+// alpha-beta search shared by the draughts variants, Board is CheckersBoard or InternationalBoard
+// iterative deepening, transposition table, history ordering and a capture-only quiescence search
+// an optional endgame database is probed at the root and inside the search (8x8 checkers only)
+// instantiated in CheckersEngine.cpp
+//
+template <class Board>
+class DraughtsEngine
+{
+public:
+    using Move = typename Board::Move;
+    using Result = DraughtsSearchResult<Board>;
+    // called after every completed iteration with the result so far
+    using IterationCallback = std::function<void(const Result &)>;
+
+    static constexpr int WIN_SCORE = 30000;
+    static constexpr int MAX_PLY = 128;
+    static constexpr int DATABASE_WIN_SCORE = 20000;
+
+    DraughtsEngine(int tableSizeMB = 16);
+
+    Result      search(const Board &board, const CheckersSearchLimits &limits);
+
+    // static evaluation from the side to move's point of view
+    static int  evaluate(const Board &board);
+
+    void        clearTable();
+    // largest power of two table that fits in bytes, the old entries are dropped
+    void        resizeTable(size_t bytes);
+    size_t      tableBytes() const { return _table.size() * sizeof(TableEntry); }
+    void        setDatabase(const CheckersDatabase *database) { _database = database; }
+    void        setIterationCallback(IterationCallback callback) { _onIteration = std::move(callback); }
+    void        stop() { _stop = true; }
+    uint64_t    nodes() const { return _nodes; }
+
+    static bool isWinScore(int score) { return score > WIN_SCORE - MAX_PLY || score < -WIN_SCORE + MAX_PLY; }
+    // a win or loss counted in plies from the root, either seen by the search or from the database
+    static bool isDecidedScore(int score) { return std::abs(score) > DATABASE_WIN_SCORE - MAX_PLY; }
+
+private:
+    enum Bound : uint8_t { BOUND_NONE, BOUND_UPPER, BOUND_LOWER, BOUND_EXACT };
+
+    struct TableEntry
+    {
+        uint64_t    key;
+        int16_t     score;
+        uint8_t     depth;
+        uint8_t     bound;
+        uint8_t     move;       // index into the position's generated move list
+    };
+
+    int         negamax(const Board &board, int depth, int ply, int alpha, int beta);
+    int         quiesce(const Board &board, int ply, int alpha, int beta);
+    void        orderMoves(Move *moves, int *scores, int count, int tableMove) const;
+    bool        checkLimits();
+    bool        probeDatabase(const Board &board, int ply, int &score);
+    int         filterByDatabase(const Board &board, Move *moves, int count);
+    std::vector<Move> principalVariation(const Board &board, int maxLength);
+
+    TableEntry* probe(uint64_t key);
+    void        store(uint64_t key, int depth, int ply, int score, Bound bound, int move);
+
+    std::vector<TableEntry>     _table;
+    uint64_t                    _tableMask;
+    int                         _history[Board::BITS][Board::BITS];
+
+    const CheckersDatabase*     _database;
+    int                         _probePieces;
+
+    std::atomic<bool>           _stop;
+    uint64_t                    _nodes;
+    uint64_t                    _tableHits;
+    CheckersSearchLimits        _limits;
+    std::chrono::steady_clock::time_point _startTime;
+    IterationCallback           _onIteration;
+};
+
+using CheckersEngine = DraughtsEngine<CheckersBoard>;
+using CheckersSearchResult = DraughtsSearchResult<CheckersBoard>;
+using InternationalEngine = DraughtsEngine<InternationalBoard>;
+using InternationalSearchResult = DraughtsSearchResult<InternationalBoard>;
@@ -0,0 +1,270 @@
+#include "Chess.h"
+#include "JobSystem.h"
+
+Chess::Chess() : Game() {
+    _grid = new Grid(8, 8);
+    _board = ChessBoard::initial();
+
+    if (_tablebase.open(TABLEBASE_DIRECTORY) > 0) {
+        _engine.setTablebase(&_tablebase);
+    }
+}
+
+Chess::~Chess() {
+    cancelAISearch();
+    delete _grid;
+}
+
+void Chess::setUpBoard() {
+    setNumberOfPlayers(2);
+    _gameOptions.rowX = 8;
+    _gameOptions.rowY = 8;
+
+    _grid->initializeSquares(80, "boardsquare.png");
+
+    _board = ChessBoard::initial();
+    _history.assign(1, _board.hash());
+    placePieces();
+
+    if (gameHasAI()) {
+        setAIPlayer(AI_PLAYER);
+    }
+
+    startGame();
+}
+
+Bit* Chess::createPiece(int color, int piece) {
+    // the white knight sprite ships as w_kinight.png
+    static const char* const names[] = { "pawn", "knight", "bishop", "rook", "queen", "king" };
+    std::string texture = color == ChessBoard::WHITE && piece == ChessBoard::KNIGHT
+        ? "w_kinight.png"
+        : std::string(color == ChessBoard::WHITE ? "w_" : "b_") + names[piece] + ".png";
+
+    Bit* bit = new Bit();
+    bit->LoadTextureFromFile(texture.c_str());
+    bit->setOwner(getPlayerAt(color == ChessBoard::WHITE ? WHITE_PLAYER : BLACK_PLAYER));
+    bit->setGameTag(piece + 1 + (color == ChessBoard::BLACK ? BLACK_TAG : 0));
+    return bit;
+}
+
+//
+// rebuild every piece on the grid from the board
+//
+void Chess::placePieces() {
+    _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
+        square->destroyBit();
+        int index = boardSquare(*square);
+        if (!_board.isEmpty(index)) {
+            Bit* piece = createPiece(_board.colorAt(index), _board.pieceAt(index));
+            piece->setPosition(square->getPosition());
+            square->setBit(piece);
+        }
+    });
+}
+
+//
+// conversions between grid squares and board squares, a1 is the bottom left
+//
+int Chess::boardSquare(BitHolder &holder) const {
+    ChessSquare* square = static_cast<ChessSquare*>(&holder);
+    return ChessBoard::squareAt(square->getColumn(), 7 - square->getRow());
+}
+
+ChessSquare* Chess::gridSquare(int square) const {
+    return _grid->getSquare(ChessBoard::fileOf(square), 7 - ChessBoard::rankOf(square));
+}
+
+bool Chess::actionForEmptyHolder(BitHolder &holder) {
+    return false;
+}
+
+bool Chess::canBitMoveFrom(Bit &bit, BitHolder &src) {
+    if (!src.bit() || bit.getOwner() != getCurrentPlayer()) return false;
+
+    int from = boardSquare(src);
+    ChessMove moves[ChessBoard::MAX_MOVES];
+    int count = _board.generateMoves(moves);
+    for (int i = 0; i < count; i++) {
+        if (moves[i].from() == from) return true;
+    }
+    return false;
+}
+
+bool Chess::canBitMoveFromTo(Bit &bit, BitHolder &src, BitHolder &dst) {
+    return !_board.findMove(boardSquare(src), boardSquare(dst)).isNull();
+}
+
+//
+// the dragged piece is already on dst and anything it landed on is gone,
+// the rest of the move happens here: en passant, the castling rook and promotion
+//
+void Chess::bitMovedFromTo(Bit &bit, BitHolder &src, BitHolder &dst) {
+    // pawns always promote to a queen when dragged
+    ChessMove move = _board.findMove(boardSquare(src), boardSquare(dst), ChessBoard::QUEEN);
+    if (move.isNull()) return;
+
+    if (move.flags() == ChessMove::EN_PASSANT) {
+        gridSquare(move.to() ^ 8)->destroyBit();
+    }
+    if (move.isCastle()) {
+        moveRookForCastle(move);
+    }
+    if (move.isPromotion()) {
+        int color = _board.sideToMove();
+        dst.destroyBit();
+        Bit* piece = createPiece(color, move.promotion());
+        piece->setPosition(dst.getPosition());
+        dst.setBit(piece);
+    }
+    finishMove(move);
+}
+
+void Chess::moveRookForCastle(const ChessMove &move) {
+    bool kingside = move.flags() == ChessMove::KING_CASTLE;
+    ChessSquare* rookFrom = gridSquare(kingside ? move.to() + 1 : move.to() - 2);
+    ChessSquare* rookTo = gridSquare(kingside ? move.to() - 1 : move.to() + 1);
+    Bit* rook = rookFrom->bit();
+    if (!rook) return;
+
+    rookTo->setBit(rook);
+    rookFrom->setBit(nullptr);
+    rook->moveTo(rookTo->getPosition());
+}
+
+//
+// play a move found by the engine on the grid, the same steps a drag and drop would take
+//
+void Chess::applyMove(const ChessMove &move) {
+    ChessSquare* src = gridSquare(move.from());
+    ChessSquare* dst = gridSquare(move.to());
+    Bit* bit = src->bit();
+    if (!bit) return;
+
+    if (move.flags() == ChessMove::EN_PASSANT) {
+        gridSquare(move.to() ^ 8)->destroyBit();
+    } else if (move.isCapture()) {
+        dst->destroyBit();
+    }
+    dst->setBit(bit);
+    src->setBit(nullptr);
+    bit->moveTo(dst->getPosition());
+
+    if (move.isCastle()) {
+        moveRookForCastle(move);
+    }
+    if (move.isPromotion()) {
+        int color = _board.sideToMove();
+        dst->destroyBit();
+        Bit* piece = createPiece(color, move.promotion());
+        piece->setPosition(dst->getPosition());
+        dst->setBit(piece);
+    }
+    finishMove(move);
+}
+
+void Chess::finishMove(const ChessMove &move) {
+    _board.makeMove(move);
+    if (_board.halfmoveClock() == 0) _history.clear();
+    _history.push_back(_board.hash());
+    endTurn();
+}
+
+Player* Chess::checkForWinner() {
+    // checkmate: no legal moves while in check
+    ChessMove moves[ChessBoard::MAX_MOVES];
+    if (_board.generateMoves(moves) == 0 && _board.inCheck()) {
+        return getPlayerAt(_board.sideToMove() == ChessBoard::WHITE ? BLACK_PLAYER : WHITE_PLAYER);
+    }
+    return nullptr;
+}
+
+//
+// the current position has appeared three times, only positions since the last irreversible move can match
+//
+bool Chess::isRepetition() const {
+    int seen = 0;
+    for (uint64_t hash : _history) {
+        if (hash == _board.hash()) seen++;
+    }
+    return seen >= 3;
+}
+
+bool Chess::insufficientMaterial() const {
+    uint64_t heavy = 0;
+    for (int color = 0; color < 2; color++) {
+        heavy |= _board.pieces(color, ChessBoard::PAWN) | _board.pieces(color, ChessBoard::ROOK) | _board.pieces(color, ChessBoard::QUEEN);
+    }
+    if (heavy) return false;
+
+    // bare kings, or a single minor piece on the board
+    uint64_t minors = _board.occupied() & ~(_board.pieces(ChessBoard::WHITE, ChessBoard::KING) | _board.pieces(ChessBoard::BLACK, ChessBoard::KING));
+    return Bitboard::popCount(minors) <= 1;
+}
+
+bool Chess::checkForDraw() {
+    ChessMove moves[ChessBoard::MAX_MOVES];
+    if (_board.generateMoves(moves) == 0) return !_board.inCheck();
+    return _board.halfmoveClock() >= 100 || isRepetition() || insufficientMaterial();
+}
+
+void Chess::stopGame() {
+    cancelAISearch();
+    _grid->forEachSquare([](ChessSquare* square, int x, int y) {
+        square->destroyBit();
+    });
+    _board = ChessBoard::initial();
+    _history.clear();
+}
+
+std::string Chess::initialStateString() {
+    return ChessBoard::START_FEN;
+}
+
+std::string Chess::stateString() {
+    return _board.toFen();
+}
+
+void Chess::setStateString(const std::string &s) {
+    cancelAISearch();
+    if (!_board.fromFen(s)) return;
+    _history.assign(1, _board.hash());
+    placePieces();
+}
+
+//
+// checks on the search once a frame so the board keeps drawing while the AI thinks
+//
+void Chess::updateAI() {
+    if (!_aiSearch.valid()) startAISearch();
+    if (_aiSearch.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+
+    ChessSearchResult result = _aiSearch.get();
+    if (!result.hasMove || _board.hash() != _aiSearchHash) return;
+    applyMove(result.bestMove);
+}
+
+//
+// the job owns copies of the board and history, only the engine is shared and nothing else uses it
+// while a search is out. without worker threads the job runs here before submit returns
+//
+void Chess::startAISearch() {
+    ChessSearchLimits limits;
+    limits.timeMs = AI_TIME_BUDGET_MS;
+    limits.threads = JobSystem::instance().workerCount();
+    _aiStopRequested = false;
+    limits.stop = &_aiStopRequested;
+    _aiSearchHash = _board.hash();
+
+    auto result = std::make_shared<std::promise<ChessSearchResult>>();
+    _aiSearch = result->get_future();
+    JobSystem::instance().submit([this, board = _board, history = _history, limits, result]() {
+        result->set_value(_engine.search(board, limits, history));
+    }, JobPriority::HIGH);
+}
+
+void Chess::cancelAISearch() {
+    if (!_aiSearch.valid()) return;
+    _aiStopRequested = true;
+    _aiSearch.wait();
+    _aiSearch = std::future<ChessSearchResult>();
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "Game.h"
+#include "ChessBoard.h"
+#include "ChessEngine.h"
+#include <atomic>
+#include <future>
+#include <vector>
+
+//
+// chess on an 8x8 Grid of ChessSquares, the rules run on a bitboard ChessBoard and the Grid mirrors it
+// grid row 0 is the eighth rank so white plays up the screen
+// piece game tags are the piece type + 1, with 128 added for black so ChessSquare can tell captures apart
+//
+class Chess : public Game
+{
+public:
+    Chess();
+    ~Chess();
+
+    // Required virtual methods from Game base class
+    void        setUpBoard() override;
+    Player*     checkForWinner() override;
+    bool        checkForDraw() override;
+    std::string initialStateString() override;
+    std::string stateString() override;
+    void        setStateString(const std::string &s) override;
+    bool        actionForEmptyHolder(BitHolder &holder) override;
+    bool        canBitMoveFrom(Bit &bit, BitHolder &src) override;
+    bool        canBitMoveFromTo(Bit &bit, BitHolder &src, BitHolder &dst) override;
+    void        stopGame() override;
+    void        bitMovedFromTo(Bit &bit, BitHolder &src, BitHolder &dst) override;
+
+    // AI methods
+    void        updateAI() override;
+    bool        gameHasAI() override { return true; }
+    Grid* getGrid() override { return _grid; }
+
+    const ChessBoard& getBoard() const { return _board; }
+
+private:
+    // Player constants, white moves first
+    static const int WHITE_PLAYER = 0;
+    static const int BLACK_PLAYER = 1;
+
+    static const int BLACK_TAG = 128;
+
+    // AI thinking time per move
+    static const int AI_TIME_BUDGET_MS = 1000;
+
+    // tablebases built by tools/chess_tablebase, optional
+    static constexpr const char *TABLEBASE_DIRECTORY = "egdb/chess";
+
+    // Helper methods
+    Bit*        createPiece(int color, int piece);
+    void        placePieces();
+    int         boardSquare(BitHolder &holder) const;
+    ChessSquare* gridSquare(int square) const;
+    void        moveRookForCastle(const ChessMove &move);
+    void        finishMove(const ChessMove &move);
+    void        applyMove(const ChessMove &move);
+    bool        isRepetition() const;
+    bool        insufficientMaterial() const;
+    void        startAISearch();
+    void        cancelAISearch();
+
+    // Board representation
+    Grid*       _grid;
+    ChessBoard  _board;
+    ChessEngine _engine;
+    ChessTablebase _tablebase;
+
+    // hashes of the positions since the last capture or pawn move, for repetitions
+    std::vector<uint64_t> _history;
+
+    // the AI's search runs as a job on a copy of the board, updateAI plays its move once it is done
+    std::future<ChessSearchResult> _aiSearch;
+    std::atomic<bool> _aiStopRequested{ false };
+    uint64_t    _aiSearchHash = 0;      // the board the search is for
+};
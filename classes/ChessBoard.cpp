@@ -0,0 +1,670 @@
+#include "ChessBoard.h"
+#include <cctype>
+#include <cstring>
+#include <sstream>
+
+namespace {
+    //
+    // zobrist keys for (color, piece, square), castling rights, en passant file and the side to move
+    //
+    struct ChessZobrist
+    {
+        uint64_t piece[2][6][64];
+        uint64_t castling[16];
+        uint64_t enPassant[8];
+        uint64_t side;
+    };
+
+    constexpr ChessZobrist makeZobrist()
+    {
+        ChessZobrist z{};
+        uint64_t state = 0xC4E55B0A4Dull;
+        for (int c = 0; c < 2; c++) {
+            for (int p = 0; p < 6; p++) {
+                for (int s = 0; s < 64; s++) z.piece[c][p][s] = Bitboard::splitMix64(state);
+            }
+        }
+        for (int i = 0; i < 16; i++) z.castling[i] = Bitboard::splitMix64(state);
+        for (int i = 0; i < 8; i++) z.enPassant[i] = Bitboard::splitMix64(state);
+        z.side = Bitboard::splitMix64(state);
+        return z;
+    }
+
+    constexpr ChessZobrist ZOBRIST = makeZobrist();
+
+    const uint64_t FILE_A = 0x0101010101010101ull;
+    const uint64_t FILE_H = FILE_A << 7;
+    const uint64_t RANK_1 = 0xFFull;
+    const uint64_t RANK_3 = RANK_1 << 16;
+    const uint64_t RANK_6 = RANK_1 << 40;
+    const uint64_t RANK_8 = RANK_1 << 56;
+
+    const char PIECE_CHARS[] = "pnbrqk";
+
+    //
+    // slider attacks by walking the rays, only used to build the magic tables
+    //
+    uint64_t slidingAttacks(int square, uint64_t occupancy, const int (*directions)[2])
+    {
+        uint64_t attacks = 0;
+        for (int d = 0; d < 4; d++) {
+            int file = square & 7, rank = square >> 3;
+            while (true) {
+                file += directions[d][0];
+                rank += directions[d][1];
+                if (file < 0 || file > 7 || rank < 0 || rank > 7) break;
+                uint64_t bit = 1ull << (rank * 8 + file);
+                attacks |= bit;
+                if (occupancy & bit) break;
+            }
+        }
+        return attacks;
+    }
+
+    const int BISHOP_DIRECTIONS[4][2] = { { 1, 1 }, { 1, -1 }, { -1, 1 }, { -1, -1 } };
+    const int ROOK_DIRECTIONS[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+
+    //
+    // magic multipliers, found once with a seeded random search over sparse 64-bit numbers
+    //
+    const uint64_t BISHOP_MAGICS[64] = {
+        0x21120C2C08020020ull, 0x0002102101010003ull, 0x20040104210CA000ull, 0xBC04040088400808ull,
+        0x0241104100000001ull, 0x2131140240401400ull, 0x000844306C1000A0ull, 0x6014808080904004ull,
+        0x00412120022A0040ull, 0x0800600811404281ull, 0x0000100404803800ull, 0xC020180600420000ull,
+        0x0106011040842800ull, 0x1000811008040014ull, 0x1100020104024020ull, 0x90080088A4100200ull,
+        0x0040809202080128ull, 0x004800206800C080ull, 0x0008004108010112ull, 0x400800040125A040ull,
+        0x1214006C80A00604ull, 0x0202004040502400ull, 0x005080A402011048ull, 0x00020A0D80A40100ull,
+        0x08A010282064110Cull, 0x1101206008280100ull, 0x8080208010008080ull, 0x0940802018020120ull,
+        0x0021004004004040ull, 0x0202830012010480ull, 0x000C240088860106ull, 0x080212000821010Aull,
+        0x0050042000120200ull, 0x4101042080100100ull, 0x1008140482100300ull, 0x4000020081080080ull,
+        0x00A4010012440040ull, 0x0401C0A5000A0062ull, 0x0010010044020240ull, 0x2091234200010510ull,
+        0x0004044440820401ull, 0x00004C0220002880ull, 0x8000108401001000ull, 0x0000314208000380ull,
+        0x0820180104001441ull, 0x111020020C100820ull, 0x1410238304108502ull, 0xC008090402804C30ull,
+        0x0C0041041040001Bull, 0x2003A88230108021ull, 0x0040050041100980ull, 0x0010000308480208ull,
+        0x2020009002022800ull, 0x0608081090208004ull, 0x0684080898088000ull, 0x0204100202002818ull,
+        0x00C0410808420200ull, 0x2014010048020802ull, 0x100C0C0042080420ull, 0x010808812C840408ull,
+        0x0009000110221202ull, 0x0C00004248010104ull, 0x0000125001110C10ull, 0x22082004C20D4100ull
+    };
+
+    const uint64_t ROOK_MAGICS[64] = {
+        0x0080018840015420ull, 0x0540100420014002ull, 0x0100110008402004ull, 0x0900100100200408ull,
+        0x2A00200200080410ull, 0x6080040002008001ull, 0x4280020000800100ull, 0x0180004100002480ull,
+        0x0020800232400280ull, 0x0189402010004001ull, 0x0008802000801008ull, 0x8082001008204204ull,
+        0x0022000A00201004ull, 0x0804802400020080ull, 0x2114001001080204ull, 0x0001800500004080ull,
+        0x8040208000400080ull, 0x4110820022420300ull, 0x0000808010002002ull, 0x0000090010002100ull,
+        0x0000808004000802ull, 0x0002008002040080ull, 0x08E0040001100208ull, 0x8288060000A24C03ull,
+        0x8800802080004000ull, 0x8090500040002000ull, 0x9020010100104020ull, 0x200A001200200840ull,
+        0x020C000808004080ull, 0x0002000200100804ull, 0x0001002100141200ull, 0x0080014200209904ull,
+        0x0080814001800024ull, 0x8410002000404002ull, 0x0220A00082803000ull, 0x0000080080801000ull,
+        0x8404008008080040ull, 0x4006000402000810ull, 0x0801020804005001ull, 0x4400800040800100ull,
+        0x044018C221808000ull, 0x1021500320044000ull, 0x3006048020120041ull, 0x1270008008008010ull,
+        0x2054000800808004ull, 0x40C1000804010002ull, 0x05800208410400B0ull, 0x0640508061160004ull,
+        0x202040118000A280ull, 0x0020084008802080ull, 0x0008204080120200ull, 0x4101A30210000900ull,
+        0x090500C800045100ull, 0x000200E4000E8080ull, 0x0030500102884400ull, 0x1900404401008200ull,
+        0x8010800010204109ull, 0x2020108900244001ull, 0x9000084011002001ull, 0x1042442100C81001ull,
+        0x1409000210040801ull, 0x0112000811041016ull, 0x197A100802008104ull, 0x0928840102815422ull
+    };
+
+    struct Magic
+    {
+        uint64_t    mask;
+        uint64_t    magic;
+        uint64_t*   attacks;
+        int         shift;
+
+        uint64_t    index(uint64_t occupancy) const { return ((occupancy & mask) * magic) >> shift; }
+    };
+
+    //
+    // every attack table, built once at startup
+    //
+    struct AttackTables
+    {
+        uint64_t    knight[64];
+        uint64_t    king[64];
+        uint64_t    pawn[2][64];
+        Magic       bishop[64];
+        Magic       rook[64];
+        uint64_t    between[64][64];
+        uint64_t    line[64][64];
+        uint64_t    bishopTable[0x1480];
+        uint64_t    rookTable[0x19000];
+
+        AttackTables();
+        void initMagics(Magic *magics, const uint64_t *multipliers, uint64_t *table, const int (*directions)[2]);
+    };
+
+    AttackTables::AttackTables()
+    {
+        for (int s = 0; s < 64; s++) {
+            int file = s & 7, rank = s >> 3;
+            knight[s] = king[s] = pawn[0][s] = pawn[1][s] = 0;
+            const int knightSteps[8][2] = { { 1, 2 }, { 2, 1 }, { 2, -1 }, { 1, -2 }, { -1, -2 }, { -2, -1 }, { -2, 1 }, { -1, 2 } };
+            for (auto &step : knightSteps) {
+                int f = file + step[0], r = rank + step[1];
+                if (f >= 0 && f < 8 && r >= 0 && r < 8) knight[s] |= 1ull << (r * 8 + f);
+            }
+            for (int df = -1; df <= 1; df++) {
+                for (int dr = -1; dr <= 1; dr++) {
+                    int f = file + df, r = rank + dr;
+                    if ((df || dr) && f >= 0 && f < 8 && r >= 0 && r < 8) king[s] |= 1ull << (r * 8 + f);
+                }
+            }
+            for (int df = -1; df <= 1; df += 2) {
+                int f = file + df;
+                if (f < 0 || f > 7) continue;
+                if (rank < 7) pawn[ChessBoard::WHITE][s] |= 1ull << ((rank + 1) * 8 + f);
+                if (rank > 0) pawn[ChessBoard::BLACK][s] |= 1ull << ((rank - 1) * 8 + f);
+            }
+        }
+
+        initMagics(bishop, BISHOP_MAGICS, bishopTable, BISHOP_DIRECTIONS);
+        initMagics(rook, ROOK_MAGICS, rookTable, ROOK_DIRECTIONS);
+
+        for (int a = 0; a < 64; a++) {
+            for (int b = 0; b < 64; b++) {
+                between[a][b] = line[a][b] = 0;
+                if (a == b) continue;
+                uint64_t bBit = 1ull << b;
+                uint64_t aBit = 1ull << a;
+                if (slidingAttacks(a, 0, BISHOP_DIRECTIONS) & bBit) {
+                    between[a][b] = slidingAttacks(a, bBit, BISHOP_DIRECTIONS) & slidingAttacks(b, aBit, BISHOP_DIRECTIONS);
+                    line[a][b] = (slidingAttacks(a, 0, BISHOP_DIRECTIONS) & slidingAttacks(b, 0, BISHOP_DIRECTIONS)) | aBit | bBit;
+                } else if (slidingAttacks(a, 0, ROOK_DIRECTIONS) & bBit) {
+                    between[a][b] = slidingAttacks(a, bBit, ROOK_DIRECTIONS) & slidingAttacks(b, aBit, ROOK_DIRECTIONS);
+                    line[a][b] = (slidingAttacks(a, 0, ROOK_DIRECTIONS) & slidingAttacks(b, 0, ROOK_DIRECTIONS)) | aBit | bBit;
+                }
+            }
+        }
+    }
+
+    void AttackTables::initMagics(Magic *magics, const uint64_t *multipliers, uint64_t *table, const int (*directions)[2])
+    {
+        uint64_t *next = table;
+        for (int s = 0; s < 64; s++) {
+            // edges don't change the attacks, unless the slider stands on them
+            uint64_t edges = ((RANK_1 | RANK_8) & ~(RANK_1 << (8 * (s >> 3)))) | ((FILE_A | FILE_H) & ~(FILE_A << (s & 7)));
+            Magic &m = magics[s];
+            m.mask = slidingAttacks(s, 0, directions) & ~edges;
+            m.magic = multipliers[s];
+            m.shift = 64 - Bitboard::popCount(m.mask);
+            m.attacks = next;
+
+            // carry-rippler walk over every subset of the mask
+            uint64_t subset = 0;
+            do {
+                m.attacks[m.index(subset)] = slidingAttacks(s, subset, directions);
+                subset = (subset - m.mask) & m.mask;
+            } while (subset);
+            next += 1ull << Bitboard::popCount(m.mask);
+        }
+    }
+
+    const AttackTables TABLES;
+
+    // castling rights kept after a move touches a square
+    struct CastlingMasks
+    {
+        int keep[64];
+        constexpr CastlingMasks() : keep()
+        {
+            for (int s = 0; s < 64; s++) keep[s] = 15;
+            keep[0] = 15 & ~ChessBoard::WHITE_QUEENSIDE;
+            keep[7] = 15 & ~ChessBoard::WHITE_KINGSIDE;
+            keep[4] = 15 & ~(ChessBoard::WHITE_KINGSIDE | ChessBoard::WHITE_QUEENSIDE);
+            keep[56] = 15 & ~ChessBoard::BLACK_QUEENSIDE;
+            keep[63] = 15 & ~ChessBoard::BLACK_KINGSIDE;
+            keep[60] = 15 & ~(ChessBoard::BLACK_KINGSIDE | ChessBoard::BLACK_QUEENSIDE);
+        }
+    };
+
+    constexpr CastlingMasks CASTLING_MASKS;
+
+    std::string squareName(int square)
+    {
+        return std::string(1, (char)('a' + (square & 7))) + (char)('1' + (square >> 3));
+    }
+}
+
+int ChessMove::promotion() const
+{
+    return ChessBoard::KNIGHT + (flags() & 3);
+}
+
+std::string ChessMove::toString() const
+{
+    if (isNull()) return "0000";
+    std::string text = squareName(from()) + squareName(to());
+    if (isPromotion()) text += PIECE_CHARS[promotion()];
+    return text;
+}
+
+uint64_t ChessBoard::knightAttacks(int square) { return TABLES.knight[square]; }
+uint64_t ChessBoard::kingAttacks(int square) { return TABLES.king[square]; }
+uint64_t ChessBoard::pawnAttacks(int color, int square) { return TABLES.pawn[color][square]; }
+uint64_t ChessBoard::between(int a, int b) { return TABLES.between[a][b]; }
+uint64_t ChessBoard::line(int a, int b) { return TABLES.line[a][b]; }
+
+uint64_t ChessBoard::bishopAttacks(int square, uint64_t occupancy)
+{
+    const Magic &m = TABLES.bishop[square];
+    return m.attacks[m.index(occupancy)];
+}
+
+uint64_t ChessBoard::rookAttacks(int square, uint64_t occupancy)
+{
+    const Magic &m = TABLES.rook[square];
+    return m.attacks[m.index(occupancy)];
+}
+
+ChessBoard::ChessBoard()
+{
+    std::memset(_pieces, 0, sizeof(_pieces));
+    _colors[WHITE] = _colors[BLACK] = 0;
+    std::memset(_board, NO_PIECE, sizeof(_board));
+    _side = WHITE;
+    _castling = 0;
+    _epSquare = NO_SQUARE;
+    _halfmove = 0;
+    _fullmove = 1;
+    _hash = 0;
+}
+
+ChessBoard ChessBoard::initial()
+{
+    ChessBoard board;
+    board.fromFen(START_FEN);
+    return board;
+}
+
+void ChessBoard::setPiece(int square, int color, int piece)
+{
+    clearSquare(square);
+    uint64_t bit = 1ull << square;
+    _pieces[color][piece] |= bit;
+    _colors[color] |= bit;
+    _board[square] = (uint8_t)(color << 3 | piece);
+    _hash ^= ZOBRIST.piece[color][piece][square];
+}
+
+void ChessBoard::clearSquare(int square)
+{
+    int piece = pieceAt(square);
+    if (piece == NO_PIECE) return;
+    int color = colorAt(square);
+    uint64_t bit = 1ull << square;
+    _pieces[color][piece] &= ~bit;
+    _colors[color] &= ~bit;
+    _board[square] = NO_PIECE;
+    _hash ^= ZOBRIST.piece[color][piece][square];
+}
+
+void ChessBoard::setSideToMove(int color)
+{
+    if (color != _side) _hash ^= ZOBRIST.side;
+    _side = color;
+}
+
+ChessBoard ChessBoard::mirrored() const
+{
+    ChessBoard board;
+    for (int square = 0; square < 64; square++) {
+        if (!isEmpty(square)) board.setPiece(square ^ 56, colorAt(square) ^ 1, pieceAt(square));
+    }
+    board.setSideToMove(_side ^ 1);
+
+    // white's castling rights are the low two bits, black's the high two
+    board._castling = ((_castling & 3) << 2) | (_castling >> 2);
+    board._hash ^= ZOBRIST.castling[board._castling];
+    if (_epSquare != NO_SQUARE) {
+        board._epSquare = _epSquare ^ 56;
+        board._hash ^= ZOBRIST.enPassant[board._epSquare & 7];
+    }
+    board._halfmove = _halfmove;
+    board._fullmove = _fullmove;
+    return board;
+}
+
+uint64_t ChessBoard::attackersTo(int square, uint64_t occupancy) const
+{
+    uint64_t bishops = _pieces[WHITE][BISHOP] | _pieces[BLACK][BISHOP] | _pieces[WHITE][QUEEN] | _pieces[BLACK][QUEEN];
+    uint64_t rooks = _pieces[WHITE][ROOK] | _pieces[BLACK][ROOK] | _pieces[WHITE][QUEEN] | _pieces[BLACK][QUEEN];
+    return (TABLES.pawn[BLACK][square] & _pieces[WHITE][PAWN]) |
+           (TABLES.pawn[WHITE][square] & _pieces[BLACK][PAWN]) |
+           (TABLES.knight[square] & (_pieces[WHITE][KNIGHT] | _pieces[BLACK][KNIGHT])) |
+           (TABLES.king[square] & (_pieces[WHITE][KING] | _pieces[BLACK][KING])) |
+           (bishopAttacks(square, occupancy) & bishops) |
+           (rookAttacks(square, occupancy) & rooks);
+}
+
+bool ChessBoard::isAttacked(int square, int byColor) const
+{
+    return (attackersTo(square, occupied()) & _colors[byColor]) != 0;
+}
+
+bool ChessBoard::inCheck() const
+{
+    return isAttacked(kingSquare(_side), _side ^ 1);
+}
+
+//
+// pieces of color that shield their own king from an enemy slider
+//
+uint64_t ChessBoard::pinnedPieces(int color) const
+{
+    int king = kingSquare(color);
+    int them = color ^ 1;
+    uint64_t snipers = (rookAttacks(king, 0) & (_pieces[them][ROOK] | _pieces[them][QUEEN])) |
+                       (bishopAttacks(king, 0) & (_pieces[them][BISHOP] | _pieces[them][QUEEN]));
+    uint64_t occupancy = occupied();
+    uint64_t pinned = 0;
+    while (snipers) {
+        int sniper = Bitboard::popLowestBit(snipers);
+        uint64_t blockers = TABLES.between[king][sniper] & occupancy;
+        if (blockers && !(blockers & (blockers - 1))) pinned |= blockers & _colors[color];
+    }
+    return pinned;
+}
+
+//
+// en passant removes two pieces from one rank, so it can uncover a slider in ways pins don't catch
+//
+bool ChessBoard::enPassantIsLegal(int from, int to) const
+{
+    int us = _side, them = us ^ 1;
+    int king = kingSquare(us);
+    int captured = to ^ 8;
+    uint64_t occupancy = (occupied() ^ (1ull << from) ^ (1ull << captured)) | (1ull << to);
+    return !(bishopAttacks(king, occupancy) & (_pieces[them][BISHOP] | _pieces[them][QUEEN])) &&
+           !(rookAttacks(king, occupancy) & (_pieces[them][ROOK] | _pieces[them][QUEEN]));
+}
+
+template <bool CAPTURES_ONLY>
+int ChessBoard::generate(ChessMove *moves) const
+{
+    int count = 0;
+    int us = _side, them = us ^ 1;
+    uint64_t own = _colors[us];
+    uint64_t enemy = _colors[them];
+    uint64_t occupancy = own | enemy;
+    int king = kingSquare(us);
+    uint64_t checkers = attackersTo(king, occupancy) & enemy;
+
+    // king moves, tested with the king lifted off the board so it can't hide behind itself
+    uint64_t kingTargets = TABLES.king[king] & (CAPTURES_ONLY ? enemy : ~own);
+    uint64_t withoutKing = occupancy ^ (1ull << king);
+    while (kingTargets) {
+        int to = Bitboard::popLowestBit(kingTargets);
+        if (attackersTo(to, withoutKing) & enemy) continue;
+        moves[count++] = ChessMove(king, to, (enemy >> to) & 1 ? ChessMove::CAPTURE : ChessMove::QUIET);
+    }
+
+    // in double check only the king can move
+    if (checkers & (checkers - 1)) return count;
+
+    // with one checker every other move has to capture it or block
+    uint64_t targets = checkers ? TABLES.between[king][Bitboard::lowestBit(checkers)] | checkers : ~0ull;
+    uint64_t pinned = pinnedPieces(us);
+
+    // knights, bishops, rooks and queens
+    for (int piece = KNIGHT; piece <= QUEEN; piece++) {
+        uint64_t movers = _pieces[us][piece];
+        if (piece == KNIGHT) movers &= ~pinned;   // a pinned knight never moves
+        while (movers) {
+            int from = Bitboard::popLowestBit(movers);
+            uint64_t attacks;
+            switch (piece) {
+                case KNIGHT: attacks = TABLES.knight[from]; break;
+                case BISHOP: attacks = bishopAttacks(from, occupancy); break;
+                case ROOK:   attacks = rookAttacks(from, occupancy); break;
+                default:     attacks = queenAttacks(from, occupancy); break;
+            }
+            attacks &= targets & (CAPTURES_ONLY ? enemy : ~own);
+            if (pinned & (1ull << from)) attacks &= TABLES.line[king][from];
+            while (attacks) {
+                int to = Bitboard::popLowestBit(attacks);
+                moves[count++] = ChessMove(from, to, (enemy >> to) & 1 ? ChessMove::CAPTURE : ChessMove::QUIET);
+            }
+        }
+    }
+
+    // pawns, one at a time so pins and promotions stay simple
+    uint64_t empty = ~occupancy;
+    uint64_t promotionRank = us == WHITE ? RANK_8 : RANK_1;
+    uint64_t doubleRank = us == WHITE ? RANK_3 : RANK_6;
+    int forward = us == WHITE ? 8 : -8;
+    uint64_t pawns = _pieces[us][PAWN];
+    while (pawns) {
+        int from = Bitboard::popLowestBit(pawns);
+        uint64_t allowed = targets;
+        if (pinned & (1ull << from)) allowed &= TABLES.line[king][from];
+
+        uint64_t quiet = 0;
+        uint64_t single = (1ull << (from + forward)) & empty;
+        if (single) {
+            quiet = single;
+            if (!CAPTURES_ONLY && (single & doubleRank)) {
+                int to = from + 2 * forward;
+                if (((empty >> to) & 1) && ((allowed >> to) & 1)) moves[count++] = ChessMove(from, to, ChessMove::DOUBLE_PUSH);
+            }
+        }
+        quiet &= allowed;
+        uint64_t captures = TABLES.pawn[us][from] & enemy & allowed;
+
+        // promotions count as tactical moves, plain pushes don't
+        if (quiet && (quiet & promotionRank)) {
+            int to = Bitboard::lowestBit(quiet);
+            for (int piece = QUEEN; piece >= KNIGHT; piece--) moves[count++] = ChessMove(from, to, ChessMove::PROMOTION | (piece - KNIGHT));
+        } else if (quiet && !CAPTURES_ONLY) {
+            moves[count++] = ChessMove(from, Bitboard::lowestBit(quiet), ChessMove::QUIET);
+        }
+        while (captures) {
+            int to = Bitboard::popLowestBit(captures);
+            if ((1ull << to) & promotionRank) {
+                for (int piece = QUEEN; piece >= KNIGHT; piece--) {
+                    moves[count++] = ChessMove(from, to, ChessMove::PROMOTION | ChessMove::CAPTURE | (piece - KNIGHT));
+                }
+            } else {
+                moves[count++] = ChessMove(from, to, ChessMove::CAPTURE);
+            }
+        }
+
+        // the captured pawn may be the checker even though the landing square doesn't block
+        if (_epSquare != NO_SQUARE && (TABLES.pawn[us][from] & (1ull << _epSquare))) {
+            int captured = _epSquare ^ 8;
+            bool resolves = !checkers || (checkers & (1ull << captured)) || (targets & (1ull << _epSquare));
+            if (resolves && enPassantIsLegal(from, _epSquare)) moves[count++] = ChessMove(from, _epSquare, ChessMove::EN_PASSANT);
+        }
+    }
+
+    // castling, the king may not start, pass or land on an attacked square
+    if (!CAPTURES_ONLY && !checkers) {
+        int rights = us == WHITE ? _castling & (WHITE_KINGSIDE | WHITE_QUEENSIDE) : _castling & (BLACK_KINGSIDE | BLACK_QUEENSIDE);
+        int base = us == WHITE ? 0 : 56;
+        if ((rights & (WHITE_KINGSIDE | BLACK_KINGSIDE)) && !(occupancy & (3ull << (base + 5))) &&
+            !isAttacked(base + 5, them) && !isAttacked(base + 6, them)) {
+            moves[count++] = ChessMove(base + 4, base + 6, ChessMove::KING_CASTLE);
+        }
+        if ((rights & (WHITE_QUEENSIDE | BLACK_QUEENSIDE)) && !(occupancy & (7ull << (base + 1))) &&
+            !isAttacked(base + 3, them) && !isAttacked(base + 2, them)) {
+            moves[count++] = ChessMove(base + 4, base + 2, ChessMove::QUEEN_CASTLE);
+        }
+    }
+    return count;
+}
+
+int ChessBoard::generateMoves(ChessMove *moves) const
+{
+    return generate<false>(moves);
+}
+
+int ChessBoard::generateCaptures(ChessMove *moves) const
+{
+    return generate<true>(moves);
+}
+
+void ChessBoard::makeMove(const ChessMove &move)
+{
+    int from = move.from(), to = move.to(), flags = move.flags();
+    int us = _side, them = us ^ 1;
+    int piece = pieceAt(from);
+
+    if (_epSquare != NO_SQUARE) _hash ^= ZOBRIST.enPassant[_epSquare & 7];
+    _epSquare = NO_SQUARE;
+    _halfmove++;
+
+    if (move.isCapture()) {
+        clearSquare(flags == ChessMove::EN_PASSANT ? to ^ 8 : to);
+        _halfmove = 0;
+    }
+
+    clearSquare(from);
+    setPiece(to, us, move.isPromotion() ? move.promotion() : piece);
+
+    if (piece == PAWN) {
+        _halfmove = 0;
+        // only record en passant when it can actually be played, so equal positions hash equally
+        if (flags == ChessMove::DOUBLE_PUSH) {
+            int square = (from + to) / 2;
+            if (TABLES.pawn[us][square] & _pieces[them][PAWN]) {
+                _epSquare = square;
+                _hash ^= ZOBRIST.enPassant[square & 7];
+            }
+        }
+    } else if (flags == ChessMove::KING_CASTLE) {
+        clearSquare(to + 1);
+        setPiece(to - 1, us, ROOK);
+    } else if (flags == ChessMove::QUEEN_CASTLE) {
+        clearSquare(to - 2);
+        setPiece(to + 1, us, ROOK);
+    }
+
+    _hash ^= ZOBRIST.castling[_castling];
+    _castling &= CASTLING_MASKS.keep[from] & CASTLING_MASKS.keep[to];
+    _hash ^= ZOBRIST.castling[_castling];
+
+    if (us == BLACK) _fullmove++;
+    _side = them;
+    _hash ^= ZOBRIST.side;
+}
+
+void ChessBoard::makeNullMove()
+{
+    if (_epSquare != NO_SQUARE) _hash ^= ZOBRIST.enPassant[_epSquare & 7];
+    _epSquare = NO_SQUARE;
+    _halfmove++;
+    _side ^= 1;
+    _hash ^= ZOBRIST.side;
+}
+
+ChessMove ChessBoard::findMove(int from, int to, int promotion) const
+{
+    ChessMove moves[MAX_MOVES];
+    int count = generateMoves(moves);
+    for (int i = 0; i < count; i++) {
+        if (moves[i].from() != from || moves[i].to() != to) continue;
+        if (moves[i].isPromotion() && moves[i].promotion() != promotion) continue;
+        return moves[i];
+    }
+    return ChessMove();
+}
+
+ChessMove ChessBoard::parseMove(const std::string &text) const
+{
+    if (text.length() < 4) return ChessMove();
+    int from = squareAt(text[0] - 'a', text[1] - '1');
+    int to = squareAt(text[2] - 'a', text[3] - '1');
+    if (from < 0 || from > 63 || to < 0 || to > 63) return ChessMove();
+
+    int promotion = QUEEN;
+    if (text.length() > 4) {
+        const char *found = strchr(PIECE_CHARS, text[4]);
+        if (found && *found) promotion = (int)(found - PIECE_CHARS);
+    }
+    return findMove(from, to, promotion);
+}
+
+bool ChessBoard::fromFen(const std::string &fen)
+{
+    std::istringstream stream(fen);
+    std::string placement, side, castling, enPassant;
+    int halfmove = 0, fullmove = 1;
+    stream >> placement >> side >> castling >> enPassant;
+    if (placement.empty()) return false;
+    stream >> halfmove >> fullmove;
+
+    *this = ChessBoard();
+    int file = 0, rank = 7;
+    for (char c : placement) {
+        if (c == '/') {
+            file = 0;
+            rank--;
+        } else if (c >= '1' && c <= '8') {
+            file += c - '0';
+        } else {
+            const char *found = strchr(PIECE_CHARS, tolower(c));
+            if (!found || !*found || file > 7 || rank < 0) return false;
+            setPiece(squareAt(file, rank), isupper(c) ? WHITE : BLACK, (int)(found - PIECE_CHARS));
+            file++;
+        }
+    }
+    if (Bitboard::popCount(_pieces[WHITE][KING]) != 1 || Bitboard::popCount(_pieces[BLACK][KING]) != 1) return false;
+
+    _side = side == "b" ? BLACK : WHITE;
+    if (_side == BLACK) _hash ^= ZOBRIST.side;
+
+    for (char c : castling) {
+        if (c == 'K') _castling |= WHITE_KINGSIDE;
+        if (c == 'Q') _castling |= WHITE_QUEENSIDE;
+        if (c == 'k') _castling |= BLACK_KINGSIDE;
+        if (c == 'q') _castling |= BLACK_QUEENSIDE;
+    }
+    _hash ^= ZOBRIST.castling[_castling];
+
+    if (enPassant.length() == 2) {
+        int square = squareAt(enPassant[0] - 'a', enPassant[1] - '1');
+        if (square >= 0 && square < 64 && (TABLES.pawn[_side ^ 1][square] & _pieces[_side][PAWN])) {
+            _epSquare = square;
+            _hash ^= ZOBRIST.enPassant[square & 7];
+        }
+    }
+    _halfmove = halfmove;
+    _fullmove = fullmove;
+    return true;
+}
+
+std::string ChessBoard::toFen() const
+{
+    std::string fen;
+    fen.reserve(96);
+    for (int rank = 7; rank >= 0; rank--) {
+        int empty = 0;
+        for (int file = 0; file < 8; file++) {
+            int square = squareAt(file, rank);
+            if (isEmpty(square)) {
+                empty++;
+                continue;
+            }
+            if (empty) fen += (char)('0' + empty);
+            empty = 0;
+            char c = PIECE_CHARS[pieceAt(square)];
+            fen += colorAt(square) == WHITE ? (char)toupper(c) : c;
+        }
+        if (empty) fen += (char)('0' + empty);
+        if (rank) fen += '/';
+    }
+
+    fen += _side == WHITE ? " w " : " b ";
+    if (!_castling) fen += '-';
+    if (_castling & WHITE_KINGSIDE) fen += 'K';
+    if (_castling & WHITE_QUEENSIDE) fen += 'Q';
+    if (_castling & BLACK_KINGSIDE) fen += 'k';
+    if (_castling & BLACK_QUEENSIDE) fen += 'q';
+    fen += ' ';
+    fen += _epSquare == NO_SQUARE ? "-" : squareName(_epSquare);
+    fen += ' ';
+    fen += std::to_string(_halfmove);
+    fen += ' ';
+    fen += std::to_string(_fullmove);
+    return fen;
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "Bitboard.h"
+#include "Symmetry.h"
+#include <cstdint>
+#include <string>
+
+//
+// 16-bit chess move: from (6 bits), to (6 bits) and a 4-bit flag
+//
+struct ChessMove
+{
+    enum Flag : uint16_t {
+        QUIET = 0, DOUBLE_PUSH = 1, KING_CASTLE = 2, QUEEN_CASTLE = 3,
+        CAPTURE = 4, EN_PASSANT = 5,
+        PROMOTION = 8,                  // + promoted piece - KNIGHT, CAPTURE bit set for capturing promotions
+    };
+
+    uint16_t    data = 0;
+
+    ChessMove() = default;
+    constexpr ChessMove(int from, int to, int flags) : data((uint16_t)(from | (to << 6) | (flags << 12))) {}
+
+    int         from() const { return data & 63; }
+    int         to() const { return (data >> 6) & 63; }
+    int         flags() const { return data >> 12; }
+    bool        isCapture() const { return (flags() & CAPTURE) != 0; }
+    bool        isPromotion() const { return (flags() & PROMOTION) != 0; }
+    bool        isCastle() const { return flags() == KING_CASTLE || flags() == QUEEN_CASTLE; }
+    int         promotion() const;      // promoted piece type, only valid for promotions
+    bool        isNull() const { return data == 0; }
+    bool        operator==(const ChessMove &o) const { return data == o.data; }
+    bool        operator!=(const ChessMove &o) const { return data != o.data; }
+
+    // long algebraic notation, e2e4 or e7e8q
+    std::string toString() const;
+};
+
+//
+// chess position on 64-bit bitboards, square 0 is a1 and square 63 is h8
+// sliders use magic bitboards, knights, kings and pawns precomputed attack tables
+// the tables are built once when the program starts
+//
+class ChessBoard
+{
+public:
+    using Move = ChessMove;
+
+    static const int SQUARES = 64;
+    static const int MAX_MOVES = 256;
+
+    enum Color { WHITE = 0, BLACK = 1 };
+    enum Piece { PAWN = 0, KNIGHT, BISHOP, ROOK, QUEEN, KING, NO_PIECE };
+    enum Castling { WHITE_KINGSIDE = 1, WHITE_QUEENSIDE = 2, BLACK_KINGSIDE = 4, BLACK_QUEENSIDE = 8 };
+
+    static const int NO_SQUARE = 64;
+
+    static constexpr const char *START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+    ChessBoard();
+
+    static ChessBoard initial();
+
+    // square helpers, file 0 is a and rank 0 is 1
+    static int      squareAt(int file, int rank) { return rank * 8 + file; }
+    static int      fileOf(int square) { return square & 7; }
+    static int      rankOf(int square) { return square >> 3; }
+
+    uint64_t        pieces(int color, int piece) const { return _pieces[color][piece]; }
+    uint64_t        pieces(int color) const { return _colors[color]; }
+    uint64_t        occupied() const { return _colors[WHITE] | _colors[BLACK]; }
+    int             pieceAt(int square) const { return _board[square] & 7; }
+    int             colorAt(int square) const { return _board[square] >> 3; }
+    bool            isEmpty(int square) const { return pieceAt(square) == NO_PIECE; }
+    int             kingSquare(int color) const { return Bitboard::lowestBit(_pieces[color][KING]); }
+
+    int             sideToMove() const { return _side; }
+    int             castling() const { return _castling; }
+    int             enPassant() const { return _epSquare; }
+    int             halfmoveClock() const { return _halfmove; }
+    int             fullmoveNumber() const { return _fullmove; }
+    uint64_t        hash() const { return _hash; }
+
+    void            setPiece(int square, int color, int piece);
+    void            clearSquare(int square);
+    void            setSideToMove(int color);
+
+    // the same position with the colours swapped and the board turned upside down
+    ChessBoard      mirrored() const;
+
+    // attacks
+    uint64_t        attackersTo(int square, uint64_t occupancy) const;
+    bool            isAttacked(int square, int byColor) const;
+    bool            inCheck() const;
+
+    // legal moves for the side to move, returns the number written (at most MAX_MOVES)
+    int             generateMoves(ChessMove *moves) const;
+    // legal captures and promotions only, for the quiescence search
+    int             generateCaptures(ChessMove *moves) const;
+
+    void            makeMove(const ChessMove &move);
+    // pass the turn, only used by the search for null move pruning
+    void            makeNullMove();
+
+    // anything besides pawns and the king, null moves are unsafe without it (zugzwang)
+    bool            hasNonPawnMaterial(int color) const { return (_colors[color] & ~_pieces[color][PAWN] & ~_pieces[color][KING]) != 0; }
+
+    // the legal move matching from, to and (for promotions) the promoted piece, or a null move
+    ChessMove       findMove(int from, int to, int promotion = QUEEN) const;
+    ChessMove       parseMove(const std::string &text) const;
+
+    // forsyth-edwards notation
+    bool            fromFen(const std::string &fen);
+    std::string     toFen() const;
+
+    // attack tables, usable without a board
+    static uint64_t knightAttacks(int square);
+    static uint64_t kingAttacks(int square);
+    static uint64_t pawnAttacks(int color, int square);
+    static uint64_t bishopAttacks(int square, uint64_t occupancy);
+    static uint64_t rookAttacks(int square, uint64_t occupancy);
+    static uint64_t queenAttacks(int square, uint64_t occupancy) { return bishopAttacks(square, occupancy) | rookAttacks(square, occupancy); }
+    static uint64_t between(int a, int b);      // squares strictly between a and b on a line, 0 if not aligned
+    static uint64_t line(int a, int b);         // the whole line through a and b, 0 if not aligned
+
+private:
+    template <bool CAPTURES_ONLY>
+    int             generate(ChessMove *moves) const;
+    uint64_t        pinnedPieces(int color) const;
+    bool            enPassantIsLegal(int from, int to) const;
+
+    uint64_t        _pieces[2][6];
+    uint64_t        _colors[2];
+    uint8_t         _board[64];         // color << 3 | piece, NO_PIECE when empty
+    int             _side;
+    int             _castling;
+    int             _epSquare;
+    int             _halfmove;
+    int             _fullmove;
+    uint64_t        _hash;
+};
+
+//
+// the colour flip, mirrored() with moves turned upside down along with the board
+//
+template <>
+struct Symmetry<ChessBoard>
+{
+    static constexpr int COUNT = 2;
+
+    static ChessBoard apply(const ChessBoard &board, int symmetry) { return symmetry ? board.mirrored() : board; }
+    static ChessMove applyMove(const ChessMove &move, int symmetry)
+    {
+        return symmetry ? ChessMove(move.from() ^ 56, move.to() ^ 56, move.flags()) : move;
+    }
+    static constexpr int inverse(int symmetry) { return symmetry; }
+};
@@ -0,0 +1,634 @@
+#include "ChessEngine.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    const int PIECE_VALUES[7] = { 100, 320, 330, 500, 900, 0, 0 };
+
+    // piece-square tables from white's side, laid out as seen on the board (a8 first)
+    const int PAWN_TABLE[64] = {
+          0,   0,   0,   0,   0,   0,   0,   0,
+         50,  50,  50,  50,  50,  50,  50,  50,
+         10,  10,  20,  30,  30,  20,  10,  10,
+          5,   5,  10,  25,  25,  10,   5,   5,
+          0,   0,   0,  20,  20,   0,   0,   0,
+          5,  -5, -10,   0,   0, -10,  -5,   5,
+          5,  10,  10, -20, -20,  10,  10,   5,
+          0,   0,   0,   0,   0,   0,   0,   0,
+    };
+    const int KNIGHT_TABLE[64] = {
+        -50, -40, -30, -30, -30, -30, -40, -50,
+        -40, -20,   0,   0,   0,   0, -20, -40,
+        -30,   0,  10,  15,  15,  10,   0, -30,
+        -30,   5,  15,  20,  20,  15,   5, -30,
+        -30,   0,  15,  20,  20,  15,   0, -30,
+        -30,   5,  10,  15,  15,  10,   5, -30,
+        -40, -20,   0,   5,   5,   0, -20, -40,
+        -50, -40, -30, -30, -30, -30, -40, -50,
+    };
+    const int BISHOP_TABLE[64] = {
+        -20, -10, -10, -10, -10, -10, -10, -20,
+        -10,   0,   0,   0,   0,   0,   0, -10,
+        -10,   0,   5,  10,  10,   5,   0, -10,
+        -10,   5,   5,  10,  10,   5,   5, -10,
+        -10,   0,  10,  10,  10,  10,   0, -10,
+        -10,  10,  10,  10,  10,  10,  10, -10,
+        -10,   5,   0,   0,   0,   0,   5, -10,
+        -20, -10, -10, -10, -10, -10, -10, -20,
+    };
+    const int ROOK_TABLE[64] = {
+          0,   0,   0,   0,   0,   0,   0,   0,
+          5,  10,  10,  10,  10,  10,  10,   5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+          0,   0,   0,   5,   5,   0,   0,   0,
+    };
+    const int QUEEN_TABLE[64] = {
+        -20, -10, -10,  -5,  -5, -10, -10, -20,
+        -10,   0,   0,   0,   0,   0,   0, -10,
+        -10,   0,   5,   5,   5,   5,   0, -10,
+         -5,   0,   5,   5,   5,   5,   0,  -5,
+          0,   0,   5,   5,   5,   5,   0,  -5,
+        -10,   5,   5,   5,   5,   5,   0, -10,
+        -10,   0,   5,   0,   0,   0,   0, -10,
+        -20, -10, -10,  -5,  -5, -10, -10, -20,
+    };
+    const int KING_MIDDLE_TABLE[64] = {
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -20, -30, -30, -40, -40, -30, -30, -20,
+        -10, -20, -20, -20, -20, -20, -20, -10,
+         20,  20,   0,   0,   0,   0,  20,  20,
+         20,  30,  10,   0,   0,  10,  30,  20,
+    };
+    const int KING_END_TABLE[64] = {
+        -50, -40, -30, -20, -20, -30, -40, -50,
+        -30, -20, -10,   0,   0, -10, -20, -30,
+        -30, -10,  20,  30,  30,  20, -10, -30,
+        -30, -10,  30,  40,  40,  30, -10, -30,
+        -30, -10,  30,  40,  40,  30, -10, -30,
+        -30, -10,  20,  30,  30,  20, -10, -30,
+        -30, -30,   0,   0,   0,   0, -30, -30,
+        -50, -30, -30, -30, -30, -30, -30, -50,
+    };
+    const int* const PIECE_TABLES[5] = { PAWN_TABLE, KNIGHT_TABLE, BISHOP_TABLE, ROOK_TABLE, QUEEN_TABLE };
+
+    const int BISHOP_PAIR_BONUS = 30;
+    const int PHASE_WEIGHTS[6] = { 0, 1, 1, 2, 4, 0 };
+    const int MAX_PHASE = 24;
+
+    // late move reductions grow with both the remaining depth and the move number
+    struct Reductions
+    {
+        int table[64][64];
+        Reductions()
+        {
+            for (int d = 0; d < 64; d++) {
+                for (int m = 0; m < 64; m++) {
+                    table[d][m] = d && m ? (int)(0.75 + std::log(d) * std::log(m) / 2.25) : 0;
+                }
+            }
+        }
+    };
+
+    const Reductions REDUCTIONS;
+
+    const uint64_t DATA_MOVE_MASK = 0xFFFF;
+}
+
+//
+// per-thread search state, nothing here is shared
+//
+struct ChessEngine::Worker
+{
+    int         id = 0;
+    uint64_t    nodes = 0;
+    uint64_t    tableHits = 0;
+    int         history[2][64][64];
+    ChessMove   killers[MAX_PLY][2];
+    uint64_t    path[MAX_PLY + 1];      // hash of the position at every ply of the current line
+
+    ChessMove   bestMove;
+    ChessMove   rootMove;
+    int         bestScore = 0;
+    int         completedDepth = 0;
+
+    Worker()
+    {
+        std::memset(history, 0, sizeof(history));
+        std::memset(killers, 0, sizeof(killers));
+    }
+};
+
+ChessEngine::ChessEngine(int tableSizeMB)
+{
+    size_t entries = 1;
+    while (entries * 2 * sizeof(TableEntry) <= (size_t)tableSizeMB * 1024 * 1024) entries *= 2;
+    _table.reset(new TableEntry[entries]);
+    _tableMask = entries - 1;
+    _tablebase = nullptr;
+    _stop = false;
+    _nodes = 0;
+    clearTable();
+}
+
+ChessEngine::~ChessEngine()
+{
+}
+
+void ChessEngine::clearTable()
+{
+    for (uint64_t i = 0; i <= _tableMask; i++) {
+        _table[i].check.store(0, std::memory_order_relaxed);
+        _table[i].data.store(0, std::memory_order_relaxed);
+    }
+}
+
+//
+// material and piece-square tables, the king's table blends from middlegame to endgame as pieces come off
+//
+int ChessEngine::evaluate(const ChessBoard &board)
+{
+    int score[2] = { 0, 0 };
+    int kingScore[2][2] = { { 0, 0 }, { 0, 0 } };
+    int phase = 0;
+
+    for (int color = 0; color < 2; color++) {
+        for (int piece = ChessBoard::PAWN; piece <= ChessBoard::KING; piece++) {
+            uint64_t pieces = board.pieces(color, piece);
+            phase += Bitboard::popCount(pieces) * PHASE_WEIGHTS[piece];
+            while (pieces) {
+                int square = Bitboard::popLowestBit(pieces);
+                // the tables read from white's side with a8 first
+                int index = color == ChessBoard::WHITE ? square ^ 56 : square;
+                if (piece == ChessBoard::KING) {
+                    kingScore[color][0] = KING_MIDDLE_TABLE[index];
+                    kingScore[color][1] = KING_END_TABLE[index];
+                } else {
+                    score[color] += PIECE_VALUES[piece] + PIECE_TABLES[piece][index];
+                }
+            }
+        }
+        if (Bitboard::popCount(board.pieces(color, ChessBoard::BISHOP)) >= 2) score[color] += BISHOP_PAIR_BONUS;
+    }
+
+    phase = std::min(phase, MAX_PHASE);
+    for (int color = 0; color < 2; color++) {
+        score[color] += (kingScore[color][0] * phase + kingScore[color][1] * (MAX_PHASE - phase)) / MAX_PHASE;
+    }
+
+    int us = board.sideToMove();
+    return score[us] - score[us ^ 1];
+}
+
+bool ChessEngine::probe(uint64_t key, TableHit &hit) const
+{
+    const TableEntry &entry = _table[key & _tableMask];
+    uint64_t data = entry.data.load(std::memory_order_relaxed);
+    if ((entry.check.load(std::memory_order_relaxed) ^ data) != key) return false;
+
+    hit.move.data = (uint16_t)(data & DATA_MOVE_MASK);
+    hit.score = (int16_t)((data >> 16) & 0xFFFF);
+    hit.depth = (int)((data >> 32) & 0xFF);
+    hit.bound = (Bound)((data >> 40) & 3);
+    return true;
+}
+
+//
+// mate scores are stored relative to the node so they stay valid from any ply
+//
+void ChessEngine::store(uint64_t key, int depth, int ply, int score, Bound bound, ChessMove move)
+{
+    TableEntry &entry = _table[key & _tableMask];
+    uint64_t old = entry.data.load(std::memory_order_relaxed);
+    bool sameKey = (entry.check.load(std::memory_order_relaxed) ^ old) == key;
+    if (sameKey && bound != BOUND_EXACT && (int)((old >> 32) & 0xFF) > depth + 2) return;
+
+    // keep the old move when this search didn't find one
+    if (move.isNull() && sameKey) move.data = (uint16_t)(old & DATA_MOVE_MASK);
+
+    if (score > MATE_SCORE - MAX_PLY) score += ply;
+    else if (score < -MATE_SCORE + MAX_PLY) score -= ply;
+
+    uint64_t data = move.data | ((uint64_t)(uint16_t)(int16_t)score << 16) | ((uint64_t)std::max(depth, 0) << 32) | ((uint64_t)bound << 40);
+    entry.check.store(key ^ data, std::memory_order_relaxed);
+    entry.data.store(data, std::memory_order_relaxed);
+}
+
+bool ChessEngine::checkLimits(Worker &worker)
+{
+    if (_limits.stop && *_limits.stop) _stop = true;
+    if ((worker.nodes & 1023) != 0) return _stop;
+
+    uint64_t total = _nodes.fetch_add(1024) + 1024;
+    if (_limits.maxNodes && total >= _limits.maxNodes) _stop = true;
+    if (_limits.timeMs > 0) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _startTime).count();
+        if (elapsed >= _limits.timeMs) _stop = true;
+    }
+    return _stop;
+}
+
+//
+// a position repeated since the last capture or pawn move is scored as a draw,
+// the search path is checked first and then the game before the root
+//
+bool ChessEngine::isRepetition(const Worker &worker, const ChessBoard &board, int ply) const
+{
+    int limit = board.halfmoveClock();
+    for (int distance = 4; distance <= limit; distance += 2) {
+        uint64_t hash;
+        if (distance <= ply) {
+            hash = worker.path[ply - distance];
+        } else {
+            int back = distance - ply;
+            if (back > (int)_gameHistory.size()) break;
+            hash = _gameHistory[_gameHistory.size() - back];
+        }
+        if (hash == board.hash()) return true;
+    }
+    return false;
+}
+
+//
+// table move first, then captures by most valuable victim / least valuable attacker,
+// promotions, the two killer moves and finally quiet moves by history
+//
+void ChessEngine::scoreMoves(const Worker &worker, const ChessBoard &board, const ChessMove *moves, int *scores,
+                             int count, ChessMove tableMove, int ply) const
+{
+    int side = board.sideToMove();
+    for (int i = 0; i < count; i++) {
+        const ChessMove &move = moves[i];
+        if (move == tableMove) {
+            scores[i] = 1 << 30;
+        } else if (move.isCapture()) {
+            int victim = move.flags() == ChessMove::EN_PASSANT ? ChessBoard::PAWN : board.pieceAt(move.to());
+            int attacker = board.pieceAt(move.from());
+            scores[i] = (1 << 24) + victim * 16 - attacker + (move.isPromotion() ? move.promotion() * 16 : 0);
+        } else if (move.isPromotion()) {
+            scores[i] = (1 << 24) + move.promotion() * 16 - 64;
+        } else if (move == worker.killers[ply][0]) {
+            scores[i] = (1 << 22) + 1;
+        } else if (move == worker.killers[ply][1]) {
+            scores[i] = 1 << 22;
+        } else {
+            scores[i] = worker.history[side][move.from()][move.to()];
+        }
+    }
+}
+
+int ChessEngine::quiesce(Worker &worker, const ChessBoard &board, int ply, int alpha, int beta)
+{
+    worker.nodes++;
+    if (checkLimits(worker)) return 0;
+    if (ply >= MAX_PLY - 1) return evaluate(board);
+
+    // in check every evasion is searched and there is no standing pat
+    bool inCheck = board.inCheck();
+    ChessMove moves[ChessBoard::MAX_MOVES];
+    int count;
+    int best;
+    if (inCheck) {
+        count = board.generateMoves(moves);
+        if (count == 0) return -MATE_SCORE + ply;
+        best = -INFINITE_SCORE;
+    } else {
+        best = evaluate(board);
+        if (best >= beta) return best;
+        alpha = std::max(alpha, best);
+        count = board.generateCaptures(moves);
+    }
+
+    int scores[ChessBoard::MAX_MOVES];
+    scoreMoves(worker, board, moves, scores, count, ChessMove(), ply);
+    for (int i = 0; i < count; i++) {
+        int pick = i;
+        for (int j = i + 1; j < count; j++) {
+            if (scores[j] > scores[pick]) pick = j;
+        }
+        std::swap(moves[i], moves[pick]);
+        std::swap(scores[i], scores[pick]);
+
+        ChessBoard child = board;
+        child.makeMove(moves[i]);
+        int score = -quiesce(worker, child, ply + 1, -beta, -alpha);
+        if (_stop) return 0;
+        if (score > best) {
+            best = score;
+            if (score > alpha) {
+                alpha = score;
+                if (alpha >= beta) break;
+            }
+        }
+    }
+    return best;
+}
+
+int ChessEngine::search(Worker &worker, const ChessBoard &board, int depth, int ply, int alpha, int beta, bool allowNull)
+{
+    bool pvNode = beta - alpha > 1;
+    worker.path[ply] = board.hash();
+
+    if (ply > 0) {
+        if (board.halfmoveClock() >= 100 || isRepetition(worker, board, ply)) return 0;
+
+        // no line from here can beat a mate already found closer to the root
+        alpha = std::max(alpha, -MATE_SCORE + ply);
+        beta = std::min(beta, MATE_SCORE - ply - 1);
+        if (alpha >= beta) return alpha;
+
+        uint8_t value;
+        if (_tablebase && _tablebase->probe(board, value)) {
+            worker.tableHits++;
+            return tablebaseScore(value, ply);
+        }
+    }
+
+    bool inCheck = board.inCheck();
+    if (inCheck) depth++;
+    if (depth <= 0) return quiesce(worker, board, ply, alpha, beta);
+
+    worker.nodes++;
+    if (checkLimits(worker)) return 0;
+    if (ply >= MAX_PLY - 1) return evaluate(board);
+
+    TableHit hit;
+    ChessMove tableMove;
+    if (probe(board.hash(), hit)) {
+        tableMove = hit.move;
+        if (!pvNode && hit.depth >= depth) {
+            int score = hit.score;
+            if (score > MATE_SCORE - MAX_PLY) score -= ply;
+            else if (score < -MATE_SCORE + MAX_PLY) score += ply;
+            if (hit.bound == BOUND_EXACT) return score;
+            if (hit.bound == BOUND_LOWER && score >= beta) return score;
+            if (hit.bound == BOUND_UPPER && score <= alpha) return score;
+        }
+    }
+
+    // null move: if passing still fails high, a real move will too
+    if (allowNull && !pvNode && !inCheck && depth >= 3 && board.hasNonPawnMaterial(board.sideToMove()) &&
+        evaluate(board) >= beta) {
+        ChessBoard child = board;
+        child.makeNullMove();
+        int reduction = 3 + depth / 6;
+        int score = -search(worker, child, depth - 1 - reduction, ply + 1, -beta, -beta + 1, false);
+        if (_stop) return 0;
+        if (score >= beta) return isMateScore(score) ? beta : score;
+    }
+
+    ChessMove moves[ChessBoard::MAX_MOVES];
+    int count = board.generateMoves(moves);
+    if (count == 0) return inCheck ? -MATE_SCORE + ply : 0;
+
+    int scores[ChessBoard::MAX_MOVES];
+    scoreMoves(worker, board, moves, scores, count, tableMove, ply);
+
+    int side = board.sideToMove();
+    int alphaStart = alpha;
+    int best = -INFINITE_SCORE;
+    ChessMove bestMove;
+    for (int i = 0; i < count; i++) {
+        int pick = i;
+        for (int j = i + 1; j < count; j++) {
+            if (scores[j] > scores[pick]) pick = j;
+        }
+        std::swap(moves[i], moves[pick]);
+        std::swap(scores[i], scores[pick]);
+        const ChessMove &move = moves[i];
+        bool quiet = !move.isCapture() && !move.isPromotion();
+
+        ChessBoard child = board;
+        child.makeMove(move);
+
+        int score;
+        if (i == 0) {
+            score = -search(worker, child, depth - 1, ply + 1, -beta, -alpha, true);
+        } else {
+            // late quiet moves are searched shallower first and only re-searched if they look good
+            int reduction = 0;
+            if (depth >= 3 && quiet && !inCheck && i >= 3 && scores[i] < (1 << 22)) {
+                reduction = REDUCTIONS.table[std::min(depth, 63)][std::min(i, 63)] - (pvNode ? 1 : 0);
+                reduction = std::clamp(reduction, 0, depth - 2);
+            }
+            score = -search(worker, child, depth - 1 - reduction, ply + 1, -alpha - 1, -alpha, true);
+            if (score > alpha && reduction > 0) {
+                score = -search(worker, child, depth - 1, ply + 1, -alpha - 1, -alpha, true);
+            }
+            if (score > alpha && score < beta) {
+                score = -search(worker, child, depth - 1, ply + 1, -beta, -alpha, true);
+            }
+        }
+        if (_stop) return 0;
+
+        if (score > best) {
+            best = score;
+            bestMove = move;
+            if (ply == 0) worker.rootMove = move;
+            if (score > alpha) {
+                alpha = score;
+                if (alpha >= beta) {
+                    if (quiet) {
+                        if (worker.killers[ply][0] != move) {
+                            worker.killers[ply][1] = worker.killers[ply][0];
+                            worker.killers[ply][0] = move;
+                        }
+                        int &history = worker.history[side][move.from()][move.to()];
+                        history = std::min(history + depth * depth, 1 << 20);
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    Bound bound = best >= beta ? BOUND_LOWER : (best > alphaStart ? BOUND_EXACT : BOUND_UPPER);
+    store(board.hash(), depth, ply, best, bound, bestMove);
+    return best;
+}
+
+//
+// iterative deepening with an aspiration window, helper threads start one ply deeper on odd ids
+// so the threads spread out over different depths
+//
+void ChessEngine::runWorker(Worker &worker, const ChessBoard &root, int maxDepth)
+{
+    int previous = 0;
+    for (int iteration = 1; iteration <= maxDepth; iteration++) {
+        int depth = std::min(iteration + (worker.id & 1), maxDepth);
+
+        int window = 40;
+        int alpha = iteration >= 5 ? previous - window : -INFINITE_SCORE;
+        int beta = iteration >= 5 ? previous + window : INFINITE_SCORE;
+        int score;
+        while (true) {
+            score = search(worker, root, depth, 0, alpha, beta, false);
+            if (_stop) break;
+            if (score <= alpha) alpha = std::max(alpha - window * 4, -INFINITE_SCORE);
+            else if (score >= beta) beta = std::min(beta + window * 4, INFINITE_SCORE);
+            else break;
+            window *= 4;
+        }
+        if (_stop) break;
+
+        previous = score;
+        worker.bestMove = worker.rootMove;
+        worker.bestScore = score;
+        worker.completedDepth = depth;
+
+        if (worker.id == 0) {
+            // a mate no longer than the depth searched can't be improved on
+            if (isMateScore(score) && MATE_SCORE - std::abs(score) <= depth) break;
+            // another iteration would most likely not finish in the time left
+            if (_limits.timeMs > 0) {
+                auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _startTime).count();
+                if (elapsed * 2 > _limits.timeMs) break;
+            }
+        }
+    }
+}
+
+//
+// distance to mate turned into a mate score from the current ply, like a mate found by the search
+//
+int ChessEngine::tablebaseScore(uint8_t value, int ply)
+{
+    if (value == ChessTablebase::DRAW) return 0;
+    int distance = ply + ChessTablebase::plies(value);
+    return ChessTablebase::isWin(value) ? MATE_SCORE - distance : -MATE_SCORE + distance;
+}
+
+//
+// the move keeping the best tablebase value: the fastest win, a draw, or the slowest loss
+// false when some move leads out of the tablebase
+//
+bool ChessEngine::bestTablebaseMove(const ChessBoard &board, ChessMove &best, int &score) const
+{
+    ChessMove moves[ChessBoard::MAX_MOVES];
+    int count = board.generateMoves(moves);
+    if (count == 0) return false;
+
+    score = -INFINITE_SCORE;
+    for (int i = 0; i < count; i++) {
+        ChessBoard child = board;
+        child.makeMove(moves[i]);
+        uint8_t value;
+        // a double push that allows en passant isn't covered, the search takes over then
+        if (!_tablebase->probe(child, value)) return false;
+        int childScore = -tablebaseScore(value, 1);
+        if (childScore > score) {
+            score = childScore;
+            best = moves[i];
+        }
+    }
+    return true;
+}
+
+bool ChessEngine::probeRoot(const ChessBoard &board, ChessSearchResult &result) const
+{
+    uint8_t value;
+    if (!_tablebase || !_tablebase->probe(board, value)) return false;
+
+    ChessMove best;
+    int score;
+    if (!bestTablebaseMove(board, best, score)) return false;
+
+    result.bestMove = best;
+    result.score = score;
+    result.depth = ChessTablebase::plies(value);
+    result.tableHits = 1;
+
+    // the line follows the tablebase's best moves to the mate
+    ChessBoard position = board;
+    result.pv.clear();
+    while ((int)result.pv.size() < MAX_PLY && bestTablebaseMove(position, best, score)) {
+        result.pv.push_back(best);
+        position.makeMove(best);
+    }
+    if (result.pv.empty() || result.pv[0] != result.bestMove) result.pv.assign(1, result.bestMove);
+    return true;
+}
+
+std::vector<ChessMove> ChessEngine::principalVariation(const ChessBoard &board, int maxLength) const
+{
+    std::vector<ChessMove> pv;
+    ChessBoard position = board;
+    TableHit hit;
+    while ((int)pv.size() < maxLength && probe(position.hash(), hit) && !hit.move.isNull()) {
+        ChessMove move = position.findMove(hit.move.from(), hit.move.to(), hit.move.isPromotion() ? hit.move.promotion() : ChessBoard::QUEEN);
+        if (move != hit.move) break;
+        pv.push_back(move);
+        position.makeMove(move);
+    }
+    return pv;
+}
+
+ChessSearchResult ChessEngine::search(const ChessBoard &board, const ChessSearchLimits &limits, const std::vector<uint64_t> &history)
+{
+    ChessSearchResult result;
+    _limits = limits;
+    _startTime = std::chrono::steady_clock::now();
+    _nodes = 0;
+    _stop = false;
+    _gameHistory = history;
+
+    ChessMove moves[ChessBoard::MAX_MOVES];
+    int count = board.generateMoves(moves);
+    if (count == 0) return result;
+
+    result.bestMove = moves[0];
+    result.hasMove = true;
+    if (count == 1) {
+        result.depth = 1;
+        result.pv.push_back(moves[0]);
+        return result;
+    }
+    if (probeRoot(board, result)) {
+        result.timeMs = (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _startTime).count();
+        return result;
+    }
+
+    int maxDepth = std::min(limits.maxDepth > 0 ? limits.maxDepth : MAX_PLY - 1, MAX_PLY - 1);
+    int threads = std::max(1, limits.threads);
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int i = 0; i < threads; i++) {
+        workers.push_back(std::make_unique<Worker>());
+        workers.back()->id = i;
+    }
+
+    JobGroup helpers;
+    for (int i = 1; i < threads; i++) {
+        helpers.run([this, &workers, &board, maxDepth, i]() { runWorker(*workers[i], board, maxDepth); });
+    }
+    runWorker(*workers[0], board, maxDepth);
+    _stop = true;
+    helpers.wait();
+
+    const Worker &main = *workers[0];
+    if (main.completedDepth > 0 && !main.bestMove.isNull()) {
+        result.bestMove = main.bestMove;
+        result.score = main.bestScore;
+        result.depth = main.completedDepth;
+    }
+
+    uint64_t nodes = 0;
+    for (const auto &worker : workers) {
+        nodes += worker->nodes;
+        result.tableHits += worker->tableHits;
+    }
+    result.nodes = nodes;
+    result.timeMs = (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _startTime).count();
+    result.nodesPerSecond = nodes * 1000 / (uint64_t)std::max(result.timeMs, 1);
+
+    result.pv = principalVariation(board, std::max(result.depth, 1));
+    if (result.pv.empty() || result.pv[0] != result.bestMove) result.pv.assign(1, result.bestMove);
+    return result;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "ChessBoard.h"
+#include "ChessTablebase.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+//
+// limits for a single search, zero means unlimited
+//
+struct ChessSearchLimits
+{
+    int         maxDepth = 64;
+    int         timeMs = 1000;
+    uint64_t    maxNodes = 0;
+    int         threads = 1;
+    const std::atomic<bool> *stop = nullptr;    // the caller's, a stop set before the search starts still counts
+};
+
+struct ChessSearchResult
+{
+    ChessMove               bestMove;
+    bool                    hasMove = false;
+    int                     score = 0;
+    int                     depth = 0;
+    uint64_t                nodes = 0;
+    int                     timeMs = 0;
+    uint64_t                nodesPerSecond = 0;
+    uint64_t                tableHits = 0;
+    std::vector<ChessMove>  pv;
+};
+
+//
+// principal variation search with a capture quiescence search, null move pruning, late move
+// reductions, MVV-LVA and history ordering
+// with a tablebase set, positions it covers are scored exactly and a covered root is played from it
+// Lazy SMP: every thread runs its own iterative deepening on the same root and they share
+// work only through the lock-free transposition table, the first thread's result is used
+//
+class ChessEngine
+{
+public:
+    static constexpr int INFINITE_SCORE = 32000;
+    static constexpr int MATE_SCORE = 31000;
+    static constexpr int MAX_PLY = 128;
+
+    ChessEngine(int tableSizeMB = 64);
+    ~ChessEngine();
+
+    // history holds the hashes of the game's earlier positions, for repetition draws
+    ChessSearchResult search(const ChessBoard &board, const ChessSearchLimits &limits,
+                             const std::vector<uint64_t> &history = {});
+
+    // static evaluation from the side to move's point of view
+    static int  evaluate(const ChessBoard &board);
+
+    void        clearTable();
+    void        setTablebase(const ChessTablebase *tablebase) { _tablebase = tablebase; }
+    void        stop() { _stop = true; }
+
+    static bool isMateScore(int score) { return score > MATE_SCORE - MAX_PLY || score < -MATE_SCORE + MAX_PLY; }
+
+private:
+    enum Bound : uint8_t { BOUND_NONE, BOUND_UPPER, BOUND_LOWER, BOUND_EXACT };
+
+    //
+    // the key is stored xor'ed with the data so a torn write from another thread reads as a miss
+    //
+    struct TableEntry
+    {
+        std::atomic<uint64_t>   check;
+        std::atomic<uint64_t>   data;
+    };
+
+    struct TableHit
+    {
+        ChessMove   move;
+        int         score;
+        int         depth;
+        Bound       bound;
+    };
+
+    struct Worker;
+
+    void        runWorker(Worker &worker, const ChessBoard &root, int maxDepth);
+    int         search(Worker &worker, const ChessBoard &board, int depth, int ply, int alpha, int beta, bool allowNull);
+    int         quiesce(Worker &worker, const ChessBoard &board, int ply, int alpha, int beta);
+    void        scoreMoves(const Worker &worker, const ChessBoard &board, const ChessMove *moves, int *scores,
+                           int count, ChessMove tableMove, int ply) const;
+    bool        checkLimits(Worker &worker);
+    bool        isRepetition(const Worker &worker, const ChessBoard &board, int ply) const;
+    std::vector<ChessMove> principalVariation(const ChessBoard &board, int maxLength) const;
+    bool        probeRoot(const ChessBoard &board, ChessSearchResult &result) const;
+    bool        bestTablebaseMove(const ChessBoard &board, ChessMove &best, int &score) const;
+    static int  tablebaseScore(uint8_t value, int ply);
+
+    bool        probe(uint64_t key, TableHit &hit) const;
+    void        store(uint64_t key, int depth, int ply, int score, Bound bound, ChessMove move);
+
+    std::unique_ptr<TableEntry[]>   _table;
+    const ChessTablebase*           _tablebase;
+    uint64_t                        _tableMask;
+
+    std::atomic<bool>               _stop;
+    std::atomic<uint64_t>           _nodes;
+    ChessSearchLimits               _limits;
+    std::chrono::steady_clock::time_point _startTime;
+    std::vector<uint64_t>           _gameHistory;
+};
@@ -0,0 +1,347 @@
+#include "ChessTablebase.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+    const int PAWN_SQUARES = 48;
+    const int MAX_KING_PAIRS = 1806;
+    const char PIECE_LETTERS[] = "PNBRQ";
+
+    //
+    // the eight symmetries of the board: bit 2 transposes, bit 0 mirrors the files and bit 1 the ranks
+    // only the file mirror (1) keeps pawns moving the right way
+    //
+    int transform(int square, int symmetry)
+    {
+        if (symmetry & 4) square = ((square & 7) << 3) | (square >> 3);
+        if (symmetry & 1) square ^= 7;
+        if (symmetry & 2) square ^= 56;
+        return square;
+    }
+
+    //
+    // canonical placements of the two kings: without pawns the white king sits in the a1-d1-d4
+    // triangle (and the black king on or below the long diagonal when the white one is on it),
+    // with pawns the white king is on files a-d. touching kings are left out
+    //
+    struct KingPairs
+    {
+        int16_t index[2][64][64];
+        uint8_t squares[2][MAX_KING_PAIRS][2];
+        int     count[2];
+
+        KingPairs()
+        {
+            for (int pawns = 0; pawns < 2; pawns++) {
+                count[pawns] = 0;
+                for (int white = 0; white < 64; white++) {
+                    for (int black = 0; black < 64; black++) {
+                        index[pawns][white][black] = -1;
+                        int whiteFile = white & 7, whiteRank = white >> 3;
+                        int blackFile = black & 7, blackRank = black >> 3;
+                        if (std::abs(whiteFile - blackFile) <= 1 && std::abs(whiteRank - blackRank) <= 1) continue;
+                        if (whiteFile > 3) continue;
+                        if (!pawns) {
+                            if (whiteRank > whiteFile) continue;
+                            if (whiteRank == whiteFile && blackRank > blackFile) continue;
+                        }
+                        index[pawns][white][black] = (int16_t)count[pawns];
+                        squares[pawns][count[pawns]][0] = (uint8_t)white;
+                        squares[pawns][count[pawns]][1] = (uint8_t)black;
+                        count[pawns]++;
+                    }
+                }
+            }
+        }
+    };
+
+    const KingPairs &kingPairs()
+    {
+        static const KingPairs pairs;
+        return pairs;
+    }
+
+    // the non-king pieces of a table in index order: white queens down to pawns, then black
+    int pieceList(const ChessMaterial &material, int *colors, int *pieces)
+    {
+        int n = 0;
+        for (int color = 0; color < 2; color++) {
+            for (int piece = ChessBoard::QUEEN; piece >= ChessBoard::PAWN; piece--) {
+                for (int i = 0; i < material.counts[color][piece]; i++) {
+                    colors[n] = color;
+                    pieces[n] = piece;
+                    n++;
+                }
+            }
+        }
+        return n;
+    }
+}
+
+int ChessMaterial::pieces() const
+{
+    int total = 2;
+    for (int color = 0; color < 2; color++) {
+        for (int piece = 0; piece < 5; piece++) total += counts[color][piece];
+    }
+    return total;
+}
+
+int ChessMaterial::key() const
+{
+    int key = 0;
+    for (int color = 0; color < 2; color++) {
+        for (int piece = 0; piece < 5; piece++) key = (key << 3) | counts[color][piece];
+    }
+    return key;
+}
+
+ChessMaterial ChessMaterial::flipped() const
+{
+    ChessMaterial m;
+    for (int piece = 0; piece < 5; piece++) {
+        m.counts[0][piece] = counts[1][piece];
+        m.counts[1][piece] = counts[0][piece];
+    }
+    return m;
+}
+
+bool ChessMaterial::isCanonical() const
+{
+    int white = 0, black = 0;
+    for (int piece = 0; piece < 5; piece++) {
+        white += counts[0][piece];
+        black += counts[1][piece];
+    }
+    if (white != black) return white > black;
+    for (int piece = ChessBoard::QUEEN; piece >= ChessBoard::PAWN; piece--) {
+        if (counts[0][piece] != counts[1][piece]) return counts[0][piece] > counts[1][piece];
+    }
+    return true;
+}
+
+std::string ChessMaterial::name() const
+{
+    std::string name;
+    for (int color = 0; color < 2; color++) {
+        name += 'K';
+        for (int piece = ChessBoard::QUEEN; piece >= ChessBoard::PAWN; piece--) {
+            name.append(counts[color][piece], PIECE_LETTERS[piece]);
+        }
+    }
+    return name;
+}
+
+ChessMaterial ChessMaterial::of(const ChessBoard &board)
+{
+    ChessMaterial m;
+    for (int color = 0; color < 2; color++) {
+        for (int piece = 0; piece < 5; piece++) m.counts[color][piece] = (uint8_t)Bitboard::popCount(board.pieces(color, piece));
+    }
+    return m;
+}
+
+ChessTablebase::ChessTablebase()
+{
+    _maxPieces = 0;
+}
+
+uint64_t ChessTablebase::tableSize(const ChessMaterial &material)
+{
+    int colors[8], pieces[8];
+    int n = pieceList(material, colors, pieces);
+    uint64_t size = 2 * (uint64_t)kingPairs().count[material.pawns() > 0];
+    for (int i = 0; i < n; i++) size *= pieces[i] == ChessBoard::PAWN ? PAWN_SQUARES : 64;
+    return size;
+}
+
+uint64_t ChessTablebase::indexOf(const ChessBoard &board, const ChessMaterial &material)
+{
+    const KingPairs &kings = kingPairs();
+    int pawns = material.pawns() > 0;
+    int whiteKing = board.kingSquare(ChessBoard::WHITE);
+    int blackKing = board.kingSquare(ChessBoard::BLACK);
+
+    // the first symmetry that brings the kings into their canonical placement
+    int symmetry = 0;
+    int pair = -1;
+    for (; symmetry < (pawns ? 2 : 8); symmetry++) {
+        pair = kings.index[pawns][transform(whiteKing, symmetry)][transform(blackKing, symmetry)];
+        if (pair >= 0) break;
+    }
+    if (pair < 0) return tableSize(material);
+
+    uint64_t index = (uint64_t)board.sideToMove() * kings.count[pawns] + pair;
+    for (int color = 0; color < 2; color++) {
+        for (int piece = ChessBoard::QUEEN; piece >= ChessBoard::PAWN; piece--) {
+            // identical pieces go in ascending order of their transformed squares
+            // a table has at most MAX_PIECES - 2 of a kind, more than that isn't one of its positions
+            int squares[MAX_PIECES - 2];
+            int n = 0;
+            uint64_t bits = board.pieces(color, piece);
+            for (; bits && n < MAX_PIECES - 2; n++) {
+                int square = transform(Bitboard::popLowestBit(bits), symmetry);
+                int i = n;
+                for (; i > 0 && squares[i - 1] > square; i--) squares[i] = squares[i - 1];
+                squares[i] = square;
+            }
+            if (bits) return tableSize(material);
+            for (int i = 0; i < n; i++) {
+                index = piece == ChessBoard::PAWN ? index * PAWN_SQUARES + (squares[i] - 8) : index * 64 + squares[i];
+            }
+        }
+    }
+    return index;
+}
+
+bool ChessTablebase::positionAt(const ChessMaterial &material, uint64_t index, ChessBoard &board)
+{
+    const KingPairs &kings = kingPairs();
+    int pawns = material.pawns() > 0;
+    int colors[8], pieces[8], squares[8];
+    int n = pieceList(material, colors, pieces);
+
+    for (int i = n - 1; i >= 0; i--) {
+        if (pieces[i] == ChessBoard::PAWN) {
+            squares[i] = (int)(index % PAWN_SQUARES) + 8;
+            index /= PAWN_SQUARES;
+        } else {
+            squares[i] = (int)(index & 63);
+            index >>= 6;
+        }
+    }
+    int pair = (int)(index % kings.count[pawns]);
+    int side = (int)(index / kings.count[pawns]);
+
+    board = ChessBoard();
+    board.setPiece(kings.squares[pawns][pair][0], ChessBoard::WHITE, ChessBoard::KING);
+    board.setPiece(kings.squares[pawns][pair][1], ChessBoard::BLACK, ChessBoard::KING);
+    for (int i = 0; i < n; i++) {
+        if (!board.isEmpty(squares[i])) return false;
+        // identical pieces are only indexed in ascending order
+        if (i > 0 && colors[i] == colors[i - 1] && pieces[i] == pieces[i - 1] && squares[i] < squares[i - 1]) return false;
+        board.setPiece(squares[i], colors[i], pieces[i]);
+    }
+    board.setSideToMove(side);
+
+    // the side that just moved can't be in check
+    return !board.isAttacked(board.kingSquare(side ^ 1), side);
+}
+
+std::vector<ChessMaterial> ChessTablebase::tablesWith(int pieces)
+{
+    std::vector<ChessMaterial> tables;
+    if (pieces < 2 || pieces > MAX_PIECES) return tables;
+    ChessMaterial material;
+
+    // every multiset of pieces - 2 non-king pieces over the ten colour and piece types
+    auto add = [&](auto &&self, int remaining, int first) -> void {
+        if (remaining == 0) {
+            if (material.isCanonical()) tables.push_back(material);
+            return;
+        }
+        for (int type = first; type < 10; type++) {
+            uint8_t &count = type < 5 ? material.counts[0][type] : material.counts[1][type - 5];
+            count++;
+            self(self, remaining - 1, type);
+            count--;
+        }
+    };
+    add(add, pieces - 2, 0);
+
+    std::stable_sort(tables.begin(), tables.end(), [](const ChessMaterial &a, const ChessMaterial &b) {
+        return a.pawns() < b.pawns();
+    });
+    return tables;
+}
+
+std::string ChessTablebase::tablePath(const std::string &directory, const ChessMaterial &material)
+{
+    return (std::filesystem::path(directory) / ("chess_" + material.name() + ".ctb")).string();
+}
+
+bool ChessTablebase::writeTable(const std::string &directory, const ChessMaterial &material, const std::vector<uint8_t> &values)
+{
+    std::filesystem::create_directories(directory);
+    std::ofstream file(tablePath(directory, material), std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+
+    FileHeader header{};
+    header.magic = FILE_MAGIC;
+    header.version = FILE_VERSION;
+    std::string name = material.name();
+    std::memcpy(header.material, name.c_str(), std::min(name.size(), sizeof(header.material)));
+    header.positions = values.size();
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(values.data()), (std::streamsize)values.size());
+    return (bool)file;
+}
+
+int ChessTablebase::open(const std::string &directory, int maxPieces)
+{
+    close();
+    bool allComplete = true;
+    for (int pieces = 3; pieces <= std::min(maxPieces, (int)MAX_PIECES); pieces++) {
+        bool complete = true;
+        for (const ChessMaterial &material : tablesWith(pieces)) {
+            auto table = std::make_unique<Table>();
+            if (!table->file.open(tablePath(directory, material)) || table->file.size() < sizeof(FileHeader)) {
+                complete = false;
+                continue;
+            }
+
+            const FileHeader *header = reinterpret_cast<const FileHeader*>(table->file.data());
+            uint64_t positions = tableSize(material);
+            if (header->magic != FILE_MAGIC || header->version != FILE_VERSION || header->positions != positions ||
+                table->file.size() < sizeof(FileHeader) + positions) {
+                complete = false;
+                continue;
+            }
+
+            table->values = table->file.data() + sizeof(FileHeader);
+            table->positions = positions;
+            _tables[material.key()] = std::move(table);
+        }
+        allComplete = allComplete && complete;
+        if (allComplete) _maxPieces = pieces;
+    }
+    return (int)_tables.size();
+}
+
+void ChessTablebase::close()
+{
+    _tables.clear();
+    _maxPieces = 0;
+}
+
+bool ChessTablebase::probe(const ChessBoard &board, uint8_t &value) const
+{
+    int pieces = Bitboard::popCount(board.occupied());
+    if (pieces > MAX_PIECES || board.castling() != 0 || board.enPassant() != ChessBoard::NO_SQUARE) return false;
+    if (pieces == 2) {
+        value = DRAW;
+        return true;
+    }
+
+    // with black the stronger side, look up the mirrored position instead
+    ChessMaterial material = ChessMaterial::of(board);
+    ChessBoard mirrored;
+    const ChessBoard *position = &board;
+    if (!material.isCanonical()) {
+        mirrored = board.mirrored();
+        position = &mirrored;
+        material = material.flipped();
+    }
+
+    auto found = _tables.find(material.key());
+    if (found == _tables.end()) return false;
+
+    uint64_t index = indexOf(*position, material);
+    const Table &table = *found->second;
+    if (index >= table.positions) return false;
+    value = table.values[index];
+    return value != INVALID;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "ChessBoard.h"
+#include "MappedFile.h"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//
+// the pieces besides the kings of a tablebase, counted per colour and piece type
+// a table is always stored with the stronger side as white
+//
+struct ChessMaterial
+{
+    uint8_t counts[2][5] = {};      // [colour][PAWN..QUEEN]
+
+    int                 pieces() const;         // including both kings
+    int                 pawns() const { return counts[0][ChessBoard::PAWN] + counts[1][ChessBoard::PAWN]; }
+    int                 key() const;
+    ChessMaterial       flipped() const;
+    bool                isCanonical() const;    // white is at least as strong as black
+    std::string         name() const;           // KQKR style, strongest piece first
+
+    static ChessMaterial of(const ChessBoard &board);
+};
+
+//
+// distance to mate tablebases for endgames with up to four pieces, built offline by
+// tools/chess_tablebase.cpp and memory mapped
+// one byte per position: 0 is a draw, an odd value is a win in that many plies and
+// an even value a loss in value - 2 plies, all for the side to move
+// positions are indexed by the king pair reduced by the board's symmetries (eight without pawns,
+// the left-right mirror with them) and then one square per piece, pawns only on ranks 2-7
+// castling and en passant are not covered
+//
+class ChessTablebase
+{
+public:
+    static constexpr int MAX_PIECES = 4;
+    static constexpr uint8_t DRAW = 0;
+    static constexpr uint8_t INVALID = 255;
+    static constexpr uint32_t FILE_MAGIC = 0x4C425443;     // "CTBL"
+    static constexpr uint32_t FILE_VERSION = 1;
+
+    struct FileHeader
+    {
+        uint32_t    magic;
+        uint32_t    version;
+        char        material[8];
+        uint64_t    positions;
+    };
+
+    ChessTablebase();
+
+    static bool             isWin(uint8_t value) { return (value & 1) != 0; }
+    static bool             isLoss(uint8_t value) { return value != DRAW && value != INVALID && !(value & 1); }
+    static int              plies(uint8_t value) { return isWin(value) ? value : value - 2; }
+    static uint8_t          win(int plies) { return (uint8_t)plies; }
+    static uint8_t          loss(int plies) { return (uint8_t)(plies + 2); }
+
+    // table indexing, the board's material must be the table's (white the stronger side)
+    static uint64_t         tableSize(const ChessMaterial &material);
+    static uint64_t         indexOf(const ChessBoard &board, const ChessMaterial &material);
+    // false for indices that aren't a legal position
+    static bool             positionAt(const ChessMaterial &material, uint64_t index, ChessBoard &board);
+
+    // every table with exactly pieces pieces including the kings, fewer pawns first
+    static std::vector<ChessMaterial> tablesWith(int pieces);
+
+    static std::string      tablePath(const std::string &directory, const ChessMaterial &material);
+    static bool             writeTable(const std::string &directory, const ChessMaterial &material, const std::vector<uint8_t> &values);
+
+    // maps every table found in directory, returns the number of tables loaded
+    int                     open(const std::string &directory, int maxPieces = MAX_PIECES);
+    void                    close();
+
+    // largest piece count for which every table is loaded
+    int                     maxPieces() const { return _maxPieces; }
+    int                     tableCount() const { return (int)_tables.size(); }
+
+    // value for the side to move, false when the position isn't covered
+    bool                    probe(const ChessBoard &board, uint8_t &value) const;
+
+private:
+    struct Table
+    {
+        MappedFile      file;
+        const uint8_t*  values;
+        uint64_t        positions;
+    };
+
+    std::unordered_map<int, std::unique_ptr<Table>>    _tables;
+    int                                                 _maxPieces;
+};
@@ -53,6 +53,9 @@ void ConnectFour::setUpBoard()
     _gameOptions.rowX = 7;
     _gameOptions.rowY = 6;
     _grid->initializeSquares(80, "square.png");
+    evalWeights<ConnectFourWeights>(); // read a tuned weights file now rather than in the first search
+    updateTableCache(false);
+    _book.open(OPENING_BOOK, "connectfour"); // built by tools/book_builder, the AI does without one
 
     if (gameHasAI()) setAIPlayer(RED_PLAYER); // AI will play second
 
@@ -198,7 +201,48 @@ std::string ConnectFour::stateString()
 //
 void ConnectFour::setStateString(const std::string &s)
 {
-    // TODO
+    if ((int)s.length() != ROWX * ROWY) return;
+
+    for (int rowX = 0; rowX < ROWX; rowX++)
+    {
+        for (int rowY = 0; rowY < ROWY; rowY++)
+        {
+            ChessSquare *square = _grid->getSquare(rowX, rowY);
+            square->destroyBit();
+            char piece = s[coordsToStateIndex(rowX, rowY)];
+            if (piece == '0') continue;
+
+            Bit *bit = createPiece(piece == '2' ? AI_PLAYER : HUMAN_PLAYER);
+            bit->setPosition(square->getPosition());
+            square->setBit(bit);
+        }
+    }
+}
+
+//
+// read straight off the grid, row 0 of the grid is the top of the board
+//
+ConnectFourBoard ConnectFour::position()
+{
+    ConnectFourBoard board;
+    for (int rowX = 0; rowX < ROWX; rowX++)
+    {
+        for (int rowY = 0; rowY < ROWY; rowY++)
+        {
+            Bit *bit = _grid->getSquare(rowX, rowY)->bit();
+            if (!bit) continue;
+            board.discs[bit->getOwner()->playerNumber()] |= 1ull << (rowX * ConnectFourBoard::STRIDE + ROWY - 1 - rowY);
+            board.moves++;
+        }
+    }
+    board.side = getCurrentPlayer()->playerNumber();
+    return board;
+}
+
+void ConnectFour::setPosition(const ConnectFourBoard &position)
+{
+    setStateString(position.toString());
+    setSideToMove(position.side);
 }
 
 //
@@ -358,8 +402,11 @@ int ConnectFour::scoreOfLine(const int *owners, int playerNumber)
             break;
         }
     }
+    // twos and threes are weighted like the bitboard evaluation, tuned weights included
+    const ConnectFourWeights &weights = evalWeights<ConnectFourWeights>();
     if (score == 1) score = 0;
-    if (score == 3) score *= TRIPLE_MULT;
+    else if (score == 2) score = weights.values[ConnectFourWeights::PAIR];
+    else if (score == 3) score = weights.values[ConnectFourWeights::TRIPLE];
 
     return score;
 }
@@ -450,85 +497,88 @@ int ConnectFour::evaluate(std::string gameState, int playerNumber)
 }
 
 //
-// Find the most optimal move by evaluating possible games stemming from that move
+// the search's table in cache/, read in the background when the board is set up and written back after
+// every search. scores depend on the evaluation weights, so retuned ones start a new cache
 //
-int ConnectFour::negamax(std::string gameState, int depth, int playerNumber, int alpha, int beta)
+void ConnectFour::updateTableCache(bool save)
 {
-	if (depth == 0 || checkForWinnerWithGameState(gameState)) 
-    {
-        int eval = evaluate(gameState, playerNumber);
-        //logger.Info("Reached end of negamax with gameState " + gameState + ". Evaluation = " + std::to_string(eval));
-        return eval;
-    }
-    std::vector<std::string> moves = generateMoves(gameState, playerNumber);
-    //if (moves.empty()) return 0;
-
-    int value = -MAX_VALUE;
-    int nextPlayer = playerNumber == 0 ? 1 : 0;
-    for (auto const & move : moves)
-    {
-        value = std::max(value, -negamax(move, depth - 1, nextPlayer, -beta, -alpha));
-        alpha = std::max(alpha, value);
-        if (alpha >= beta) break;
+    if (!_gameOptions.AIPersistentCache) {
+        _engine.closeCache();
+        return;
     }
-    return value;
+    _engine.openCache(TABLE_CACHE, "connectfour", evalWeightsSignature(evalWeights<ConnectFourWeights>()));
+    if (save) _engine.saveCache();
 }
 
 //
-// Negamax wrapper function to get the best move for the AI
+// Called by the AI upon AI player's turn
 //
-std::string ConnectFour::getBestMove()
+void ConnectFour::updateAI()
 {
-    std::string gameState = stateString();
-    std::vector<std::string> moves = generateMoves(gameState, AI_PLAYER);
-    std::string bestMove = "";
-    int bestEvaluation = -MAX_VALUE;
-
-    for (auto const & move : moves) 
-    {
-        int evaluation = -negamax(move, 4, HUMAN_PLAYER, -MAX_VALUE, MAX_VALUE);
-        //logger.Event("Checking move: " + move + " Evaluation: " + std::to_string(evaluation));
+    if (_gameOptions.gameOver) return;
 
-        if (evaluation > bestEvaluation) 
-        {
-            bestMove = move;
-            bestEvaluation = evaluation;
-            //logger.Event("AI chose a new best move: " + bestMove + " Evaluation: " + std::to_string(bestEvaluation));
+    int column;
+    if (_book.move(position(), column)) {
+        // still inside the opening book, whose moves were searched far deeper than there is time for now
+    } else if (_gameOptions.AIUseMCTS) {
+        // playouts for a slice of the frame, the node budget means nothing to them
+        ConnectFourBoard board = position();
+        if (!_mcts.searching() || _mcts.searchRoot().hash() != board.hash()) {
+            MctsLimits limits;
+            limits.timeMs = AI_TIME_BUDGET_MS;
+            _mcts.start(board, limits);
+        }
+        if (!_mcts.advance(0, _gameOptions.AIFrameBudgetUs)) return;
+        const MctsEngine<ConnectFourTraits>::Result &result = _mcts.result();
+        if (!result.hasMove) return;
+        column = result.bestMove;
+    } else if (_gameOptions.AIUseNNUE && gameHasNNUE()) {
+        NnuePosition<ConnectFourFeatures> board(position());
+        if (!_nnueEngine.searching() || _nnueEngine.searchRoot().hash() != board.hash()) {
+            SearchLimits limits;
+            limits.timeMs = AI_TIME_BUDGET_MS;
+            _nnueEngine.start(board, limits);
         }
+        if (!_nnueEngine.advance(_gameOptions.AIFrameNodes, _gameOptions.AIFrameBudgetUs)) return;
+        const SearchEngine<ConnectFourNnueTraits>::Result &result = _nnueEngine.result();
+        if (!result.hasMove) return;
+        column = result.bestMove;
+    } else {
+        // a slice of the search a frame, so the board keeps drawing while the AI thinks
+        ConnectFourBoard board = position();
+        if (!_engine.searching() || _engine.searchRoot().hash() != board.hash()) {
+            SearchLimits limits;
+            limits.timeMs = AI_TIME_BUDGET_MS;
+            _engine.start(board, limits);
+        }
+        if (!_engine.advance(_gameOptions.AIFrameNodes, _gameOptions.AIFrameBudgetUs)) return;
+        const SearchEngine<ConnectFourTraits>::Result &result = _engine.result();
+        updateTableCache(true);
+        if (!result.hasMove) return;
+        column = result.bestMove;
+    }
+
+    ChessSquare *square = _grid->getSquare(column, 0);
+    if (!actionForEmptyHolder(*square))
+    {
+        logger.Error("updateAI(): Failed to drop a piece in column " + std::to_string(column));
     }
+}
 
-    return bestMove;
+std::unique_ptr<ProtocolGame> ConnectFour::aiPosition()
+{
+    ConnectFourBoard board = position();
+    std::unique_ptr<ProtocolGame> game = ProtocolGame::create("connectfour");
+    if (!game->setState(board.toString(), board.side)) return nullptr;
+    return game;
 }
 
 //
-// Called by the AI upon AI player's turn
+// the protocol names a move by its column letter, the piece drops from the top square
 //
-void ConnectFour::updateAI()
+bool ConnectFour::applyAIMove(const std::string &move)
 {
-    if (_gameOptions.gameOver) return;
-
-    std::string bestMove = getBestMove();
-    //logger.Info("Best AI move: " + bestMove);
-
-    std::string gameState = stateString();
-    for (size_t i = 0; i < gameState.length(); i++)
-    {
-        if (gameState[i] != bestMove[i])
-        {
-            // Place correct piece in this spot
-            int rowX = i / ROWY;
-            int rowY = findLowestOpenSquareY(gameState, rowX);
-            ChessSquare *square  = _grid->getSquare(rowX, rowY);
-
-            if (actionForEmptyHolder(*square))
-            {
-            }
-            else
-            {
-                logger.Error("updateAI(): Failed to place piece at (" + std::to_string(rowX) + ", " + std::to_string(rowY) + ")");
-            }
-            
-            break;
-        }
-    }
-}
\ No newline at end of file
+    if (move.size() != 1) return false;
+    ChessSquare *square = _grid->getSquare(move[0] - 'a', 0);
+    return square && actionForEmptyHolder(*square);
+}
@@ -1,5 +1,10 @@
 #pragma once
 #include "Game.h"
+#include "ConnectFourBoard.h"
+#include "Mcts.h"
+#include "Nnue.h"
+#include "OpeningBook.h"
+#include "Search.h"
 
 class ConnectFour : public Game
 {
@@ -24,12 +29,20 @@ public:
 	std::vector<std::string> generateMoves(std::string gameState, int playerNumber);
     Player*     checkForWinnerWithGameState(std::string gameState);
     int         evaluate(std::string gameState, int playerNumber);
-    int         negamax(std::string gameState, int depth, int playerNumber, int alpha, int beta);
-    std::string getBestMove();
     void        updateAI() override;
     bool        gameHasAI() override { return true; } // Set to true when AI is implemented
+    bool        gameHasMCTS() override { return true; }
+    bool        gameHasNNUE() override { return sharedNetwork<ConnectFourFeatures>() != nullptr; }
+    bool        gameHasPersistentCache() override { return true; }
+    bool        gameHasSlicedSearch() override { return true; }
+    std::unique_ptr<ProtocolGame> aiPosition() override;
+    bool        applyAIMove(const std::string &move) override;
     Grid* getGrid() override { return _grid; }
 
+    // the board as a GamePosition and back
+    ConnectFourBoard position();
+    void        setPosition(const ConnectFourBoard &position);
+
 private:
     // Constants
     static const int ROWX = 7;
@@ -38,8 +51,10 @@ private:
     static const int HUMAN_PLAYER = 0;
     static const int YELLOW_PLAYER = 0; // Yellow goes first in Connect Four
     static const int RED_PLAYER = 1;
-    static const int TRIPLE_MULT = 5; // Multiplier used for lines of three pieces
     static const int MAX_VALUE = 1000;
+    static const int AI_TIME_BUDGET_MS = 500;
+    static constexpr const char *TABLE_CACHE = "cache/connectfour.tt";
+    static constexpr const char *OPENING_BOOK = "book/connectfour.book";
 
     // Helper methods
     Bit*        createPiece(int pieceType);     
@@ -50,7 +65,12 @@ private:
     bool        ownersAreTheSame(Player *owner1, Player *owner2, Player *owner3, Player *owner4);
     bool        ownerNumbersAreTheSame(const int *owners);
     Player*     ownerAt(int x, int y);
+    void        updateTableCache(bool save);
 
     // Board representation
     Grid*        _grid;
+    SearchEngine<ConnectFourTraits> _engine;
+    MctsEngine<ConnectFourTraits> _mcts{ { MctsOptions::UCT, 1.0f, 0, 1 << 20, true } };
+    SearchEngine<ConnectFourNnueTraits> _nnueEngine;
+    OpeningBook  _book;
 };
\ No newline at end of file
@@ -0,0 +1,284 @@
+#pragma once
+
+#include "Bitboard.h"
+#include "EvalWeights.h"
+#include "Position.h"
+#include "Symmetry.h"
+#include <array>
+#include <cstdlib>
+#include <string>
+
+namespace ConnectFourLayout
+{
+    constexpr int WIDTH = 7;
+    constexpr int HEIGHT = 6;
+    constexpr int STRIDE = HEIGHT + 1;
+    constexpr int WINDOWS = 69;
+
+    constexpr uint64_t columnMask(int x) { return ((1ull << HEIGHT) - 1) << (x * STRIDE); }
+
+    constexpr uint64_t bottomMask()
+    {
+        uint64_t m = 0;
+        for (int x = 0; x < WIDTH; x++) m |= 1ull << (x * STRIDE);
+        return m;
+    }
+
+    //
+    // every run of four cells a line can be made on
+    //
+    constexpr std::array<uint64_t, WINDOWS> makeWindows()
+    {
+        std::array<uint64_t, WINDOWS> windows{};
+        const int dx[4] = { 1, 0, 1, 1 };
+        const int dy[4] = { 0, 1, 1, -1 };
+        int n = 0;
+        for (int d = 0; d < 4; d++) {
+            for (int x = 0; x < WIDTH; x++) {
+                for (int y = 0; y < HEIGHT; y++) {
+                    int endX = x + 3 * dx[d];
+                    int endY = y + 3 * dy[d];
+                    if (endX >= WIDTH || endY < 0 || endY >= HEIGHT) continue;
+                    uint64_t m = 0;
+                    for (int i = 0; i < 4; i++) m |= 1ull << ((x + i * dx[d]) * STRIDE + y + i * dy[d]);
+                    windows[n++] = m;
+                }
+            }
+        }
+        return windows;
+    }
+}
+
+//
+// the open lines evaluation's weights: what an open two and an open three are worth. the built-in values
+// are ConnectFour::scoreOfLine's, a two counts its discs and a three TRIPLE_MULT times its discs
+//
+struct ConnectFourWeights
+{
+    enum { PAIR, TRIPLE, COUNT };
+    static constexpr int TRIPLE_MULT = 5;
+    static constexpr const char *NAMES[COUNT] = { "pair", "triple" };
+    static constexpr const char *WEIGHTS_FILE = "weights/connectfour.eval";
+
+    int         values[COUNT] = { 2, 3 * TRIPLE_MULT };
+};
+
+//
+// bitboard core for Connect Four, column major with 7 bits per column (6 cells and a sentinel)
+// bit x * 7 + row, row 0 is the bottom. state strings follow ConnectFour::stateString():
+// index x * 6 + y with y = 0 the top row, '1' for player 0 (yellow, moves first) and '2' for player 1
+// a GamePosition with the column as the move, centre columns generated first
+//
+struct ConnectFourBoard
+{
+    using Move = int;
+    using Undo = NoUndo;
+
+    static constexpr int WIDTH = ConnectFourLayout::WIDTH;
+    static constexpr int HEIGHT = ConnectFourLayout::HEIGHT;
+    static constexpr int STRIDE = ConnectFourLayout::STRIDE;
+    static constexpr int WINDOWS = ConnectFourLayout::WINDOWS;
+    static constexpr int MAX_MOVES = WIDTH;
+
+    static constexpr int MAX_VALUE = 1000;
+
+    static constexpr uint64_t BOTTOM = ConnectFourLayout::bottomMask();
+    static constexpr uint64_t FULL = BOTTOM * ((1ull << HEIGHT) - 1);
+    static constexpr std::array<uint64_t, WINDOWS> WINDOW_MASKS = ConnectFourLayout::makeWindows();
+
+    static constexpr uint64_t columnMask(int x) { return ConnectFourLayout::columnMask(x); }
+    static constexpr uint64_t topMask(int x) { return 1ull << (x * STRIDE + HEIGHT - 1); }
+
+    uint64_t    discs[2] = { 0, 0 };
+    int         side = 0;
+    int         moves = 0;
+
+    static constexpr ConnectFourBoard initial() { return ConnectFourBoard(); }
+
+    constexpr uint64_t occupied() const { return discs[0] | discs[1]; }
+    constexpr bool canPlay(int x) const { return !(occupied() & topMask(x)); }
+
+    // bit of the cell a disc dropped in column x lands on
+    constexpr uint64_t dropCell(int x) const { return (occupied() + (BOTTOM & columnMask(x))) & columnMask(x); }
+
+    constexpr void play(int x)
+    {
+        discs[side] |= dropCell(x);
+        side ^= 1;
+        moves++;
+    }
+
+    //
+    // GamePosition
+    //
+    int         sideToMove() const { return side; }
+    bool        isTerminal() const { return isOver(); }
+
+    // the side to move's discs plus the occupied cells pushed up a row is unique for every position
+    uint64_t    hash() const { return mixPositionKey(discs[side] + occupied() + BOTTOM); }
+
+    void generateMoves(MoveList<Move, MAX_MOVES> &moves) const
+    {
+        static constexpr int ORDER[WIDTH] = { 3, 2, 4, 1, 5, 0, 6 };
+        moves.clear();
+        if (isOver()) return;
+        for (int x : ORDER) {
+            if (canPlay(x)) moves.push(x);
+        }
+    }
+
+    NoUndo makeMove(Move move)
+    {
+        play(move);
+        return {};
+    }
+
+    // the top disc of the column is the one just played
+    void unmakeMove(Move move, NoUndo)
+    {
+        uint64_t column = occupied() & columnMask(move);
+        side ^= 1;
+        moves--;
+        discs[side] &= ~(1ull << (63 - std::countl_zero(column)));
+    }
+
+    static constexpr bool hasFour(uint64_t m)
+    {
+        for (int shift : { 1, STRIDE, STRIDE - 1, STRIDE + 1 }) {
+            uint64_t pairs = m & (m >> shift);
+            if (pairs & (pairs >> (2 * shift))) return true;
+        }
+        return false;
+    }
+
+    constexpr bool isWon(int player) const { return hasFour(discs[player]); }
+    constexpr bool isFull() const { return moves == WIDTH * HEIGHT; }
+    constexpr bool isOver() const { return isWon(0) || isWon(1) || isFull(); }
+
+    //
+    // open lines of two and three from player's point of view, lines holding none of the opponent's discs
+    // every window counts once (the string version counts the middle column's vertical lines twice)
+    //
+    constexpr void countLines(int player, int &twos, int &threes) const
+    {
+        twos = threes = 0;
+        for (uint64_t window : WINDOW_MASKS) {
+            if (window & discs[player ^ 1]) continue;
+            int own = Bitboard::popCount(window & discs[player]);
+            if (own == 3) threes++;
+            else if (own == 2) twos++;
+        }
+    }
+
+    int lineScore(int player, const ConnectFourWeights &weights) const
+    {
+        int twos, threes;
+        countLines(player, twos, threes);
+        return twos * weights.values[ConnectFourWeights::PAIR] + threes * weights.values[ConnectFourWeights::TRIPLE];
+    }
+
+    int evaluate(int player) const
+    {
+        if (isWon(player)) return MAX_VALUE;
+        if (isWon(player ^ 1)) return -MAX_VALUE;
+        const ConnectFourWeights &weights = evalWeights<ConnectFourWeights>();
+        return lineScore(player, weights) - lineScore(player ^ 1, weights);
+    }
+
+    std::string toString() const
+    {
+        std::string state(WIDTH * HEIGHT, '0');
+        for (int x = 0; x < WIDTH; x++) {
+            for (int y = 0; y < HEIGHT; y++) {
+                uint64_t cell = 1ull << (x * STRIDE + HEIGHT - 1 - y);
+                if (discs[0] & cell) state[x * HEIGHT + y] = '1';
+                else if (discs[1] & cell) state[x * HEIGHT + y] = '2';
+            }
+        }
+        return state;
+    }
+
+    bool fromString(const std::string &state, int sideToMove)
+    {
+        if ((int)state.length() != WIDTH * HEIGHT) return false;
+        discs[0] = discs[1] = 0;
+        moves = 0;
+        for (int x = 0; x < WIDTH; x++) {
+            for (int y = 0; y < HEIGHT; y++) {
+                char c = state[x * HEIGHT + y];
+                if (c != '1' && c != '2') continue;
+                discs[c - '1'] |= 1ull << (x * STRIDE + HEIGHT - 1 - y);
+                moves++;
+            }
+        }
+        side = sideToMove & 1;
+        return true;
+    }
+};
+
+static_assert(GamePosition<ConnectFourBoard>);
+
+//
+// connect four is the same game mirrored left to right, moves are columns
+//
+template <>
+struct Symmetry<ConnectFourBoard>
+{
+    static constexpr int COUNT = 2;
+
+    // the columns in the opposite order, each a 7 bit group
+    static uint64_t mirror(uint64_t discs)
+    {
+        uint64_t mirrored = 0;
+        for (int x = 0; x < ConnectFourBoard::WIDTH; x++) {
+            mirrored |= ((discs >> (x * ConnectFourBoard::STRIDE)) & 0x7F) << ((ConnectFourBoard::WIDTH - 1 - x) * ConnectFourBoard::STRIDE);
+        }
+        return mirrored;
+    }
+
+    static ConnectFourBoard apply(const ConnectFourBoard &board, int symmetry)
+    {
+        ConnectFourBoard result = board;
+        if (symmetry) {
+            result.discs[0] = mirror(board.discs[0]);
+            result.discs[1] = mirror(board.discs[1]);
+        }
+        return result;
+    }
+
+    static int applyMove(int move, int symmetry) { return symmetry ? ConnectFourBoard::WIDTH - 1 - move : move; }
+    static constexpr int inverse(int symmetry) { return symmetry; }
+};
+
+//
+// SearchEngine traits, the open lines evaluation from the side to move's point of view
+//
+struct ConnectFourTraits
+{
+    using Position = ConnectFourBoard;
+    using Weights = ConnectFourWeights;
+    static constexpr int HISTORY_SIZE = ConnectFourBoard::WIDTH;
+
+    static int evaluate(const Position &board) { return board.evaluate(board.side); }
+    // the differences the weights apply to, side to move minus opponent, for positions nobody has won
+    static void terms(const Position &board, int (&values)[Weights::COUNT])
+    {
+        int twos[2], threes[2];
+        board.countLines(board.side, twos[0], threes[0]);
+        board.countLines(board.side ^ 1, twos[1], threes[1]);
+        values[Weights::PAIR] = twos[0] - twos[1];
+        values[Weights::TRIPLE] = threes[0] - threes[1];
+    }
+    // only the player who just moved can have made four
+    static int result(const Position &board) { return board.isWon(board.side ^ 1) ? -1 : 0; }
+    static int historyIndex(int move) { return move; }
+
+    // MCTS move weights: a winning drop, a drop that blocks four, then the centre columns
+    static float prior(const Position &board, int move)
+    {
+        uint64_t cell = board.dropCell(move);
+        if (ConnectFourBoard::hasFour(board.discs[board.side] | cell)) return 50.0f;
+        if (ConnectFourBoard::hasFour(board.discs[board.side ^ 1] | cell)) return 20.0f;
+        return (float)(ConnectFourBoard::WIDTH / 2 + 1 - std::abs(move - ConnectFourBoard::WIDTH / 2));
+    }
+};
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "CheckersBoard.h"
+#include "CheckersEngine.h"
+#include "InternationalBoard.h"
+#include "Position.h"
+#include "Symmetry.h"
+#include <algorithm>
+#include <vector>
+
+//
+// checkers and international draughts as a GamePosition. a move can promote and take a whole row of
+// pieces, so the undo record is the board from before it: a few dozen bytes, still no allocation
+//
+template <class Board>
+struct DraughtsPosition
+{
+    using Move = typename Board::Move;
+    using Undo = Board;
+
+    static constexpr int MAX_MOVES = Board::MAX_MOVES;
+
+    Board       board = Board::initial();
+
+    int         sideToMove() const { return board.sideToMove(); }
+    uint64_t    hash() const { return board.hash(); }
+
+    // the side to move has lost when it has nothing left to move
+    bool        isTerminal() const { return !board.movers() && !board.jumpers(); }
+
+    void generateMoves(MoveList<Move, MAX_MOVES> &moves) const
+    {
+        moves.resize(board.generateMoves(moves.data()));
+    }
+
+    Board makeMove(const Move &move)
+    {
+        Board before = board;
+        board.makeMove(move);
+        return before;
+    }
+
+    void unmakeMove(const Move &, const Board &before) { board = before; }
+
+    std::string toString() const { return board.toString(); }
+    bool fromString(const std::string &state, int sideToMove) { return board.fromString(state, sideToMove & 1); }
+};
+
+static_assert(GamePosition<DraughtsPosition<CheckersBoard>>);
+static_assert(GamePosition<DraughtsPosition<InternationalBoard>>);
+
+//
+// the colour flip: the board turned half way round with red and yellow swapped, and the other side to move
+// square 0 becomes the last square. the 8x8 board has its own flipped(), a bit reversal
+//
+template <class Board>
+struct Symmetry<DraughtsPosition<Board>>
+{
+    using Position = DraughtsPosition<Board>;
+    using Move = typename Board::Move;
+    using Mask = typename Board::Mask;
+    static constexpr int COUNT = 2;
+
+    static int flipSquare(int square)
+    {
+        return Board::squareAt(Board::WIDTH - 1 - Board::squareX(square), Board::WIDTH - 1 - Board::squareY(square));
+    }
+
+    static int flipPiece(int pieceType)
+    {
+        if (pieceType == Board::EMPTY) return pieceType;
+        return pieceType <= Board::RED_KING ? pieceType + 2 : pieceType - 2;
+    }
+
+    static Position apply(const Position &position, int symmetry)
+    {
+        if (!symmetry) return position;
+        Position result;
+        if constexpr (requires { position.board.flipped(); }) {
+            result.board = position.board.flipped();
+        } else {
+            result.board = Board();
+            Mask pieces = position.board.occupied();
+            while (pieces) {
+                int square = Bitboard::popLowestBit(pieces);
+                result.board.setPiece(flipSquare(square), flipPiece(position.board.pieceAt(square)));
+            }
+            result.board.setSideToMove(position.board.sideToMove() ^ 1);
+        }
+        return result;
+    }
+
+    static Move applyMove(const Move &move, int symmetry)
+    {
+        if (!symmetry) return move;
+        Move result = move;
+        result.from = (uint8_t)flipSquare(move.from);
+        for (int step = 0; step < move.steps; step++) result.path[step] = (uint8_t)flipSquare(move.path[step]);
+        Mask captured = move.captured;
+        result.captured = 0;
+        while (captured) result.captured |= Bitboard::bit<Mask>(flipSquare(Bitboard::popLowestBit(captured)));
+        return result;
+    }
+
+    static constexpr int inverse(int symmetry) { return symmetry; }
+};
+
+//
+// SearchEngine traits, the DraughtsEngine's evaluation without its quiescence search or endgame database
+//
+template <class Board>
+struct DraughtsTraits
+{
+    using Position = DraughtsPosition<Board>;
+    static constexpr int HISTORY_SIZE = Board::BITS * Board::BITS;
+
+    static int evaluate(const Position &position) { return DraughtsEngine<Board>::evaluate(position.board); }
+    // a side with nothing to move has lost
+    static int result(const Position &) { return -1; }
+    static int historyIndex(const typename Board::Move &move) { return move.from * Board::BITS + move.to(); }
+};
+
+//
+// the positions of a game since its last capture or man move, by board hash with the side to move in
+// it. only king moves that take nothing can lead back to one of them. the last entry is the position
+// on the board, so asking how often it occurred can be done any number of times
+//
+template <class Board>
+class DraughtsRepetitions
+{
+public:
+    void reset(const Board &board) { _hashes.assign(1, board.hash()); }
+    void clear() { _hashes.clear(); }
+
+    // makes the move on board and records the position it leads to
+    void play(Board &board, const typename Board::Move &move)
+    {
+        int pieceType = board.pieceAt(move.from);
+        bool irreversible = move.captured || pieceType == Board::RED_PIECE || pieceType == Board::YELLOW_PIECE;
+        board.makeMove(move);
+        if (irreversible) _hashes.clear();
+        _hashes.push_back(board.hash());
+    }
+
+    int occurrences(const Board &board) const { return (int)std::count(_hashes.begin(), _hashes.end(), board.hash()); }
+
+private:
+    std::vector<uint64_t> _hashes;
+};
@@ -0,0 +1,551 @@
+#include "EngineProtocol.h"
+#include "CheckersEngine.h"
+#include "ConnectFourBoard.h"
+#include "OthelloBoard.h"
+#include "ProofSolver.h"
+#include "Search.h"
+#include "TicTacToeBoard.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <sstream>
+#include <type_traits>
+
+namespace {
+    const char* const CHECKERS_DATABASE_DIRECTORY = "egdb/checkers";
+
+    // grid squares are a column letter and a row number counted from the top, like the Grid
+    std::string squareName(int x, int y)
+    {
+        return std::string(1, (char)('a' + x)) + std::to_string(y + 1);
+    }
+
+    //
+    // SearchEngine traits plus what the protocol needs: the game's name and its move notation
+    //
+    struct TicTacToeRules : TicTacToeTraits
+    {
+        static const char*  name() { return "tictactoe"; }
+        static std::string  moveName(int move) { return squareName(move % 3, move / 3); }
+    };
+
+    struct ConnectFourRules : ConnectFourTraits
+    {
+        static const char*  name() { return "connectfour"; }
+        static std::string  moveName(int move) { return std::string(1, (char)('a' + move)); }
+    };
+
+    template <int N>
+    struct OthelloRules : OthelloTraits<N>
+    {
+        static const char* name() { return N == 8 ? "othello" : N == 6 ? "othello6" : "othello10"; }
+
+        static std::string moveName(int move)
+        {
+            return move == OthelloPosition<N>::PASS ? "pass" : squareName(move % N, move / N);
+        }
+    };
+
+    //
+    // the small games on a SearchEngine, the table is sized to the memory limit. proofs use a ProofSolver
+    // whose table only grows on the first proof, to the same limit
+    //
+    template <class Rules>
+    class SearchProtocolGame : public ProtocolGame
+    {
+    public:
+        using Position = typename Rules::Position;
+        using Move = typename Position::Move;
+        using Engine = SearchEngine<Rules>;
+        using Solver = ProofSolver<Rules>;
+
+        // the smallest transposition table worth searching with
+        static const size_t MIN_TABLE_BYTES = 16 * 1024;
+
+        const char*     name() const override { return Rules::name(); }
+        void            reset() override { _position = Position(); }
+        bool            setState(const std::string &state, int side) override { return _position.fromString(state, side); }
+        std::string     state() const override { return _position.toString(); }
+        int             sideToMove() const override { return _position.sideToMove(); }
+        bool            isOver() const override { return _position.isTerminal(); }
+        void            newGame() override { _engine.clearTable(); }
+        size_t          memoryUsage() const override { return fixedBytes() + _engine.tableBytes() + _solver.tableBytes(); }
+
+        void stop() override
+        {
+            _engine.stop();
+            _solver.stop();
+        }
+
+        // never more than the engine's default table
+        bool setMemoryLimit(size_t bytes) override
+        {
+            if (bytes < fixedBytes() + MIN_TABLE_BYTES) return false;
+            _engine.resizeTable(std::min(bytes - fixedBytes(), Engine::DEFAULT_TABLE_BYTES));
+            _proofTableBytes = std::min(bytes - fixedBytes() - _engine.tableBytes(), Solver::DEFAULT_TABLE_BYTES);
+            if (_solver.tableBytes() > _proofTableBytes) _solver.resizeTable(_proofTableBytes);
+            return true;
+        }
+
+        std::vector<std::string> legalMoves() const override
+        {
+            MovesOf<Position> moves;
+            if (!_position.isTerminal()) _position.generateMoves(moves);
+            std::vector<std::string> names;
+            for (Move move : moves) names.push_back(Rules::moveName(move));
+            return names;
+        }
+
+        bool playMove(const std::string &move) override
+        {
+            if (_position.isTerminal()) return false;
+            MovesOf<Position> moves;
+            _position.generateMoves(moves);
+            for (Move legal : moves) {
+                if (Rules::moveName(legal) == move) {
+                    _position.makeMove(legal);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        std::string search(const ProtocolLimits &limits, const InfoCallback &onInfo) override
+        {
+            SearchLimits engineLimits;
+            engineLimits.depth = limits.depth;
+            engineLimits.timeMs = limits.timeMs;
+            engineLimits.nodes = limits.nodes;
+            engineLimits.stop = limits.stop;
+
+            _engine.setIterationCallback([&](const typename Engine::Result &result) {
+                if (!onInfo) return;
+                ProtocolInfo info;
+                info.depth = result.depth;
+                info.score = result.score;
+                info.mateIn = result.mateIn;
+                info.nodes = result.stats.nodes;
+                info.timeMs = result.stats.timeMs;
+                for (Move move : result.pv) info.pv.push_back(Rules::moveName(move));
+                onInfo(info);
+            });
+            typename Engine::Result result = _engine.search(_position, engineLimits);
+            _engine.setIterationCallback(nullptr);
+            return result.hasMove ? Rules::moveName(result.bestMove) : "";
+        }
+
+        bool prove(const ProtocolLimits &limits, ProtocolProof &proof) override
+        {
+            static const char* const RESULTS[] = { "unknown", "win", "draw", "loss" };
+            if (_solver.tableBytes() < _proofTableBytes) _solver.resizeTable(_proofTableBytes);
+
+            ProofLimits solverLimits;
+            solverLimits.timeMs = limits.timeMs;
+            solverLimits.nodes = limits.nodes;
+            solverLimits.stop = limits.stop;
+            typename Solver::Result result = _solver.solve(_position, solverLimits);
+            proof.result = RESULTS[(int)result.outcome];
+            proof.line.clear();
+            for (Move move : result.line) proof.line.push_back(Rules::moveName(move));
+            proof.treeNodes = result.tree.size();
+            proof.treeComplete = result.complete;
+            proof.nodes = result.stats.nodes;
+            proof.timeMs = result.stats.timeMs;
+            proof.tableEntries = result.stats.tableEntries;
+            proof.collections = result.stats.collections;
+            return true;
+        }
+
+    private:
+        // everything but the tables, the engine's search stack is tens of kilobytes for the bigger boards
+        size_t          fixedBytes() const { return sizeof(*this) + _engine.frameBytes(); }
+
+        Position            _position;
+        Engine              _engine;
+        Solver              _solver{ 0 };
+        size_t              _proofTableBytes = Solver::DEFAULT_TABLE_BYTES;
+    };
+
+    //
+    // checkers and international draughts use the DraughtsEngine, squares are numbered 1 up in
+    // reading order over the dark squares, "-" joins a simple move and "x" every landing square of a jump
+    //
+    template <class Board>
+    class DraughtsProtocolGame : public ProtocolGame
+    {
+    public:
+        using Move = typename Board::Move;
+
+        // the smallest transposition table worth searching with
+        static const size_t MIN_TABLE_BYTES = 64 * 1024;
+
+        DraughtsProtocolGame() : _board(Board::initial())
+        {
+            if constexpr (std::is_same_v<Board, CheckersBoard>) {
+                _engine.setDatabase(sharedDatabase());
+            }
+        }
+
+        const char*     name() const override { return std::is_same_v<Board, CheckersBoard> ? "checkers" : "international"; }
+        void            reset() override { _board = Board::initial(); }
+        bool            setState(const std::string &state, int side) override { return _board.fromString(state, side & 1); }
+        std::string     state() const override { return _board.toString(); }
+        int             sideToMove() const override { return _board.sideToMove(); }
+        void            newGame() override { _engine.clearTable(); }
+        void            stop() override { _engine.stop(); }
+        size_t          memoryUsage() const override { return sizeof(*this) + _engine.tableBytes(); }
+
+        // never more than the engine's default table
+        bool setMemoryLimit(size_t bytes) override
+        {
+            if (bytes < sizeof(*this) + MIN_TABLE_BYTES) return false;
+            _engine.resizeTable(std::min(bytes - sizeof(*this), _defaultTableBytes));
+            return true;
+        }
+
+        bool isOver() const override
+        {
+            Move moves[Board::MAX_MOVES];
+            return _board.generateMoves(moves) == 0;
+        }
+
+        std::vector<std::string> legalMoves() const override
+        {
+            Move moves[Board::MAX_MOVES];
+            int count = _board.generateMoves(moves);
+            std::vector<std::string> names;
+            for (int i = 0; i < count; i++) names.push_back(moveName(moves[i]));
+            return names;
+        }
+
+        // a jump may also be given as just its first and last square when that is unambiguous
+        bool playMove(const std::string &move) override
+        {
+            Move moves[Board::MAX_MOVES];
+            int count = _board.generateMoves(moves);
+            int shortMatch = -1;
+            int shortMatches = 0;
+            for (int i = 0; i < count; i++) {
+                if (moveName(moves[i]) == move) {
+                    _board.makeMove(moves[i]);
+                    return true;
+                }
+                if (moves[i].isCapture() && shortName(moves[i]) == move) {
+                    shortMatch = i;
+                    shortMatches++;
+                }
+            }
+            if (shortMatches != 1) return false;
+            _board.makeMove(moves[shortMatch]);
+            return true;
+        }
+
+        std::string search(const ProtocolLimits &limits, const InfoCallback &onInfo) override
+        {
+            CheckersSearchLimits engineLimits;
+            if (limits.depth > 0) engineLimits.maxDepth = std::min(limits.depth, engineLimits.maxDepth);
+            engineLimits.timeMs = limits.timeMs;
+            engineLimits.maxNodes = limits.nodes;
+            engineLimits.stop = limits.stop;
+
+            _engine.setIterationCallback([&](const typename DraughtsEngine<Board>::Result &result) {
+                if (onInfo) onInfo(toInfo(result));
+            });
+            typename DraughtsEngine<Board>::Result result = _engine.search(_board, engineLimits);
+            _engine.setIterationCallback(nullptr);
+            return result.hasMove ? moveName(result.bestMove) : "";
+        }
+
+    private:
+        // one mapping of the endgame database for every checkers game in the process, null when there is none
+        static const CheckersDatabase* sharedDatabase()
+        {
+            static const CheckersDatabase* database = [] {
+                static CheckersDatabase loaded;
+                return loaded.open(CHECKERS_DATABASE_DIRECTORY) > 0 ? &loaded : nullptr;
+            }();
+            return database;
+        }
+
+        static int squareNumber(int square)
+        {
+            return Board::squareY(square) * (Board::WIDTH / 2) + Board::squareX(square) / 2 + 1;
+        }
+
+        static std::string moveName(const Move &move)
+        {
+            std::string name = std::to_string(squareNumber(move.from));
+            for (int i = 0; i < move.steps; i++) {
+                name += move.isCapture() ? "x" : "-";
+                name += std::to_string(squareNumber(move.path[i]));
+            }
+            return name;
+        }
+
+        static std::string shortName(const Move &move)
+        {
+            return std::to_string(squareNumber(move.from)) + "x" + std::to_string(squareNumber(move.to()));
+        }
+
+        static ProtocolInfo toInfo(const typename DraughtsEngine<Board>::Result &result)
+        {
+            ProtocolInfo info;
+            info.depth = result.depth;
+            info.score = result.score;
+            if (DraughtsEngine<Board>::isWinScore(result.score)) {
+                int plies = DraughtsEngine<Board>::WIN_SCORE - std::abs(result.score);
+                info.mateIn = result.score > 0 ? (plies + 1) / 2 : -(plies / 2);
+            }
+            info.nodes = result.nodes;
+            info.timeMs = result.timeMs;
+            for (const Move &move : result.pv) info.pv.push_back(moveName(move));
+            return info;
+        }
+
+        Board                   _board;
+        DraughtsEngine<Board>   _engine;
+        size_t                  _defaultTableBytes = _engine.tableBytes();
+    };
+
+    std::vector<std::string> splitWords(const std::string &line)
+    {
+        std::istringstream stream(line);
+        std::vector<std::string> words;
+        std::string word;
+        while (stream >> word) words.push_back(word);
+        return words;
+    }
+}
+
+std::unique_ptr<ProtocolGame> ProtocolGame::create(const std::string &name)
+{
+    if (name == "tictactoe") return std::make_unique<SearchProtocolGame<TicTacToeRules>>();
+    if (name == "connectfour") return std::make_unique<SearchProtocolGame<ConnectFourRules>>();
+    if (name == "othello") return std::make_unique<SearchProtocolGame<OthelloRules<8>>>();
+    if (name == "othello6") return std::make_unique<SearchProtocolGame<OthelloRules<6>>>();
+    if (name == "othello10") return std::make_unique<SearchProtocolGame<OthelloRules<10>>>();
+    if (name == "checkers") return std::make_unique<DraughtsProtocolGame<CheckersBoard>>();
+    if (name == "international") return std::make_unique<DraughtsProtocolGame<InternationalBoard>>();
+    return nullptr;
+}
+
+std::vector<std::string> ProtocolGame::names()
+{
+    return { "tictactoe", "connectfour", "othello", "othello6", "othello10", "checkers", "international" };
+}
+
+EngineProtocol::EngineProtocol(const std::string &gameName, std::ostream &out) : _out(out), _stopRequested(false), _infinite(false)
+{
+    setGame(gameName);
+    if (!_game) _game = ProtocolGame::create("connectfour");
+}
+
+EngineProtocol::~EngineProtocol()
+{
+    stopSearch();
+}
+
+void EngineProtocol::run(std::istream &in)
+{
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!handle(line)) return;
+    }
+    // end of input waits for a running search to report its move, an infinite one would never stop
+    if (_infinite) stopSearch();
+    else if (_searchThread.joinable()) _searchThread.join();
+}
+
+bool EngineProtocol::handle(const std::string &line)
+{
+    std::vector<std::string> words = splitWords(line);
+    if (words.empty()) return true;
+    const std::string &command = words[0];
+
+    if (command == "uci") {
+        send("id name boardgames " + std::string(_game->name()));
+        std::string option = "option name Game type combo default " + std::string(_game->name());
+        for (const std::string &name : ProtocolGame::names()) option += " var " + name;
+        send(option);
+        send("uciok");
+    } else if (command == "isready") {
+        send("readyok");
+    } else if (command == "ucinewgame") {
+        stopSearch();
+        _game->newGame();
+        _game->reset();
+    } else if (command == "setoption") {
+        // setoption name Game value <name>
+        auto name = std::find(words.begin(), words.end(), "name");
+        auto value = std::find(words.begin(), words.end(), "value");
+        if (name + 1 < words.end() && *(name + 1) == "Game" && value + 1 < words.end()) {
+            stopSearch();
+            setGame(*(value + 1));
+        }
+    } else if (command == "position") {
+        stopSearch();
+        setPosition(words);
+    } else if (command == "go") {
+        stopSearch();
+        startSearch(words);
+    } else if (command == "prove") {
+        stopSearch();
+        startProof(words);
+    } else if (command == "stop") {
+        stopSearch();
+    } else if (command == "d") {
+        std::string moves;
+        for (const std::string &move : _game->legalMoves()) moves += " " + move;
+        send("game " + std::string(_game->name()) + " state " + _game->state() + " side " + std::to_string(_game->sideToMove()));
+        send("moves" + moves);
+    } else if (command == "quit") {
+        stopSearch();
+        return false;
+    } else {
+        send("info string unknown command " + command);
+    }
+    return true;
+}
+
+void EngineProtocol::send(const std::string &line)
+{
+    std::lock_guard<std::mutex> lock(_outMutex);
+    _out << line << std::endl;
+}
+
+void EngineProtocol::setGame(const std::string &name)
+{
+    std::unique_ptr<ProtocolGame> game = ProtocolGame::create(name);
+    if (!game) {
+        send("info string unknown game " + name);
+        return;
+    }
+    _game = std::move(game);
+}
+
+void EngineProtocol::setPosition(const std::vector<std::string> &words)
+{
+    size_t next = 1;
+    if (next < words.size() && words[next] == "startpos") {
+        _game->reset();
+        next++;
+    } else if (next + 2 < words.size() && words[next] == "state") {
+        if (!_game->setState(words[next + 1], std::atoi(words[next + 2].c_str()))) {
+            send("info string bad state " + words[next + 1]);
+            _game->reset();
+            return;
+        }
+        next += 3;
+    } else {
+        send("info string position needs startpos or state <state> <side>");
+        return;
+    }
+
+    if (next < words.size() && words[next] == "moves") {
+        for (next++; next < words.size(); next++) {
+            if (!_game->playMove(words[next])) {
+                send("info string illegal move " + words[next]);
+                return;
+            }
+        }
+    }
+}
+
+void EngineProtocol::startSearch(const std::vector<std::string> &words)
+{
+    ProtocolLimits limits;
+    int clock[2] = { 0, 0 };
+    int increment[2] = { 0, 0 };
+    bool infinite = false;
+    for (size_t i = 1; i < words.size(); i++) {
+        const std::string &word = words[i];
+        bool hasValue = i + 1 < words.size();
+        if (word == "infinite") infinite = true;
+        else if (word == "depth" && hasValue) limits.depth = std::atoi(words[++i].c_str());
+        else if (word == "movetime" && hasValue) limits.timeMs = std::atoi(words[++i].c_str());
+        else if (word == "nodes" && hasValue) limits.nodes = std::strtoull(words[++i].c_str(), nullptr, 10);
+        else if (word == "wtime" && hasValue) clock[0] = std::atoi(words[++i].c_str());
+        else if (word == "btime" && hasValue) clock[1] = std::atoi(words[++i].c_str());
+        else if (word == "winc" && hasValue) increment[0] = std::atoi(words[++i].c_str());
+        else if (word == "binc" && hasValue) increment[1] = std::atoi(words[++i].c_str());
+    }
+
+    // w is the side that moves first in every game
+    int side = _game->sideToMove();
+    if (!limits.timeMs && clock[side] > 0) {
+        limits.timeMs = std::max(1, std::min(clock[side] / 30 + increment[side] / 2, clock[side] / 2));
+    }
+    if (infinite) limits = ProtocolLimits();
+    else if (!limits.depth && !limits.timeMs && !limits.nodes) infinite = true;
+
+    _stopRequested = false;
+    _infinite = infinite;
+    limits.stop = &_stopRequested;
+    _searchThread = std::thread([this, limits, infinite]() {
+        std::string bestMove = _game->search(limits, [this](const ProtocolInfo &info) {
+            uint64_t nps = info.nodes * 1000 / (uint64_t)std::max(1, info.timeMs);
+            std::string line = "info depth " + std::to_string(info.depth);
+            line += info.mateIn ? " score mate " + std::to_string(info.mateIn) : " score cp " + std::to_string(info.score);
+            line += " nodes " + std::to_string(info.nodes) + " nps " + std::to_string(nps) + " time " + std::to_string(info.timeMs);
+            if (!info.pv.empty()) {
+                line += " pv";
+                for (const std::string &move : info.pv) line += " " + move;
+            }
+            send(line);
+        });
+
+        // an infinite search only reports its move when told to stop
+        if (infinite) {
+            std::unique_lock<std::mutex> lock(_stopMutex);
+            _stopChanged.wait(lock, [this] { return _stopRequested.load(); });
+        }
+        send("bestmove " + (bestMove.empty() ? std::string("(none)") : bestMove));
+    });
+}
+
+//
+// a proof runs on the search thread and ends with a proof line and the first move of its main line
+//
+void EngineProtocol::startProof(const std::vector<std::string> &words)
+{
+    ProtocolLimits limits;
+    for (size_t i = 1; i + 1 < words.size(); i++) {
+        if (words[i] == "movetime") limits.timeMs = std::atoi(words[++i].c_str());
+        else if (words[i] == "nodes") limits.nodes = std::strtoull(words[++i].c_str(), nullptr, 10);
+    }
+
+    _stopRequested = false;
+    _infinite = false;
+    limits.stop = &_stopRequested;
+    _searchThread = std::thread([this, limits]() {
+        ProtocolProof proof;
+        bool proved = _game->prove(limits, proof);
+        if (!proved) {
+            send("info string no solver for " + std::string(_game->name()));
+            send("bestmove (none)");
+            return;
+        }
+
+        std::string line = "proof " + proof.result + " nodes " + std::to_string(proof.nodes) + " time " + std::to_string(proof.timeMs);
+        line += " tree " + std::to_string(proof.treeNodes) + (proof.treeComplete ? " complete" : " partial");
+        line += " table " + std::to_string(proof.tableEntries) + " gc " + std::to_string(proof.collections);
+        if (!proof.line.empty()) {
+            line += " pv";
+            for (const std::string &move : proof.line) line += " " + move;
+        }
+        send(line);
+        send("bestmove " + (proof.line.empty() ? std::string("(none)") : proof.line[0]));
+    });
+}
+
+void EngineProtocol::stopSearch()
+{
+    if (!_searchThread.joinable()) return;
+    // the search's stop token, a search that hasn't got going yet still sees it
+    {
+        std::lock_guard<std::mutex> lock(_stopMutex);
+        _stopRequested = true;
+    }
+    _stopChanged.notify_all();
+    _searchThread.join();
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//
+// limits for a protocol search, zero means unlimited
+//
+struct ProtocolLimits
+{
+    int         depth = 0;
+    int         timeMs = 0;
+    uint64_t    nodes = 0;
+    // set by the caller to end the search, unlike ProtocolGame::stop it can't be missed by a search
+    // that hasn't started yet. the search never clears it
+    const std::atomic<bool> *stop = nullptr;
+};
+
+//
+// progress of a search, sent as an info line after every completed iteration
+// mateIn is the number of moves to a forced win (negative when losing), zero otherwise
+//
+struct ProtocolInfo
+{
+    int         depth = 0;
+    int         score = 0;
+    int         mateIn = 0;
+    uint64_t    nodes = 0;
+    int         timeMs = 0;
+    std::vector<std::string> pv;
+};
+
+//
+// a proof of the game's value from the current position, see ProofSolver
+//
+struct ProtocolProof
+{
+    std::string result;                 // win, draw or loss for the side to move, unknown when a limit ran out
+    std::vector<std::string> line;      // best play for both sides
+    size_t      treeNodes = 0;
+    bool        treeComplete = false;
+    uint64_t    nodes = 0;
+    int         timeMs = 0;
+    uint64_t    tableEntries = 0;
+    uint64_t    collections = 0;
+};
+
+//
+// a game as the protocol sees it: a position, moves in text notation and a search
+// implemented in EngineProtocol.cpp on top of the bitboard rules cores, so nothing here needs a window
+//
+class ProtocolGame
+{
+public:
+    using InfoCallback = std::function<void(const ProtocolInfo &)>;
+
+    virtual ~ProtocolGame() = default;
+
+    virtual const char*     name() const = 0;
+    virtual void            reset() = 0;
+    virtual bool            setState(const std::string &state, int side) = 0;
+    virtual std::string     state() const = 0;
+    virtual int             sideToMove() const = 0;
+    virtual std::vector<std::string> legalMoves() const = 0;
+    virtual bool            playMove(const std::string &move) = 0;
+    virtual bool            isOver() const = 0;
+    virtual void            newGame() {}
+
+    // bytes held by the game and its search tables, the tables are sized to fit under a limit
+    // setMemoryLimit returns false when the game can't be played in that little memory
+    virtual size_t          memoryUsage() const = 0;
+    virtual bool            setMemoryLimit(size_t bytes) = 0;
+
+    // returns the best move, or an empty string when there is none
+    virtual std::string     search(const ProtocolLimits &limits, const InfoCallback &onInfo) = 0;
+    virtual void            stop() = 0;
+
+    // proof-number search for the game's value, false when the game has no solver. stop() ends it too
+    virtual bool            prove(const ProtocolLimits &limits, ProtocolProof &proof) { return false; }
+
+    static std::unique_ptr<ProtocolGame> create(const std::string &name);
+    static std::vector<std::string> names();
+};
+
+//
+// a UCI-like text protocol over a pair of streams:
+//   uci, isready, ucinewgame, setoption name Game value <name>
+//   position startpos|state <state> <side> [moves m1 m2 ...]
+//   go [depth N] [movetime MS] [nodes N] [wtime MS btime MS winc MS binc MS] [infinite]
+//   prove [movetime MS] [nodes N]
+//   stop, d (print the position), quit
+// the search runs on its own thread so stop and isready are answered while it thinks
+//
+class EngineProtocol
+{
+public:
+    EngineProtocol(const std::string &gameName, std::ostream &out);
+    ~EngineProtocol();
+
+    // reads commands until quit or the end of input
+    void        run(std::istream &in);
+
+    // handles a single command line, returns false on quit
+    bool        handle(const std::string &line);
+
+private:
+    void        send(const std::string &line);
+    void        setPosition(const std::vector<std::string> &words);
+    void        startSearch(const std::vector<std::string> &words);
+    void        startProof(const std::vector<std::string> &words);
+    void        stopSearch();
+    void        setGame(const std::string &name);
+
+    std::unique_ptr<ProtocolGame> _game;
+    std::ostream&       _out;
+    std::mutex          _outMutex;
+    std::thread         _searchThread;
+    std::atomic<bool>   _stopRequested;         // the running search's stop token, see ProtocolLimits::stop
+    std::mutex          _stopMutex;
+    std::condition_variable _stopChanged;
+    bool                _infinite;              // the running search waits for stop to report its move
+};
@@ -0,0 +1,55 @@
+#include "EvalWeights.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+bool EvalWeights::load(const std::string &path, const char *const *names, int *values, int count)
+{
+    FILE *file = fopen(path.c_str(), "r");
+    if (!file) return false;
+
+    std::vector<int> loaded(count);
+    std::vector<bool> seen(count, false);
+    bool ok = true;
+    char name[64];
+    int value;
+    int fields;
+    while (ok && (fields = fscanf(file, "%63s %d", name, &value)) != EOF) {
+        if (fields != 2) {
+            ok = false;
+            break;
+        }
+        int index = 0;
+        while (index < count && strcmp(names[index], name) != 0) index++;
+        if (index == count) ok = false;
+        else {
+            loaded[index] = value;
+            seen[index] = true;
+        }
+    }
+    fclose(file);
+
+    for (int i = 0; i < count; i++) ok = ok && seen[i];
+    if (!ok) return false;
+    for (int i = 0; i < count; i++) values[i] = loaded[i];
+    return true;
+}
+
+bool EvalWeights::save(const std::string &path, const char *const *names, const int *values, int count)
+{
+    FILE *file = fopen(path.c_str(), "w");
+    if (!file) return false;
+    bool ok = true;
+    for (int i = 0; i < count; i++) ok = ok && fprintf(file, "%s %d\n", names[i], values[i]) > 0;
+    return fclose(file) == 0 && ok;
+}
+
+uint64_t EvalWeights::signature(const int *values, int count)
+{
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (int i = 0; i < count; i++) {
+        hash ^= (uint32_t)values[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
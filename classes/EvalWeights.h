@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+//
+// weights of the handcrafted evaluations, the built-in values unless a tuned file replaces them
+// a weights struct has COUNT, NAMES[COUNT], WEIGHTS_FILE and int values[COUNT] holding its defaults
+// the files are text, a "name value" line per weight, as texel_tune writes them
+//
+namespace EvalWeights
+{
+    // a file naming a weight the struct doesn't have, or missing one, leaves values as they were
+    bool    load(const std::string &path, const char *const *names, int *values, int count);
+    bool    save(const std::string &path, const char *const *names, const int *values, int count);
+    // a hash of the values, for anything keeping scores they produced
+    uint64_t signature(const int *values, int count);
+}
+
+template <class Weights>
+bool loadEvalWeights(const std::string &path, Weights &weights)
+{
+    return EvalWeights::load(path, Weights::NAMES, weights.values, Weights::COUNT);
+}
+
+template <class Weights>
+bool saveEvalWeights(const std::string &path, const Weights &weights)
+{
+    return EvalWeights::save(path, Weights::NAMES, weights.values, Weights::COUNT);
+}
+
+template <class Weights>
+uint64_t evalWeightsSignature(const Weights &weights)
+{
+    return EvalWeights::signature(weights.values, Weights::COUNT);
+}
+
+//
+// the weights an evaluation uses, read from the weights file the first time they are asked for
+// tools that tune them assign new ones here, between searches
+//
+template <class Weights>
+Weights& evalWeights()
+{
+    static Weights weights = [] {
+        Weights loaded;
+        loadEvalWeights(Weights::WEIGHTS_FILE, loaded);
+        return loaded;
+    }();
+    return weights;
+}
@@ -17,6 +17,11 @@ Game::Game()
 	_gameOptions.score = 0;
 	_gameOptions.AIDepthSearches = 0;
 	_gameOptions.AIvsAI = false;
+	_gameOptions.AIUseMCTS = false;
+	_gameOptions.AIUseNNUE = false;
+	_gameOptions.AIPersistentCache = true;
+	_gameOptions.AIFrameBudgetUs = 8000;
+	_gameOptions.AIFrameNodes = 1 << 20;
 
 	_table = nullptr;
 	_winner = nullptr;
@@ -86,11 +91,13 @@ void Game::startGame()
 	turn->_boardState = startState;
 	turn->_gameNumber = _gameOptions.gameNumber;
 	_gameOptions.currentTurnNo = 0;
+	getGrid()->setSideToMove(0);
 }
 
 void Game::endTurn()
 {
 	_gameOptions.currentTurnNo++;
+	getGrid()->setSideToMove((int)(_gameOptions.currentTurnNo & 1));
 	std::string startState = stateString();
 	Turn *turn = new Turn;
 	turn->_boardState = stateString();
@@ -98,7 +105,7 @@ void Game::endTurn()
 	turn->_score = _gameOptions.score;
 	turn->_gameNumber = _gameOptions.gameNumber;
 	_turns.push_back(turn);
-	ClassGame::EndOfTurn();
+	ClassGame::EndOfTurn(this);
 }
 
 //
@@ -147,6 +154,24 @@ void Game::scanForMouse()
 	}
 }
 
+//
+// protocol moves name a square by its column letter and its row number counted from the top
+//
+ChessSquare *Game::squareForMove(const std::string &move)
+{
+	if (move.size() < 2 || move[0] < 'a') return nullptr;
+	return getGrid()->getSquare(move[0] - 'a', std::atoi(move.c_str() + 1) - 1);
+}
+
+void Game::setSideToMove(int side)
+{
+	if ((int)(_gameOptions.currentTurnNo & 1) != (side & 1))
+	{
+		_gameOptions.currentTurnNo++;
+		getGrid()->setSideToMove(side);
+	}
+}
+
 void Game::findDropTarget(ImVec2 &pos)
 {
 	Grid* grid = getGrid();
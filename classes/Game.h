@@ -12,6 +12,7 @@
 #include <chrono>
 #include <ctime>
 #include <future>
+#include <memory>
 
 #ifdef _MSC_VER
 #include <intrin.h>
@@ -23,6 +24,7 @@
 #include "BitHolder.h"
 #include "Grid.h"
 #include "Logger.h"
+#include "EngineProtocol.h"
 
 const int AI_PLAYER = 1;
 const int HUMAN_PLAYER = -1;
@@ -43,13 +45,18 @@ struct GameOptions
 	int AIDepthSearches;
 	int AIMAXDepth;
 	bool AIvsAI;
+	bool AIUseMCTS;		// Monte Carlo tree search in place of the game's own search
+	bool AIUseNNUE;		// the network evaluation in place of the handcrafted one
+	bool AIPersistentCache;	// the search's table saved in cache/ and read back next session
+	int AIFrameBudgetUs;	// how long a game's sliced search may run in one frame
+	int AIFrameNodes;		// and how many nodes, whichever runs out first
 };
 
 class Game
 {
 public:
 	Game();
-	~Game();
+	virtual ~Game();
 
 	void startGame();
 
@@ -95,9 +102,20 @@ public:
 
 	virtual void stopGame() = 0;
 	virtual bool gameHasAI();
+	virtual bool gameHasMCTS() { return false; }
+	virtual bool gameHasNNUE() { return false; }
+	virtual bool gameHasPersistentCache() { return false; }
+	// the AI thinks a slice a frame on the UI thread (SearchEngine::advance) rather than in one call
+	virtual bool gameHasSlicedSearch() { return false; }
 	virtual void updateAI();
 	virtual void pieceTaken(Bit *bit){};
 
+	// the AI move in two halves so it can be searched off the UI thread: aiPosition() copies the
+	// position into a headless ProtocolGame (null when the game has none) and applyAIMove() plays
+	// the search's move, in the protocol's notation, back on the board
+	virtual std::unique_ptr<ProtocolGame> aiPosition() { return nullptr; }
+	virtual bool applyAIMove(const std::string &move) { return false; }
+
 	virtual std::string initialStateString() = 0;
 	virtual std::string stateString() = 0;
 	virtual void setStateString(const std::string &s) = 0;
@@ -113,6 +131,8 @@ public:
 	virtual Grid* getGrid() = 0;
 	// legacy support - calls getGrid()->getSquare(x, y)
 	BitHolder &getHolderAt(const int x, const int y) { return *getGrid()->getSquare(x, y); }
+	// zobrist key of the pieces on the grid and the side to move, for caches and repetition checks
+	uint64_t positionKey() { return getGrid()->getPositionKey(); }
 
 	const unsigned int getCurrentTurnNo() { return _gameOptions.currentTurnNo; };
 	const int getScore() { return _gameOptions.score; };
@@ -143,6 +163,10 @@ protected:
 	void mouseMoved(ImVec2 &location, Entity *bit);
 	void mouseUp(ImVec2 &location, Entity *bit);
 	void findDropTarget(ImVec2 &pos);
+	// grid square named like the protocol's moves, e.g. "b3"
+	ChessSquare *squareForMove(const std::string &move);
+	// moves the turn counter on when needed so side is the one to move, for loading positions
+	void setSideToMove(int side);
 
 	ImVec2 _dragStartPos;
 	ImVec2 _dragOffset;
@@ -0,0 +1,260 @@
+#include "GameServer.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    unsigned defaultWorkers(int workers)
+    {
+        if (workers > 0) return (unsigned)workers;
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::vector<std::string> splitWords(const std::string &line)
+    {
+        std::istringstream stream(line);
+        std::vector<std::string> words;
+        std::string word;
+        while (stream >> word) words.push_back(word);
+        return words;
+    }
+}
+
+GameServer::GameServer(const GameServerOptions &options)
+    : _options(options),
+      _sessions(options.maxSessions, options.sessionMemory),
+      _scheduler((int)defaultWorkers(options.workers), options.maxMoveTimeMs)
+{
+    _listenFd = -1;
+    _running = false;
+    _nextConnectionId = 1;
+}
+
+GameServer::~GameServer()
+{
+    stop();
+}
+
+void GameServer::Connection::send(const std::string &line)
+{
+#ifndef _WIN32
+    std::lock_guard<std::mutex> lock(writeMutex);
+    if (!open) return;
+    std::string data = line + "\n";
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            open = false;
+            return;
+        }
+        sent += (size_t)n;
+    }
+#endif
+}
+
+bool GameServer::start(std::string &error)
+{
+#ifdef _WIN32
+    error = "the game server needs Unix domain sockets";
+    return false;
+#else
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (_options.socketPath.size() >= sizeof(address.sun_path)) {
+        error = "socket path too long";
+        return false;
+    }
+    std::strcpy(address.sun_path, _options.socketPath.c_str());
+
+    _listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (_listenFd < 0) {
+        error = std::string("socket: ") + strerror(errno);
+        return false;
+    }
+    unlink(_options.socketPath.c_str());
+    if (bind(_listenFd, (sockaddr*)&address, sizeof(address)) < 0 || listen(_listenFd, 128) < 0) {
+        error = _options.socketPath + ": " + strerror(errno);
+        ::close(_listenFd);
+        _listenFd = -1;
+        return false;
+    }
+
+    _running = true;
+    _acceptThread = std::thread(&GameServer::acceptLoop, this);
+    return true;
+#endif
+}
+
+void GameServer::stop()
+{
+#ifndef _WIN32
+    if (!_running.exchange(false)) return;
+    _acceptThread.join();
+    ::close(_listenFd);
+    _listenFd = -1;
+    unlink(_options.socketPath.c_str());
+
+    std::vector<std::shared_ptr<Connection>> connections;
+    {
+        std::lock_guard<std::mutex> lock(_connectionsMutex);
+        connections.swap(_connections);
+    }
+    for (const auto &connection : connections) shutdown(connection->fd, SHUT_RDWR);
+    for (const auto &connection : connections) {
+        if (connection->reader.joinable()) connection->reader.join();
+    }
+    _scheduler.shutdown();
+    for (const auto &connection : connections) ::close(connection->fd);
+#endif
+}
+
+void GameServer::acceptLoop()
+{
+#ifndef _WIN32
+    while (_running) {
+        pollfd listener{ _listenFd, POLLIN, 0 };
+        if (poll(&listener, 1, 100) <= 0) continue;
+        int fd = accept(_listenFd, nullptr, nullptr);
+        if (fd < 0) continue;
+
+        auto connection = std::make_shared<Connection>();
+        connection->fd = fd;
+        std::lock_guard<std::mutex> lock(_connectionsMutex);
+        connection->id = _nextConnectionId++;
+
+        // drop the connections that have gone away since
+        for (auto it = _connections.begin(); it != _connections.end();) {
+            if (!(*it)->finished) {
+                ++it;
+                continue;
+            }
+            (*it)->reader.join();
+            ::close((*it)->fd);
+            it = _connections.erase(it);
+        }
+        _connections.push_back(connection);
+        connection->reader = std::thread(&GameServer::readLoop, this, connection);
+    }
+#endif
+}
+
+void GameServer::readLoop(std::shared_ptr<Connection> connection)
+{
+#ifndef _WIN32
+    std::string buffer;
+    char chunk[4096];
+    bool quit = false;
+    while (!quit) {
+        ssize_t n = recv(connection->fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) break;
+        buffer.append(chunk, (size_t)n);
+
+        size_t start = 0;
+        size_t end;
+        while (!quit && (end = buffer.find('\n', start)) != std::string::npos) {
+            quit = !handle(connection, buffer.substr(start, end - start));
+            start = end + 1;
+        }
+        buffer.erase(0, start);
+    }
+
+    _sessions.closeOwnedBy(connection->id);
+    std::lock_guard<std::mutex> lock(connection->writeMutex);
+    connection->open = false;
+    shutdown(connection->fd, SHUT_RDWR);
+    connection->finished = true;
+#endif
+}
+
+std::shared_ptr<GameSession> GameServer::sessionFor(const std::shared_ptr<Connection> &connection, const std::string &id)
+{
+    std::shared_ptr<GameSession> session = _sessions.find(std::strtoull(id.c_str(), nullptr, 10));
+    if (!session || session->owner != connection->id) {
+        connection->send("error unknown session " + id);
+        return nullptr;
+    }
+    return session;
+}
+
+bool GameServer::handle(const std::shared_ptr<Connection> &connection, const std::string &line)
+{
+    std::vector<std::string> words = splitWords(line);
+    if (words.empty()) return true;
+    const std::string &command = words[0];
+    std::string error;
+
+    if (command == "new" && words.size() >= 2) {
+        size_t memory = 0;
+        if (words.size() >= 4 && words[2] == "memory") memory = (size_t)std::strtoull(words[3].c_str(), nullptr, 10) * 1024;
+        std::shared_ptr<GameSession> session = _sessions.create(words[1], memory, connection->id, error);
+        connection->send(session ? "session " + std::to_string(session->id) : "error " + error);
+    } else if (command == "move" && words.size() >= 3) {
+        std::shared_ptr<GameSession> session = sessionFor(connection, words[1]);
+        if (!session) return true;
+        if (_sessions.playMove(*session, words[2], error)) connection->send("ok " + words[1]);
+        else connection->send("error " + words[1] + " " + error);
+    } else if (command == "go" && words.size() >= 2) {
+        std::shared_ptr<GameSession> session = sessionFor(connection, words[1]);
+        if (!session) return true;
+        ProtocolLimits limits;
+        for (size_t i = 2; i + 1 < words.size(); i += 2) {
+            if (words[i] == "movetime") limits.timeMs = std::atoi(words[i + 1].c_str());
+            else if (words[i] == "depth") limits.depth = std::atoi(words[i + 1].c_str());
+            else if (words[i] == "nodes") limits.nodes = std::strtoull(words[i + 1].c_str(), nullptr, 10);
+        }
+        bool queued = _scheduler.submit(session, limits, [connection](GameSession &session, const SearchOutcome &outcome) {
+            connection->send("bestmove " + std::to_string(session.id) + " " + (outcome.bestMove.empty() ? "(none)" : outcome.bestMove) +
+                             " nodes " + std::to_string(outcome.nodes) + " latency " + std::to_string(outcome.latencyUs) +
+                             " over " + (outcome.gameOver ? "1" : "0"));
+        });
+        if (!queued) connection->send("error " + words[1] + " searching");
+    } else if (command == "moves" && words.size() >= 2) {
+        std::shared_ptr<GameSession> session = sessionFor(connection, words[1]);
+        if (!session) return true;
+        std::lock_guard<std::mutex> lock(session->mutex);
+        if (session->searching) {
+            connection->send("error " + words[1] + " searching");
+            return true;
+        }
+        std::string reply = "moves " + words[1];
+        for (const std::string &move : session->game->legalMoves()) reply += " " + move;
+        connection->send(reply);
+    } else if (command == "state" && words.size() >= 2) {
+        std::shared_ptr<GameSession> session = sessionFor(connection, words[1]);
+        if (!session) return true;
+        std::lock_guard<std::mutex> lock(session->mutex);
+        if (session->searching) {
+            connection->send("error " + words[1] + " searching");
+            return true;
+        }
+        connection->send("state " + words[1] + " " + session->game->state() + " " + std::to_string(session->game->sideToMove()) +
+                         (session->game->isOver() ? " over" : " playing"));
+    } else if (command == "close" && words.size() >= 2) {
+        if (!sessionFor(connection, words[1])) return true;
+        _sessions.close(std::strtoull(words[1].c_str(), nullptr, 10));
+        connection->send("closed " + words[1]);
+    } else if (command == "stats") {
+        SchedulerStats stats = _scheduler.stats();
+        char reply[256];
+        snprintf(reply, sizeof(reply), "stats sessions %zu memory %zu moves %llu mps %.1f p50 %d p99 %d max %d missed %llu queued %zu",
+                 _sessions.count(), _sessions.memoryUsage(), (unsigned long long)stats.completed, stats.movesPerSecond,
+                 stats.p50Us, stats.p99Us, stats.maxUs, (unsigned long long)stats.missedDeadlines, stats.queued);
+        connection->send(reply);
+    } else if (command == "quit") {
+        return false;
+    } else {
+        connection->send("error bad request " + command);
+    }
+    return true;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "GameSession.h"
+#include "SearchScheduler.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct GameServerOptions
+{
+    std::string socketPath = "/tmp/boardgames.sock";
+    int         workers = 0;                // 0 for one per hardware thread
+    size_t      maxSessions = 10000;
+    size_t      sessionMemory = SessionManager::DEFAULT_SESSION_MEMORY;
+    int         maxMoveTimeMs = 5000;
+};
+
+//
+// hosts many games in one process behind a line based protocol on a Unix domain socket
+// requests, answered in order except for go, whose bestmove comes when the search is done:
+//   new <game> [memory <KB>]               -> session <id>
+//   move <id> <move>                       -> ok <id>
+//   go <id> [movetime MS] [depth N] [nodes N]  -> bestmove <id> <move>|(none) nodes N latency US over 0|1
+//   moves <id>                             -> moves <id> m1 m2 ...
+//   state <id>                             -> state <id> <state> <side> playing|over
+//   close <id>                             -> closed <id>
+//   stats                                  -> stats sessions N memory B moves N mps X p50 US p99 US max US missed N queued N
+//   quit
+// failures answer "error <message>". sessions are closed with the connection that made them
+//
+class GameServer
+{
+public:
+    GameServer(const GameServerOptions &options);
+    ~GameServer();
+
+    // binds the socket and starts accepting, false with error set when it can't
+    bool            start(std::string &error);
+    void            stop();
+
+    SessionManager& sessions() { return _sessions; }
+    SearchScheduler& scheduler() { return _scheduler; }
+
+private:
+    struct Connection
+    {
+        uint64_t            id;
+        int                 fd;
+        std::mutex          writeMutex;
+        std::atomic<bool>   open{ true };
+        std::atomic<bool>   finished{ false };  // the reader has exited
+        std::thread         reader;
+
+        void        send(const std::string &line);
+    };
+
+    void            acceptLoop();
+    void            readLoop(std::shared_ptr<Connection> connection);
+    // returns false on quit
+    bool            handle(const std::shared_ptr<Connection> &connection, const std::string &line);
+    std::shared_ptr<GameSession> sessionFor(const std::shared_ptr<Connection> &connection, const std::string &id);
+
+    GameServerOptions   _options;
+    SessionManager      _sessions;
+    SearchScheduler     _scheduler;
+    int                 _listenFd;
+    std::atomic<bool>   _running;
+    std::thread         _acceptThread;
+    std::mutex          _connectionsMutex;
+    std::vector<std::shared_ptr<Connection>> _connections;
+    uint64_t            _nextConnectionId;
+};
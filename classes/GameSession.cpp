@@ -0,0 +1,121 @@
+#include "GameSession.h"
+
+size_t GameSession::memoryUsage() const
+{
+    size_t bytes = sizeof(*this) + (game ? game->memoryUsage() : 0) + history.capacity() * sizeof(std::string);
+    for (const std::string &move : history) bytes += move.capacity();
+    return bytes;
+}
+
+SessionManager::SessionManager(size_t maxSessions, size_t defaultMemoryLimit)
+{
+    _nextId = 1;
+    _maxSessions = maxSessions;
+    _defaultMemoryLimit = defaultMemoryLimit;
+}
+
+std::shared_ptr<GameSession> SessionManager::create(const std::string &gameName, size_t memoryLimit, uint64_t owner, std::string &error)
+{
+    auto session = std::make_shared<GameSession>();
+    session->game = ProtocolGame::create(gameName);
+    if (!session->game) {
+        error = "unknown game " + gameName;
+        return nullptr;
+    }
+
+    session->owner = owner;
+    session->memoryLimit = memoryLimit ? memoryLimit : _defaultMemoryLimit;
+    // whatever the session itself needs comes off the top, the rest goes to the search tables
+    size_t overhead = sizeof(GameSession);
+    if (session->memoryLimit <= overhead || !session->game->setMemoryLimit(session->memoryLimit - overhead)) {
+        error = "memory limit too small for " + gameName;
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_sessions.size() >= _maxSessions) {
+        error = "too many sessions";
+        return nullptr;
+    }
+    session->id = _nextId++;
+    _sessions[session->id] = session;
+    return session;
+}
+
+std::shared_ptr<GameSession> SessionManager::find(uint64_t id) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto found = _sessions.find(id);
+    return found == _sessions.end() ? nullptr : found->second;
+}
+
+bool SessionManager::close(uint64_t id)
+{
+    std::shared_ptr<GameSession> session;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto found = _sessions.find(id);
+        if (found == _sessions.end()) return false;
+        session = found->second;
+        _sessions.erase(found);
+    }
+    // a search still running or queued on it keeps the session alive until it finishes
+    std::lock_guard<std::mutex> lock(session->mutex);
+    session->closed = true;
+    session->stopRequested = true;
+    return true;
+}
+
+int SessionManager::closeOwnedBy(uint64_t owner)
+{
+    std::vector<uint64_t> owned;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (const auto &entry : _sessions) {
+            if (entry.second->owner == owner) owned.push_back(entry.first);
+        }
+    }
+    int closed = 0;
+    for (uint64_t id : owned) closed += close(id);
+    return closed;
+}
+
+bool SessionManager::playMove(GameSession &session, const std::string &move, std::string &error)
+{
+    std::lock_guard<std::mutex> lock(session.mutex);
+    if (session.searching) {
+        error = "searching";
+        return false;
+    }
+    if (session.memoryUsage() + sizeof(std::string) + move.size() > session.memoryLimit) {
+        error = "memory limit reached";
+        return false;
+    }
+    if (!session.game->playMove(move)) {
+        error = "illegal move " + move;
+        return false;
+    }
+    session.history.push_back(move);
+    return true;
+}
+
+size_t SessionManager::count() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _sessions.size();
+}
+
+size_t SessionManager::memoryUsage() const
+{
+    std::vector<std::shared_ptr<GameSession>> sessions;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (const auto &entry : _sessions) sessions.push_back(entry.second);
+    }
+    size_t bytes = 0;
+    for (const auto &session : sessions) {
+        std::lock_guard<std::mutex> lock(session->mutex);
+        bytes += session->memoryUsage();
+    }
+    return bytes;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "EngineProtocol.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//
+// one hosted game: the position, its move history and the memory it may use
+// searching is set under mutex when a search is handed the game, which then owns it until the
+// search is done. everything else touches the game under mutex and only while it isn't searching
+// stopRequested is the search's stop token (ProtocolLimits::stop), cleared when a search is handed
+// the game and set for good once the session is closed
+//
+struct GameSession
+{
+    uint64_t                        id = 0;
+    uint64_t                        owner = 0;      // connection that created it
+    std::unique_ptr<ProtocolGame>   game;
+    std::vector<std::string>        history;
+    size_t                          memoryLimit = 0;
+    std::mutex                      mutex;
+    std::atomic<bool>               searching{ false };
+    std::atomic<bool>               stopRequested{ false };
+    bool                            closed = false;
+
+    size_t      memoryUsage() const;
+};
+
+//
+// creates, finds and closes sessions. every session gets its own memory limit, the search tables
+// are sized to fit under it and moves that would take the history over it are refused
+//
+class SessionManager
+{
+public:
+    static const size_t DEFAULT_SESSION_MEMORY = 256 * 1024;
+
+    SessionManager(size_t maxSessions = 10000, size_t defaultMemoryLimit = DEFAULT_SESSION_MEMORY);
+
+    // returns null and sets error when the game is unknown, the limit too small or the server full
+    std::shared_ptr<GameSession> create(const std::string &gameName, size_t memoryLimit, uint64_t owner, std::string &error);
+    std::shared_ptr<GameSession> find(uint64_t id) const;
+    bool            close(uint64_t id);
+    // closes every session a connection created, returns how many
+    int             closeOwnedBy(uint64_t owner);
+
+    // plays a move on a session that isn't searching
+    bool            playMove(GameSession &session, const std::string &move, std::string &error);
+
+    size_t          count() const;
+    size_t          memoryUsage() const;
+
+private:
+    mutable std::mutex  _mutex;
+    std::unordered_map<uint64_t, std::shared_ptr<GameSession>> _sessions;
+    uint64_t            _nextId;
+    size_t              _maxSessions;
+    size_t              _defaultMemoryLimit;
+};
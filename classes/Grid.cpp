@@ -1,4 +1,36 @@
 #include "Grid.h"
+#include "Bitboard.h"
+#include <array>
+#include <bit>
+
+namespace {
+    //
+    // random keys for (square, piece tag, owner) on grids of up to 128 squares, owner 2 is a bit with
+    // no owner. tags past the table reuse its keys rotated, chess's black tags start at 128
+    //
+    const int KEY_SQUARES = 128;
+    const int KEY_TAGS = 32;
+    const int KEY_OWNERS = 3;
+
+    struct ZobristKeys
+    {
+        std::array<uint64_t, KEY_SQUARES * KEY_TAGS * KEY_OWNERS> pieces;
+        uint64_t side;
+
+        ZobristKeys()
+        {
+            uint64_t state = 0x47524944u;   // "GRID"
+            for (uint64_t &key : pieces) key = Bitboard::splitMix64(state);
+            side = Bitboard::splitMix64(state);
+        }
+    };
+
+    const ZobristKeys& zobristKeys()
+    {
+        static const ZobristKeys keys;
+        return keys;
+    }
+}
 
 Grid::Grid(int width, int height) : _width(width), _height(height)
 {
@@ -12,6 +44,7 @@ Grid::Grid(int width, int height) : _width(width), _height(height)
 
         for (int x = 0; x < width; x++) {
             _squares[y][x] = new ChessSquare();
+            _squares[y][x]->setPositionKey(&_positionKey, y * width + x);
             _enabled[y][x] = true; // All squares enabled by default
         }
     }
@@ -226,4 +259,21 @@ void Grid::setStateString(const std::string& state)
             }
         }
     }
-}
\ No newline at end of file
+}
+
+void Grid::setSideToMove(int side)
+{
+    if ((side & 1) != _sideToMove) {
+        _positionKey ^= zobristKeys().side;
+        _sideToMove = side & 1;
+    }
+}
+
+uint64_t Grid::pieceKey(int index, int tag, int owner)
+{
+    unsigned slot = (unsigned)tag % KEY_TAGS;
+    unsigned round = (unsigned)tag / KEY_TAGS;
+    int ownerSlot = owner == 0 || owner == 1 ? owner : 2;
+    uint64_t key = zobristKeys().pieces[((unsigned)index % KEY_SQUARES * KEY_TAGS + slot) * KEY_OWNERS + ownerSlot];
+    return round ? std::rotl(key, (int)(round % 63) + 1) : key;
+}
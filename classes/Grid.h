@@ -61,10 +61,17 @@ public:
     std::string getStateString() const;
     void setStateString(const std::string& state);
 
+    // Zobrist key of the pieces and the side to move, the squares keep it current as bits come and go
+    uint64_t getPositionKey() const { return _positionKey; }
+    void setSideToMove(int side);
+    static uint64_t pieceKey(int index, int tag, int owner);
+
 private:
     std::vector<std::vector<ChessSquare*>> _squares;
     std::vector<std::vector<bool>> _enabled;
     std::unordered_map<int, std::vector<int>> _connections;
     int _width;
     int _height;
+    uint64_t _positionKey = 0;
+    int _sideToMove = 0;
 };
\ No newline at end of file
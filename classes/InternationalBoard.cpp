@@ -0,0 +1,281 @@
+#include "InternationalBoard.h"
+
+namespace {
+    //
+    // zobrist keys for (piece type, square) and the side to move, built at compile time
+    //
+    struct InternationalZobrist
+    {
+        uint64_t piece[5][InternationalBoard::BITS];
+        uint64_t side;
+    };
+
+    constexpr InternationalZobrist makeZobrist()
+    {
+        InternationalZobrist z{};
+        uint64_t state = 0x10D2A1175ull;
+        for (int p = 1; p < 5; p++) {
+            for (int s = 0; s < InternationalBoard::BITS; s++) {
+                z.piece[p][s] = Bitboard::splitMix64(state);
+            }
+        }
+        z.side = Bitboard::splitMix64(state);
+        return z;
+    }
+
+    constexpr InternationalZobrist ZOBRIST = makeZobrist();
+}
+
+bool InternationalMove::operator==(const InternationalMove &o) const
+{
+    if (from != o.from || steps != o.steps || captured != o.captured) return false;
+    for (int i = 0; i < steps; i++) {
+        if (path[i] != o.path[i]) return false;
+    }
+    return true;
+}
+
+InternationalBoard::InternationalBoard()
+{
+    _men[RED] = _men[YELLOW] = 0;
+    _kings[RED] = _kings[YELLOW] = 0;
+    _side = RED;
+    _hash = 0;
+}
+
+InternationalBoard InternationalBoard::initial()
+{
+    InternationalBoard board;
+    for (int y = 0; y < 4; y++) {
+        Mask red = rowMask(y);
+        Mask yellow = rowMask(9 - y);
+        while (red) board.setPiece(Bitboard::popLowestBit(red), RED_PIECE);
+        while (yellow) board.setPiece(Bitboard::popLowestBit(yellow), YELLOW_PIECE);
+    }
+    return board;
+}
+
+void InternationalBoard::setSideToMove(int side)
+{
+    if (side != _side) {
+        _side = side;
+        _hash ^= ZOBRIST.side;
+    }
+}
+
+int InternationalBoard::pieceAt(int square) const
+{
+    Mask bit = 1ull << square;
+    if (_men[RED] & bit) return RED_PIECE;
+    if (_kings[RED] & bit) return RED_KING;
+    if (_men[YELLOW] & bit) return YELLOW_PIECE;
+    if (_kings[YELLOW] & bit) return YELLOW_KING;
+    return EMPTY;
+}
+
+void InternationalBoard::updateHash(int square, int pieceType)
+{
+    if (pieceType != EMPTY) _hash ^= ZOBRIST.piece[pieceType][square];
+}
+
+//
+// replace whatever is on square with pieceType (EMPTY clears it)
+//
+void InternationalBoard::setPiece(int square, int pieceType)
+{
+    Mask bit = 1ull << square;
+    updateHash(square, pieceAt(square));
+    for (int side = 0; side < 2; side++) {
+        _men[side] &= ~bit;
+        _kings[side] &= ~bit;
+    }
+    switch (pieceType) {
+        case RED_PIECE:    _men[RED] |= bit; break;
+        case RED_KING:     _kings[RED] |= bit; break;
+        case YELLOW_PIECE: _men[YELLOW] |= bit; break;
+        case YELLOW_KING:  _kings[YELLOW] |= bit; break;
+    }
+    updateHash(square, pieceType);
+}
+
+InternationalBoard::Mask InternationalBoard::movers() const
+{
+    Mask open = empty();
+    Mask result = 0;
+    for (int dir = 0; dir < 4; dir++) {
+        Mask pieceSet = _kings[_side] | (forward(_side, dir) ? _men[_side] : 0);
+        result |= step(open, opposite(dir)) & pieceSet;
+    }
+    return result;
+}
+
+//
+// men take in all four directions, kings take along the whole diagonal so the squares that
+// see a takeable piece are found by sliding back from it over empty squares
+//
+InternationalBoard::Mask InternationalBoard::jumpers() const
+{
+    Mask open = empty();
+    Mask opp = pieces(_side ^ 1);
+    Mask result = 0;
+    for (int dir = 0; dir < 4; dir++) {
+        int back = opposite(dir);
+        Mask takeable = step(open, back) & opp;
+        Mask attackers = step(takeable, back);
+        result |= attackers & (_men[_side] | _kings[_side]);
+
+        attackers &= open;
+        while (attackers) {
+            attackers = step(attackers, back);
+            result |= attackers & _kings[_side];
+            attackers &= open;
+        }
+    }
+    return result;
+}
+
+//
+// keep a finished capture if it takes at least as many pieces as the best so far
+//
+void InternationalBoard::addCapture(const InternationalMove &current, InternationalMove *moves, int &count) const
+{
+    if (count > 0) {
+        if (current.steps < moves[0].steps) return;
+        if (current.steps > moves[0].steps) count = 0;
+    }
+    for (int i = 0; i < count; i++) {
+        if (moves[i].from == current.from && moves[i].to() == current.to() && moves[i].captured == current.captured) return;
+    }
+    if (count < MAX_MOVES) moves[count++] = current;
+}
+
+//
+// depth first walk of every capture sequence from one piece
+// captured pieces stay on the board until the move is over, so they block the way but can't
+// be taken twice, and a man passing the crown row mid-capture stays a man
+//
+void InternationalBoard::addCaptures(bool king, Mask square, Mask capturable, Mask open,
+                                     InternationalMove &current, InternationalMove *moves, int &count) const
+{
+    bool extended = false;
+    for (int dir = 0; dir < 4; dir++) {
+        Mask middle = step(square, dir);
+        if (king) {
+            while (middle & open) middle = step(middle, dir);
+        }
+        middle &= capturable;
+        if (!middle) continue;
+
+        Mask landing = step(middle, dir) & open;
+        while (landing && current.steps < InternationalMove::MAX_STEPS) {
+            extended = true;
+            current.path[current.steps++] = (uint8_t)Bitboard::lowestBit(landing);
+            current.captured |= middle;
+            addCaptures(king, landing, capturable & ~middle, open, current, moves, count);
+            current.steps--;
+            current.captured &= ~middle;
+
+            // a man lands right behind the piece, a king anywhere further along
+            landing = king ? step(landing, dir) & open : 0;
+        }
+    }
+    if (!extended && current.steps > 0) {
+        addCapture(current, moves, count);
+    }
+}
+
+int InternationalBoard::generateCaptures(InternationalMove *moves) const
+{
+    int count = 0;
+    Mask jumping = jumpers();
+    Mask opp = pieces(_side ^ 1);
+    while (jumping) {
+        int from = Bitboard::popLowestBit(jumping);
+        Mask fromBit = 1ull << from;
+        InternationalMove current{};
+        current.from = (uint8_t)from;
+        addCaptures((_kings[_side] & fromBit) != 0, fromBit, opp, empty() | fromBit, current, moves, count);
+    }
+    return count;
+}
+
+int InternationalBoard::generateMoves(InternationalMove *moves) const
+{
+    // captures are mandatory
+    int count = generateCaptures(moves);
+    if (count) return count;
+
+    Mask open = empty();
+    for (int dir = 0; dir < 4; dir++) {
+        // men step once
+        Mask targets = forward(_side, dir) ? step(_men[_side], dir) & open : 0;
+        while (targets && count < MAX_MOVES) {
+            int to = Bitboard::popLowestBit(targets);
+            InternationalMove &move = moves[count++];
+            move.from = (uint8_t)Bitboard::lowestBit(step(1ull << to, opposite(dir)));
+            move.steps = 1;
+            move.path[0] = (uint8_t)to;
+            move.captured = 0;
+        }
+
+        // kings slide any distance
+        Mask kings = _kings[_side];
+        while (kings) {
+            int from = Bitboard::popLowestBit(kings);
+            Mask to = step(1ull << from, dir) & open;
+            while (to && count < MAX_MOVES) {
+                InternationalMove &move = moves[count++];
+                move.from = (uint8_t)from;
+                move.steps = 1;
+                move.path[0] = (uint8_t)Bitboard::lowestBit(to);
+                move.captured = 0;
+                to = step(to, dir) & open;
+            }
+        }
+    }
+    return count;
+}
+
+void InternationalBoard::makeMove(const InternationalMove &move)
+{
+    int pieceType = pieceAt(move.from);
+    int to = move.to();
+
+    Mask taken = move.captured;
+    while (taken) {
+        setPiece(Bitboard::popLowestBit(taken), EMPTY);
+    }
+    setPiece(move.from, EMPTY);
+
+    // men are crowned when the move ends on the far row
+    if (pieceType == RED_PIECE && ((1ull << to) & crownRow(RED))) pieceType = RED_KING;
+    if (pieceType == YELLOW_PIECE && ((1ull << to) & crownRow(YELLOW))) pieceType = YELLOW_KING;
+    setPiece(to, pieceType);
+
+    setSideToMove(_side ^ 1);
+}
+
+std::string InternationalBoard::toString() const
+{
+    std::string state;
+    state.reserve(SQUARES);
+    Mask squares = BOARD;
+    while (squares) {
+        state += (char)('0' + pieceAt(Bitboard::popLowestBit(squares)));
+    }
+    return state;
+}
+
+bool InternationalBoard::fromString(const std::string &state, int sideToMove)
+{
+    if (state.length() != SQUARES) return false;
+    *this = InternationalBoard();
+    Mask squares = BOARD;
+    for (int i = 0; i < SQUARES; i++) {
+        int square = Bitboard::popLowestBit(squares);
+        int pieceType = state[i] - '0';
+        if (pieceType > EMPTY && pieceType <= YELLOW_KING) setPiece(square, pieceType);
+    }
+    setSideToMove(sideToMove);
+    return true;
+}
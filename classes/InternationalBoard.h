@@ -0,0 +1,124 @@
+#pragma once
+
+#include "Bitboard.h"
+#include <cstdint>
+#include <string>
+
+//
+// padded bitboard for 10x10 international draughts
+// the 50 dark squares are stored in a 64-bit word with a ghost bit after every second row,
+// bit = y * 5 + x / 2 + y / 2, so every diagonal step is a shift by 5 or 6 and steps off the
+// board land on a ghost bit or outside the board mask
+// side 0 is red (starts at the top, moves down the board), side 1 is yellow
+//
+struct InternationalMove
+{
+    static const int MAX_STEPS = 20;
+
+    uint8_t     from;
+    uint8_t     steps;                  // 1 for a simple move, number of pieces taken for a capture
+    uint8_t     path[MAX_STEPS];        // landing square of every step, path[steps - 1] is the destination
+    uint64_t    captured;               // squares of the pieces taken by this move
+
+    uint8_t     to() const { return path[steps - 1]; }
+    bool        isCapture() const { return captured != 0; }
+    bool        operator==(const InternationalMove &o) const;
+};
+
+class InternationalBoard
+{
+public:
+    using Mask = uint64_t;
+    using Move = InternationalMove;
+
+    static const int WIDTH = 10;
+    static const int SQUARES = 50;
+    static const int BITS = 64;
+    static const int MAX_MOVES = 128;
+    static const int RED = 0;
+    static const int YELLOW = 1;
+
+    // 0 = empty, then the piece types used by the game tags, the same as CheckersBoard
+    static const int EMPTY = 0;
+    static const int RED_PIECE = 1;
+    static const int RED_KING = 2;
+    static const int YELLOW_PIECE = 3;
+    static const int YELLOW_KING = 4;
+
+    InternationalBoard();
+
+    static InternationalBoard initial();
+
+    // square helpers, a square is its bit index
+    static constexpr int squareAt(int x, int y) { return y * 5 + x / 2 + y / 2; }
+    static constexpr int squareX(int square) { int y = squareY(square); return (square - y * 5 - y / 2) * 2 + (y % 2 == 0 ? 1 : 0); }
+    static constexpr int squareY(int square) { return (square / 11) * 2 + (square % 11 >= 5 ? 1 : 0); }
+
+    Mask            pieces(int side) const { return _men[side] | _kings[side]; }
+    Mask            men(int side) const { return _men[side]; }
+    Mask            kings(int side) const { return _kings[side]; }
+    Mask            occupied() const { return pieces(RED) | pieces(YELLOW); }
+    Mask            empty() const { return ~occupied() & BOARD; }
+    int             sideToMove() const { return _side; }
+    void            setSideToMove(int side);
+    uint64_t        hash() const { return _hash; }
+    int             pieceAt(int square) const;
+    void            setPiece(int square, int pieceType);
+
+    // pieces of the side to move that can make a simple move or a capture
+    Mask            movers() const;
+    Mask            jumpers() const;
+    bool            hasCapture() const { return jumpers() != 0; }
+
+    // legal moves for the side to move, only the captures taking the most pieces are legal
+    // and sequences that end on the same square with the same pieces taken count once
+    // returns the number of moves written into moves (at most MAX_MOVES)
+    int             generateMoves(InternationalMove *moves) const;
+    int             generateCaptures(InternationalMove *moves) const;
+
+    void            makeMove(const InternationalMove &move);
+
+    // 50 characters using the piece types above plus the side to move
+    std::string     toString() const;
+    bool            fromString(const std::string &state, int sideToMove);
+
+    static constexpr Mask GHOSTS = (1ull << 10) | (1ull << 21) | (1ull << 32) | (1ull << 43);
+    static constexpr Mask BOARD = ((1ull << 54) - 1) & ~GHOSTS;
+
+    static constexpr Mask rowMask(int y) { return 0x1Full << (y * 5 + y / 2); }
+
+    enum Direction { DOWN_LEFT, DOWN_RIGHT, UP_LEFT, UP_RIGHT };
+
+    //
+    // one diagonal step for every bit in m, no edge masks needed thanks to the ghost bits
+    //
+    static constexpr Mask step(Mask m, int direction)
+    {
+        switch (direction) {
+            case DOWN_LEFT:  return (m << 5) & BOARD;
+            case DOWN_RIGHT: return (m << 6) & BOARD;
+            case UP_LEFT:    return (m >> 6) & BOARD;
+            case UP_RIGHT:   return (m >> 5) & BOARD;
+        }
+        return 0;
+    }
+
+    // the direction that undoes a step
+    static constexpr int opposite(int direction) { return direction ^ 3; }
+
+    // red men move down, yellow men move up, kings move both ways
+    static constexpr bool forward(int side, int direction) { return side == RED ? direction <= DOWN_RIGHT : direction >= UP_LEFT; }
+
+    static constexpr Mask crownRow(int side) { return side == RED ? rowMask(9) : rowMask(0); }
+
+private:
+    void            addCaptures(bool king, Mask square, Mask capturable, Mask open,
+                                InternationalMove &current, InternationalMove *moves, int &count) const;
+    void            addCapture(const InternationalMove &current, InternationalMove *moves, int &count) const;
+    void            updateHash(int square, int pieceType);
+
+    Mask            _men[2];
+    Mask            _kings[2];
+    int             _side;
+    uint64_t        _hash;
+};
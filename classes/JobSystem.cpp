@@ -0,0 +1,252 @@
+#include "JobSystem.h"
+#include <algorithm>
+
+namespace {
+    thread_local int currentWorkerIndex = -1;
+}
+
+//
+// Deque, after Lê, Pop, Cohen and Zappa Nardelli's C11 version of the Chase-Lev deque
+//
+bool JobSystem::Deque::push(Job *job)
+{
+    int64_t bottom = _bottom.load(std::memory_order_relaxed);
+    int64_t top = _top.load(std::memory_order_acquire);
+    if (bottom - top >= CAPACITY) return false;
+    _slots[bottom & (CAPACITY - 1)].store(job, std::memory_order_relaxed);
+    _bottom.store(bottom + 1, std::memory_order_release);
+    return true;
+}
+
+JobSystem::Job* JobSystem::Deque::pop()
+{
+    int64_t bottom = _bottom.load(std::memory_order_relaxed) - 1;
+    _bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = _top.load(std::memory_order_relaxed);
+    if (top > bottom) {
+        _bottom.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    Job *job = _slots[bottom & (CAPACITY - 1)].load(std::memory_order_relaxed);
+    if (top == bottom) {
+        // the last job, a thief may be taking it too
+        if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) job = nullptr;
+        _bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+JobSystem::Job* JobSystem::Deque::steal()
+{
+    int64_t top = _top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t bottom = _bottom.load(std::memory_order_acquire);
+    if (top >= bottom) return nullptr;
+    Job *job = _slots[top & (CAPACITY - 1)].load(std::memory_order_relaxed);
+    if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) return nullptr;
+    return job;
+}
+
+JobSystem& JobSystem::instance()
+{
+    static JobSystem system;
+    return system;
+}
+
+JobSystem::JobSystem(int workers)
+{
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+    // no threads to be had, every job runs where it is submitted
+    (void)workers;
+    int count = 0;
+#else
+    int count = workers > 0 ? workers : std::max(2, (int)std::thread::hardware_concurrency());
+#endif
+    for (int i = 0; i < count; i++) _workers.push_back(std::make_unique<Worker>());
+    for (int i = 0; i < count; i++) _workers[i]->thread = std::thread(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    shutdown();
+}
+
+int JobSystem::currentWorker()
+{
+    return currentWorkerIndex;
+}
+
+void JobSystem::submit(std::function<void()> job, JobPriority priority)
+{
+    if (stopping() || _workers.empty()) {
+        job();
+        return;
+    }
+    enqueue(new Job{ std::move(job), priority });
+}
+
+void JobSystem::enqueue(Job *job)
+{
+    int priority = (int)job->priority;
+    int self = currentWorkerIndex;
+    if (self < 0 || self >= (int)_workers.size() || !_workers[self]->deques[priority].push(job)) {
+        std::lock_guard<std::mutex> lock(_sharedMutex);
+        _shared[priority].push_back(job);
+        _sharedCount[priority].fetch_add(1, std::memory_order_release);
+    }
+
+    // a worker going to sleep counts itself before its last look at _queued, so one of the two sees the other
+    _queued.fetch_add(1, std::memory_order_seq_cst);
+    if (_sleeping.load(std::memory_order_seq_cst) > 0) {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        _wake.notify_one();
+    }
+}
+
+// the most urgent job anywhere: this worker's own first, then the shared queue, then the others'
+JobSystem::Job* JobSystem::take(int self)
+{
+    int count = (int)_workers.size();
+    for (int priority = 0; priority < PRIORITIES; priority++) {
+        Job *job = _workers[self]->deques[priority].pop();
+        if (!job && _sharedCount[priority].load(std::memory_order_acquire) > 0) {
+            std::lock_guard<std::mutex> lock(_sharedMutex);
+            if (!_shared[priority].empty()) {
+                job = _shared[priority].front();
+                _shared[priority].pop_front();
+                _sharedCount[priority].fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+        for (int i = 1; !job && i < count; i++) job = _workers[(self + i) % count]->deques[priority].steal();
+        if (job) {
+            _queued.fetch_sub(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+void JobSystem::workerLoop(int self)
+{
+    currentWorkerIndex = self;
+    for (;;) {
+        Job *job = take(self);
+        if (job) {
+            job->run();
+            delete job;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_sleepMutex);
+        _sleeping.fetch_add(1, std::memory_order_seq_cst);
+        // a queued job not found yet is being pushed or stolen, look again soon
+        if (_queued.load(std::memory_order_seq_cst) > 0) {
+            _sleeping.fetch_sub(1, std::memory_order_relaxed);
+            lock.unlock();
+            std::this_thread::yield();
+            continue;
+        }
+        if (stopping()) {
+            _sleeping.fetch_sub(1, std::memory_order_relaxed);
+            return;
+        }
+        _wake.wait(lock, [this] { return _queued.load(std::memory_order_seq_cst) > 0 || stopping(); });
+        _sleeping.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+void JobSystem::shutdown()
+{
+    if (_joined) return;
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        _stopping.store(true, std::memory_order_release);
+    }
+    _wake.notify_all();
+    for (auto &worker : _workers) worker->thread.join();
+    _joined = true;
+
+    // anything queued as the workers were leaving
+    for (int priority = 0; priority < PRIORITIES; priority++) {
+        for (auto &worker : _workers) {
+            while (Job *job = worker->deques[priority].steal()) _shared[priority].push_back(job);
+        }
+        while (!_shared[priority].empty()) {
+            Job *job = _shared[priority].front();
+            _shared[priority].pop_front();
+            job->run();
+            delete job;
+        }
+    }
+}
+
+JobGroup::JobGroup(JobPriority priority, JobSystem &system)
+{
+    _state = std::make_shared<State>();
+    _state->system = &system;
+    _priority = priority;
+}
+
+JobGroup::~JobGroup()
+{
+    bool continues;
+    {
+        std::lock_guard<std::mutex> lock(_state->mutex);
+        continues = _state->hasContinuation;
+    }
+    if (!continues) wait();
+}
+
+void JobGroup::run(std::function<void()> task)
+{
+    State &state = *_state;
+    Task &added = state.tasks.emplace_back();
+    added.run = std::move(task);
+    state.pending.fetch_add(1, std::memory_order_relaxed);
+    // a pool that is shutting down, or has no workers, would run it right here before the caller's own
+    // share of the work, so it waits for wait() instead
+    if (state.system->stopping() || state.system->workerCount() == 0) return;
+    state.system->submit([state = _state, &added] { state->execute(added); }, _priority);
+}
+
+void JobGroup::wait()
+{
+    State &state = *_state;
+    for (Task &task : state.tasks) state.execute(task);
+    std::unique_lock<std::mutex> lock(state.mutex);
+    state.done.wait(lock, [&state] { return state.pending.load(std::memory_order_acquire) == 0; });
+}
+
+void JobGroup::then(std::function<void()> continuation, JobPriority priority)
+{
+    State &state = *_state;
+    std::unique_lock<std::mutex> lock(state.mutex);
+    state.continuation = std::move(continuation);
+    state.continuationPriority = priority;
+    state.hasContinuation = true;
+    if (state.pending.load(std::memory_order_acquire) == 0 && !state.continued) {
+        state.continued = true;
+        lock.unlock();
+        state.system->submit(std::move(state.continuation), priority);
+    }
+}
+
+void JobGroup::State::execute(Task &task)
+{
+    if (task.claimed.exchange(true, std::memory_order_acq_rel)) return;
+    task.run();
+    finishTask();
+}
+
+void JobGroup::State::finishTask()
+{
+    if (pending.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+    std::unique_lock<std::mutex> lock(mutex);
+    done.notify_all();
+    if (hasContinuation && !continued) {
+        continued = true;
+        lock.unlock();
+        system->submit(std::move(continuation), continuationPriority);
+    }
+}
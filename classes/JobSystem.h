@@ -0,0 +1,147 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//
+// what runs first when there is more work than workers: moves the player is waiting on before
+// search helpers, both before background analysis and file writes
+//
+enum class JobPriority { HIGH, NORMAL, LOW };
+
+//
+// the engine-wide thread pool, a worker per core. every worker owns a lock-free deque per priority:
+// it pushes and pops its own jobs at the bottom, idle workers steal from the top of the others'.
+// jobs submitted from outside the pool (the UI thread) go through a shared queue per priority
+// a job runs to completion on whichever worker picks it up, so one that blocks or runs for long
+// (a proof, a whole search) holds its worker for that time and should watch stopping()
+//
+class JobSystem
+{
+public:
+    static JobSystem& instance();
+
+    // 0 for one per core, and never fewer than two. a build without threads has none and runs jobs inline
+    explicit JobSystem(int workers = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    // after shutdown(), or without workers, the job runs on the caller before submit returns
+    void            submit(std::function<void()> job, JobPriority priority = JobPriority::NORMAL);
+
+    // lets the queued jobs finish and joins the workers, later submissions run inline
+    void            shutdown();
+    bool            stopping() const { return _stopping.load(std::memory_order_acquire); }
+
+    int             workerCount() const { return (int)_workers.size(); }
+    // the pool worker this thread is, -1 for any other thread
+    static int      currentWorker();
+
+private:
+    struct Job
+    {
+        std::function<void()> run;
+        JobPriority     priority;
+    };
+
+    //
+    // Chase-Lev work-stealing deque of a fixed size. push and pop only from the owning worker,
+    // steal from anywhere. a full deque refuses the push and the job goes to the shared queue
+    //
+    class Deque
+    {
+    public:
+        static constexpr int64_t CAPACITY = 1 << 12;
+
+        bool        push(Job *job);
+        Job*        pop();
+        Job*        steal();
+
+    private:
+        alignas(64) std::atomic<int64_t> _top{ 0 };
+        alignas(64) std::atomic<int64_t> _bottom{ 0 };
+        std::atomic<Job*> _slots[CAPACITY] = {};
+    };
+
+    static constexpr int PRIORITIES = 3;
+
+    struct Worker
+    {
+        Deque           deques[PRIORITIES];
+        std::thread     thread;
+    };
+
+    void            enqueue(Job *job);
+    Job*            take(int self);
+    void            workerLoop(int self);
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+    std::mutex      _sharedMutex;
+    std::deque<Job*> _shared[PRIORITIES];
+    std::atomic<int> _sharedCount[PRIORITIES] = {};     // to skip the lock when a queue is empty
+
+    // sleeping workers wait for _queued to go above zero
+    std::mutex      _sleepMutex;
+    std::condition_variable _wake;
+    std::atomic<int64_t> _queued{ 0 };
+    std::atomic<int> _sleeping{ 0 };
+    std::atomic<bool> _stopping{ false };
+    bool            _joined = false;
+};
+
+//
+// fork-join over the JobSystem: run() forks tasks, wait() joins them. waiting runs the tasks no worker
+// has started yet on the waiting thread, and never anything else, so a search waiting on its helpers
+// can't be held up by an unrelated job and waiting from inside a job doesn't deadlock a busy pool
+// then() sets a continuation instead, submitted when the last task finishes, and comes after the last
+// run(). a group is used from one thread; its destructor waits unless a continuation was set
+//
+class JobGroup
+{
+public:
+    explicit JobGroup(JobPriority priority = JobPriority::NORMAL, JobSystem &system = JobSystem::instance());
+    ~JobGroup();
+
+    JobGroup(const JobGroup &) = delete;
+    JobGroup &operator=(const JobGroup &) = delete;
+
+    void            run(std::function<void()> task);
+    void            wait();
+    void            then(std::function<void()> continuation, JobPriority priority = JobPriority::NORMAL);
+
+private:
+    struct Task
+    {
+        std::function<void()> run;
+        std::atomic<bool> claimed{ false };
+    };
+
+    // shared with the queued jobs, which can outlive the group once their task has been claimed
+    struct State
+    {
+        std::deque<Task> tasks;
+        std::atomic<int> pending{ 0 };
+        std::mutex      mutex;
+        std::condition_variable done;
+        std::function<void()> continuation;
+        JobPriority     continuationPriority = JobPriority::NORMAL;
+        bool            hasContinuation = false;
+        bool            continued = false;
+        JobSystem*      system = nullptr;
+
+        void            execute(Task &task);
+        void            finishTask();
+    };
+
+    std::shared_ptr<State> _state;
+    JobPriority     _priority;
+};
@@ -1,4 +1,6 @@
 #include "Logger.h"
+#include "JobSystem.h"
+#include <memory>
 
 std::vector<LogEntry> Logger::_buffer;
 bool Logger::_scrollToBottom = false;
@@ -13,8 +15,12 @@ void Logger::ToFile()
 {
     std::string filename = "debug_log.txt";
     std::filesystem::path filePath = std::filesystem::current_path() / filename;
-    std::ofstream logFile(filePath);
-    for (const auto& entry : _buffer) logFile << entry.Message;
+    // a copy of the log as it is now goes to the file in the background
+    auto entries = std::make_shared<std::vector<LogEntry>>(_buffer);
+    JobSystem::instance().submit([filePath, entries]() {
+        std::ofstream logFile(filePath);
+        for (const auto& entry : *entries) logFile << entry.Message;
+    }, JobPriority::LOW);
     Logger::Info("Debug log saved to " + filePath.string());
 }
 
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+//
+// read-only memory mapped file, used for the endgame databases and other large tables
+// the mapping stays valid until close() or destruction
+//
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool            open(const std::string &path);
+    void            close();
+
+    bool            isOpen() const { return _data != nullptr; }
+    const uint8_t*  data() const { return _data; }
+    size_t          size() const { return _size; }
+
+private:
+    const uint8_t*  _data;
+    size_t          _size;
+#ifdef _WIN32
+    void*           _file;
+    void*           _mapping;
+#else
+    int             _fd;
+#endif
+};
@@ -0,0 +1,462 @@
+#pragma once
+
+#include "JobSystem.h"
+#include "Search.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+//
+// limits for an MCTS search, zero means unlimited (at least one must be set)
+//
+struct MctsLimits
+{
+    int         timeMs = 0;
+    uint64_t    playouts = 0;
+};
+
+struct MctsOptions
+{
+    enum Selection { UCT, PUCT };
+
+    Selection   selection = UCT;
+    float       exploration = 1.4f;         // c in UCT, c_puct in PUCT
+    int         threads = 0;                // 0 for one per core
+    uint32_t    maxNodes = 1 << 18;         // per arena, the engine keeps two for tree reuse
+    bool        lightRollouts = false;      // rollout moves drawn by the traits' prior instead of uniformly
+    int         maxRolloutPlies = 300;      // a rollout this long is scored by the evaluation's sign
+};
+
+template <class Move>
+struct MctsResult
+{
+    Move        bestMove{};
+    bool        hasMove = false;
+    uint64_t    playouts = 0;
+    uint32_t    nodes = 0;
+    uint32_t    reusedNodes = 0;            // nodes carried over from the last search's tree
+    float       winRate = 0.0f;             // of the best move, for the side to move
+    int         timeMs = 0;
+};
+
+//
+// the optional traits function behind PUCT and light rollouts, a positive weight for a move
+//   float prior(const Position &, const Move &)
+//
+template <class Traits>
+concept PriorTraits = SearchTraits<Traits> && requires(const typename Traits::Position position, const typename Traits::Position::Move move) {
+    { Traits::prior(position, move) } -> std::convertible_to<float>;
+};
+
+//
+// Monte Carlo tree search over the same traits as the SearchEngine: UCT or PUCT selection, random or
+// prior weighted rollouts and any number of threads sharing one tree, kept apart by virtual losses
+// nodes live in a fixed arena with the children of a node side by side. when the next search starts
+// from a position one or two moves below the last root, that subtree is copied to the other arena and
+// the search carries on from there
+//
+template <SearchTraits Traits>
+class MctsEngine
+{
+public:
+    using Position = typename Traits::Position;
+    using Move = typename Position::Move;
+    using Result = MctsResult<Move>;
+
+    MctsEngine(const MctsOptions &options = MctsOptions()) : _options(options), _stop(false) {}
+
+    Result search(const Position &root, const MctsLimits &limits)
+    {
+        start(root, limits);
+        if (!_searching) return _result;
+
+        int threadCount = _options.threads > 0 ? _options.threads : JobSystem::instance().workerCount();
+        int helpers = std::max(0, threadCount - 1);
+        JobGroup group;
+        for (int i = 0; i < helpers; i++) {
+            group.run([this, i] {
+                uint64_t random = 0x9E3779B97F4A7C15ull * ((uint64_t)i + 2);
+                run(random);
+            });
+        }
+        run(_random);
+        group.wait();
+        finish();
+        return _result;
+    }
+
+    //
+    // the same search a batch of playouts at a time on the calling thread, for builds that can't give it
+    // threads: start() sets it up and each advance() plays at most playouts more, or for timeUs
+    // microseconds (zero for no bound), returning true once the limits are reached. limits.timeMs counts
+    // from start(), so the search thinks for that long whatever share of each frame it gets
+    //
+    void start(const Position &root, const MctsLimits &limits)
+    {
+        _stop = false;
+        _startTime = std::chrono::steady_clock::now();
+        _limits = limits;
+        _playouts = 0;
+        _random = 0x9E3779B97F4A7C15ull;
+        if (!_arenas[0]) {
+            _arenas[0] = std::make_unique<Node[]>(_options.maxNodes);
+            _arenas[1] = std::make_unique<Node[]>(_options.maxNodes);
+        }
+
+        _result = Result();
+        _result.reusedNodes = reuseTree(root);
+        if (!_result.reusedNodes) {
+            resetNode(nodes()[0]);
+            _top = 1;
+        }
+        _root = root;
+        _hasTree = true;
+        _searching = !root.isTerminal();
+        if (_searching) expand(nodes()[0], root);
+    }
+
+    bool advance(uint64_t playouts = 0, int timeUs = 0)
+    {
+        if (!_searching) return true;
+        _slicePlayouts = playouts ? _playouts + playouts : 0;
+        _sliceEnd = std::chrono::steady_clock::now() + std::chrono::microseconds(timeUs);
+        _sliceTimed = timeUs > 0;
+        run(_random);
+        _slicePlayouts = 0;
+        _sliceTimed = false;
+        if (!finished()) return false;
+        finish();
+        return true;
+    }
+
+    // a search started and not finished yet
+    bool        searching() const { return _searching; }
+    const Position& searchRoot() const { return _root; }
+    // the search's answer once advance() has returned true
+    const Result& result() const { return _result; }
+
+    void        stop() { _stop = true; }
+    void        clearTree() { _hasTree = false; }
+    const MctsOptions& options() const { return _options; }
+
+    // takes effect with the next search, a new node budget drops the tree
+    void setOptions(const MctsOptions &options)
+    {
+        if (options.maxNodes != _options.maxNodes) {
+            _arenas[0].reset();
+            _arenas[1].reset();
+            _hasTree = false;
+        }
+        _options = options;
+    }
+
+private:
+    enum State : uint8_t { UNEXPANDED, EXPANDING, EXPANDED };
+
+    static const int VIRTUAL_LOSS = 1;
+    static const int MAX_PATH = 512;
+
+    struct Node
+    {
+        Move                    move{};
+        uint32_t                firstChild = 0;
+        uint16_t                childCount = 0;
+        uint8_t                 mover = 0;          // the side that played move
+        std::atomic<uint8_t>    state{ UNEXPANDED };
+        float                   prior = 1.0f;
+        std::atomic<uint32_t>   visits{ 0 };
+        std::atomic<uint32_t>   virtualLoss{ 0 };
+        std::atomic<uint64_t>   score{ 0 };         // half points for mover: 2 a win, 1 a draw
+    };
+
+    Node*       nodes() { return _arenas[_current].get(); }
+
+    int elapsedMs() const
+    {
+        return (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _startTime).count();
+    }
+
+    // the most visited root move is the answer
+    void finish()
+    {
+        const Node &rootNode = nodes()[0];
+        const Node *best = nullptr;
+        for (uint32_t i = 0; i < rootNode.childCount; i++) {
+            const Node &child = nodes()[rootNode.firstChild + i];
+            if (!best || child.visits > best->visits) best = &child;
+        }
+        if (best) {
+            _result.bestMove = best->move;
+            _result.hasMove = true;
+            uint32_t visits = best->visits;
+            _result.winRate = visits ? (float)best->score / (2.0f * visits) : 0.0f;
+        }
+        _result.playouts = _playouts;
+        _result.nodes = std::min<uint32_t>(_top, _options.maxNodes);
+        _result.timeMs = elapsedMs();
+        _searching = false;
+    }
+
+    bool finished()
+    {
+        if (_stop) return true;
+        if (_limits.playouts && _playouts >= _limits.playouts) return true;
+        if (_limits.timeMs && elapsedMs() >= _limits.timeMs) return true;
+        return !_limits.playouts && !_limits.timeMs;
+    }
+
+    static void resetNode(Node &node)
+    {
+        node.firstChild = 0;
+        node.childCount = 0;
+        node.state.store(UNEXPANDED, std::memory_order_relaxed);
+        node.visits.store(0, std::memory_order_relaxed);
+        node.virtualLoss.store(0, std::memory_order_relaxed);
+        node.score.store(0, std::memory_order_relaxed);
+    }
+
+    static void copyNode(Node &to, const Node &from)
+    {
+        to.move = from.move;
+        to.mover = from.mover;
+        to.prior = from.prior;
+        to.childCount = 0;
+        to.firstChild = 0;
+        to.state.store(UNEXPANDED, std::memory_order_relaxed);
+        to.visits.store(from.visits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        to.virtualLoss.store(0, std::memory_order_relaxed);
+        to.score.store(from.score.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    //
+    // finds root among the last root's children and grandchildren and makes its subtree the tree,
+    // returns the number of nodes kept
+    //
+    uint32_t reuseTree(const Position &root)
+    {
+        if (!_hasTree) return 0;
+        uint64_t key = root.hash();
+        if (_root.hash() == key) return std::min<uint32_t>(_top, _options.maxNodes);
+
+        Node *old = nodes();
+        int found = -1;
+        const Node &oldRoot = old[0];
+        if (oldRoot.state != EXPANDED) return 0;
+        for (uint32_t i = 0; i < oldRoot.childCount && found < 0; i++) {
+            const Node &child = old[oldRoot.firstChild + i];
+            Position position = _root;
+            position.makeMove(child.move);
+            if (position.hash() == key) {
+                found = (int)(oldRoot.firstChild + i);
+                break;
+            }
+            if (child.state != EXPANDED) continue;
+            for (uint32_t j = 0; j < child.childCount; j++) {
+                Position next = position;
+                next.makeMove(old[child.firstChild + j].move);
+                if (next.hash() == key) {
+                    found = (int)(child.firstChild + j);
+                    break;
+                }
+            }
+        }
+        if (found < 0) return 0;
+
+        // breadth first, so every node's children stay side by side in the new arena
+        Node *fresh = _arenas[_current ^ 1].get();
+        copyNode(fresh[0], old[found]);
+        std::vector<std::pair<uint32_t, uint32_t>> queue = { { (uint32_t)found, 0u } };
+        uint32_t top = 1;
+        for (size_t next = 0; next < queue.size(); next++) {
+            const Node &from = old[queue[next].first];
+            Node &to = fresh[queue[next].second];
+            if (from.state != EXPANDED) continue;
+            to.firstChild = top;
+            to.childCount = from.childCount;
+            for (uint32_t i = 0; i < from.childCount; i++) {
+                copyNode(fresh[top + i], old[from.firstChild + i]);
+                queue.push_back({ from.firstChild + i, top + i });
+            }
+            top += from.childCount;
+            to.state.store(EXPANDED, std::memory_order_relaxed);
+        }
+        _current ^= 1;
+        _top = top;
+        return top;
+    }
+
+    //
+    // allocates and fills node's children, false when another thread got there first or the arena is full
+    //
+    bool expand(Node &node, const Position &position)
+    {
+        if (_top.load(std::memory_order_relaxed) >= _options.maxNodes) return false;
+        uint8_t expected = UNEXPANDED;
+        if (!node.state.compare_exchange_strong(expected, EXPANDING, std::memory_order_acquire)) return false;
+
+        MovesOf<Position> moves;
+        position.generateMoves(moves);
+        uint32_t first = _top.fetch_add((uint32_t)moves.size());
+        if (first + (uint32_t)moves.size() > _options.maxNodes) {
+            node.state.store(UNEXPANDED, std::memory_order_release);
+            return false;
+        }
+
+        float total = 0.0f;
+        for (int i = 0; i < moves.size(); i++) {
+            Node &child = nodes()[first + i];
+            resetNode(child);
+            child.move = moves[i];
+            child.mover = (uint8_t)position.sideToMove();
+            child.prior = 1.0f;
+            if constexpr (PriorTraits<Traits>) child.prior = std::max(0.001f, (float)Traits::prior(position, moves[i]));
+            total += child.prior;
+        }
+        for (int i = 0; i < moves.size(); i++) nodes()[first + i].prior /= total;
+
+        node.firstChild = first;
+        node.childCount = (uint16_t)moves.size();
+        node.state.store(EXPANDED, std::memory_order_release);
+        return true;
+    }
+
+    Node& select(Node &parent)
+    {
+        uint32_t parentVisits = parent.visits.load(std::memory_order_relaxed) + parent.virtualLoss.load(std::memory_order_relaxed);
+        float logParent = std::log((float)std::max(1u, parentVisits));
+        float sqrtParent = std::sqrt((float)std::max(1u, parentVisits));
+        Node *best = &nodes()[parent.firstChild];
+        float bestValue = -1e30f;
+        for (uint32_t i = 0; i < parent.childCount; i++) {
+            Node &child = nodes()[parent.firstChild + i];
+            uint32_t visits = child.visits.load(std::memory_order_relaxed) + child.virtualLoss.load(std::memory_order_relaxed);
+            float wins = (float)child.score.load(std::memory_order_relaxed) * 0.5f;
+            float value;
+            if (_options.selection == MctsOptions::PUCT) {
+                float q = visits ? wins / visits : 0.5f;
+                value = q + _options.exploration * child.prior * sqrtParent / (1.0f + visits);
+            } else if (visits == 0) {
+                // every child once first, the likelier ones first
+                value = 1e20f + child.prior;
+            } else {
+                value = wins / visits + _options.exploration * std::sqrt(logParent / visits);
+            }
+            if (value > bestValue) {
+                bestValue = value;
+                best = &child;
+            }
+        }
+        return *best;
+    }
+
+    static uint64_t nextRandom(uint64_t &state)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+
+    //
+    // plays the position out, returns the winning side or -1 for a draw
+    //
+    int rollout(Position position, uint64_t &random) const
+    {
+        MovesOf<Position> moves;
+        for (int ply = 0; ply < _options.maxRolloutPlies; ply++) {
+            if (position.isTerminal()) {
+                int result = Traits::result(position);
+                return result > 0 ? position.sideToMove() : result < 0 ? position.sideToMove() ^ 1 : -1;
+            }
+            position.generateMoves(moves);
+            int pick = (int)(nextRandom(random) % (uint64_t)moves.size());
+            if constexpr (PriorTraits<Traits>) {
+                if (_options.lightRollouts) pick = weightedPick(position, moves, random);
+            }
+            position.makeMove(moves[pick]);
+        }
+        int score = Traits::evaluate(position);
+        return score > 0 ? position.sideToMove() : score < 0 ? position.sideToMove() ^ 1 : -1;
+    }
+
+    static int weightedPick(const Position &position, const MovesOf<Position> &moves, uint64_t &random)
+    {
+        float weights[Position::MAX_MOVES];
+        float total = 0.0f;
+        for (int i = 0; i < moves.size(); i++) {
+            weights[i] = std::max(0.001f, (float)Traits::prior(position, moves[i]));
+            total += weights[i];
+        }
+        float target = (float)(nextRandom(random) >> 40) / (float)(1ull << 24) * total;
+        for (int i = 0; i < moves.size(); i++) {
+            target -= weights[i];
+            if (target <= 0.0f) return i;
+        }
+        return moves.size() - 1;
+    }
+
+    // only ever set while advance() runs, so the helper threads of search() never see a slice
+    bool sliceUsed() const
+    {
+        if (_slicePlayouts && _playouts >= _slicePlayouts) return true;
+        return _sliceTimed && std::chrono::steady_clock::now() >= _sliceEnd;
+    }
+
+    void run(uint64_t &random)
+    {
+        Node *path[MAX_PATH];
+        while (!finished() && !sliceUsed()) {
+            Position position = _root;
+            Node *node = &nodes()[0];
+            int length = 0;
+            path[length++] = node;
+
+            // down the tree, marking the path so the other threads spread out
+            while (node->state.load(std::memory_order_acquire) == EXPANDED && node->childCount && length < MAX_PATH) {
+                node = &select(*node);
+                node->virtualLoss.fetch_add(VIRTUAL_LOSS, std::memory_order_relaxed);
+                position.makeMove(node->move);
+                path[length++] = node;
+            }
+
+            // a leaf that has been played out once gets its children
+            if (!position.isTerminal() && node->visits.load(std::memory_order_relaxed) > 0 && length < MAX_PATH &&
+                expand(*node, position)) {
+                node = &select(*node);
+                node->virtualLoss.fetch_add(VIRTUAL_LOSS, std::memory_order_relaxed);
+                position.makeMove(node->move);
+                path[length++] = node;
+            }
+
+            int winner = rollout(position, random);
+            for (int i = 0; i < length; i++) {
+                Node *visited = path[i];
+                if (i > 0) visited->virtualLoss.fetch_sub(VIRTUAL_LOSS, std::memory_order_relaxed);
+                visited->visits.fetch_add(1, std::memory_order_relaxed);
+                if (winner < 0) visited->score.fetch_add(1, std::memory_order_relaxed);
+                else if (winner == visited->mover) visited->score.fetch_add(2, std::memory_order_relaxed);
+            }
+            _playouts.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    MctsOptions             _options;
+    std::unique_ptr<Node[]> _arenas[2];
+    int                     _current = 0;
+    std::atomic<uint32_t>   _top{ 0 };
+    Position                _root;
+    bool                    _hasTree = false;
+
+    std::atomic<bool>       _stop;
+    std::atomic<uint64_t>   _playouts{ 0 };
+    MctsLimits              _limits;
+    Result                  _result;
+    bool                    _searching = false;
+    uint64_t                _random = 0;            // the calling thread's rollouts, carried between slices
+    uint64_t                _slicePlayouts = 0;
+    bool                    _sliceTimed = false;
+    std::chrono::steady_clock::time_point _sliceEnd;
+    std::chrono::steady_clock::time_point _startTime;
+};
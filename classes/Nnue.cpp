@@ -0,0 +1,169 @@
+#include "Nnue.h"
+#include <algorithm>
+
+// the SIMD kernels are built for their instruction set on their own and picked at run time, so the
+// rest of the build stays on the baseline. other compilers and CPUs get the scalar kernel
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define NNUE_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace Nnue
+{
+    namespace {
+        using PropagateFunction = int32_t (*)(const OutputLayers &, const int16_t *, const int16_t *);
+
+        int32_t outputLayer(const OutputLayers &layers, const int32_t *hidden)
+        {
+            int32_t output = layers.outputBias;
+            for (int j = 0; j < HIDDEN2; j++) output += hidden[j] * layers.outputWeights[j];
+            return output;
+        }
+
+        int32_t propagateScalar(const OutputLayers &layers, const int16_t *us, const int16_t *them)
+        {
+            uint8_t input[2 * HIDDEN];
+            for (int i = 0; i < HIDDEN; i++) {
+                input[i] = (uint8_t)std::clamp<int>(us[i], 0, QA);
+                input[HIDDEN + i] = (uint8_t)std::clamp<int>(them[i], 0, QA);
+            }
+
+            int32_t hidden[HIDDEN2];
+            for (int j = 0; j < HIDDEN2; j++) {
+                int32_t sum = layers.hiddenBias[j];
+                for (int i = 0; i < 2 * HIDDEN; i++) sum += input[i] * layers.hiddenWeights[j][i];
+                hidden[j] = std::clamp(sum >> WEIGHT_SHIFT, 0, QA);
+            }
+            return outputLayer(layers, hidden);
+        }
+
+#ifdef NNUE_X86_KERNELS
+        //
+        // 16 clipped int16 values to uint8 with the clipped relu on the way
+        //
+        __attribute__((target("ssse3")))
+        __m128i clip128(const int16_t *values)
+        {
+            __m128i packed = _mm_packus_epi16(_mm_load_si128((const __m128i *)values), _mm_load_si128((const __m128i *)(values + 8)));
+            return _mm_min_epu8(packed, _mm_set1_epi8((char)QA));
+        }
+
+        __attribute__((target("ssse3")))
+        int32_t propagateSsse3(const OutputLayers &layers, const int16_t *us, const int16_t *them)
+        {
+            const int BLOCKS = 2 * HIDDEN / 16;
+            __m128i input[BLOCKS];
+            for (int b = 0; b < BLOCKS / 2; b++) {
+                input[b] = clip128(us + 16 * b);
+                input[BLOCKS / 2 + b] = clip128(them + 16 * b);
+            }
+
+            const __m128i ones = _mm_set1_epi16(1);
+            int32_t hidden[HIDDEN2];
+            for (int j = 0; j < HIDDEN2; j++) {
+                __m128i sum = _mm_setzero_si128();
+                for (int b = 0; b < BLOCKS; b++) {
+                    __m128i weights = _mm_load_si128((const __m128i *)(layers.hiddenWeights[j] + 16 * b));
+                    sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_maddubs_epi16(input[b], weights), ones));
+                }
+                sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+                sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+                hidden[j] = std::clamp((_mm_cvtsi128_si32(sum) + layers.hiddenBias[j]) >> WEIGHT_SHIFT, 0, QA);
+            }
+            return outputLayer(layers, hidden);
+        }
+
+        // packus works within 128-bit lanes, the permute puts the 32 bytes back in order
+        __attribute__((target("avx2")))
+        __m256i clip256(const int16_t *values)
+        {
+            __m256i packed = _mm256_packus_epi16(_mm256_load_si256((const __m256i *)values), _mm256_load_si256((const __m256i *)(values + 16)));
+            packed = _mm256_permute4x64_epi64(packed, 0xD8);
+            return _mm256_min_epu8(packed, _mm256_set1_epi8((char)QA));
+        }
+
+        __attribute__((target("avx2")))
+        int32_t propagateAvx2(const OutputLayers &layers, const int16_t *us, const int16_t *them)
+        {
+            const int BLOCKS = 2 * HIDDEN / 32;
+            __m256i input[BLOCKS];
+            for (int b = 0; b < BLOCKS / 2; b++) {
+                input[b] = clip256(us + 32 * b);
+                input[BLOCKS / 2 + b] = clip256(them + 32 * b);
+            }
+
+            const __m256i ones = _mm256_set1_epi16(1);
+            int32_t hidden[HIDDEN2];
+            for (int j = 0; j < HIDDEN2; j++) {
+                __m256i sum = _mm256_setzero_si256();
+                for (int b = 0; b < BLOCKS; b++) {
+                    __m256i weights = _mm256_load_si256((const __m256i *)(layers.hiddenWeights[j] + 32 * b));
+                    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(input[b], weights), ones));
+                }
+                __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+                half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+                half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+                hidden[j] = std::clamp((_mm_cvtsi128_si32(half) + layers.hiddenBias[j]) >> WEIGHT_SHIFT, 0, QA);
+            }
+            return outputLayer(layers, hidden);
+        }
+#endif
+
+        bool supported(Kernel kernel)
+        {
+#ifdef NNUE_X86_KERNELS
+            if (kernel == AVX2) return __builtin_cpu_supports("avx2");
+            if (kernel == SSSE3) return __builtin_cpu_supports("ssse3");
+#else
+            if (kernel != SCALAR) return false;
+#endif
+            return true;
+        }
+
+        PropagateFunction functionFor(Kernel kernel)
+        {
+#ifdef NNUE_X86_KERNELS
+            if (kernel == AVX2) return propagateAvx2;
+            if (kernel == SSSE3) return propagateSsse3;
+#endif
+            return propagateScalar;
+        }
+
+        struct Selected
+        {
+            Kernel              kernel;
+            PropagateFunction   function;
+        };
+
+        Selected& selected()
+        {
+            static Selected best = [] {
+                Kernel kernel = supported(AVX2) ? AVX2 : supported(SSSE3) ? SSSE3 : SCALAR;
+                return Selected{ kernel, functionFor(kernel) };
+            }();
+            return best;
+        }
+    }
+
+    int32_t propagate(const OutputLayers &layers, const int16_t *us, const int16_t *them)
+    {
+        return selected().function(layers, us, them);
+    }
+
+    Kernel kernel()
+    {
+        return selected().kernel;
+    }
+
+    bool setKernel(Kernel kernel)
+    {
+        if (!supported(kernel)) return false;
+        selected() = { kernel, functionFor(kernel) };
+        return true;
+    }
+
+    const char* kernelName(Kernel kernel)
+    {
+        return kernel == AVX2 ? "avx2" : kernel == SSSE3 ? "ssse3" : "scalar";
+    }
+}
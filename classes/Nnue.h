@@ -0,0 +1,280 @@
+#pragma once
+
+#include "ConnectFourBoard.h"
+#include "OthelloBoard.h"
+#include "Position.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+//
+// a small quantized network in the NNUE style for the bitboard games. the first layer is one int16 row
+// per (square, own or opponent's disc) from each side's point of view, summed into an accumulator that
+// makeMove and unmakeMove keep up to date with a few row additions. the rest, 2 x 64 clipped inputs to
+// 32 int8 weighted hidden units to one output, runs in Nnue::propagate with AVX2 or SSSE3 when the CPU
+// has them. networks are written by tools/nnue_train and loaded from weights/ at startup
+//
+namespace Nnue
+{
+    constexpr int HIDDEN = 64;              // accumulator width per side
+    constexpr int HIDDEN2 = 32;
+    constexpr int QA = 127;                 // accumulator units for 1.0, the clipped relu's top
+    constexpr int QB = 64;                  // weight units for 1.0 in the int8 layers
+    constexpr int WEIGHT_SHIFT = 6;         // log2(QB)
+
+    constexpr uint32_t FILE_MAGIC = 0x45554E4E;     // "NNUE"
+    constexpr uint32_t FILE_VERSION = 1;
+
+    struct FileHeader
+    {
+        uint32_t    magic;
+        uint32_t    version;
+        uint32_t    squares;
+        uint32_t    hidden;
+        uint32_t    hidden2;
+        int32_t     outputScale;            // evaluation units for an output of 1.0
+    };
+
+    struct OutputLayers
+    {
+        alignas(32) int8_t  hiddenWeights[HIDDEN2][2 * HIDDEN];
+        alignas(32) int32_t hiddenBias[HIDDEN2];
+        alignas(32) int8_t  outputWeights[HIDDEN2];
+        int32_t             outputBias;
+    };
+
+    enum Kernel { SCALAR, SSSE3, AVX2 };
+
+    // the layers after the accumulator, the output in QA * QB units
+    int32_t     propagate(const OutputLayers &layers, const int16_t *us, const int16_t *them);
+
+    // the best kernel the CPU runs is picked on first use, setKernel is for benchmarks
+    Kernel      kernel();
+    bool        setKernel(Kernel kernel);
+    const char* kernelName(Kernel kernel);
+}
+
+struct alignas(32) NnueAccumulator
+{
+    int16_t     values[2][Nnue::HIDDEN];    // from player 0's and player 1's point of view
+};
+
+//
+// the network for a board of SQUARES squares, feature (own ? 0 : SQUARES) + square
+//
+template <int SQUARES>
+struct NnueNetwork
+{
+    static constexpr int FEATURES = 2 * SQUARES;
+
+    alignas(32) int16_t featureWeights[FEATURES][Nnue::HIDDEN];
+    alignas(32) int16_t featureBias[Nnue::HIDDEN];
+    Nnue::OutputLayers  layers;
+    int32_t             outputScale = 100;
+
+    static int feature(int perspective, int color, int square) { return (color == perspective ? 0 : SQUARES) + square; }
+
+    void addFeature(NnueAccumulator &accumulator, int color, int square) const
+    {
+        for (int perspective = 0; perspective < 2; perspective++) {
+            const int16_t *row = featureWeights[feature(perspective, color, square)];
+            int16_t *values = accumulator.values[perspective];
+            for (int i = 0; i < Nnue::HIDDEN; i++) values[i] += row[i];
+        }
+    }
+
+    void removeFeature(NnueAccumulator &accumulator, int color, int square) const
+    {
+        for (int perspective = 0; perspective < 2; perspective++) {
+            const int16_t *row = featureWeights[feature(perspective, color, square)];
+            int16_t *values = accumulator.values[perspective];
+            for (int i = 0; i < Nnue::HIDDEN; i++) values[i] -= row[i];
+        }
+    }
+
+    // score for side, in the evaluation units the network was trained on
+    int evaluate(const NnueAccumulator &accumulator, int side) const
+    {
+        int32_t output = Nnue::propagate(layers, accumulator.values[side], accumulator.values[side ^ 1]);
+        return (int)((int64_t)output * outputScale / (Nnue::QA * Nnue::QB));
+    }
+
+    bool load(const std::string &path)
+    {
+        FILE *file = fopen(path.c_str(), "rb");
+        if (!file) return false;
+        Nnue::FileHeader header;
+        bool ok = fread(&header, sizeof(header), 1, file) == 1 && header.magic == Nnue::FILE_MAGIC &&
+                  header.version == Nnue::FILE_VERSION && header.squares == (uint32_t)SQUARES &&
+                  header.hidden == (uint32_t)Nnue::HIDDEN && header.hidden2 == (uint32_t)Nnue::HIDDEN2 &&
+                  fread(featureWeights, sizeof(featureWeights), 1, file) == 1 &&
+                  fread(featureBias, sizeof(featureBias), 1, file) == 1 &&
+                  fread(&layers, sizeof(layers), 1, file) == 1;
+        fclose(file);
+        if (ok) outputScale = header.outputScale;
+        return ok;
+    }
+
+    bool save(const std::string &path) const
+    {
+        FILE *file = fopen(path.c_str(), "wb");
+        if (!file) return false;
+        Nnue::FileHeader header = { Nnue::FILE_MAGIC, Nnue::FILE_VERSION, (uint32_t)SQUARES, (uint32_t)Nnue::HIDDEN,
+                                    (uint32_t)Nnue::HIDDEN2, outputScale };
+        bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                  fwrite(featureWeights, sizeof(featureWeights), 1, file) == 1 &&
+                  fwrite(featureBias, sizeof(featureBias), 1, file) == 1 &&
+                  fwrite(&layers, sizeof(layers), 1, file) == 1;
+        return fclose(file) == 0 && ok;
+    }
+};
+
+//
+// what the network sees of a game: its GamePosition and the discs of each color as a bit mask
+//
+struct ConnectFourFeatures
+{
+    using Position = ConnectFourBoard;
+    using Mask = uint64_t;
+    static constexpr int SQUARES = ConnectFourBoard::WIDTH * ConnectFourBoard::STRIDE;     // sentinel bits included
+    static constexpr const char *WEIGHTS_FILE = "weights/connectfour.nnue";
+
+    static uint64_t discs(const Position &board, int color) { return board.discs[color]; }
+};
+
+template <int N>
+struct OthelloFeatures
+{
+    using Position = OthelloPosition<N>;
+    using Mask = typename OthelloBoard<N>::Mask;
+    static constexpr int SQUARES = N * N;
+    static constexpr const char *WEIGHTS_FILE = N == 8 ? "weights/othello.nnue" : N == 6 ? "weights/othello6.nnue" : "weights/othello10.nnue";
+
+    static Mask discs(const Position &position, int color) { return position.board.discs[color]; }
+};
+
+//
+// the network for a game, read from its weights file the first time it is asked for, null without one
+// tools that train or benchmark a network put their own in place with setSharedNetwork, between searches
+//
+template <class Features>
+const NnueNetwork<Features::SQUARES>*& sharedNetworkSlot()
+{
+    static const NnueNetwork<Features::SQUARES> *network = [] {
+        static NnueNetwork<Features::SQUARES> loaded;
+        return loaded.load(Features::WEIGHTS_FILE) ? &loaded : nullptr;
+    }();
+    return network;
+}
+
+template <class Features>
+const NnueNetwork<Features::SQUARES>* sharedNetwork() { return sharedNetworkSlot<Features>(); }
+
+template <class Features>
+void setSharedNetwork(const NnueNetwork<Features::SQUARES> *network) { sharedNetworkSlot<Features>() = network; }
+
+//
+// a game's position with the shared network's accumulator riding along, a GamePosition itself
+// the accumulator is all zeros when there is no network
+//
+template <class Features>
+struct NnuePosition
+{
+    using Base = typename Features::Position;
+    using Move = typename Base::Move;
+    using Undo = typename Base::Undo;
+    using Mask = typename Features::Mask;
+    using Network = NnueNetwork<Features::SQUARES>;
+
+    static constexpr int MAX_MOVES = Base::MAX_MOVES;
+
+    Base            base;
+    NnueAccumulator accumulator;
+
+    NnuePosition() { refresh(); }
+    explicit NnuePosition(const Base &position) : base(position) { refresh(); }
+
+    int         sideToMove() const { return base.sideToMove(); }
+    uint64_t    hash() const { return base.hash(); }
+    bool        isTerminal() const { return base.isTerminal(); }
+    void        generateMoves(MoveList<Move, MAX_MOVES> &moves) const { base.generateMoves(moves); }
+    std::string toString() const { return base.toString(); }
+
+    Undo makeMove(Move move)
+    {
+        Mask before[2] = { Features::discs(base, 0), Features::discs(base, 1) };
+        Undo undo = base.makeMove(move);
+        update(before);
+        return undo;
+    }
+
+    void unmakeMove(Move move, Undo undo)
+    {
+        Mask before[2] = { Features::discs(base, 0), Features::discs(base, 1) };
+        base.unmakeMove(move, undo);
+        update(before);
+    }
+
+    bool fromString(const std::string &state, int side)
+    {
+        bool ok = base.fromString(state, side);
+        refresh();
+        return ok;
+    }
+
+    // the accumulator from scratch
+    void refresh()
+    {
+        const Network *network = sharedNetwork<Features>();
+        for (int perspective = 0; perspective < 2; perspective++) {
+            for (int i = 0; i < Nnue::HIDDEN; i++) accumulator.values[perspective][i] = network ? network->featureBias[i] : 0;
+        }
+        if (!network) return;
+        for (int color = 0; color < 2; color++) {
+            Mask discs = Features::discs(base, color);
+            while (discs) network->addFeature(accumulator, color, Bitboard::popLowestBit(discs));
+        }
+    }
+
+private:
+    // only the discs that changed, one for a connect four drop, the flips too for othello
+    void update(const Mask before[2])
+    {
+        const Network *network = sharedNetwork<Features>();
+        if (!network) return;
+        for (int color = 0; color < 2; color++) {
+            Mask after = Features::discs(base, color);
+            Mask added = after & ~before[color];
+            Mask removed = before[color] & ~after;
+            while (added) network->addFeature(accumulator, color, Bitboard::popLowestBit(added));
+            while (removed) network->removeFeature(accumulator, color, Bitboard::popLowestBit(removed));
+        }
+    }
+};
+
+//
+// SearchEngine traits that score with the network and fall back to the game's own evaluation without one
+//
+template <class Features, class BaseTraits>
+struct NnueTraits
+{
+    using Position = NnuePosition<Features>;
+    static constexpr int HISTORY_SIZE = BaseTraits::HISTORY_SIZE;
+
+    static int evaluate(const Position &position)
+    {
+        const auto *network = sharedNetwork<Features>();
+        return network ? network->evaluate(position.accumulator, position.sideToMove()) : BaseTraits::evaluate(position.base);
+    }
+
+    static int result(const Position &position) { return BaseTraits::result(position.base); }
+    static int historyIndex(const typename Position::Move &move) { return BaseTraits::historyIndex(move); }
+};
+
+using ConnectFourNnueTraits = NnueTraits<ConnectFourFeatures, ConnectFourTraits>;
+template <int N>
+using OthelloNnueTraits = NnueTraits<OthelloFeatures<N>, OthelloTraits<N>>;
+
+static_assert(GamePosition<NnuePosition<ConnectFourFeatures>>);
+static_assert(GamePosition<NnuePosition<OthelloFeatures<8>>>);
+static_assert(GamePosition<NnuePosition<OthelloFeatures<10>>>);
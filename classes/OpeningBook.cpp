@@ -0,0 +1,91 @@
+#include "OpeningBook.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+uint64_t OpeningBookFile::checksum(const uint8_t *bytes, size_t size)
+{
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+bool OpeningBookFile::write(const std::string &path, const std::string &game, int plies, std::vector<Entry> entries)
+{
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.key < b.key; });
+    entries.erase(std::unique(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.key == b.key; }),
+                  entries.end());
+
+    Header header = {};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    strncpy(header.game, game.c_str(), sizeof(header.game) - 1);
+    header.entrySize = sizeof(Entry);
+    header.plies = (uint32_t)plies;
+    header.entryCount = entries.size();
+    header.checksum = checksum(reinterpret_cast<const uint8_t*>(entries.data()), entries.size() * sizeof(Entry));
+
+    std::error_code error;
+    std::filesystem::path target(path);
+    if (target.has_parent_path()) std::filesystem::create_directories(target.parent_path(), error);
+    std::string temporary = path + ".tmp";
+    FILE *file = fopen(temporary.c_str(), "wb");
+    if (!file) return false;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(entries.data(), sizeof(Entry), entries.size(), file) == entries.size();
+    ok = fclose(file) == 0 && ok;
+    if (ok) std::filesystem::rename(temporary, target, error);
+    if (!ok || error) {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
+
+bool OpeningBook::open(const std::string &path, const std::string &game)
+{
+    close();
+    if (!_file.open(path) || _file.size() < sizeof(OpeningBookFile::Header)) {
+        _file.close();
+        return false;
+    }
+    OpeningBookFile::Header header;
+    memcpy(&header, _file.data(), sizeof(header));
+    char name[sizeof(header.game)] = {};
+    strncpy(name, game.c_str(), sizeof(name) - 1);
+    size_t bytes = _file.size() - sizeof(header);
+    const uint8_t *entries = _file.data() + sizeof(header);
+    if (header.magic != OpeningBookFile::MAGIC || header.version != OpeningBookFile::VERSION ||
+        memcmp(header.game, name, sizeof(name)) != 0 || header.entrySize != sizeof(OpeningBookFile::Entry) ||
+        header.entryCount * sizeof(OpeningBookFile::Entry) != bytes || OpeningBookFile::checksum(entries, bytes) != header.checksum) {
+        _file.close();
+        return false;
+    }
+    _entries = reinterpret_cast<const OpeningBookFile::Entry*>(entries);
+    _count = header.entryCount;
+    _plies = (int)header.plies;
+    return true;
+}
+
+void OpeningBook::close()
+{
+    _file.close();
+    _entries = nullptr;
+    _count = 0;
+    _plies = 0;
+}
+
+bool OpeningBook::find(uint64_t key, OpeningBookFile::Entry &entry) const
+{
+    if (!_entries) return false;
+    const OpeningBookFile::Entry *end = _entries + _count;
+    const OpeningBookFile::Entry *found = std::lower_bound(_entries, end, key,
+        [](const OpeningBookFile::Entry &candidate, uint64_t value) { return candidate.key < value; });
+    if (found == end || found->key != key) return false;
+    entry = *found;
+    return true;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "Position.h"
+#include "Symmetry.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//
+// opening book files: a header naming the game, then entries sorted by key for a binary search in the
+// memory mapping. a key is the canonical key of a position (Symmetry.h), so one entry stands for every
+// transposition and symmetric form of it, and its move is an index into the moves of the canonical form
+//
+namespace OpeningBookFile
+{
+    constexpr uint32_t MAGIC = 0x314B4F42;      // "BOK1"
+    constexpr uint32_t VERSION = 1;
+    constexpr uint8_t NO_MOVE = 255;
+
+    struct Header
+    {
+        uint32_t    magic;
+        uint32_t    version;
+        char        game[16];
+        uint32_t    entrySize;
+        uint32_t    plies;          // how deep the book's tree goes
+        uint64_t    entryCount;
+        uint64_t    checksum;       // FNV-1a of the entries
+    };
+
+    struct Entry
+    {
+        uint64_t    key;
+        int16_t     score;          // for the side to move, in the engine's units
+        uint8_t     move;           // the best move of the canonical form, NO_MOVE for none
+        uint8_t     ply;
+        uint16_t    depth;          // plies searched behind the score
+        uint16_t    reserved;
+    };
+
+    static_assert(sizeof(Header) == 48 && sizeof(Entry) == 16, "the book is read in place");
+
+    uint64_t    checksum(const uint8_t *bytes, size_t size);
+
+    // sorts the entries and writes them through a temporary file renamed over path, false when that fails
+    bool        write(const std::string &path, const std::string &game, int plies, std::vector<Entry> entries);
+}
+
+//
+// a book file opened for lookups, read in place from a memory mapping
+//
+class OpeningBook
+{
+public:
+    // false, with the book left closed, for no file or one of another game or version or a bad checksum
+    bool            open(const std::string &path, const std::string &game);
+    void            close();
+
+    bool            isOpen() const { return _entries != nullptr; }
+    size_t          size() const { return _count; }
+    int             plies() const { return _plies; }
+
+    bool            find(uint64_t key, OpeningBookFile::Entry &entry) const;
+
+    // the book's move for a position, in the position's own orientation
+    template <SymmetricPosition P>
+    bool move(const P &position, typename P::Move &move, int *score = nullptr) const
+    {
+        Canonical<P> canonical = canonicalize(position);
+        OpeningBookFile::Entry entry;
+        if (!find(canonical.position.hash(), entry) || entry.move == OpeningBookFile::NO_MOVE) return false;
+        MovesOf<P> moves;
+        canonical.position.generateMoves(moves);
+        if (entry.move >= moves.size()) return false;
+        move = fromCanonical<P>(moves[entry.move], canonical.symmetry);
+        if (score) *score = entry.score;
+        return true;
+    }
+
+private:
+    MappedFile      _file;
+    const OpeningBookFile::Entry *_entries = nullptr;
+    size_t          _count = 0;
+    int             _plies = 0;
+};
@@ -1,83 +1,100 @@
 #include "Othello.h"
 #include <iostream>
 
-// Define the 8 directions: N, NE, E, SE, S, SW, W, NW
-const int Othello::DIRECTIONS[8][2] = {
-    {0, -1}, {1, -1}, {1, 0}, {1, 1},
-    {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}
-};
-
-Othello::Othello() : Game() {
-    _grid = new Grid(8, 8);
+template <int N>
+OthelloGame<N>::OthelloGame() : Game() {
+    _grid = new Grid(N, N);
+    _board = Board::initial();
     _consecutivePasses = 0;
     _showingHints = false;
 }
 
-Othello::~Othello() {
+template <int N>
+OthelloGame<N>::~OthelloGame() {
     delete _grid;
 }
 
-void Othello::setUpBoard() {
+template <int N>
+void OthelloGame<N>::setUpBoard() {
     setNumberOfPlayers(2);
-    _gameOptions.rowX = 8;
-    _gameOptions.rowY = 8;
+    _gameOptions.rowX = N;
+    _gameOptions.rowY = N;
 
     _grid->initializeSquares(80, "boardsquare.png");
+    evalWeights<OthelloWeights<N>>(); // read a tuned weights file now rather than in the first search
+    updateTableCache(false);
+    _book.open(OPENING_BOOK, GAME_NAME); // built by tools/book_builder, the AI does without one
 
-    // Set up initial four pieces in the center
-    Player* blackPlayer = getPlayerAt(BLACK_PLAYER);
-    Player* whitePlayer = getPlayerAt(WHITE_PLAYER);
-
-    // Standard Othello starting position
-    auto placePiece = [&](int x, int y, Player* player) {
-        Bit* piece = createPiece(player);
-        piece->setPosition(_grid->getSquare(x, y)->getPosition());
-        _grid->getSquare(x, y)->setBit(piece);
-    };
-
-    placePiece(3, 3, whitePlayer);  // White at (3,3)
-    placePiece(4, 4, whitePlayer);  // White at (4,4)
-    placePiece(4, 3, blackPlayer);  // Black at (4,3)
-    placePiece(3, 4, blackPlayer);  // Black at (3,4)
+    // Standard Othello starting position, four pieces in the center
+    _board = Board::initial();
+    _consecutivePasses = 0;
+    for (int index = 0; index < Board::SQUARES; index++) {
+        int piece = _board.pieceAt(index);
+        if (piece) {
+            placePiece(index, getPlayerAt(piece == 1 ? BLACK_PLAYER : WHITE_PLAYER));
+        }
+    }
 
     if (gameHasAI()) {
         setAIPlayer(AI_PLAYER);
     }
-    
+
     startGame();
 }
 
-Bit* Othello::createPiece(Player* player) {
+template <int N>
+Bit* OthelloGame<N>::createPiece(Player* player) {
     Bit* bit = new Bit();
     bit->LoadTextureFromFile(player == getPlayerAt(BLACK_PLAYER) ? "o.png" : "x.png");
     bit->setOwner(player);
     return bit;
 }
 
-bool Othello::actionForEmptyHolder(BitHolder &holder) {
+//
+// put a new piece for player on the grid square matching a board index
+//
+template <int N>
+void OthelloGame<N>::placePiece(int index, Player* player) {
+    ChessSquare* square = _grid->getSquareByIndex(index);
+    square->destroyBit();
+    Bit* piece = createPiece(player);
+    piece->setPosition(square->getPosition());
+    square->setBit(piece);
+}
+
+//
+// mirror the discs flipped on the bitboard onto the grid
+//
+template <int N>
+void OthelloGame<N>::flipPieces(Mask flipped, Player* player) {
+    while (flipped) {
+        placePiece(Bitboard::popLowestBit(flipped), player);
+    }
+}
+
+template <int N>
+bool OthelloGame<N>::actionForEmptyHolder(BitHolder &holder) {
     if (holder.bit()) return false;
 
     ChessSquare* square = static_cast<ChessSquare*>(&holder);
     int x = square->getColumn();
     int y = square->getRow();
     Player* currentPlayer = getCurrentPlayer();
+    int side = currentPlayer->playerNumber();
 
-    if (!isValidMove(x, y, currentPlayer)) return false;
-
-    // Place the piece
-    Bit* newPiece = createPiece(currentPlayer);
-    newPiece->setPosition(holder.getPosition());
-    holder.setBit(newPiece);
+    // Place the piece, the board rejects moves that don't flip anything
+    int index = Board::index(x, y);
+    Mask flipped = _board.play(side, index);
+    if (!flipped) return false;
 
-    // Flip all affected pieces
-    flipPieces(x, y, currentPlayer);
+    placePiece(index, currentPlayer);
+    flipPieces(flipped, currentPlayer);
     _consecutivePasses = 0;
 
     // Check if next player has moves
-    Player* nextPlayer = getPlayerAt(1 - currentPlayer->playerNumber());
-    if (!hasValidMove(nextPlayer)) {
+    if (!_board.hasMove(side ^ 1)) {
         _consecutivePasses++;
-        if (hasValidMove(currentPlayer)) {
+        if (_board.hasMove(side)) {
             // Next player passes, current player continues
             return true;
         } else {
@@ -89,254 +106,225 @@ bool Othello::actionForEmptyHolder(BitHolder &holder) {
     return true;
 }
 
-bool Othello::canBitMoveFrom(Bit &bit, BitHolder &src) {
+template <int N>
+bool OthelloGame<N>::canBitMoveFrom(Bit &bit, BitHolder &src) {
     return false; // Pieces cannot be moved in Othello
 }
 
-bool Othello::canBitMoveFromTo(Bit &bit, BitHolder &src, BitHolder &dst) {
+template <int N>
+bool OthelloGame<N>::canBitMoveFromTo(Bit &bit, BitHolder &src, BitHolder &dst) {
     return false; // Pieces cannot be moved in Othello
 }
 
-bool Othello::isValidMove(int x, int y, Player* player) const {
-    if (!_grid->isValid(x, y) || _grid->getSquare(x, y)->bit()) return false;
-
-    // Check if placing a piece here would flip at least one opponent piece
-    for (int i = 0; i < 8; i++) {
-        if (checkDirection(x, y, DIRECTIONS[i][0], DIRECTIONS[i][1], player) > 0) {
-            return true;
-        }
-    }
-    return false;
-}
-
-int Othello::checkDirection(int x, int y, int dx, int dy, Player* player) const {
-    int count = 0;
-    int nx = x + dx;
-    int ny = y + dy;
-
-    if (!_grid->isValid(nx, ny)) return 0;
-
-    Bit* firstPiece = _grid->getSquare(nx, ny)->bit();
-    if (!firstPiece || firstPiece->getOwner() == player) return 0;
-
-    // Count opponent pieces in this direction
-    while (_grid->isValid(nx, ny)) {
-        Bit* piece = _grid->getSquare(nx, ny)->bit();
-        if (!piece) return 0;
-        if (piece->getOwner() == player) return count;
-        count++;
-        nx += dx;
-        ny += dy;
-    }
-    return 0;
-}
-
-void Othello::flipPieces(int x, int y, Player* player) {
-    for (int i = 0; i < 8; i++) {
-        int count = checkDirection(x, y, DIRECTIONS[i][0], DIRECTIONS[i][1], player);
-        if (count > 0) {
-            flipInDirection(x, y, DIRECTIONS[i][0], DIRECTIONS[i][1], player, count);
-        }
-    }
-}
-
-void Othello::flipInDirection(int x, int y, int dx, int dy, Player* player, int count) {
-    int nx = x + dx;
-    int ny = y + dy;
-
-    for (int i = 0; i < count; i++) {
-        ChessSquare* square = _grid->getSquare(nx, ny);
-        if (square && square->bit()) {
-            square->destroyBit();
-            Bit* newPiece = createPiece(player);
-            newPiece->setPosition(square->getPosition());
-            square->setBit(newPiece);
-        }
-        nx += dx;
-        ny += dy;
-    }
+template <int N>
+bool OthelloGame<N>::isValidMove(int x, int y, Player* player) const {
+    if (!_grid->isValid(x, y)) return false;
+    return Bitboard::test(_board.legalMoves(player->playerNumber()), Board::index(x, y));
 }
 
-bool Othello::hasValidMove(Player* player) const {
-    bool hasMove = false;
-    _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
-        if (!hasMove && isValidMove(x, y, player)) {
-            hasMove = true;
-        }
-    });
-    return hasMove;
+template <int N>
+bool OthelloGame<N>::hasValidMove(Player* player) const {
+    return _board.hasMove(player->playerNumber());
 }
 
-std::vector<std::pair<int, int>> Othello::getValidMoves(Player* player) const {
+template <int N>
+std::vector<std::pair<int, int>> OthelloGame<N>::getValidMoves(Player* player) const {
     std::vector<std::pair<int, int>> moves;
-    _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
-        if (isValidMove(x, y, player)) {
-            moves.push_back({x, y});
-        }
-    });
+    Mask legal = _board.legalMoves(player->playerNumber());
+    while (legal) {
+        int index = Bitboard::popLowestBit(legal);
+        moves.push_back({index % N, index / N});
+    }
     return moves;
 }
 
-Player* Othello::checkForWinner() {
-    // Game ends when neither player can move
-    if (_consecutivePasses >= 2 ||
-        (!hasValidMove(getPlayerAt(BLACK_PLAYER)) && !hasValidMove(getPlayerAt(WHITE_PLAYER)))) {
-
-        int blackCount, whiteCount;
-        countPieces(blackCount, whiteCount);
-
-        if (blackCount > whiteCount) return getPlayerAt(BLACK_PLAYER);
-        if (whiteCount > blackCount) return getPlayerAt(WHITE_PLAYER);
-    }
+//
+// Game ends when neither player can move, which includes a full board
+//
+template <int N>
+bool OthelloGame<N>::isGameOver() const {
+    return _consecutivePasses >= 2 || _board.isOver();
+}
 
-    // Check if board is full
-    bool boardFull = true;
-    _grid->forEachSquare([&boardFull](ChessSquare* square, int x, int y) {
-        if (!square->bit()) boardFull = false;
-    });
+template <int N>
+Player* OthelloGame<N>::checkForWinner() {
+    if (!isGameOver()) return nullptr;
 
-    if (boardFull) {
-        int blackCount, whiteCount;
-        countPieces(blackCount, whiteCount);
-        if (blackCount > whiteCount) return getPlayerAt(BLACK_PLAYER);
-        if (whiteCount > blackCount) return getPlayerAt(WHITE_PLAYER);
-    }
+    int blackCount, whiteCount;
+    countPieces(blackCount, whiteCount);
 
+    if (blackCount > whiteCount) return getPlayerAt(BLACK_PLAYER);
+    if (whiteCount > blackCount) return getPlayerAt(WHITE_PLAYER);
     return nullptr;
 }
 
-bool Othello::checkForDraw() {
-    if (_consecutivePasses >= 2 ||
-        (!hasValidMove(getPlayerAt(BLACK_PLAYER)) && !hasValidMove(getPlayerAt(WHITE_PLAYER)))) {
-        int blackCount, whiteCount;
-        countPieces(blackCount, whiteCount);
-        return blackCount == whiteCount;
-    }
-
-    bool boardFull = true;
-    _grid->forEachSquare([&boardFull](ChessSquare* square, int x, int y) {
-        if (!square->bit()) boardFull = false;
-    });
+template <int N>
+bool OthelloGame<N>::checkForDraw() {
+    if (!isGameOver()) return false;
 
-    if (boardFull) {
-        int blackCount, whiteCount;
-        countPieces(blackCount, whiteCount);
-        return blackCount == whiteCount;
-    }
-    return false;
+    int blackCount, whiteCount;
+    countPieces(blackCount, whiteCount);
+    return blackCount == whiteCount;
 }
 
-void Othello::countPieces(int &blackCount, int &whiteCount) const {
-    blackCount = 0;
-    whiteCount = 0;
-
-    _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
-        Bit* piece = square->bit();
-        if (piece) {
-            if (piece->getOwner() == getPlayerAt(BLACK_PLAYER)) {
-                blackCount++;
-            } else {
-                whiteCount++;
-            }
-        }
-    });
+template <int N>
+void OthelloGame<N>::countPieces(int &blackCount, int &whiteCount) const {
+    blackCount = _board.count(Board::BLACK);
+    whiteCount = _board.count(Board::WHITE);
 }
 
-void Othello::stopGame() {
+template <int N>
+void OthelloGame<N>::stopGame() {
     _grid->forEachSquare([](ChessSquare* square, int x, int y) {
         square->destroyBit();
     });
+    _board = Board::initial();
     _consecutivePasses = 0;
 }
 
-std::string Othello::initialStateString() {
-    std::string state(64, '0');
-    state[3 * 8 + 3] = '2';  // White at (3,3)
-    state[4 * 8 + 4] = '2';  // White at (4,4)
-    state[4 * 8 + 3] = '1';  // Black at (4,3)
-    state[3 * 8 + 4] = '1';  // Black at (3,4)
-    return state;
+template <int N>
+std::string OthelloGame<N>::initialStateString() {
+    return Board::initial().toString();
 }
 
-std::string Othello::stateString() {
-    std::string state;
-    _grid->forEachSquare([&state, this](ChessSquare* square, int x, int y) {
-        Bit* bit = square->bit();
-        if (!bit) {
-            state += '0';
-        } else if (bit->getOwner() == getPlayerAt(BLACK_PLAYER)) {
-            state += '1';
-        } else {
-            state += '2';
-        }
-    });
-    return state;
+template <int N>
+std::string OthelloGame<N>::stateString() {
+    return _board.toString();
 }
 
-void Othello::setStateString(const std::string &s) {
-    if (s.length() != 64) return;
+template <int N>
+void OthelloGame<N>::setStateString(const std::string &s) {
+    if (!_board.fromString(s)) return;
 
-    int index = 0;
     _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
-        if (index < s.length()) {
-            char pieceType = s[index++];
-            square->destroyBit();
-
-            if (pieceType == '1') {
-                Bit* piece = createPiece(getPlayerAt(BLACK_PLAYER));
-                piece->setPosition(square->getPosition());
-                square->setBit(piece);
-            } else if (pieceType == '2') {
-                Bit* piece = createPiece(getPlayerAt(WHITE_PLAYER));
-                piece->setPosition(square->getPosition());
-                square->setBit(piece);
-            }
+        int piece = _board.pieceAt(Board::index(x, y));
+        square->destroyBit();
+        if (piece) {
+            placePiece(Board::index(x, y), getPlayerAt(piece == 1 ? BLACK_PLAYER : WHITE_PLAYER));
         }
     });
 }
 
-void Othello::updateAI() {
+//
+// the search's table in cache/, read in the background when the board is set up and written back after
+// every search. a cache saved under other evaluation weights is ignored
+//
+template <int N>
+void OthelloGame<N>::updateTableCache(bool save) {
+    if (!_gameOptions.AIPersistentCache) {
+        _engine.closeCache();
+        return;
+    }
+    _engine.openCache(TABLE_CACHE, GAME_NAME, evalWeightsSignature(evalWeights<OthelloWeights<N>>()));
+    if (save) _engine.saveCache();
+}
+
+template <int N>
+void OthelloGame<N>::updateAI() {
     if (!gameHasAI()) return;
 
-    Player* aiPlayer = getCurrentPlayer();
-    std::vector<std::pair<int, int>> validMoves = getValidMoves(aiPlayer);
+    int move;
+    if (_book.move(position(), move)) {
+        // still inside the opening book, whose moves were searched far deeper than there is time for now
+    } else if (_gameOptions.AIUseMCTS) {
+        // playouts for a slice of the frame, the node budget means nothing to them
+        OthelloPosition<N> current = position();
+        if (!_mcts.searching() || _mcts.searchRoot().hash() != current.hash()) {
+            MctsLimits limits;
+            limits.timeMs = AI_TIME_BUDGET_MS;
+            _mcts.start(current, limits);
+        }
+        if (!_mcts.advance(0, _gameOptions.AIFrameBudgetUs)) return;
+        const typename MctsEngine<OthelloTraits<N>>::Result &result = _mcts.result();
+        if (!result.hasMove) return;
+        move = result.bestMove;
+    } else if (_gameOptions.AIUseNNUE && gameHasNNUE()) {
+        NnuePosition<OthelloFeatures<N>> current(position());
+        if (!_nnueEngine.searching() || _nnueEngine.searchRoot().hash() != current.hash()) {
+            SearchLimits limits;
+            limits.timeMs = AI_TIME_BUDGET_MS;
+            _nnueEngine.start(current, limits);
+        }
+        if (!_nnueEngine.advance(_gameOptions.AIFrameNodes, _gameOptions.AIFrameBudgetUs)) return;
+        const typename SearchEngine<OthelloNnueTraits<N>>::Result &result = _nnueEngine.result();
+        if (!result.hasMove) return;
+        move = result.bestMove;
+    } else {
+        // a slice of the search a frame, so the board keeps drawing while the AI thinks
+        OthelloPosition<N> current = position();
+        if (!_engine.searching() || _engine.searchRoot().hash() != current.hash()) {
+            SearchLimits limits;
+            limits.timeMs = AI_TIME_BUDGET_MS;
+            _engine.start(current, limits);
+        }
+        if (!_engine.advance(_gameOptions.AIFrameNodes, _gameOptions.AIFrameBudgetUs)) return;
+        const typename SearchEngine<OthelloTraits<N>>::Result &result = _engine.result();
+        updateTableCache(true);
+        if (!result.hasMove) return;
+        move = result.bestMove;
+    }
 
-    if (validMoves.empty()) {
+    if (move == OthelloPosition<N>::PASS) {
         _consecutivePasses++;
         endTurn();
         return;
     }
+    actionForEmptyHolder(*_grid->getSquareByIndex(move));
+}
 
-    // Find move that flips the most pieces
-    int bestX = -1, bestY = -1, maxFlips = 0;
+template <int N>
+OthelloPosition<N> OthelloGame<N>::position() {
+    OthelloPosition<N> position;
+    position.board = _board;
+    position.side = getCurrentPlayer()->playerNumber();
+    return position;
+}
 
-    for (const auto& move : validMoves) {
-        int x = move.first, y = move.second, totalFlips = 0;
-        for (int i = 0; i < 8; i++) {
-            totalFlips += checkDirection(x, y, DIRECTIONS[i][0], DIRECTIONS[i][1], aiPlayer);
-        }
-        if (totalFlips > maxFlips) {
-            maxFlips = totalFlips;
-            bestX = x;
-            bestY = y;
-        }
-    }
+template <int N>
+void OthelloGame<N>::setPosition(const OthelloPosition<N> &position) {
+    setStateString(position.toString());
+    setSideToMove(position.side);
+    _consecutivePasses = 0;
+}
+
+template <int N>
+std::unique_ptr<ProtocolGame> OthelloGame<N>::aiPosition() {
+    OthelloPosition<N> current = position();
+    std::unique_ptr<ProtocolGame> game = ProtocolGame::create(N == 8 ? "othello" : N == 6 ? "othello6" : "othello10");
+    if (!game->setState(current.toString(), current.side)) return nullptr;
+    return game;
+}
 
-    if (bestX >= 0 && bestY >= 0) {
-        actionForEmptyHolder(*_grid->getSquare(bestX, bestY));
+template <int N>
+bool OthelloGame<N>::applyAIMove(const std::string &move) {
+    // a side without a move passes, the same as updateAI
+    if (move == "pass") {
+        _consecutivePasses++;
+        endTurn();
+        return true;
     }
+    ChessSquare* square = squareForMove(move);
+    return square && actionForEmptyHolder(*square);
 }
 
-void Othello::getBoardPosition(BitHolder& holder, int &x, int &y) const {
+template <int N>
+void OthelloGame<N>::getBoardPosition(BitHolder& holder, int &x, int &y) const {
     ChessSquare* square = static_cast<ChessSquare*>(&holder);
     x = square->getColumn();
     y = square->getRow();
 }
 
-void Othello::showValidMoves(Player* player) {
+template <int N>
+void OthelloGame<N>::showValidMoves(Player* player) {
     _showingHints = true;
 }
 
-void Othello::clearValidMoveIndicators() {
+template <int N>
+void OthelloGame<N>::clearValidMoveIndicators() {
     _showingHints = false;
-}
\ No newline at end of file
+}
+
+// board sizes offered by the app: 6x6, standard 8x8 and 10x10 Grand Othello
+template class OthelloGame<6>;
+template class OthelloGame<8>;
+template class OthelloGame<10>;
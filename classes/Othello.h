@@ -1,15 +1,25 @@
 #pragma once
 #include "Game.h"
+#include "OthelloBoard.h"
+#include "Mcts.h"
+#include "Nnue.h"
+#include "OpeningBook.h"
+#include "Search.h"
 #include <vector>
 
 // NOTE: This implementation assumes black.png and white.png exist in resources.
 // If not, you can use o.png and x.png, or any other suitable graphics.
 
-class Othello : public Game
+//
+// Othello on an N x N board, the rules run on OthelloBoard<N> and the Grid mirrors it
+// instantiated in Othello.cpp for 6x6, 8x8 and 10x10 (Grand Othello)
+//
+template <int N>
+class OthelloGame : public Game
 {
 public:
-    Othello();
-    ~Othello();
+    OthelloGame();
+    ~OthelloGame();
 
     // Required virtual methods from Game base class
     void        setUpBoard() override;
@@ -26,35 +36,63 @@ public:
     // AI methods
     void        updateAI() override;
     bool        gameHasAI() override { return true; } // Set to true when AI is implemented
+    bool        gameHasMCTS() override { return true; }
+    bool        gameHasNNUE() override { return sharedNetwork<OthelloFeatures<N>>() != nullptr; }
+    bool        gameHasPersistentCache() override { return true; }
+    bool        gameHasSlicedSearch() override { return true; }
+    std::unique_ptr<ProtocolGame> aiPosition() override;
+    bool        applyAIMove(const std::string &move) override;
     Grid* getGrid() override { return _grid; }
 
+    const OthelloBoard<N>& getBoard() const { return _board; }
+
+    // the board as a GamePosition and back
+    OthelloPosition<N> position();
+    void        setPosition(const OthelloPosition<N> &position);
+
 private:
+    using Board = OthelloBoard<N>;
+    using Mask = typename Board::Mask;
+
     // Player constants
     static const int BLACK_PLAYER = 0;
     static const int WHITE_PLAYER = 1;
 
-    // Direction vectors for checking all 8 directions
-    static const int DIRECTIONS[8][2];
+    // AI thinking time per move
+    static const int AI_TIME_BUDGET_MS = 500;
+    static constexpr const char *GAME_NAME = N == 8 ? "othello" : N == 6 ? "othello6" : "othello10";
+    static constexpr const char *TABLE_CACHE = N == 8 ? "cache/othello.tt" : N == 6 ? "cache/othello6.tt" : "cache/othello10.tt";
+    static constexpr const char *OPENING_BOOK = N == 8 ? "book/othello.book" : N == 6 ? "book/othello6.book" : "book/othello10.book";
 
     // Helper methods
     Bit*        createPiece(Player* player);
+    void        placePiece(int index, Player* player);
+    void        flipPieces(Mask flipped, Player* player);
     bool        isValidMove(int x, int y, Player* player) const;
-    int         checkDirection(int x, int y, int dx, int dy, Player* player) const;
-    void        flipPieces(int x, int y, Player* player);
-    void        flipInDirection(int x, int y, int dx, int dy, Player* player, int count);
     bool        hasValidMove(Player* player) const;
+    bool        isGameOver() const;
     void        countPieces(int &blackCount, int &whiteCount) const;
     std::vector<std::pair<int, int>> getValidMoves(Player* player) const;
     void        showValidMoves(Player* player);
     void        clearValidMoveIndicators();
+    void        updateTableCache(bool save);
 
     // Board position helper
     void        getBoardPosition(BitHolder& holder, int &x, int &y) const;
 
     // Board representation
     Grid*       _grid;
+    Board       _board;
+    SearchEngine<OthelloTraits<N>> _engine;
+    MctsEngine<OthelloTraits<N>> _mcts{ { MctsOptions::PUCT, 1.5f, 0, 1 << 20, true } };
+    SearchEngine<OthelloNnueTraits<N>> _nnueEngine;
+    OpeningBook _book;
 
     // Game state
     int         _consecutivePasses;
     bool        _showingHints;
-};
\ No newline at end of file
+};
+
+using Othello = OthelloGame<8>;
+using Othello6x6 = OthelloGame<6>;
+using GrandOthello = OthelloGame<10>;
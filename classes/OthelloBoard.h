@@ -0,0 +1,348 @@
+#pragma once
+
+#include "Bitboard.h"
+#include "EvalWeights.h"
+#include "Position.h"
+#include "Symmetry.h"
+#include <array>
+#include <cstdlib>
+#include <string>
+#include <type_traits>
+
+//
+// bitboard core for Othello, templated on the board size
+// square index is y * N + x, matching Grid::getIndex()
+// boards up to 8x8 use a uint64_t mask, bigger boards (10x10 Grand Othello) use Bits128
+//
+template <int N>
+struct OthelloBoard
+{
+    static_assert(N >= 4 && N % 2 == 0, "Othello boards must be even sized");
+    static_assert(N * N <= 128, "Othello boards are limited to 128 squares");
+
+    using Mask = std::conditional_t<(N * N <= 64), uint64_t, Bits128>;
+
+    static constexpr int SIZE = N;
+    static constexpr int SQUARES = N * N;
+    static constexpr int BLACK = 0;
+    static constexpr int WHITE = 1;
+
+    //
+    // compile time mask tables
+    //
+    static constexpr Mask fullMask()
+    {
+        Mask m = Mask(0);
+        for (int i = 0; i < SQUARES; i++) m |= Bitboard::bit<Mask>(i);
+        return m;
+    }
+
+    static constexpr Mask columnMask(int column)
+    {
+        Mask m = Mask(0);
+        for (int y = 0; y < N; y++) m |= Bitboard::bit<Mask>(y * N + column);
+        return m;
+    }
+
+    // the 8 directions: N, NE, E, SE, S, SW, W, NW (same order as Othello::DIRECTIONS)
+    static constexpr int DX[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+    static constexpr int DY[8] = { -1, -1, 0, 1, 1, 1, 0, -1 };
+
+    static constexpr std::array<int, 8> makeShifts()
+    {
+        std::array<int, 8> shifts{};
+        for (int d = 0; d < 8; d++) shifts[d] = DY[d] * N + DX[d];
+        return shifts;
+    }
+
+    // mask applied after shifting in a direction, removes bits that wrapped around a row edge
+    static constexpr std::array<Mask, 8> makeShiftMasks()
+    {
+        std::array<Mask, 8> masks{};
+        for (int d = 0; d < 8; d++) {
+            Mask m = fullMask();
+            if (DX[d] > 0) m &= ~columnMask(0);
+            if (DX[d] < 0) m &= ~columnMask(N - 1);
+            masks[d] = m;
+        }
+        return masks;
+    }
+
+    static constexpr Mask FULL = fullMask();
+    static constexpr std::array<int, 8> SHIFTS = makeShifts();
+    static constexpr std::array<Mask, 8> SHIFT_MASKS = makeShiftMasks();
+
+    static constexpr Mask shift(Mask m, int d)
+    {
+        int s = SHIFTS[d];
+        return (s > 0 ? (m << s) : (m >> -s)) & SHIFT_MASKS[d];
+    }
+
+    //
+    // board state
+    //
+    Mask discs[2];
+
+    constexpr OthelloBoard() : discs{ Mask(0), Mask(0) } {}
+
+    // standard starting position, white on the main diagonal of the centre
+    static constexpr OthelloBoard initial()
+    {
+        OthelloBoard board;
+        int lo = N / 2 - 1;
+        int hi = N / 2;
+        board.discs[WHITE] = Bitboard::bit<Mask>(lo * N + lo) | Bitboard::bit<Mask>(hi * N + hi);
+        board.discs[BLACK] = Bitboard::bit<Mask>(lo * N + hi) | Bitboard::bit<Mask>(hi * N + lo);
+        return board;
+    }
+
+    static constexpr int index(int x, int y) { return y * N + x; }
+
+    constexpr Mask occupied() const { return discs[BLACK] | discs[WHITE]; }
+    constexpr Mask empty() const { return ~occupied() & FULL; }
+
+    // 0 = empty, 1 = black, 2 = white
+    constexpr int pieceAt(int index) const
+    {
+        if (Bitboard::test(discs[BLACK], index)) return 1;
+        if (Bitboard::test(discs[WHITE], index)) return 2;
+        return 0;
+    }
+
+    constexpr int count(int side) const { return Bitboard::popCount(discs[side]); }
+
+    //
+    // all legal moves for side, using a directional flood fill from its own discs
+    //
+    constexpr Mask legalMoves(int side) const
+    {
+        Mask own = discs[side];
+        Mask opp = discs[side ^ 1];
+        Mask open = empty();
+        Mask moves = Mask(0);
+        for (int d = 0; d < 8; d++) {
+            Mask run = shift(own, d) & opp;
+            for (int i = 0; i < N - 3; i++) run |= shift(run, d) & opp;
+            moves |= shift(run, d) & open;
+        }
+        return moves;
+    }
+
+    constexpr bool hasMove(int side) const { return bool(legalMoves(side)); }
+
+    //
+    // discs that would be flipped if side plays at index (empty mask if the move is illegal)
+    //
+    constexpr Mask flips(int side, int index) const
+    {
+        Mask own = discs[side];
+        Mask opp = discs[side ^ 1];
+        Mask start = Bitboard::bit<Mask>(index);
+        Mask flipped = Mask(0);
+        if (occupied() & start) return flipped;
+        for (int d = 0; d < 8; d++) {
+            Mask line = Mask(0);
+            Mask m = shift(start, d);
+            while (m & opp) {
+                line |= m;
+                m = shift(m, d);
+            }
+            if (m & own) flipped |= line;
+        }
+        return flipped;
+    }
+
+    //
+    // play a disc for side at index, returns the flipped discs so the caller can mirror them
+    //
+    constexpr Mask play(int side, int index)
+    {
+        Mask flipped = flips(side, index);
+        if (!flipped) return flipped;
+        discs[side] |= flipped | Bitboard::bit<Mask>(index);
+        discs[side ^ 1] ^= flipped;
+        return flipped;
+    }
+
+    // neither side can move
+    constexpr bool isOver() const { return !hasMove(BLACK) && !hasMove(WHITE); }
+
+    //
+    // state strings use '0' for empty, '1' for black and '2' for white, row major
+    //
+    std::string toString() const
+    {
+        std::string state(SQUARES, '0');
+        for (int i = 0; i < SQUARES; i++) state[i] = char('0' + pieceAt(i));
+        return state;
+    }
+
+    bool fromString(const std::string &state)
+    {
+        if ((int)state.length() != SQUARES) return false;
+        discs[BLACK] = discs[WHITE] = Mask(0);
+        for (int i = 0; i < SQUARES; i++) {
+            if (state[i] == '1') discs[BLACK] |= Bitboard::bit<Mask>(i);
+            else if (state[i] == '2') discs[WHITE] |= Bitboard::bit<Mask>(i);
+        }
+        return true;
+    }
+};
+
+//
+// othello keeps the side to move next to the discs, a GamePosition where a side without a move passes
+// moves are square indexes or PASS, the undo record is the discs that were flipped
+//
+template <int N>
+struct OthelloPosition
+{
+    using Board = OthelloBoard<N>;
+    using Mask = typename Board::Mask;
+    using Move = int;
+    using Undo = Mask;
+
+    static constexpr int MAX_MOVES = N * N;
+    static constexpr int PASS = -1;
+
+    Board       board = Board::initial();
+    int         side = Board::BLACK;
+
+    int         sideToMove() const { return side; }
+    bool        isTerminal() const { return board.isOver(); }
+
+    uint64_t hash() const
+    {
+        if constexpr (std::is_same_v<Mask, uint64_t>) {
+            return mixPositionKey(board.discs[0] ^ mixPositionKey(board.discs[1] + side));
+        } else {
+            uint64_t key = mixPositionKey(board.discs[0].lo ^ mixPositionKey(board.discs[0].hi));
+            key = mixPositionKey(key ^ board.discs[1].lo);
+            return mixPositionKey(key ^ mixPositionKey(board.discs[1].hi + side));
+        }
+    }
+
+    void generateMoves(MoveList<Move, MAX_MOVES> &moves) const
+    {
+        moves.clear();
+        Mask legal = board.legalMoves(side);
+        while (legal) moves.push(Bitboard::popLowestBit(legal));
+        if (moves.empty() && !board.isOver()) moves.push(PASS);
+    }
+
+    Mask makeMove(Move move)
+    {
+        Mask flipped = move == PASS ? Mask(0) : board.play(side, move);
+        side ^= 1;
+        return flipped;
+    }
+
+    void unmakeMove(Move move, Mask flipped)
+    {
+        side ^= 1;
+        if (move == PASS) return;
+        board.discs[side] ^= flipped | Bitboard::bit<Mask>(move);
+        board.discs[side ^ 1] |= flipped;
+    }
+
+    std::string toString() const { return board.toString(); }
+
+    bool fromString(const std::string &state, int sideToMove)
+    {
+        side = sideToMove & 1;
+        return board.fromString(state);
+    }
+};
+
+static_assert(GamePosition<OthelloPosition<8>>);
+static_assert(GamePosition<OthelloPosition<10>>);
+
+//
+// the 8 symmetries of the square board, moves are squares or the pass
+//
+template <int N>
+struct Symmetry<OthelloPosition<N>>
+{
+    using Position = OthelloPosition<N>;
+    static constexpr int COUNT = SquareSymmetry::COUNT;
+
+    static Position apply(const Position &position, int symmetry)
+    {
+        Position result = position;
+        for (int side = 0; side < 2; side++) result.board.discs[side] = SquareSymmetry::mask(position.board.discs[side], symmetry, N);
+        return result;
+    }
+
+    static int applyMove(int move, int symmetry) { return move == Position::PASS ? move : SquareSymmetry::square(move, symmetry, N); }
+    static constexpr int inverse(int symmetry) { return SquareSymmetry::inverse(symmetry); }
+};
+
+//
+// OthelloTraits::evaluate's weights on the mobility, corner and disc differences, one file per board size
+//
+template <int N>
+struct OthelloWeights
+{
+    enum { MOBILITY, CORNERS, DISCS, COUNT };
+    static constexpr const char *NAMES[COUNT] = { "mobility", "corners", "discs" };
+    static constexpr const char *WEIGHTS_FILE = N == 8 ? "weights/othello.eval" : N == 6 ? "weights/othello6.eval" : "weights/othello10.eval";
+
+    int         values[COUNT] = { 10, 25, 1 };
+};
+
+//
+// SearchEngine traits: mobility and corners, with the disc count as a tie break
+//
+template <int N>
+struct OthelloTraits
+{
+    using Position = OthelloPosition<N>;
+    using Mask = typename OthelloBoard<N>::Mask;
+    using Weights = OthelloWeights<N>;
+    static constexpr int HISTORY_SIZE = N * N + 1;     // the last slot is the pass
+
+    static int result(const Position &position)
+    {
+        int difference = position.board.count(position.side) - position.board.count(position.side ^ 1);
+        return (difference > 0) - (difference < 0);
+    }
+
+    // the differences the weights apply to, side to move minus opponent
+    static void terms(const Position &position, int (&values)[Weights::COUNT])
+    {
+        const OthelloBoard<N> &board = position.board;
+        const Mask corners = Bitboard::bit<Mask>(0) | Bitboard::bit<Mask>(N - 1) |
+                             Bitboard::bit<Mask>(N * (N - 1)) | Bitboard::bit<Mask>(N * N - 1);
+        int us = position.side;
+        int them = us ^ 1;
+        values[Weights::MOBILITY] = Bitboard::popCount(board.legalMoves(us)) - Bitboard::popCount(board.legalMoves(them));
+        values[Weights::CORNERS] = Bitboard::popCount(board.discs[us] & corners) - Bitboard::popCount(board.discs[them] & corners);
+        values[Weights::DISCS] = board.count(us) - board.count(them);
+    }
+
+    static int evaluate(const Position &position)
+    {
+        const Weights &weights = evalWeights<Weights>();
+        int values[Weights::COUNT];
+        terms(position, values);
+        int score = 0;
+        for (int i = 0; i < Weights::COUNT; i++) score += values[i] * weights.values[i];
+        return score;
+    }
+
+    static int historyIndex(int move) { return move == Position::PASS ? N * N : move; }
+
+    // MCTS move weights: take corners and edges, stay off the squares next to an empty corner
+    static float prior(const Position &position, int move)
+    {
+        if (move == Position::PASS) return 1.0f;
+        int x = move % N, y = move / N;
+        bool edgeX = x == 0 || x == N - 1, edgeY = y == 0 || y == N - 1;
+        if (edgeX && edgeY) return 8.0f;
+        int cornerX = x < N / 2 ? 0 : N - 1, cornerY = y < N / 2 ? 0 : N - 1;
+        bool nearCorner = std::abs(x - cornerX) <= 1 && std::abs(y - cornerY) <= 1;
+        if (nearCorner && !(position.board.occupied() & Bitboard::bit<Mask>(cornerY * N + cornerX))) {
+            return edgeX || edgeY ? 0.5f : 0.2f;
+        }
+        return edgeX || edgeY ? 2.0f : 1.0f;
+    }
+};
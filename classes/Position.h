@@ -0,0 +1,74 @@
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+//
+// fixed capacity move buffer that lives on the stack, nothing is constructed until it is pushed
+//
+template <class Move, int CAPACITY>
+class MoveList
+{
+public:
+    static constexpr int capacity() { return CAPACITY; }
+
+    int             size() const { return _size; }
+    bool            empty() const { return _size == 0; }
+    void            clear() { _size = 0; }
+    void            push(const Move &move) { _moves[_size++] = move; }
+
+    // for generators that fill a raw array and return the count
+    Move*           data() { return _moves; }
+    void            resize(int size) { _size = size; }
+
+    Move&           operator[](int index) { return _moves[index]; }
+    const Move&     operator[](int index) const { return _moves[index]; }
+    Move*           begin() { return _moves; }
+    Move*           end() { return _moves + _size; }
+    const Move*     begin() const { return _moves; }
+    const Move*     end() const { return _moves + _size; }
+
+private:
+    Move            _moves[CAPACITY];
+    int             _size = 0;
+};
+
+// undo record for games whose moves can be taken back from the move alone
+struct NoUndo {};
+
+//
+// a game position as a plain value: no Bits, no Sprites, copied with memcpy. every search in the
+// repo works on these. makeMove returns whatever unmakeMove needs to put the position back, side 0
+// moves first, and hash() is the same for the same position however it was reached
+// the toString/fromString pair uses the Game's state strings, which is the bridge to the UI
+//
+template <class P>
+concept GamePosition = std::is_trivially_copyable_v<P> && requires(P position, const P constPosition,
+                                                                   const typename P::Move move, const typename P::Undo undo,
+                                                                   MoveList<typename P::Move, P::MAX_MOVES> moves,
+                                                                   const std::string state, int side) {
+    { P::MAX_MOVES } -> std::convertible_to<int>;
+    { constPosition.generateMoves(moves) } -> std::same_as<void>;
+    { position.makeMove(move) } -> std::same_as<typename P::Undo>;
+    { position.unmakeMove(move, undo) } -> std::same_as<void>;
+    { constPosition.hash() } -> std::same_as<uint64_t>;
+    { constPosition.isTerminal() } -> std::same_as<bool>;
+    { constPosition.sideToMove() } -> std::same_as<int>;
+    { constPosition.toString() } -> std::same_as<std::string>;
+    { position.fromString(state, side) } -> std::same_as<bool>;
+};
+
+template <GamePosition P>
+using MovesOf = MoveList<typename P::Move, P::MAX_MOVES>;
+
+//
+// spreads a small exact key over 64 bits for positions that have no zobrist key of their own
+//
+constexpr uint64_t mixPositionKey(uint64_t key)
+{
+    key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ull;
+    key = (key ^ (key >> 27)) * 0x94D049BB133111EBull;
+    return key ^ (key >> 31);
+}
@@ -0,0 +1,78 @@
+#include "ProofPanel.h"
+#include "JobSystem.h"
+#include "../imgui/imgui.h"
+
+ProofPanel::~ProofPanel()
+{
+    cancel();
+}
+
+void ProofPanel::start(Game *game)
+{
+    cancel();
+    _position = game->aiPosition();
+    if (!_position) return;
+
+    _provedState = game->stateString();
+    ProtocolLimits limits;
+    limits.timeMs = _timeMs;
+    _stopRequested = false;
+    limits.stop = &_stopRequested;
+    ProtocolGame *position = _position.get();
+    auto result = std::make_shared<std::promise<ProtocolProof>>();
+    _running = result->get_future();
+    JobSystem::instance().submit([position, limits, result]() {
+        ProtocolProof proof;
+        if (!position->prove(limits, proof)) proof.result = "no solver";
+        result->set_value(proof);
+    }, JobPriority::LOW);
+}
+
+void ProofPanel::cancel()
+{
+    if (!_running.valid()) return;
+    _stopRequested = true;
+    _running.wait();
+    _running = std::future<ProtocolProof>();
+}
+
+void ProofPanel::draw(Game *game)
+{
+    ImGui::Begin("Proof Solver");
+    if (!game) {
+        ImGui::Text("Start a game to prove its positions");
+        ImGui::End();
+        return;
+    }
+
+    if (_running.valid() && _running.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        _proof = _running.get();
+        _hasProof = true;
+    }
+
+    ImGui::SliderInt("Time limit ms", &_timeMs, 100, 60000);
+    if (_running.valid()) {
+        ImGui::Text("Proving...");
+        if (ImGui::Button("Stop")) _stopRequested = true;
+    } else if (ImGui::Button("Prove Position")) {
+        start(game);
+        if (!_position) {
+            _proof = ProtocolProof();
+            _proof.result = "no solver";
+            _hasProof = true;
+        }
+    }
+
+    if (_hasProof) {
+        ImGui::Separator();
+        bool stale = _provedState != game->stateString();
+        ImGui::Text("Side to move: %s%s", _proof.result.c_str(), stale ? " (position has changed)" : "");
+        ImGui::Text("%llu nodes in %d ms, table %llu entries, %llu collections", (unsigned long long)_proof.nodes, _proof.timeMs,
+                    (unsigned long long)_proof.tableEntries, (unsigned long long)_proof.collections);
+        ImGui::Text("Solution tree: %zu nodes%s", _proof.treeNodes, _proof.treeComplete ? "" : " (cut short)");
+        std::string line;
+        for (const std::string &move : _proof.line) line += move + " ";
+        ImGui::TextWrapped("Line: %s", line.c_str());
+    }
+    ImGui::End();
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "EngineProtocol.h"
+#include "Game.h"
+#include <atomic>
+#include <future>
+#include <memory>
+#include <string>
+
+//
+// analysis window that asks the proof-number solver for the value of the position on the board
+// the proof runs on a headless copy (Game::aiPosition) as a low priority job, the board stays playable
+// and a result for a position that has since changed is shown as stale
+//
+class ProofPanel
+{
+public:
+    ~ProofPanel();
+
+    // once a frame with the game on screen, null when there is none
+    void        draw(Game *game);
+    // stops a running proof and waits for it
+    void        cancel();
+
+private:
+    void        start(Game *game);
+
+    std::unique_ptr<ProtocolGame> _position;
+    std::future<ProtocolProof> _running;
+    std::atomic<bool> _stopRequested{ false };  // the proof's stop token, seen even before the job starts
+    ProtocolProof   _proof;
+    std::string     _provedState;       // the state the shown proof is for
+    bool            _hasProof = false;
+    int             _timeMs = 5000;
+};
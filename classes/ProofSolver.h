@@ -0,0 +1,439 @@
+#pragma once
+
+#include "Search.h"
+#include "Symmetry.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+//
+// limits for a proof, zero means unlimited
+//
+struct ProofLimits
+{
+    int         timeMs = 0;
+    uint64_t    nodes = 0;
+    const std::atomic<bool> *stop = nullptr;    // the caller's, a stop set before the proof starts still counts
+};
+
+// the game's value for the side to move at the root, UNKNOWN when a limit ran out first
+enum class ProofOutcome { UNKNOWN, WIN, DRAW, LOSS };
+
+struct ProofStats
+{
+    uint64_t    nodes = 0;
+    uint64_t    tableEntries = 0;
+    uint64_t    collections = 0;        // garbage collections of the table
+    uint64_t    collected = 0;          // entries they dropped
+    int         timeMs = 0;
+};
+
+template <class Move>
+struct SolutionNode
+{
+    Move        move{};                 // the move into this node, unset at the root
+    int         parent = -1;
+    int         firstChild = 0;
+    int         childCount = 0;
+    uint32_t    work = 0;               // nodes the solver spent below here, zero for a finished game
+};
+
+template <class Move>
+struct ProofResult
+{
+    ProofOutcome outcome = ProofOutcome::UNKNOWN;
+    Move        bestMove{};
+    bool        hasMove = false;
+    std::vector<Move> line;             // the solution tree's main line, the loser playing its longest defence
+    // node 0 is the root: every reply of the losing side and one answer of the winning side (for a draw,
+    // the side that can't lose). complete is false when it was cut at MAX_SOLUTION_NODES or a limit ran out
+    std::vector<SolutionNode<Move>> tree;
+    bool        complete = false;
+    ProofStats  stats;
+};
+
+//
+// depth-first proof-number search (df-pn) on the same traits as the SearchEngine. it proves "the side to
+// move at the root wins" and, when that fails, "it doesn't lose", so draws need two passes
+// proof and disproof numbers live in a table of 16 byte entries, four to a cache line, that never grows
+// past its budget: when it is three quarters full the entries with the smallest subtrees behind them are
+// thrown away. child thresholds use the 1 + epsilon trick to switch between siblings less often
+// for games without cycles: a repeated position would be searched again, never recognised
+//
+template <SearchTraits Traits>
+class ProofSolver
+{
+public:
+    using Position = typename Traits::Position;
+    using Move = typename Position::Move;
+    using Result = ProofResult<Move>;
+
+    static constexpr size_t DEFAULT_TABLE_BYTES = 16 << 20;
+    static constexpr int MAX_SOLUTION_NODES = 100000;
+    static constexpr int MAX_PLY = 128;
+
+    explicit ProofSolver(size_t tableBytes = DEFAULT_TABLE_BYTES) : _stop(false) { resizeTable(tableBytes); }
+
+    Result solve(const Position &root, const ProofLimits &limits)
+    {
+        _limits = limits;
+        _stop = false;
+        _stats = ProofStats();
+        _startTime = std::chrono::steady_clock::now();
+        _attacker = root.sideToMove();
+
+        Result result;
+        Position position = root;
+        if (position.isTerminal()) {
+            int value = Traits::result(position);
+            result.outcome = value > 0 ? ProofOutcome::WIN : value < 0 ? ProofOutcome::LOSS : ProofOutcome::DRAW;
+            result.complete = true;
+            return finish(result);
+        }
+
+        _drawIsWin = false;
+        Numbers numbers = prove(position);
+        if (!numbers.pn) {
+            result.outcome = ProofOutcome::WIN;
+        } else if (!numbers.dn) {
+            _drawIsWin = true;
+            numbers = prove(position);
+            if (!numbers.pn) result.outcome = ProofOutcome::DRAW;
+            else if (!numbers.dn) result.outcome = ProofOutcome::LOSS;
+        }
+        if (result.outcome == ProofOutcome::UNKNOWN) return finish(result);
+
+        result.complete = extractTree(position, !numbers.pn, result.tree);
+        mainLine(result);
+        return finish(result);
+    }
+
+    void        stop() { _stop = true; }
+    size_t      tableBytes() const { return _table.size() * sizeof(Bucket); }
+
+    void clearTable()
+    {
+        std::fill(_table.begin(), _table.end(), Bucket());
+        _used = 0;
+    }
+
+    // rounds down to a power of two buckets, drops everything in the table
+    void resizeTable(size_t bytes)
+    {
+        size_t buckets = std::bit_floor(std::max<size_t>(bytes / sizeof(Bucket), 1));
+        _table.assign(buckets, Bucket());
+        _mask = buckets - 1;
+        _used = 0;
+    }
+
+private:
+    static constexpr uint32_t INF = 0xFFFFFFFFu;
+    static constexpr float EPSILON = 0.25f;
+    static constexpr int BUCKET_SIZE = 4;
+
+    struct Numbers
+    {
+        uint32_t    pn;
+        uint32_t    dn;
+    };
+
+    static constexpr Numbers PROVEN = { 0, INF };
+    static constexpr Numbers DISPROVEN = { INF, 0 };
+
+    // work is never zero in a used entry
+    struct Entry
+    {
+        uint32_t    check = 0;
+        uint32_t    pn = 0;
+        uint32_t    dn = 0;
+        uint32_t    work = 0;
+    };
+
+    struct alignas(64) Bucket
+    {
+        Entry       entries[BUCKET_SIZE];
+    };
+
+    // the same position means different things depending on who is trying to win and what a draw counts as.
+    // proof numbers don't change under a symmetry, so mirror images share an entry. a colour flip swaps
+    // the side to move, so the attacker is keyed as whether it is the side to move
+    uint64_t keyOf(const Position &position) const
+    {
+        static constexpr uint64_t MODE_KEYS[4] = { 0, 0x9E3779B97F4A7C15ull, 0xC2B2AE3D27D4EB4Full, 0x165667B19E3779F9ull };
+        return canonicalKey(position) ^ MODE_KEYS[(_attacker == position.sideToMove()) * 2 + _drawIsWin];
+    }
+
+    Result& finish(Result &result)
+    {
+        _stats.tableEntries = _used;
+        _stats.timeMs = elapsedMs();
+        result.stats = _stats;
+        return result;
+    }
+
+    int elapsedMs() const
+    {
+        return (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _startTime).count();
+    }
+
+    void checkLimits()
+    {
+        if (_limits.stop && *_limits.stop) _stop = true;
+        if (_limits.nodes && _stats.nodes >= _limits.nodes) _stop = true;
+        if ((_stats.nodes & 1023) == 0 && _limits.timeMs && elapsedMs() >= _limits.timeMs) _stop = true;
+    }
+
+    Numbers prove(Position &position)
+    {
+        Numbers numbers;
+        mid(position, keyOf(position), INF, INF, 0, numbers);
+        return _stop ? Numbers{ 1, 1 } : numbers;
+    }
+
+    //
+    // table
+    //
+    Entry* probe(uint64_t key)
+    {
+        Bucket &bucket = _table[key & _mask];
+        uint32_t check = (uint32_t)(key >> 32);
+        for (Entry &entry : bucket.entries) {
+            if (entry.work && entry.check == check) return &entry;
+        }
+        return nullptr;
+    }
+
+    void store(uint64_t key, Numbers numbers, uint32_t work)
+    {
+        Bucket &bucket = _table[key & _mask];
+        uint32_t check = (uint32_t)(key >> 32);
+        Entry *slot = nullptr;
+        for (Entry &entry : bucket.entries) {
+            if (entry.work && entry.check == check) {
+                slot = &entry;
+                break;
+            }
+            if (!slot || entry.work < slot->work) slot = &entry;
+        }
+        if (!slot->work) _used++;
+        *slot = { check, numbers.pn, numbers.dn, std::max(work, 1u) };
+        if (_used * 4 > _table.size() * BUCKET_SIZE * 3) collect();
+    }
+
+    //
+    // drops at least half the entries, smallest work first, in whole powers of two
+    //
+    void collect()
+    {
+        uint64_t counts[33] = {};
+        for (const Bucket &bucket : _table) {
+            for (const Entry &entry : bucket.entries) {
+                if (entry.work) counts[std::bit_width(entry.work)]++;
+            }
+        }
+        unsigned limit = 1;
+        uint64_t dropping = counts[1];
+        while (limit < 32 && dropping * 2 < _used) dropping += counts[++limit];
+
+        for (Bucket &bucket : _table) {
+            for (Entry &entry : bucket.entries) {
+                if (entry.work && std::bit_width(entry.work) <= limit) entry = Entry();
+            }
+        }
+        _used -= dropping;
+        _stats.collections++;
+        _stats.collected += dropping;
+    }
+
+    //
+    // numbers for a position from the table, or from the rules for a finished game, or 1 and 1
+    //
+    Numbers lookup(const Position &position, uint64_t key, uint32_t &work)
+    {
+        if (Entry *entry = probe(key)) {
+            work = entry->work;
+            return { entry->pn, entry->dn };
+        }
+        work = 0;
+        if (!position.isTerminal()) return { 1, 1 };
+        int value = Traits::result(position);
+        int winner = value > 0 ? position.sideToMove() : value < 0 ? position.sideToMove() ^ 1 : -1;
+        return winner == _attacker || (winner < 0 && _drawIsWin) ? PROVEN : DISPROVEN;
+    }
+
+    static uint32_t addCapped(uint32_t a, uint32_t b)
+    {
+        if (a == INF || b == INF) return INF;
+        return (uint32_t)std::min<uint64_t>((uint64_t)a + b, INF - 1);
+    }
+
+    // threshold - total + part, where threshold is more than total
+    static uint32_t childThreshold(uint32_t threshold, uint32_t total, uint32_t part)
+    {
+        if (threshold == INF) return INF;
+        return (uint32_t)std::min<uint64_t>((uint64_t)threshold - total + part, INF - 1);
+    }
+
+    //
+    // expands position until its proof number reaches thresholdPn or its disproof number thresholdDn,
+    // leaves the result in numbers and the table and returns the nodes it took
+    //
+    uint32_t mid(Position &position, uint64_t key, uint32_t thresholdPn, uint32_t thresholdDn, int ply, Numbers &numbers)
+    {
+        _stats.nodes++;
+        checkLimits();
+        if (ply >= MAX_PLY) {
+            numbers = _drawIsWin ? PROVEN : DISPROVEN;
+            return 1;
+        }
+
+        MovesOf<Position> moves;
+        position.generateMoves(moves);
+        int count = moves.size();
+        bool attacking = position.sideToMove() == _attacker;
+
+        uint64_t keys[Position::MAX_MOVES];
+        Numbers children[Position::MAX_MOVES];
+        for (int i = 0; i < count; i++) {
+            auto undo = position.makeMove(moves[i]);
+            keys[i] = keyOf(position);
+            uint32_t childWork;
+            children[i] = lookup(position, keys[i], childWork);
+            position.unmakeMove(moves[i], undo);
+        }
+
+        uint32_t work = 1;
+        while (true) {
+            // an attacking node needs one proven child, a defending node all of them
+            uint32_t minimum = INF, total = 0;
+            int best = 0;
+            uint32_t second = INF;
+            for (int i = 0; i < count; i++) {
+                uint32_t chosen = attacking ? children[i].pn : children[i].dn;
+                uint32_t summed = attacking ? children[i].dn : children[i].pn;
+                total = addCapped(total, summed);
+                if (chosen < minimum) {
+                    second = minimum;
+                    minimum = chosen;
+                    best = i;
+                } else if (chosen < second) {
+                    second = chosen;
+                }
+            }
+            numbers = attacking ? Numbers{ minimum, total } : Numbers{ total, minimum };
+            if (numbers.pn >= thresholdPn || numbers.dn >= thresholdDn || _stop) break;
+
+            uint32_t widened = second == INF ? INF : std::max<uint32_t>(second + 1, (uint32_t)std::min<double>(second * (1.0 + EPSILON), INF - 1));
+            uint32_t childPn, childDn;
+            if (attacking) {
+                childPn = std::min(thresholdPn, widened);
+                childDn = childThreshold(thresholdDn, numbers.dn, children[best].dn);
+            } else {
+                childPn = childThreshold(thresholdPn, numbers.pn, children[best].pn);
+                childDn = std::min(thresholdDn, widened);
+            }
+
+            auto undo = position.makeMove(moves[best]);
+            uint32_t childWork = mid(position, keys[best], childPn, childDn, ply + 1, children[best]);
+            position.unmakeMove(moves[best], undo);
+            work = addCapped(work, childWork);
+            if (work == INF) work = INF - 1;
+        }
+
+        store(key, numbers, work);
+        return work;
+    }
+
+    //
+    // the solution tree breadth first, so every node's children sit side by side. a child the table
+    // has lost is proved again. proving says whether the last pass proved or disproved the root
+    //
+    bool extractTree(const Position &root, bool proving, std::vector<SolutionNode<Move>> &tree)
+    {
+        tree.assign(1, SolutionNode<Move>());
+        std::vector<Position> positions = { root };
+        auto solved = [proving](Numbers numbers) { return proving ? numbers.pn == 0 : numbers.dn == 0; };
+
+        for (size_t next = 0; next < positions.size(); next++) {
+            Position position = positions[next];
+            if (position.isTerminal()) continue;
+
+            MovesOf<Position> moves;
+            position.generateMoves(moves);
+            // the losing side's every reply, one answer from the winning side
+            bool everyMove = (position.sideToMove() == _attacker) != proving;
+
+            int chosen = -1;
+            uint32_t chosenWork = INF;
+            int first = (int)tree.size();
+            // an answer already in the table beats proving one again, so that is a second pass
+            for (int pass = 0; pass < 2 && chosen < 0; pass++) {
+                for (int i = 0; i < moves.size(); i++) {
+                    Position child = position;
+                    child.makeMove(moves[i]);
+                    uint64_t key = keyOf(child);
+                    uint32_t work;
+                    Numbers numbers = lookup(child, key, work);
+                    if (!solved(numbers) && numbers.pn && numbers.dn && (everyMove || pass == 1)) {
+                        work = mid(child, key, INF, INF, 0, numbers);
+                        if (_stop) return false;
+                    }
+                    if (everyMove) {
+                        // a reply the proof doesn't cover, only possible after the table lost part of it
+                        if (!solved(numbers) || (int)tree.size() >= MAX_SOLUTION_NODES) return false;
+                        tree.push_back({ moves[i], (int)next, 0, 0, work });
+                        positions.push_back(child);
+                    } else if (solved(numbers) && (chosen < 0 || work < chosenWork)) {
+                        chosen = i;
+                        chosenWork = work;
+                        if (pass == 1) break;
+                    }
+                }
+                if (everyMove) break;
+            }
+            if (!everyMove) {
+                if (chosen < 0 || (int)tree.size() >= MAX_SOLUTION_NODES) return false;
+                tree.push_back({ moves[chosen], (int)next, 0, 0, chosenWork });
+                position.makeMove(moves[chosen]);
+                positions.push_back(position);
+            }
+            tree[next].firstChild = first;
+            tree[next].childCount = (int)tree.size() - first;
+        }
+        return true;
+    }
+
+    // down the tree, taking the most work at every node with a choice
+    void mainLine(Result &result)
+    {
+        int node = 0;
+        while (!result.tree.empty() && result.tree[node].childCount) {
+            const SolutionNode<Move> &current = result.tree[node];
+            int next = current.firstChild;
+            for (int i = 1; i < current.childCount; i++) {
+                if (result.tree[current.firstChild + i].work > result.tree[next].work) next = current.firstChild + i;
+            }
+            result.line.push_back(result.tree[next].move);
+            node = next;
+        }
+        if (!result.line.empty()) {
+            result.bestMove = result.line[0];
+            result.hasMove = true;
+        }
+    }
+
+    std::vector<Bucket>     _table;
+    size_t                  _mask = 0;
+    uint64_t                _used = 0;
+
+    int                     _attacker = 0;
+    bool                    _drawIsWin = false;
+
+    std::atomic<bool>       _stop;
+    ProofLimits             _limits;
+    ProofStats              _stats;
+    std::chrono::steady_clock::time_point _startTime;
+};
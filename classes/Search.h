@@ -0,0 +1,625 @@
+#pragma once
+
+#include "Position.h"
+#include "ShardedTable.h"
+#include "TableCache.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+//
+// limits for a search, zero means unlimited
+//
+struct SearchLimits
+{
+    int         depth = 0;
+    int         timeMs = 0;
+    uint64_t    nodes = 0;
+    const std::atomic<bool> *stop = nullptr;    // the caller's, a stop set before the search starts still counts
+};
+
+struct SearchStats
+{
+    uint64_t    nodes = 0;
+    uint64_t    tableProbes = 0;
+    uint64_t    tableHits = 0;
+    uint64_t    cutoffs = 0;
+    uint64_t    firstMoveCutoffs = 0;   // cutoffs on the first move tried, how good the ordering is
+    uint64_t    researches = 0;         // null window searches that failed high and were searched again
+    uint64_t    sharedProbes = 0;       // lookups in the shared table, see SearchEngine::setSharedTable
+    uint64_t    sharedHits = 0;
+    int         timeMs = 0;
+};
+
+template <class Move>
+struct SearchResult
+{
+    Move        bestMove{};
+    bool        hasMove = false;
+    int         score = 0;
+    int         depth = 0;
+    int         mateIn = 0;             // moves to a forced win, negative when losing, zero otherwise
+    bool        solved = false;         // the whole tree was searched, the score is the game's value
+    SearchStats stats;
+    std::vector<Move> pv;
+};
+
+//
+// what a game supplies to get a SearchEngine: its Position (a GamePosition) and two static functions,
+//   int evaluate(const Position &)     static score for the side to move
+//   int result(const Position &)       1, 0 or -1 for the side to move once the position is terminal
+// and optionally HISTORY_SIZE with int historyIndex(const Move &) below it for history ordering
+//
+template <class Traits>
+concept SearchTraits = GamePosition<typename Traits::Position> && requires(const typename Traits::Position position) {
+    { Traits::evaluate(position) } -> std::convertible_to<int>;
+    { Traits::result(position) } -> std::convertible_to<int>;
+};
+
+template <class Traits>
+concept HistoryTraits = SearchTraits<Traits> && requires(const typename Traits::Position::Move move) {
+    { Traits::HISTORY_SIZE } -> std::convertible_to<int>;
+    { Traits::historyIndex(move) } -> std::convertible_to<int>;
+};
+
+//
+// iterative deepening negamax with principal variation search, a transposition table, killer and history
+// move ordering. everything is resolved at compile time from Traits, nothing in the search loop is virtual
+// moves are made and unmade on a single position. an iteration that never reached the horizon has
+// solved the game and ends the search, so do a proven win or loss and the time running low
+//
+template <SearchTraits Traits>
+class SearchEngine
+{
+public:
+    using Position = typename Traits::Position;
+    using Move = typename Position::Move;
+    using Result = SearchResult<Move>;
+    // called after every completed iteration with the result so far
+    using IterationCallback = std::function<void(const Result &)>;
+
+    static constexpr int WIN_SCORE = 30000;
+    static constexpr int INFINITE_SCORE = 32000;
+    static constexpr int MAX_PLY = 128;
+    static constexpr size_t DEFAULT_TABLE_BYTES = 1 << 20;
+
+    explicit SearchEngine(size_t tableBytes = DEFAULT_TABLE_BYTES) : _stop(false)
+    {
+        resizeTable(tableBytes);
+        if constexpr (HistoryTraits<Traits>) _history.assign(2 * Traits::HISTORY_SIZE, 0);
+    }
+
+    Result search(const Position &root, const SearchLimits &limits)
+    {
+        start(root, limits);
+        while (!advance()) {}
+        return _result;
+    }
+
+    //
+    // the same search a slice at a time, for builds that can't give it a thread: start() sets it up and
+    // each advance() takes it at most nodes further, or for timeUs microseconds (zero for no bound),
+    // returning true once it has finished. limits.timeMs counts from start(), so the search thinks for
+    // that long whatever share of each frame it gets. the tree walk keeps its stack in the engine rather
+    // than in recursive calls, which is what lets it stop between any two nodes and carry on later
+    //
+    void start(const Position &root, const SearchLimits &limits)
+    {
+        _limits = limits;
+        _stop = false;
+        _stats = SearchStats();
+        _startTime = std::chrono::steady_clock::now();
+        _age++;
+        mergeCache();
+        for (auto &killers : _killers) killers[0].set = killers[1].set = false;
+        for (int &value : _history) value /= 2;
+
+        _result = Result();
+        _root = root;
+        _position = root;
+        _depth = 0;
+        _frameCount = 0;
+        _hasValue = false;
+        _iterating = false;
+        MovesOf<Position> moves;
+        if (!_root.isTerminal()) _root.generateMoves(moves);
+        _searching = !moves.empty();
+        if (!_searching) return;
+        _result.bestMove = moves[0];
+        _result.hasMove = true;
+        _maxDepth = limits.depth > 0 ? std::min(limits.depth, MAX_PLY - 1) : MAX_PLY - 1;
+    }
+
+    bool advance(uint64_t nodes = 0, int timeUs = 0)
+    {
+        if (!_searching) return true;
+        _sliceNodes = nodes ? _stats.nodes + nodes : 0;
+        _sliceEnd = timeUs > 0 ? std::chrono::steady_clock::now() + std::chrono::microseconds(timeUs) : std::chrono::steady_clock::time_point();
+        _sliceTimed = timeUs > 0;
+
+        for (;;) {
+            if (!_iterating) {
+                if (++_depth > _maxDepth) return finish();
+                _reachedHorizon = false;
+                _rootMoveFound = false;
+                _iterating = true;
+                enter(_depth, 0, -INFINITE_SCORE, INFINITE_SCORE);
+            }
+            if (!walk()) return false;
+            _iterating = false;
+
+            int score = _value;
+            // an unfinished iteration is only worth anything when nothing has finished yet
+            if (_stop && _depth > 1) return finish();
+            if (!_rootMoveFound) return finish();
+
+            _result.bestMove = _rootMove;
+            _result.score = score;
+            _result.depth = _depth;
+            _result.solved = !_reachedHorizon && !_stop;
+            _result.mateIn = 0;
+            if (isWinScore(score)) {
+                int plies = WIN_SCORE - std::abs(score);
+                _result.mateIn = score > 0 ? (plies + 1) / 2 : -(plies / 2);
+            }
+            _result.pv = principalVariation(_root, _result.bestMove, _depth);
+            _stats.timeMs = elapsedMs();
+            _result.stats = _stats;
+            if (_onIteration) _onIteration(_result);
+
+            if (_stop || _result.solved || _result.mateIn != 0) return finish();
+            // another iteration would not finish in the time left
+            if (_limits.timeMs && _stats.timeMs * 2 > _limits.timeMs) return finish();
+        }
+    }
+
+    // a search started and not finished yet
+    bool        searching() const { return _searching; }
+    const Position& searchRoot() const { return _root; }
+    // the best of the iterations finished so far, the search's answer once advance() has returned true
+    const Result& result() const { return _result; }
+
+    void        stop() { _stop = true; }
+    void        setIterationCallback(IterationCallback callback) { _onIteration = std::move(callback); }
+    const SearchStats& stats() const { return _stats; }
+
+    void clearTable()
+    {
+        std::fill(_table.begin(), _table.end(), TableEntry());
+        std::fill(_history.begin(), _history.end(), 0);
+    }
+
+    // largest power of two table that fits in bytes, at least one bucket, the old entries are dropped
+    void resizeTable(size_t bytes)
+    {
+        size_t entries = 2;
+        while (entries * 2 * sizeof(TableEntry) <= bytes) entries *= 2;
+        _table.assign(entries, TableEntry());
+        _tableMask = entries - 1;
+    }
+
+    size_t      tableBytes() const { return _table.size() * sizeof(TableEntry) + _history.size() * sizeof(int); }
+    // what the engine holds besides its table, the frame for every ply of the search stack
+    size_t      frameBytes() const { return _frames.size() * sizeof(Frame); }
+
+    //
+    // keeps the table in a file between sessions (TableCache.h). the file is read in the background and
+    // its entries join the table when a search starts after the read has finished. signature stands for
+    // what the scores depend on besides the rules, a file saved under another one is ignored
+    //
+    void openCache(const std::string &path, const char *game, uint64_t signature = 0)
+    {
+        if (_cache && _cache->path() == path) return;
+        _cache = std::make_unique<TableCache>(path, game, sizeof(TableEntry), signature);
+        _cache->load();
+    }
+
+    // finishes writing what was saved
+    void        closeCache() { _cache.reset(); }
+    bool        hasCache() const { return _cache != nullptr; }
+
+    // hands a copy of the table to the cache's writer. nothing is saved while the file is still being
+    // read, the entries it holds would be lost
+    void saveCache()
+    {
+        if (!_cache) return;
+        mergeCache();
+        if (_cache->loading()) return;
+        _cache->save(reinterpret_cast<const uint8_t*>(_table.data()), _table.size() * sizeof(TableEntry));
+    }
+
+    //
+    // shares the entries of nodes with at least minDepth plies to go with other searches, e.g. in other
+    // processes (ShardedTable.h): such a node asks the shared table when its own has nothing good enough
+    // and tells it what it found. a lookup there can be a round trip to another process, minDepth keeps
+    // it to the nodes near the root whose subtrees are worth it. nullptr stops sharing
+    //
+    void setSharedTable(SharedTable *table, int minDepth)
+    {
+        _shared = table;
+        _sharedDepth = std::max(1, minDepth);
+    }
+
+    static bool isWinScore(int score) { return score > WIN_SCORE - MAX_PLY || score < -WIN_SCORE + MAX_PLY; }
+
+private:
+    enum Bound : uint8_t { BOUND_NONE, BOUND_UPPER, BOUND_LOWER, BOUND_EXACT };
+    static_assert((int)BOUND_EXACT == SharedEntry::BOUND_EXACT && (int)BOUND_LOWER == SharedEntry::BOUND_LOWER, "shared entries keep the bound as is");
+
+    static constexpr uint8_t NO_MOVE = 255;
+
+    struct TableEntry
+    {
+        uint64_t    key = 0;
+        int16_t     score = 0;
+        uint8_t     depth = 0;
+        uint8_t     bound = BOUND_NONE;
+        uint8_t     move = NO_MOVE;     // index into the position's generated move list
+        uint8_t     age = 0;            // the search that stored it
+        bool        solved = false;     // searched to the end of the game, good at any depth
+    };
+
+    struct Killer
+    {
+        Move        move{};
+        bool        set = false;
+    };
+
+    // which search of the current move a frame is waiting on
+    enum Phase : uint8_t { FULL_WINDOW, NULL_WINDOW, RESEARCH };
+
+    // a node being searched, what the recursive version would keep on the call stack
+    struct Frame
+    {
+        uint64_t    key;
+        int         depth;
+        int         ply;
+        int         alpha;
+        int         beta;
+        int         alphaOriginal;
+        int         best;
+        int         bestIndex;
+        int         index;              // the move being searched, in order
+        int         count;
+        int         side;
+        Phase       phase;
+        bool        horizonAbove;
+        typename Position::Undo undo;
+        MovesOf<Position> moves;
+        int         order[Position::MAX_MOVES];
+        int         scores[Position::MAX_MOVES];
+    };
+
+    int elapsedMs() const
+    {
+        return (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _startTime).count();
+    }
+
+    int orderScore(const Move &move, int side, int ply) const
+    {
+        if (_killers[ply][0].set && _killers[ply][0].move == move) return 1 << 29;
+        if (_killers[ply][1].set && _killers[ply][1].move == move) return 1 << 28;
+        if constexpr (HistoryTraits<Traits>) return _history[side * Traits::HISTORY_SIZE + Traits::historyIndex(move)];
+        return 0;
+    }
+
+    void rewardCutoff(const Move &move, int side, int depth, int ply)
+    {
+        if (!(_killers[ply][0].set && _killers[ply][0].move == move)) {
+            _killers[ply][1] = _killers[ply][0];
+            _killers[ply][0] = { move, true };
+        }
+        if constexpr (HistoryTraits<Traits>) {
+            int &value = _history[side * Traits::HISTORY_SIZE + Traits::historyIndex(move)];
+            value = std::min(value + depth * depth, 1 << 27);
+        }
+    }
+
+    bool finish()
+    {
+        _stats.timeMs = elapsedMs();
+        _result.stats = _stats;
+        _searching = false;
+        return true;
+    }
+
+    bool sliceUsed()
+    {
+        if (_sliceNodes && _stats.nodes >= _sliceNodes) return true;
+        return _sliceTimed && (_stats.nodes & 255) == 0 && std::chrono::steady_clock::now() >= _sliceEnd;
+    }
+
+    bool leaf(int value)
+    {
+        _value = value;
+        _hasValue = true;
+        return true;
+    }
+
+    //
+    // the first half of a node: a leaf or a table cutoff has its value right away, anything else gets a
+    // frame with its ordered moves for walk() to search
+    //
+    bool enter(int depth, int ply, int alpha, int beta)
+    {
+        _stats.nodes++;
+        if (_limits.stop && *_limits.stop) _stop = true;
+        if (_limits.nodes && _stats.nodes >= _limits.nodes) _stop = true;
+        if ((_stats.nodes & 1023) == 0 && _limits.timeMs && elapsedMs() >= _limits.timeMs) _stop = true;
+        if (_stop) return leaf(0);
+
+        if (_position.isTerminal()) return leaf(Traits::result(_position) * (WIN_SCORE - ply));
+        if (depth <= 0 || ply >= MAX_PLY - 1) {
+            _reachedHorizon = true;
+            return leaf(Traits::evaluate(_position));
+        }
+
+        uint64_t key = _position.hash();
+        const TableEntry *entry = probe(key);
+        if (_shared && depth >= _sharedDepth && !(entry && (entry->depth >= depth || entry->solved))) {
+            SharedEntry shared;
+            _stats.sharedProbes++;
+            if (_shared->probe(key, shared)) {
+                _stats.sharedHits++;
+                place({ shared.key, shared.score, shared.depth, shared.bound, shared.move, _age, shared.solved != 0 });
+                entry = probe(key);
+            }
+        }
+        int tableMove = -1;
+        _stats.tableProbes++;
+        if (entry) {
+            _stats.tableHits++;
+            if (entry->move != NO_MOVE) tableMove = entry->move;
+            if (ply > 0 && (entry->depth >= depth || entry->solved)) {
+                int score = fromTable(entry->score, ply);
+                if (entry->bound == BOUND_EXACT || (entry->bound == BOUND_LOWER && score >= beta) ||
+                    (entry->bound == BOUND_UPPER && score <= alpha)) {
+                    if (!entry->solved) _reachedHorizon = true;
+                    return leaf(score);
+                }
+            }
+        }
+
+        Frame &frame = _frames[_frameCount++];
+        frame.key = key;
+        frame.depth = depth;
+        frame.ply = ply;
+        frame.alpha = alpha;
+        frame.beta = beta;
+        frame.alphaOriginal = alpha;
+        frame.best = -INFINITE_SCORE;
+        frame.bestIndex = -1;
+        frame.index = 0;
+        frame.side = _position.sideToMove();
+        frame.moves.clear();
+        _position.generateMoves(frame.moves);
+        frame.count = frame.moves.size();
+        for (int i = 0; i < frame.count; i++) {
+            frame.order[i] = i;
+            frame.scores[i] = i == tableMove ? 1 << 30 : orderScore(frame.moves[i], frame.side, ply);
+        }
+        frame.horizonAbove = _reachedHorizon;
+        _reachedHorizon = false;
+        return false;
+    }
+
+    // the second half, the node's value goes to its parent
+    void leave(Frame &frame)
+    {
+        bool horizonBelow = _reachedHorizon;
+        _reachedHorizon = frame.horizonAbove || horizonBelow;
+        Bound bound = frame.best <= frame.alphaOriginal ? BOUND_UPPER : frame.best >= frame.beta ? BOUND_LOWER : BOUND_EXACT;
+        store(frame.key, frame.depth, !horizonBelow, frame.ply, frame.best, bound, frame.bestIndex);
+        if (_shared && frame.depth >= _sharedDepth) {
+            SharedEntry shared;
+            shared.key = frame.key;
+            shared.score = (int16_t)toTable(frame.best, frame.ply);
+            shared.depth = (uint8_t)frame.depth;
+            shared.bound = bound;
+            shared.move = frame.bestIndex < 0 ? NO_MOVE : (uint8_t)frame.bestIndex;
+            shared.solved = !horizonBelow;
+            _shared->store(shared);
+        }
+        _frameCount--;
+        leaf(frame.best);
+    }
+
+    //
+    // negamax with principal variation search over the frames, making and unmaking moves on _position
+    // returns true when the root has its value, false when the slice ran out first
+    //
+    bool walk()
+    {
+        for (;;) {
+            if (_hasValue) {
+                _hasValue = false;
+                if (_frameCount == 0) return true;
+
+                Frame &frame = _frames[_frameCount - 1];
+                int score = -_value;
+                if (frame.phase == NULL_WINDOW && score > frame.alpha && score < frame.beta && !_stop) {
+                    _stats.researches++;
+                    frame.phase = RESEARCH;
+                    enter(frame.depth - 1, frame.ply + 1, -frame.beta, -frame.alpha);
+                    continue;
+                }
+                const Move &move = frame.moves[frame.order[frame.index]];
+                _position.unmakeMove(move, frame.undo);
+                if (_stop) {
+                    _frameCount--;
+                    leaf(0);
+                    continue;
+                }
+
+                if (score > frame.best) {
+                    frame.best = score;
+                    frame.bestIndex = frame.order[frame.index];
+                    if (frame.ply == 0) {
+                        _rootMove = move;
+                        _rootMoveFound = true;
+                    }
+                }
+                if (score > frame.alpha) frame.alpha = score;
+                frame.index++;
+                if (frame.alpha >= frame.beta) {
+                    _stats.cutoffs++;
+                    if (frame.index == 1) _stats.firstMoveCutoffs++;
+                    rewardCutoff(move, frame.side, frame.depth, frame.ply);
+                    frame.index = frame.count;
+                }
+            }
+
+            Frame &frame = _frames[_frameCount - 1];
+            if (frame.index >= frame.count) {
+                leave(frame);
+                continue;
+            }
+            if (sliceUsed()) return false;
+
+            // selection sort, a cutoff usually comes before the rest needs sorting
+            int i = frame.index;
+            int pick = i;
+            for (int j = i + 1; j < frame.count; j++) {
+                if (frame.scores[j] > frame.scores[pick]) pick = j;
+            }
+            std::swap(frame.order[i], frame.order[pick]);
+            std::swap(frame.scores[i], frame.scores[pick]);
+
+            frame.undo = _position.makeMove(frame.moves[frame.order[i]]);
+            if (i == 0) {
+                frame.phase = FULL_WINDOW;
+                enter(frame.depth - 1, frame.ply + 1, -frame.beta, -frame.alpha);
+            } else {
+                frame.phase = NULL_WINDOW;
+                enter(frame.depth - 1, frame.ply + 1, -frame.alpha - 1, -frame.alpha);
+            }
+        }
+    }
+
+    // win scores are stored relative to the node so they stay valid from any ply
+    static int toTable(int score, int ply)
+    {
+        if (score > WIN_SCORE - MAX_PLY) return score + ply;
+        if (score < -WIN_SCORE + MAX_PLY) return score - ply;
+        return score;
+    }
+
+    static int fromTable(int score, int ply)
+    {
+        if (score > WIN_SCORE - MAX_PLY) return score - ply;
+        if (score < -WIN_SCORE + MAX_PLY) return score + ply;
+        return score;
+    }
+
+    //
+    // two entry buckets: the first keeps the deepest search of this search, the second always takes the newest
+    //
+    const TableEntry* probe(uint64_t key) const
+    {
+        const TableEntry *bucket = &_table[key & _tableMask & ~(size_t)1];
+        if (bucket[0].key == key) return &bucket[0];
+        if (bucket[1].key == key) return &bucket[1];
+        return nullptr;
+    }
+
+    void store(uint64_t key, int depth, bool solved, int ply, int score, Bound bound, int move)
+    {
+        TableEntry *bucket = &_table[key & _tableMask & ~(size_t)1];
+        TableEntry *slot = &bucket[1];
+        if (bucket[0].key == key || bucket[0].age != _age || depth >= bucket[0].depth) slot = &bucket[0];
+        TableEntry &entry = *slot;
+        if (entry.key == key && (entry.depth > depth || entry.solved) && !solved && bound != BOUND_EXACT) return;
+        entry.key = key;
+        entry.solved = solved;
+        entry.age = _age;
+        entry.score = (int16_t)toTable(score, ply);
+        entry.depth = (uint8_t)depth;
+        entry.bound = bound;
+        entry.move = move < 0 ? NO_MOVE : (uint8_t)move;
+    }
+
+    // a finished cache read into the table
+    void mergeCache()
+    {
+        std::vector<uint8_t> bytes;
+        if (!_cache || !_cache->takeLoaded(bytes)) return;
+        size_t count = bytes.size() / sizeof(TableEntry);
+        for (size_t i = 0; i < count; i++) {
+            TableEntry entry;
+            memcpy(&entry, bytes.data() + i * sizeof(TableEntry), sizeof(TableEntry));
+            if (entry.bound != BOUND_NONE) place(entry);
+        }
+    }
+
+    // an entry from outside the search (the cache file, the shared table) takes a slot only from a shallower one
+    void place(TableEntry entry)
+    {
+        entry.age = _age;
+        TableEntry *bucket = &_table[entry.key & _tableMask & ~(size_t)1];
+        TableEntry *slot = &bucket[0];
+        if (bucket[0].key != entry.key && bucket[0].bound != BOUND_NONE) {
+            slot = bucket[1].key == entry.key || bucket[1].bound == BOUND_NONE || bucket[1].depth < bucket[0].depth ? &bucket[1] : &bucket[0];
+        }
+        if (slot->bound == BOUND_NONE || slot->key == entry.key || entry.depth >= slot->depth || entry.solved) *slot = entry;
+    }
+
+    // the best move, then the table's moves from there on
+    std::vector<Move> principalVariation(const Position &root, const Move &bestMove, int maxLength)
+    {
+        std::vector<Move> pv;
+        Position position = root;
+        position.makeMove(bestMove);
+        pv.push_back(bestMove);
+        while ((int)pv.size() < maxLength && !position.isTerminal()) {
+            const TableEntry *entry = probe(position.hash());
+            if (!entry || entry->move == NO_MOVE) break;
+            MovesOf<Position> moves;
+            position.generateMoves(moves);
+            if (entry->move >= moves.size()) break;
+            pv.push_back(moves[entry->move]);
+            position.makeMove(moves[entry->move]);
+        }
+        return pv;
+    }
+
+    std::vector<TableEntry> _table;
+    size_t              _tableMask;
+    uint8_t             _age = 0;
+    Killer              _killers[MAX_PLY][2];
+    std::vector<int>    _history;
+    std::unique_ptr<TableCache> _cache;
+    SharedTable*        _shared = nullptr;
+    int                 _sharedDepth = 0;
+
+    std::atomic<bool>   _stop;
+    SearchLimits        _limits;
+    SearchStats         _stats;
+    std::chrono::steady_clock::time_point _startTime;
+    IterationCallback   _onIteration;
+    bool                _reachedHorizon = false;
+    bool                _rootMoveFound = false;
+    Move                _rootMove{};
+
+    // the search in progress, between advance() calls
+    Position            _root{};
+    Position            _position{};
+    Result              _result;
+    bool                _searching = false;
+    bool                _iterating = false;     // an iteration's tree walk is under way
+    int                 _depth = 0;
+    int                 _maxDepth = 0;
+    std::vector<Frame>  _frames = std::vector<Frame>(MAX_PLY);
+    int                 _frameCount = 0;
+    int                 _value = 0;             // the value of the node that just finished
+    bool                _hasValue = false;
+    uint64_t            _sliceNodes = 0;
+    bool                _sliceTimed = false;
+    std::chrono::steady_clock::time_point _sliceEnd;
+};
@@ -0,0 +1,153 @@
+#include "SearchScheduler.h"
+#include "JobSystem.h"
+#include <algorithm>
+
+SearchScheduler::SearchScheduler(int workers, int maxMoveTimeMs)
+{
+    _shuttingDown = false;
+    _sequence = 0;
+    _maxMoveTimeMs = std::max(1, maxMoveTimeMs);
+    _latencies.reserve(LATENCY_SAMPLES);
+    _latencyNext = 0;
+    _completed = 0;
+    _missedDeadlines = 0;
+    _startTime = Clock::now();
+    _concurrency = std::max(1, workers);
+    _active = 0;
+}
+
+SearchScheduler::~SearchScheduler()
+{
+    shutdown();
+}
+
+bool SearchScheduler::submit(const std::shared_ptr<GameSession> &session, const ProtocolLimits &limits, Callback done)
+{
+    {
+        std::lock_guard<std::mutex> lock(session->mutex);
+        if (session->searching || session->closed) return false;
+        session->searching = true;
+        session->stopRequested = false;
+    }
+
+    Job job;
+    job.session = session;
+    job.limits = limits;
+    job.submitted = Clock::now();
+    // without a time limit the server's cap is the deadline
+    int budgetMs = limits.timeMs > 0 ? std::min(limits.timeMs, _maxMoveTimeMs) : _maxMoveTimeMs;
+    job.deadline = job.submitted + std::chrono::milliseconds(budgetMs);
+    job.done = std::move(done);
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_shuttingDown) {
+            session->searching = false;
+            return false;
+        }
+        job.sequence = _sequence++;
+        _queue.push(std::move(job));
+        if (_active >= _concurrency) return true;
+        _active++;
+    }
+    JobSystem::instance().submit([this] { runQueue(); }, JobPriority::HIGH);
+    return true;
+}
+
+void SearchScheduler::shutdown()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _shuttingDown = true;
+    // the tokens stay set, so a job taken off the queue but not searching yet stops as soon as it starts
+    for (const auto &session : _running) session->stopRequested = true;
+    _idle.wait(lock, [this] { return _active == 0; });
+}
+
+void SearchScheduler::runQueue()
+{
+    for (;;) {
+        Job job;
+        bool cancelled;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_queue.empty()) {
+                _active--;
+                _idle.notify_all();
+                return;
+            }
+            job = _queue.top();
+            _queue.pop();
+            cancelled = _shuttingDown || job.session->stopRequested;
+            if (!cancelled) _running.push_back(job.session);
+        }
+
+        if (cancelled) finish(job, SearchOutcome());
+        else run(job);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto running = std::find(_running.begin(), _running.end(), job.session);
+        if (running != _running.end()) _running.erase(running);
+    }
+}
+
+void SearchScheduler::run(Job &job)
+{
+    // whatever time queueing used up comes out of this move's budget
+    Clock::time_point start = Clock::now();
+    int remainingMs = (int)std::chrono::duration_cast<std::chrono::milliseconds>(job.deadline - start).count();
+    ProtocolLimits limits = job.limits;
+    limits.timeMs = std::max(1, remainingMs);
+    limits.stop = &job.session->stopRequested;
+
+    SearchOutcome outcome;
+    outcome.bestMove = job.session->game->search(limits, [&](const ProtocolInfo &info) { outcome.nodes = info.nodes; });
+    outcome.missedDeadline = remainingMs <= 0 || Clock::now() > job.deadline + std::chrono::milliseconds(1);
+    finish(job, outcome);
+}
+
+void SearchScheduler::finish(Job &job, const SearchOutcome &result)
+{
+    SearchOutcome outcome = result;
+    outcome.latencyUs = (int)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - job.submitted).count();
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_latencies.size() < LATENCY_SAMPLES) _latencies.push_back(outcome.latencyUs);
+        else _latencies[_latencyNext] = outcome.latencyUs;
+        _latencyNext = (_latencyNext + 1) % LATENCY_SAMPLES;
+        _completed++;
+        _missedDeadlines += outcome.missedDeadline;
+    }
+
+    // the move is on the board and the session free again before anyone hears about it
+    {
+        GameSession &session = *job.session;
+        std::lock_guard<std::mutex> lock(session.mutex);
+        if (!outcome.bestMove.empty() && session.game->playMove(outcome.bestMove)) session.history.push_back(outcome.bestMove);
+        outcome.gameOver = session.game->isOver();
+        session.searching = false;
+    }
+    if (job.done) job.done(*job.session, outcome);
+}
+
+SchedulerStats SearchScheduler::stats() const
+{
+    SchedulerStats stats;
+    std::vector<int> latencies;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        stats.completed = _completed;
+        stats.missedDeadlines = _missedDeadlines;
+        stats.queued = _queue.size();
+        latencies = _latencies;
+    }
+
+    double seconds = std::chrono::duration<double>(Clock::now() - _startTime).count();
+    stats.movesPerSecond = seconds > 0 ? stats.completed / seconds : 0;
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        stats.p50Us = latencies[latencies.size() / 2];
+        stats.p99Us = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+        stats.maxUs = latencies.back();
+    }
+    return stats;
+}
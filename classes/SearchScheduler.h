@@ -0,0 +1,98 @@
+#pragma once
+
+#include "GameSession.h"
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <vector>
+
+struct SearchOutcome
+{
+    std::string bestMove;           // empty when the game was over or the session closed
+    uint64_t    nodes = 0;
+    int         latencyUs = 0;      // from submit to the move, queueing included
+    bool        missedDeadline = false;
+    bool        gameOver = false;   // after the move was played
+};
+
+struct SchedulerStats
+{
+    uint64_t    completed = 0;
+    uint64_t    missedDeadlines = 0;
+    size_t      queued = 0;
+    double      movesPerSecond = 0;
+    int         p50Us = 0;
+    int         p99Us = 0;
+    int         maxUs = 0;
+};
+
+//
+// finds and plays the AI moves of every hosted session on up to workers high priority jobs of the
+// JobSystem at once, each taking searches off the queue until it is empty
+// a session has at most one search in flight, so a busy game can't crowd out the others, and the
+// queue runs earliest deadline first. a search only gets the time left before its deadline and
+// never more than maxMoveTimeMs, whatever it asked for
+//
+class SearchScheduler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using Callback = std::function<void(GameSession &session, const SearchOutcome &outcome)>;
+
+    SearchScheduler(int workers, int maxMoveTimeMs = 5000);
+    ~SearchScheduler();
+
+    // false when the session is already searching or the scheduler is shutting down
+    // the best move is played on the session before done runs on the worker
+    bool            submit(const std::shared_ptr<GameSession> &session, const ProtocolLimits &limits, Callback done);
+
+    // stops the running searches, finishes the queued ones with no move and waits for the jobs
+    void            shutdown();
+
+    SchedulerStats  stats() const;
+
+private:
+    struct Job
+    {
+        std::shared_ptr<GameSession> session;
+        ProtocolLimits      limits;
+        Clock::time_point   submitted;
+        Clock::time_point   deadline;
+        uint64_t            sequence;
+        Callback            done;
+    };
+
+    struct LaterDeadline
+    {
+        bool operator()(const Job &a, const Job &b) const
+        {
+            return a.deadline != b.deadline ? a.deadline > b.deadline : a.sequence > b.sequence;
+        }
+    };
+
+    static const size_t LATENCY_SAMPLES = 65536;
+
+    void            runQueue();
+    void            run(Job &job);
+    void            finish(Job &job, const SearchOutcome &outcome);
+
+    int                         _concurrency;
+    int                         _active;        // jobs running the queue
+    mutable std::mutex          _mutex;
+    std::condition_variable     _idle;
+    std::priority_queue<Job, std::vector<Job>, LaterDeadline> _queue;
+    std::vector<std::shared_ptr<GameSession>> _running;
+    bool                        _shuttingDown;
+    uint64_t                    _sequence;
+    int                         _maxMoveTimeMs;
+
+    // the most recent latencies in a ring, for the percentiles
+    std::vector<int>            _latencies;
+    size_t                      _latencyNext;
+    uint64_t                    _completed;
+    uint64_t                    _missedDeadlines;
+    Clock::time_point           _startTime;
+};
@@ -0,0 +1,130 @@
+#include "SelfPlayData.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+uint64_t SelfPlayFile::checksum(const SelfPlayRecord *records, size_t count)
+{
+    const uint8_t *bytes = reinterpret_cast<const uint8_t*>(records);
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < count * sizeof(SelfPlayRecord); i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+SelfPlayWriter::~SelfPlayWriter()
+{
+    close();
+}
+
+bool SelfPlayWriter::open(const std::string &path, const std::string &game)
+{
+    close();
+    _written = 0;
+    _failed = false;
+
+    SelfPlayReader existing;
+    if (existing.open(path)) {
+        if (existing.game() != game) return false;
+        // drop whatever follows the last whole chunk
+        std::error_code error;
+        std::filesystem::resize_file(path, existing.validBytes(), error);
+        if (error) return false;
+        existing.close();
+        _file = fopen(path.c_str(), "ab");
+        return _file != nullptr;
+    }
+
+    _file = fopen(path.c_str(), "wb");
+    if (!_file) return false;
+    SelfPlayFile::FileHeader header = {};
+    header.magic = SelfPlayFile::FILE_MAGIC;
+    header.version = SelfPlayFile::FILE_VERSION;
+    strncpy(header.game, game.c_str(), sizeof(header.game) - 1);
+    header.recordSize = sizeof(SelfPlayRecord);
+    if (fwrite(&header, sizeof(header), 1, _file) != 1 || fflush(_file) != 0) {
+        fclose(_file);
+        _file = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void SelfPlayWriter::add(const SelfPlayRecord &record)
+{
+    _pending.push_back(record);
+    if (_pending.size() >= (size_t)SelfPlayFile::CHUNK_RECORDS) flush();
+}
+
+void SelfPlayWriter::flush()
+{
+    if (!_file || _pending.empty()) return;
+    SelfPlayFile::ChunkHeader header = { SelfPlayFile::CHUNK_MAGIC, (uint32_t)_pending.size(),
+                                         SelfPlayFile::checksum(_pending.data(), _pending.size()) };
+    bool ok = fwrite(&header, sizeof(header), 1, _file) == 1 &&
+              fwrite(_pending.data(), sizeof(SelfPlayRecord), _pending.size(), _file) == _pending.size() &&
+              fflush(_file) == 0;
+    if (ok) _written += _pending.size();
+    else _failed = true;
+    _pending.clear();
+}
+
+bool SelfPlayWriter::close()
+{
+    if (!_file) return !_failed;
+    flush();
+    if (fclose(_file) != 0) _failed = true;
+    _file = nullptr;
+    return !_failed;
+}
+
+bool SelfPlayReader::open(const std::string &path, bool verify)
+{
+    close();
+    if (!_file.open(path)) return false;
+
+    const uint8_t *data = _file.data();
+    size_t size = _file.size();
+    SelfPlayFile::FileHeader header;
+    if (size < sizeof(header)) return false;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != SelfPlayFile::FILE_MAGIC || header.version != SelfPlayFile::FILE_VERSION ||
+        header.recordSize != sizeof(SelfPlayRecord)) {
+        close();
+        return false;
+    }
+    _game.assign(header.game, strnlen(header.game, sizeof(header.game)));
+
+    size_t offset = sizeof(header);
+    while (offset + sizeof(SelfPlayFile::ChunkHeader) <= size) {
+        SelfPlayFile::ChunkHeader chunk;
+        memcpy(&chunk, data + offset, sizeof(chunk));
+        size_t bytes = (size_t)chunk.count * sizeof(SelfPlayRecord);
+        if (chunk.magic != SelfPlayFile::CHUNK_MAGIC || !chunk.count || offset + sizeof(chunk) + bytes > size) break;
+
+        const SelfPlayRecord *records = reinterpret_cast<const SelfPlayRecord*>(data + offset + sizeof(chunk));
+        if (verify && SelfPlayFile::checksum(records, chunk.count) != chunk.checksum) break;
+        _chunks.push_back({ records, chunk.count, _size });
+        _size += chunk.count;
+        offset += sizeof(chunk) + bytes;
+    }
+    _validBytes = offset;
+    return true;
+}
+
+void SelfPlayReader::close()
+{
+    _file.close();
+    _game.clear();
+    _chunks.clear();
+    _size = 0;
+    _validBytes = 0;
+}
+
+const SelfPlayRecord& SelfPlayReader::operator[](uint64_t index) const
+{
+    auto chunk = std::upper_bound(_chunks.begin(), _chunks.end(), index, [](uint64_t i, const Chunk &c) { return i < c.first; }) - 1;
+    return chunk->records[index - chunk->first];
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "MappedFile.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+//
+// one labelled position, 24 bytes, for the games whose boards fit a 64-bit mask per player
+//
+struct SelfPlayRecord
+{
+    uint64_t    discs[2];       // player 0's and player 1's discs in the game's bitboard layout
+    int16_t     score;          // search score for the side to move
+    int8_t      result;         // how the game ended for the side to move: 1, 0 or -1
+    uint8_t     side;
+    uint16_t    ply;
+    uint16_t    reserved;
+};
+
+static_assert(sizeof(SelfPlayRecord) == 24);
+
+//
+// self-play data files: a header naming the game, then chunks of records, each behind a small header
+// with its count and a checksum. chunks are written whole and flushed, so a file that is still being
+// written, or was cut off, reads up to its last whole chunk. records sit 8 byte aligned in the file
+// and are read in place from a memory mapping
+//
+namespace SelfPlayFile
+{
+    constexpr uint32_t FILE_MAGIC = 0x31445053;     // "SPD1"
+    constexpr uint32_t CHUNK_MAGIC = 0x4B4E4843;    // "CHNK"
+    constexpr uint32_t FILE_VERSION = 1;
+    constexpr int CHUNK_RECORDS = 4096;
+
+    struct FileHeader
+    {
+        uint32_t    magic;
+        uint32_t    version;
+        char        game[16];
+        uint32_t    recordSize;
+        uint32_t    reserved;
+    };
+
+    struct ChunkHeader
+    {
+        uint32_t    magic;
+        uint32_t    count;
+        uint64_t    checksum;       // FNV-1a of the records
+    };
+
+    uint64_t    checksum(const SelfPlayRecord *records, size_t count);
+}
+
+//
+// appends records to a data file, a chunk at a time. opening a file for the same game appends to it,
+// dropping a torn chunk at its end first
+//
+class SelfPlayWriter
+{
+public:
+    ~SelfPlayWriter();
+
+    bool        open(const std::string &path, const std::string &game);
+    void        add(const SelfPlayRecord &record);
+    void        flush();
+    bool        close();
+
+    uint64_t    written() const { return _written; }
+    bool        failed() const { return _failed; }
+
+private:
+    FILE*       _file = nullptr;
+    std::vector<SelfPlayRecord> _pending;
+    uint64_t    _written = 0;
+    bool        _failed = false;
+};
+
+//
+// a data file read in place, every whole chunk is a span of records
+//
+class SelfPlayReader
+{
+public:
+    struct Chunk
+    {
+        const SelfPlayRecord*   records;
+        uint32_t                count;
+        uint64_t                first;      // index of the chunk's first record in the file
+    };
+
+    // verify checks every chunk's checksum, otherwise only the headers are walked
+    bool        open(const std::string &path, bool verify = false);
+    void        close();
+
+    const std::string&          game() const { return _game; }
+    uint64_t                    size() const { return _size; }
+    const std::vector<Chunk>&   chunks() const { return _chunks; }
+    // bytes of the file that hold whole chunks, a writer appending cuts the file here
+    size_t                      validBytes() const { return _validBytes; }
+
+    const SelfPlayRecord&       operator[](uint64_t index) const;
+
+private:
+    MappedFile          _file;
+    std::string         _game;
+    std::vector<Chunk>  _chunks;
+    uint64_t            _size = 0;
+    size_t              _validBytes = 0;
+};
@@ -0,0 +1,403 @@
+#include "ShardedTable.h"
+#include <chrono>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef _WIN32
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // the largest message accepted, anything longer is a broken peer
+    const uint32_t MAX_COUNT = 1 << 16;
+
+#ifndef _WIN32
+    bool isUnix(const std::string &address) { return address.compare(0, 5, "unix:") == 0; }
+    bool isTcp(const std::string &address) { return address.compare(0, 4, "tcp:") == 0; }
+
+    bool unixAddress(const std::string &address, sockaddr_un &result, std::string &error)
+    {
+        std::string path = address.substr(5);
+        result = sockaddr_un{};
+        result.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(result.sun_path)) {
+            error = address + ": bad socket path";
+            return false;
+        }
+        std::strcpy(result.sun_path, path.c_str());
+        return true;
+    }
+
+    addrinfo* tcpAddress(const std::string &address, bool passive, std::string &error)
+    {
+        std::string rest = address.substr(4);
+        size_t colon = rest.rfind(':');
+        if (colon == std::string::npos) {
+            error = address + ": no port";
+            return nullptr;
+        }
+        std::string host = rest.substr(0, colon);
+        std::string port = rest.substr(colon + 1);
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        if (passive) hints.ai_flags = AI_PASSIVE;
+        addrinfo *result = nullptr;
+        int status = getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &result);
+        if (status != 0) {
+            error = address + ": " + gai_strerror(status);
+            return nullptr;
+        }
+        return result;
+    }
+
+    // one attempt, -1 when nothing accepted it
+    int tryConnect(const std::string &address, std::string &error)
+    {
+        if (isUnix(address)) {
+            sockaddr_un target;
+            if (!unixAddress(address, target, error)) return -1;
+            int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd >= 0 && connect(fd, (sockaddr*)&target, sizeof(target)) == 0) return fd;
+            error = address + ": " + strerror(errno);
+            if (fd >= 0) ::close(fd);
+            return -1;
+        }
+        addrinfo *targets = tcpAddress(address, false, error);
+        if (!targets) return -1;
+        int fd = -1;
+        for (addrinfo *target = targets; target && fd < 0; target = target->ai_next) {
+            fd = socket(target->ai_family, target->ai_socktype, target->ai_protocol);
+            if (fd < 0) continue;
+            if (connect(fd, target->ai_addr, target->ai_addrlen) != 0) {
+                error = address + ": " + strerror(errno);
+                ::close(fd);
+                fd = -1;
+            }
+        }
+        freeaddrinfo(targets);
+        if (fd >= 0) {
+            // probes are small and waited on
+            int on = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        }
+        return fd;
+    }
+#endif
+}
+
+int ClusterSocket::listenOn(const std::string &address, std::string &error)
+{
+#ifdef _WIN32
+    error = "cluster sockets aren't supported on Windows";
+    return -1;
+#else
+    int fd = -1;
+    if (isUnix(address)) {
+        sockaddr_un local;
+        if (!unixAddress(address, local, error)) return -1;
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            error = std::string("socket: ") + strerror(errno);
+            return -1;
+        }
+        unlink(local.sun_path);
+        if (bind(fd, (sockaddr*)&local, sizeof(local)) < 0 || listen(fd, 128) < 0) {
+            error = address + ": " + strerror(errno);
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+    if (!isTcp(address)) {
+        error = address + ": not unix:path or tcp:host:port";
+        return -1;
+    }
+
+    addrinfo *locals = tcpAddress(address, true, error);
+    if (!locals) return -1;
+    for (addrinfo *local = locals; local && fd < 0; local = local->ai_next) {
+        fd = socket(local->ai_family, local->ai_socktype, local->ai_protocol);
+        if (fd < 0) continue;
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        if (bind(fd, local->ai_addr, local->ai_addrlen) < 0 || listen(fd, 128) < 0) {
+            error = address + ": " + strerror(errno);
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(locals);
+    return fd;
+#endif
+}
+
+int ClusterSocket::connectTo(const std::string &address, int timeoutMs, std::string &error)
+{
+#ifdef _WIN32
+    error = "cluster sockets aren't supported on Windows";
+    return -1;
+#else
+    if (!isUnix(address) && !isTcp(address)) {
+        error = address + ": not unix:path or tcp:host:port";
+        return -1;
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    for (;;) {
+        int fd = tryConnect(address, error);
+        if (fd >= 0 || std::chrono::steady_clock::now() >= deadline) return fd;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+#endif
+}
+
+void ClusterSocket::close(int fd, const std::string &listenAddress)
+{
+#ifndef _WIN32
+    if (fd >= 0) ::close(fd);
+    if (isUnix(listenAddress)) unlink(listenAddress.c_str() + 5);
+#endif
+}
+
+bool ClusterSocket::sendAll(int fd, const void *data, size_t size)
+{
+#ifdef _WIN32
+    return false;
+#else
+    const char *bytes = (const char*)data;
+    while (size > 0) {
+        ssize_t n = ::send(fd, bytes, size, MSG_NOSIGNAL);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return false;
+        }
+        bytes += n;
+        size -= (size_t)n;
+    }
+    return true;
+#endif
+}
+
+bool ClusterSocket::receiveAll(int fd, void *data, size_t size)
+{
+#ifdef _WIN32
+    return false;
+#else
+    char *bytes = (char*)data;
+    while (size > 0) {
+        ssize_t n = recv(fd, bytes, size, 0);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return false;
+        }
+        bytes += n;
+        size -= (size_t)n;
+    }
+    return true;
+#endif
+}
+
+ShardedTable::ShardedTable(int shard, const std::vector<std::string> &addresses, size_t bytes)
+{
+    _shard = shard;
+    _addresses = addresses;
+    size_t entries = 2;
+    while (entries * 2 * sizeof(SharedEntry) <= bytes) entries *= 2;
+    _table.assign(entries, SharedEntry());
+    _tableMask = entries - 1;
+    _peers.assign(addresses.size(), -1);
+    _outgoing.resize(addresses.size());
+    _listenFd = -1;
+    _running = false;
+    _served = 0;
+}
+
+ShardedTable::~ShardedTable()
+{
+    stop();
+}
+
+bool ShardedTable::start(std::string &error)
+{
+    if (_shard < 0 || _shard >= shards()) {
+        error = "shard " + std::to_string(_shard) + " of " + std::to_string(shards());
+        return false;
+    }
+    _listenFd = ClusterSocket::listenOn(_addresses[_shard], error);
+    if (_listenFd < 0) return false;
+    _running = true;
+    _acceptThread = std::thread(&ShardedTable::acceptLoop, this);
+
+    for (int i = 0; i < shards(); i++) {
+        if (i == _shard) continue;
+        _peers[i] = ClusterSocket::connectTo(_addresses[i], CONNECT_TIMEOUT_MS, error);
+        if (_peers[i] < 0) {
+            stop();
+            return false;
+        }
+    }
+    return true;
+}
+
+void ShardedTable::stop()
+{
+#ifndef _WIN32
+    if (!_running.exchange(false)) return;
+    flush();
+    // the other shards' servers see the end of these and let go of their threads
+    for (int &fd : _peers) {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+    _acceptThread.join();
+    ClusterSocket::close(_listenFd, _addresses[_shard]);
+    _listenFd = -1;
+
+    std::vector<std::thread> servers;
+    {
+        std::lock_guard<std::mutex> lock(_servingMutex);
+        for (int fd : _serverFds) shutdown(fd, SHUT_RDWR);
+        servers.swap(_servers);
+    }
+    for (std::thread &server : servers) server.join();
+    for (int fd : _serverFds) ::close(fd);
+    _serverFds.clear();
+#endif
+}
+
+bool ShardedTable::probeLocal(uint64_t key, SharedEntry &entry)
+{
+    size_t index = key & _tableMask & ~(size_t)1;
+    std::lock_guard<std::mutex> lock(_locks[(index >> 1) % LOCKS]);
+    for (int i = 0; i < 2; i++) {
+        if (_table[index + i].key == key && _table[index + i].bound != SharedEntry::BOUND_NONE) {
+            entry = _table[index + i];
+            return true;
+        }
+    }
+    return false;
+}
+
+void ShardedTable::storeLocal(const SharedEntry &entry)
+{
+    size_t index = entry.key & _tableMask & ~(size_t)1;
+    std::lock_guard<std::mutex> lock(_locks[(index >> 1) % LOCKS]);
+    SharedEntry *bucket = &_table[index];
+    SharedEntry *slot = &bucket[1];
+    if (bucket[0].key == entry.key || bucket[0].bound == SharedEntry::BOUND_NONE || entry.depth >= bucket[0].depth ||
+        (entry.solved && !bucket[0].solved)) {
+        slot = &bucket[0];
+    }
+    if (slot->key == entry.key && (slot->depth > entry.depth || slot->solved) && !entry.solved &&
+        entry.bound != SharedEntry::BOUND_EXACT) {
+        return;
+    }
+    *slot = entry;
+}
+
+bool ShardedTable::probe(uint64_t key, SharedEntry &entry)
+{
+    _stats.probes++;
+    int target = owner(key, shards());
+    bool found;
+    if (target == _shard) {
+        found = probeLocal(key, entry);
+    } else {
+        _stats.remoteProbes++;
+        int fd = _peers[target];
+        struct { Header header; uint64_t key; } request = { { PROBE, 1 }, key };
+        found = fd >= 0 && ClusterSocket::sendAll(fd, &request, sizeof(request)) &&
+                ClusterSocket::receiveAll(fd, &entry, sizeof(entry)) && entry.key == key;
+    }
+    if (found) _stats.hits++;
+    return found;
+}
+
+void ShardedTable::store(const SharedEntry &entry)
+{
+    _stats.stores++;
+    int target = owner(entry.key, shards());
+    if (target == _shard) {
+        storeLocal(entry);
+        return;
+    }
+    _stats.remoteStores++;
+    _outgoing[target].push_back(entry);
+    if ((int)_outgoing[target].size() >= STORE_BATCH) sendStores(target);
+}
+
+void ShardedTable::sendStores(int shard)
+{
+    std::vector<SharedEntry> &entries = _outgoing[shard];
+    if (entries.empty()) return;
+    Header header = { STORE, (uint32_t)entries.size() };
+    // a shard that has gone away just misses them
+    if (_peers[shard] >= 0 && ClusterSocket::sendAll(_peers[shard], &header, sizeof(header))) {
+        ClusterSocket::sendAll(_peers[shard], entries.data(), entries.size() * sizeof(SharedEntry));
+    }
+    entries.clear();
+}
+
+void ShardedTable::flush()
+{
+    for (int i = 0; i < shards(); i++) sendStores(i);
+}
+
+ShardedTableStats ShardedTable::stats() const
+{
+    ShardedTableStats stats = _stats;
+    stats.served = _served;
+    return stats;
+}
+
+void ShardedTable::acceptLoop()
+{
+#ifndef _WIN32
+    while (_running) {
+        pollfd listener{ _listenFd, POLLIN, 0 };
+        if (poll(&listener, 1, 100) <= 0) continue;
+        int fd = accept(_listenFd, nullptr, nullptr);
+        if (fd < 0) continue;
+        if (isTcp(_addresses[_shard])) {
+            int on = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        }
+        std::lock_guard<std::mutex> lock(_servingMutex);
+        _serverFds.push_back(fd);
+        _servers.emplace_back(&ShardedTable::serve, this, fd);
+    }
+#endif
+}
+
+// answers one peer until it hangs up
+void ShardedTable::serve(int fd)
+{
+    std::vector<uint64_t> keys;
+    std::vector<SharedEntry> entries;
+    Header header;
+    while (ClusterSocket::receiveAll(fd, &header, sizeof(header)) && header.count <= MAX_COUNT) {
+        _served++;
+        if (header.type == PROBE) {
+            keys.resize(header.count);
+            entries.assign(header.count, SharedEntry());
+            if (!ClusterSocket::receiveAll(fd, keys.data(), keys.size() * sizeof(uint64_t))) break;
+            for (size_t i = 0; i < keys.size(); i++) {
+                if (!probeLocal(keys[i], entries[i])) entries[i].key = 0;
+            }
+            if (!ClusterSocket::sendAll(fd, entries.data(), entries.size() * sizeof(SharedEntry))) break;
+        } else if (header.type == STORE) {
+            entries.resize(header.count);
+            if (!ClusterSocket::receiveAll(fd, entries.data(), entries.size() * sizeof(SharedEntry))) break;
+            for (const SharedEntry &entry : entries) storeLocal(entry);
+        } else {
+            break;
+        }
+    }
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//
+// a transposition table entry as it travels between processes. the score is relative to the node
+// like the engine's own entries, and the move an index into the position's generated moves,
+// so an entry means the same in any process searching the same game
+//
+struct SharedEntry
+{
+    enum : uint8_t { BOUND_NONE, BOUND_UPPER, BOUND_LOWER, BOUND_EXACT };
+
+    uint64_t    key = 0;
+    int16_t     score = 0;
+    uint8_t     depth = 0;
+    uint8_t     bound = BOUND_NONE;
+    uint8_t     move = 255;         // 255 for none
+    uint8_t     solved = 0;
+    uint8_t     reserved[2] = {};
+};
+
+static_assert(sizeof(SharedEntry) == 16, "SharedEntry is a wire format");
+
+//
+// a table a SearchEngine shares with other searches, see SearchEngine::setSharedTable
+//
+class SharedTable
+{
+public:
+    virtual ~SharedTable() = default;
+
+    virtual bool    probe(uint64_t key, SharedEntry &entry) = 0;
+    virtual void    store(const SharedEntry &entry) = 0;
+};
+
+//
+// stream sockets named by address: "unix:/path/to/socket" or "tcp:host:port". on Windows every call fails
+//
+namespace ClusterSocket
+{
+    // a listening socket, -1 with error set when it can't be made
+    int         listenOn(const std::string &address, std::string &error);
+    // keeps trying for timeoutMs while nothing listens there yet
+    int         connectTo(const std::string &address, int timeoutMs, std::string &error);
+    void        close(int fd, const std::string &listenAddress = "");
+
+    bool        sendAll(int fd, const void *data, size_t size);
+    bool        receiveAll(int fd, void *data, size_t size);
+}
+
+struct ShardedTableStats
+{
+    uint64_t    probes = 0;
+    uint64_t    remoteProbes = 0;       // probes that took a round trip to another shard
+    uint64_t    hits = 0;
+    uint64_t    stores = 0;
+    uint64_t    remoteStores = 0;
+    uint64_t    served = 0;             // requests from other shards answered by this one
+};
+
+//
+// a transposition table partitioned by hash across processes. every process owns the entries whose
+// key maps to its shard and answers the others' probes and stores for them on a thread per peer;
+// its own search probes them in memory. a probe of another shard's entry is a round trip, stores
+// to a shard are collected and sent STORE_BATCH at a time. used by one search thread per process
+// messages are a 8 byte header (type, count) and count keys or entries:
+//   PROBE keys         -> count entries, key 0 for a miss
+//   STORE entries      no answer
+//
+class ShardedTable : public SharedTable
+{
+public:
+    static constexpr int STORE_BATCH = 256;
+    static constexpr int CONNECT_TIMEOUT_MS = 10000;
+
+    // shard is this process's index into addresses, one address per shard
+    ShardedTable(int shard, const std::vector<std::string> &addresses, size_t bytes);
+    ~ShardedTable();
+
+    ShardedTable(const ShardedTable &) = delete;
+    ShardedTable &operator=(const ShardedTable &) = delete;
+
+    // serves this shard at its address, then connects to every other shard, waiting for the ones
+    // that aren't up yet. false with error set when either fails
+    bool            start(std::string &error);
+    void            stop();
+
+    bool            probe(uint64_t key, SharedEntry &entry) override;
+    void            store(const SharedEntry &entry) override;
+    // sends the stores still collected
+    void            flush();
+
+    static int      owner(uint64_t key, int shards) { return (int)((key >> 40) % (uint64_t)shards); }
+    int             shard() const { return _shard; }
+    int             shards() const { return (int)_addresses.size(); }
+    ShardedTableStats stats() const;
+
+private:
+    enum MessageType : uint32_t { PROBE = 1, STORE = 2 };
+
+    struct Header
+    {
+        uint32_t    type;
+        uint32_t    count;
+    };
+
+    static constexpr int LOCKS = 64;
+
+    bool            probeLocal(uint64_t key, SharedEntry &entry);
+    void            storeLocal(const SharedEntry &entry);
+    void            sendStores(int shard);
+    void            acceptLoop();
+    void            serve(int fd);
+
+    int                 _shard;
+    std::vector<std::string> _addresses;
+
+    // this shard's entries in two entry buckets, the first keeps the deepest, the second the newest
+    std::vector<SharedEntry> _table;
+    size_t              _tableMask;
+    std::mutex          _locks[LOCKS];
+
+    std::vector<int>    _peers;                 // a connection to every other shard, -1 for this one
+    std::vector<std::vector<SharedEntry>> _outgoing;
+
+    int                 _listenFd;
+    std::atomic<bool>   _running;
+    std::thread         _acceptThread;
+    std::mutex          _servingMutex;
+    std::vector<std::thread> _servers;
+    std::vector<int>    _serverFds;
+
+    ShardedTableStats   _stats;
+    std::atomic<uint64_t> _served;
+};
@@ -0,0 +1,201 @@
+#include "Simul.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    const float THUMBNAIL_SIZE = 150.0f;
+}
+
+Simul::Simul(const std::string &name, GameFactory factory, int boards, int moveTimeMs, int workers)
+    : _name(name),
+      _focused(0),
+      _moveTimeMs(std::max(1, moveTimeMs)),
+      _scheduler(workers > 0 ? workers : std::max(1, (int)std::thread::hardware_concurrency()), std::max(1, moveTimeMs))
+{
+    _boards.resize(std::max(1, boards));
+    for (Board &board : _boards) {
+        board.game = factory();
+        board.game->setUpBoard();
+        board.game->setAIPlayer(AI_PLAYER);
+    }
+}
+
+Simul::~Simul()
+{
+    _scheduler.shutdown();
+    for (Board &board : _boards) {
+        board.game->stopGame();
+        delete board.game;
+    }
+}
+
+void Simul::update()
+{
+    applyFinishedMoves();
+    for (int i = 0; i < (int)_boards.size(); i++) {
+        Board &board = _boards[i];
+        updateResult(board);
+        if (!board.over && !board.session && board.game->getCurrentPlayer()->isAIPlayer()) {
+            startSearch(i);
+        }
+    }
+}
+
+//
+// the search gets a headless copy of the position, the board itself stays with the UI thread
+//
+void Simul::startSearch(int index)
+{
+    Board &board = _boards[index];
+    std::unique_ptr<ProtocolGame> position = board.game->aiPosition();
+    if (!position) {
+        // no headless position for this game, think on the UI thread instead
+        board.game->updateAI();
+        return;
+    }
+
+    auto session = std::make_shared<GameSession>();
+    session->id = (uint64_t)index;
+    session->game = std::move(position);
+
+    ProtocolLimits limits;
+    limits.timeMs = _moveTimeMs;
+    bool queued = _scheduler.submit(session, limits, [this, index](GameSession &, const SearchOutcome &outcome) {
+        std::lock_guard<std::mutex> lock(_finishedMutex);
+        _finished.push_back({ index, outcome.bestMove });
+    });
+    if (queued) board.session = session;
+}
+
+void Simul::applyFinishedMoves()
+{
+    std::vector<AIMove> finished;
+    {
+        std::lock_guard<std::mutex> lock(_finishedMutex);
+        finished.swap(_finished);
+    }
+
+    for (const AIMove &found : finished) {
+        Board &board = _boards[found.board];
+        board.session.reset();
+        if (found.move.empty() || board.over) continue;
+        if (board.game->applyAIMove(found.move)) {
+            board.aiMoves++;
+        } else {
+            Logger::GetInstance().Error("simul board " + std::to_string(found.board + 1) + ": can't play " + found.move);
+            board.game->updateAI();
+        }
+    }
+}
+
+void Simul::updateResult(Board &board)
+{
+    if (board.over) return;
+    Player *winner = board.game->checkForWinner();
+    if (winner) {
+        board.over = true;
+        board.winner = winner->playerNumber();
+    } else if (board.game->checkForDraw()) {
+        board.over = true;
+        board.winner = -1;
+    }
+}
+
+void Simul::focusNextWaitingBoard()
+{
+    int count = (int)_boards.size();
+    for (int step = 1; step <= count; step++) {
+        int index = (_focused + step) % count;
+        const Board &board = _boards[index];
+        if (!board.over && !board.session && !board.game->getCurrentPlayer()->isAIPlayer()) {
+            _focused = index;
+            return;
+        }
+    }
+}
+
+void Simul::drawSettings()
+{
+    int waiting = 0, thinking = 0, humanWins = 0, aiWins = 0, draws = 0;
+    for (const Board &board : _boards) {
+        if (board.over) {
+            if (board.winner < 0) draws++;
+            else if (board.winner == AI_PLAYER) aiWins++;
+            else humanWins++;
+        } else if (board.session) {
+            thinking++;
+        } else {
+            waiting++;
+        }
+    }
+
+    ImGui::Text("Simul: %s on %d boards", _name.c_str(), (int)_boards.size());
+    ImGui::Text("Your move on %d, AI thinking on %d", waiting, thinking);
+    ImGui::Text("Won %d, lost %d, drawn %d", humanWins, aiWins, draws);
+
+    SchedulerStats stats = _scheduler.stats();
+    ImGui::Text("AI: %llu moves, p50 %.0f ms, p99 %.0f ms, %llu late", (unsigned long long)stats.completed,
+                stats.p50Us / 1000.0, stats.p99Us / 1000.0, (unsigned long long)stats.missedDeadlines);
+
+    ImGui::Text("Board %d: %s", _focused + 1, _boards[_focused].game->stateString().c_str());
+    if (ImGui::Button("Next Waiting Board")) focusNextWaitingBoard();
+}
+
+void Simul::drawThumbnails()
+{
+    float spacing = ImGui::GetStyle().ItemSpacing.x;
+    int columns = std::max(1, (int)((ImGui::GetContentRegionAvail().x + spacing) / (THUMBNAIL_SIZE + spacing)));
+    for (int i = 0; i < (int)_boards.size(); i++) {
+        if (i % columns != 0) ImGui::SameLine();
+        drawThumbnail(i, THUMBNAIL_SIZE);
+    }
+}
+
+void Simul::drawFocusedBoard()
+{
+    _boards[_focused].game->drawFrame();
+}
+
+//
+// a small board drawn straight from the grid with the draw list, click to play on it
+//
+void Simul::drawThumbnail(int index, float size)
+{
+    Board &board = _boards[index];
+    Grid *grid = board.game->getGrid();
+    int width = grid->getWidth();
+    int height = grid->getHeight();
+    float cell = std::floor(size / std::max(width, height));
+    ImVec2 boardSize(cell * width, cell * height);
+
+    ImGui::BeginGroup();
+    ImGui::PushID(index);
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    if (ImGui::InvisibleButton("board", boardSize)) _focused = index;
+    ImGui::PopID();
+
+    ImDrawList *drawList = ImGui::GetWindowDrawList();
+    grid->forEachSquare([&](ChessSquare *square, int x, int y) {
+        ImVec2 topLeft(origin.x + x * cell, origin.y + y * cell);
+        ImVec2 bottomRight(topLeft.x + cell, topLeft.y + cell);
+        ImU32 color = !grid->isEnabled(x, y) ? IM_COL32(60, 60, 60, 255)
+                    : (x + y) % 2 ? IM_COL32(120, 120, 120, 255) : IM_COL32(170, 170, 170, 255);
+        drawList->AddRectFilled(topLeft, bottomRight, color);
+
+        Bit *bit = square->bit();
+        if (bit && bit->getOwner()) {
+            ImU32 piece = bit->getOwner()->playerNumber() == 0 ? IM_COL32(240, 220, 90, 255) : IM_COL32(200, 50, 50, 255);
+            drawList->AddCircleFilled(ImVec2(topLeft.x + cell / 2, topLeft.y + cell / 2), cell * 0.38f, piece);
+        }
+    });
+
+    ImU32 border = index == _focused ? IM_COL32(255, 255, 0, 255) : board.session ? IM_COL32(80, 140, 255, 255) : IM_COL32(30, 30, 30, 255);
+    drawList->AddRect(origin, ImVec2(origin.x + boardSize.x, origin.y + boardSize.y), border, 0.0f, 0, index == _focused ? 3.0f : 1.0f);
+
+    const char *status = "your move";
+    if (board.over) status = board.winner < 0 ? "draw" : board.winner == AI_PLAYER ? "AI won" : "you won";
+    else if (board.session) status = "thinking";
+    else if (board.game->getCurrentPlayer()->isAIPlayer()) status = "AI to move";
+    ImGui::Text("%d: %s", index + 1, status);
+    ImGui::EndGroup();
+}
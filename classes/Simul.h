@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Game.h"
+#include "SearchScheduler.h"
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//
+// a simultaneous exhibition: one AI against the human on many independent boards
+// every board is drawn as a thumbnail, the focused one full size and playable. the AI searches on
+// headless copies of the positions in a shared SearchScheduler, so the boards keep responding while
+// it thinks. a board's deadline is moveTimeMs after the human moved on it, the earliest goes first
+// and a board that waited too long in the queue gets what time is left
+//
+class Simul
+{
+public:
+    using GameFactory = std::function<Game*()>;
+
+    Simul(const std::string &name, GameFactory factory, int boards, int moveTimeMs, int workers = 0);
+    ~Simul();
+
+    // once a frame from RenderGame: plays the AI moves that came in and starts the searches due
+    void        update();
+
+    void        drawSettings();
+    void        drawThumbnails();
+    void        drawFocusedBoard();
+
+    const std::string& name() const { return _name; }
+
+private:
+    struct Board
+    {
+        Game*               game = nullptr;
+        std::shared_ptr<GameSession> session;   // the position the AI is searching, null when idle
+        bool                over = false;
+        int                 winner = -1;
+        int                 aiMoves = 0;
+    };
+
+    struct AIMove
+    {
+        int             board;
+        std::string     move;
+    };
+
+    void        startSearch(int index);
+    void        applyFinishedMoves();
+    void        updateResult(Board &board);
+    void        drawThumbnail(int index, float size);
+    void        focusNextWaitingBoard();
+
+    std::string         _name;
+    std::vector<Board>  _boards;
+    int                 _focused;
+    int                 _moveTimeMs;
+
+    // moves found by the workers, picked up by the UI thread on the next frame
+    std::mutex          _finishedMutex;
+    std::vector<AIMove> _finished;
+
+    // last so the workers are gone before anything they report to
+    SearchScheduler     _scheduler;
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "Bitboard.h"
+#include <algorithm>
+#include <concepts>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+//
+// the symmetries of a game, for keys that are the same for every position in a symmetry class
+// Symmetry<P> is specialized next to a position type with
+//   static constexpr int COUNT                             number of transforms, 0 the identity
+//   static P apply(const P &, int symmetry)                an equivalent position, the same result for its side to move
+//   static Move applyMove(const Move &, int symmetry)      a move of the position as the same move in the transformed one
+//   static constexpr int inverse(int symmetry)
+// a transform may swap the colours, so the side to move of the transformed position can differ
+//
+template <class P>
+struct Symmetry;
+
+template <class P>
+concept SymmetricPosition = requires(const P &position, const typename P::Move &move, int symmetry) {
+    { Symmetry<P>::COUNT } -> std::convertible_to<int>;
+    { Symmetry<P>::apply(position, symmetry) } -> std::same_as<P>;
+    { Symmetry<P>::applyMove(move, symmetry) } -> std::same_as<typename P::Move>;
+    { Symmetry<P>::inverse(symmetry) } -> std::convertible_to<int>;
+    { position.hash() } -> std::same_as<uint64_t>;
+};
+
+//
+// the symmetric form with the lowest hash, and the transform that takes the position there
+//
+template <class P>
+struct Canonical
+{
+    P           position;
+    int         symmetry;
+};
+
+template <SymmetricPosition P>
+Canonical<P> canonicalize(const P &position)
+{
+    Canonical<P> best = { position, 0 };
+    uint64_t bestKey = position.hash();
+    for (int symmetry = 1; symmetry < Symmetry<P>::COUNT; symmetry++) {
+        P transformed = Symmetry<P>::apply(position, symmetry);
+        uint64_t key = transformed.hash();
+        if (key < bestKey) {
+            bestKey = key;
+            best = { transformed, symmetry };
+        }
+    }
+    return best;
+}
+
+// the canonical form's hash, just the hash for positions without symmetries
+template <class P>
+uint64_t canonicalKey(const P &position)
+{
+    if constexpr (SymmetricPosition<P>) {
+        uint64_t key = position.hash();
+        for (int symmetry = 1; symmetry < Symmetry<P>::COUNT; symmetry++) {
+            key = std::min(key, Symmetry<P>::apply(position, symmetry).hash());
+        }
+        return key;
+    } else {
+        return position.hash();
+    }
+}
+
+// a move of the position as a move of its canonical form, and back
+template <SymmetricPosition P>
+typename P::Move toCanonical(const typename P::Move &move, int symmetry)
+{
+    return Symmetry<P>::applyMove(move, symmetry);
+}
+
+template <SymmetricPosition P>
+typename P::Move fromCanonical(const typename P::Move &move, int symmetry)
+{
+    return Symmetry<P>::applyMove(move, Symmetry<P>::inverse(symmetry));
+}
+
+//
+// the 8 symmetries of a square N x N board with square = y * N + x
+// bit 2 of a symmetry transposes, then bit 0 mirrors x and bit 1 mirrors y
+//
+namespace SquareSymmetry
+{
+    constexpr int COUNT = 8;
+
+    constexpr int square(int index, int symmetry, int n)
+    {
+        int x = index % n, y = index / n;
+        if (symmetry & 4) std::swap(x, y);
+        if (symmetry & 1) x = n - 1 - x;
+        if (symmetry & 2) y = n - 1 - y;
+        return y * n + x;
+    }
+
+    constexpr int inverse(int symmetry)
+    {
+        for (int candidate = 0; candidate < COUNT; candidate++) {
+            bool undoes = true;
+            for (int index = 0; index < 9; index++) undoes = undoes && square(square(index, symmetry, 3), candidate, 3) == index;
+            if (undoes) return candidate;
+        }
+        return 0;
+    }
+
+    // 8x8 masks by delta swaps, other sizes a square at a time
+    template <class Mask>
+    constexpr Mask mask(Mask m, int symmetry, int n)
+    {
+        if constexpr (std::is_same_v<Mask, uint64_t>) {
+            if (n == 8) {
+                if (symmetry & 4) m = Bitboard::transpose(m);
+                if (symmetry & 1) m = Bitboard::mirrorHorizontal(m);
+                if (symmetry & 2) m = Bitboard::flipVertical(m);
+                return m;
+            }
+        }
+        Mask result = Mask(0);
+        while (m) result |= Bitboard::bit<Mask>(square(Bitboard::popLowestBit(m), symmetry, n));
+        return result;
+    }
+}
@@ -0,0 +1,146 @@
+#include "TableCache.h"
+#include "JobSystem.h"
+#include "MappedFile.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+uint64_t TableCacheFile::checksum(const uint8_t *bytes, size_t size)
+{
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+TableCache::TableCache(const std::string &path, const char *game, size_t entrySize, uint64_t signature)
+{
+    _path = path;
+    memset(_game, 0, sizeof(_game));
+    strncpy(_game, game, sizeof(_game) - 1);
+    _entrySize = entrySize;
+    _signature = signature;
+    _loading = false;
+    _loadDone = true;
+    _hasPending = false;
+    _writing = false;
+    _failed = false;
+}
+
+TableCache::~TableCache()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _idle.wait(lock, [this] { return _loadDone && !_writing; });
+}
+
+void TableCache::load()
+{
+    if (_loading) return;
+    _loading = true;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _loadDone = false;
+    }
+    JobSystem::instance().submit([this] {
+        std::vector<uint8_t> entries = read();
+        std::lock_guard<std::mutex> lock(_mutex);
+        _loaded.swap(entries);
+        _loadDone = true;
+        _idle.notify_all();
+    }, JobPriority::LOW);
+}
+
+bool TableCache::takeLoaded(std::vector<uint8_t> &entries)
+{
+    if (!_loading) return false;
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_loadDone) return false;
+    entries.swap(_loaded);
+    _loaded.clear();
+    _loading = false;
+    return true;
+}
+
+std::vector<uint8_t> TableCache::read() const
+{
+    MappedFile file;
+    if (!file.open(_path) || file.size() < sizeof(TableCacheFile::Header)) return {};
+
+    TableCacheFile::Header header;
+    memcpy(&header, file.data(), sizeof(header));
+    size_t bytes = file.size() - sizeof(header);
+    if (header.magic != TableCacheFile::MAGIC || header.version != TableCacheFile::VERSION ||
+        memcmp(header.game, _game, sizeof(_game)) != 0 || header.entrySize != _entrySize ||
+        header.signature != _signature || header.entryCount * _entrySize != bytes) {
+        return {};
+    }
+    const uint8_t *entries = file.data() + sizeof(header);
+    if (TableCacheFile::checksum(entries, bytes) != header.checksum) return {};
+    return std::vector<uint8_t>(entries, entries + bytes);
+}
+
+void TableCache::save(const uint8_t *entries, size_t bytes)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _pending.assign(entries, entries + bytes);
+    _hasPending = true;
+    if (_writing) return;
+    _writing = true;
+    lock.unlock();
+    JobSystem::instance().submit([this] { writePending(); }, JobPriority::LOW);
+}
+
+bool TableCache::flush()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _idle.wait(lock, [this] { return !_writing; });
+    return !_failed;
+}
+
+bool TableCache::write(const std::vector<uint8_t> &entries) const
+{
+    std::error_code error;
+    std::filesystem::path target(_path);
+    if (target.has_parent_path()) std::filesystem::create_directories(target.parent_path(), error);
+
+    TableCacheFile::Header header = {};
+    header.magic = TableCacheFile::MAGIC;
+    header.version = TableCacheFile::VERSION;
+    memcpy(header.game, _game, sizeof(_game));
+    header.entrySize = (uint32_t)_entrySize;
+    header.entryCount = entries.size() / _entrySize;
+    header.signature = _signature;
+    header.checksum = TableCacheFile::checksum(entries.data(), entries.size());
+
+    std::string temporary = _path + ".tmp";
+    FILE *file = fopen(temporary.c_str(), "wb");
+    if (!file) return false;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(entries.data(), 1, entries.size(), file) == entries.size();
+    ok = fclose(file) == 0 && ok;
+    if (ok) std::filesystem::rename(temporary, target, error);
+    if (!ok || error) {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
+
+// the write job, it keeps going while saves come in faster than it writes
+void TableCache::writePending()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (_hasPending) {
+        std::vector<uint8_t> entries;
+        entries.swap(_pending);
+        _hasPending = false;
+        lock.unlock();
+        bool ok = write(entries);
+        lock.lock();
+        _failed = _failed || !ok;
+    }
+    _writing = false;
+    _idle.notify_all();
+}
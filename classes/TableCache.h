@@ -0,0 +1,80 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//
+// a transposition table kept in a file between sessions, the bytes of the entries behind a header that
+// says whose they are. reading and writing both happen in low priority jobs (JobSystem.h): load() maps
+// and checks the file in the background, save() copies the entries and a job puts them in a temporary
+// file that is renamed over the old one, so a crash mid-write leaves the previous cache in place
+// a file of another version, game, entry size or signature, or with a bad checksum, is ignored
+//
+namespace TableCacheFile
+{
+    constexpr uint32_t MAGIC = 0x31435454;      // "TTC1"
+    constexpr uint32_t VERSION = 1;
+
+    struct Header
+    {
+        uint32_t    magic;
+        uint32_t    version;
+        char        game[16];
+        uint32_t    entrySize;
+        uint32_t    reserved;
+        uint64_t    entryCount;
+        uint64_t    signature;      // what the scores depend on besides the rules, e.g. the evaluation weights
+        uint64_t    checksum;       // FNV-1a of the entries
+    };
+
+    uint64_t    checksum(const uint8_t *bytes, size_t size);
+}
+
+class TableCache
+{
+public:
+    TableCache(const std::string &path, const char *game, size_t entrySize, uint64_t signature);
+    // waits for the read and for the last entries saved to be written
+    ~TableCache();
+
+    TableCache(const TableCache &) = delete;
+    TableCache &operator=(const TableCache &) = delete;
+
+    const std::string& path() const { return _path; }
+
+    // starts reading the file in a background job
+    void            load();
+    // true once the read has finished, entries then holds what it found, empty for no usable file
+    // the entries are handed over once, later calls return false
+    bool            takeLoaded(std::vector<uint8_t> &entries);
+    bool            loading() const { return _loading; }
+
+    // queues a copy of the entries for writing, replacing any still waiting
+    void            save(const uint8_t *entries, size_t bytes);
+    // blocks until everything saved so far is on disk, false when a write failed
+    bool            flush();
+
+private:
+    std::vector<uint8_t> read() const;
+    bool            write(const std::vector<uint8_t> &entries) const;
+    void            writePending();
+
+    std::string     _path;
+    char            _game[16];
+    size_t          _entrySize;
+    uint64_t        _signature;
+
+    bool            _loading;           // a read was started and its entries not taken yet
+
+    std::mutex      _mutex;
+    std::condition_variable _idle;
+    std::vector<uint8_t> _loaded;
+    bool            _loadDone;
+    std::vector<uint8_t> _pending;
+    bool            _hasPending;
+    bool            _writing;           // a write job is queued or running
+    bool            _failed;
+};
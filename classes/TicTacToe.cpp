@@ -30,6 +30,7 @@ void TicTacToe::setUpBoard()
     _gameOptions.rowX = 3;
     _gameOptions.rowY = 3;
     _grid->initializeSquares(80, "square.png");
+    updateTableCache(false);
 
     if (gameHasAI()) {
         setAIPlayer(AI_PLAYER);
@@ -149,99 +150,93 @@ void TicTacToe::setStateString(const std::string &s)
     _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
         int index = y*3 + x;
         int playerNumber = s[index] - '0';
+        square->destroyBit();
         if (playerNumber) {
-            square->setBit( PieceForPlayer(playerNumber-1) );
-        } else {
-            square->setBit( nullptr );
+            Bit *bit = PieceForPlayer(playerNumber-1);
+            bit->setPosition(square->getPosition());
+            square->setBit(bit);
         }
     });
 }
 
-
 //
-// this is the function that will be called by the AI
+// read straight off the grid, no state string in between
 //
-void TicTacToe::updateAI() 
+TicTacToeBoard TicTacToe::position()
 {
-    int bestVal = -1000;
-    BitHolder* bestMove = nullptr;
-    std::string state = stateString();
-
-    // Traverse all cells, evaluate minimax function for all empty cells
+    TicTacToeBoard board;
     _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
-        int index = y * 3 + x;
-        // Check if cell is empty
-        if (state[index] == '0') {
-            // Make the move
-            state[index] = '2';
-            int moveVal = -negamax(state, 0, HUMAN_PLAYER);
-            // Undo the move
-            state[index] = '0';
-            // If the value of the current move is more than the best value, update best
-            if (moveVal > bestVal) {
-                bestMove = square;
-                bestVal = moveVal;
-            }
+        Bit *bit = square->bit();
+        if (bit) {
+            board.marks[bit->getOwner()->playerNumber()] |= (uint16_t)(1 << (y * 3 + x));
         }
     });
-
-
-    // Make the best move
-    if(bestMove) {
-        if (actionForEmptyHolder(*bestMove)) {
-        }
-    }
+    board.side = getCurrentPlayer()->playerNumber();
+    return board;
 }
 
-bool isAIBoardFull(const std::string& state) {
-    return state.find('0') == std::string::npos;
+void TicTacToe::setPosition(const TicTacToeBoard &position)
+{
+    setStateString(position.toString());
+    setSideToMove(position.side);
 }
 
-int evaluateAIBoard(const std::string& state) {
-    static const int kWinningTriples[8][3] =  { {0,1,2}, {3,4,5}, {6,7,8},  // rows
-                                                {0,3,6}, {1,4,7}, {2,5,8},  // cols
-                                                {0,4,8}, {2,4,6} };         // diagonals
-    for( int i=0; i<8; i++ ) {
-        const int *triple = kWinningTriples[i];
-        char first = state[triple[0]];
-        if( first != '0' && first == state[triple[1]] && first == state[triple[2]] ) {
-            return 10;   // someone won, negamax will handle who
-        }
-    }
-    return 0; // No winner
-}
 
 //
-// player is the current player's number (AI or human)
+// the search's table in cache/, so the solved positions are still known next session
 //
-int TicTacToe::negamax(std::string& state, int depth, int playerColor) 
+void TicTacToe::updateTableCache(bool save)
 {
-    int score = evaluateAIBoard(state);
-
-    // Check if AI wins, human wins, or draw
-    if(score) { 
-        // A winning state is a loss for the player whose turn it is.
-        // The previous player made the winning move.
-        return -score; 
-    }
-
-    if(isAIBoardFull(state)) {
-        return 0; // Draw
+    if (!_gameOptions.AIPersistentCache) {
+        _engine.closeCache();
+        return;
     }
+    _engine.openCache(TABLE_CACHE, "tictactoe");
+    if (save) _engine.saveCache();
+}
 
-    int bestVal = -1000; // Min value
-    for (int y = 0; y < 3; y++) {
-        for (int x = 0; x < 3; x++) {
-            // Check if cell is empty
-            if (state[y * 3 + x] == '0') {
-                // Make the move
-                state[y * 3 + x] = playerColor == HUMAN_PLAYER ? '1' : '2'; // Set the cell to the current player's color
-                bestVal = std::max(bestVal, -negamax(state, depth + 1, -playerColor));
-                // Undo the move for backtracking
-                state[y * 3 + x] = '0';
-            }
+//
+// this is the function that will be called by the AI
+// tic tac toe is searched to the end every move, so the AI never loses
+//
+void TicTacToe::updateAI() 
+{
+    int move;
+    if (_gameOptions.AIUseMCTS) {
+        // playouts for a slice of the frame, the node budget means nothing to them
+        TicTacToeBoard board = position();
+        if (!_mcts.searching() || _mcts.searchRoot().hash() != board.hash()) {
+            MctsLimits limits;
+            limits.playouts = MCTS_PLAYOUTS;
+            _mcts.start(board, limits);
         }
+        if (!_mcts.advance(0, _gameOptions.AIFrameBudgetUs)) return;
+        const MctsEngine<TicTacToeTraits>::Result &result = _mcts.result();
+        if (!result.hasMove) return;
+        move = result.bestMove;
+    } else {
+        // searched a slice a frame like the bigger games, though it rarely needs more than one
+        TicTacToeBoard board = position();
+        if (!_engine.searching() || _engine.searchRoot().hash() != board.hash()) _engine.start(board, SearchLimits());
+        if (!_engine.advance(_gameOptions.AIFrameNodes, _gameOptions.AIFrameBudgetUs)) return;
+        const SearchEngine<TicTacToeTraits>::Result &result = _engine.result();
+        updateTableCache(true);
+        if (!result.hasMove) return;
+        move = result.bestMove;
     }
+    actionForEmptyHolder(*_grid->getSquare(move % 3, move / 3));
+}
+
+std::unique_ptr<ProtocolGame> TicTacToe::aiPosition()
+{
+    TicTacToeBoard board = position();
+    std::unique_ptr<ProtocolGame> game = ProtocolGame::create("tictactoe");
+    if (!game->setState(board.toString(), board.side)) return nullptr;
+    return game;
+}
 
-    return bestVal;
-}
\ No newline at end of file
+bool TicTacToe::applyAIMove(const std::string &move)
+{
+    ChessSquare *square = squareForMove(move);
+    return square && actionForEmptyHolder(*square);
+}
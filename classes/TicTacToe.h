@@ -1,5 +1,8 @@
 #pragma once
 #include "Game.h"
+#include "Mcts.h"
+#include "Search.h"
+#include "TicTacToeBoard.h"
 
 //
 // the classic game of tic tac toe
@@ -29,12 +32,28 @@ public:
 
 	void        updateAI() override;
     bool        gameHasAI() override { return true; }
+    bool        gameHasMCTS() override { return true; }
+    bool        gameHasPersistentCache() override { return true; }
+    bool        gameHasSlicedSearch() override { return true; }
+    std::unique_ptr<ProtocolGame> aiPosition() override;
+    bool        applyAIMove(const std::string &move) override;
     Grid* getGrid() override { return _grid; }
+
+    // the board as a GamePosition and back
+    TicTacToeBoard position();
+    void        setPosition(const TicTacToeBoard &position);
 private:
     Bit *       PieceForPlayer(const int playerNumber);
     Player*     ownerAt(int index ) const;
-    int         negamax(std::string& state, int depth, int playerColor);
+    void        updateTableCache(bool save);
+
+    // playouts per MCTS move, enough to never miss a win or a block
+    static const int MCTS_PLAYOUTS = 20000;
+    static constexpr const char *TABLE_CACHE = "cache/tictactoe.tt";
 
     Grid*       _grid;
+    // the whole game fits in a small table
+    SearchEngine<TicTacToeTraits> _engine{ 64 * 1024 };
+    MctsEngine<TicTacToeTraits> _mcts{ { MctsOptions::UCT, 1.0f, 1, 1 << 16, true } };
 };
 
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "Bitboard.h"
+#include "Position.h"
+#include "Symmetry.h"
+#include <string>
+
+//
+// bitboard core for tic tac toe, square index is y * 3 + x like TicTacToe::stateString()
+// player 0 ('1' in state strings) moves first. a GamePosition with the square index as the move
+//
+struct TicTacToeBoard
+{
+    using Move = int;
+    using Undo = NoUndo;
+
+    static constexpr int SIZE = 3;
+    static constexpr int SQUARES = SIZE * SIZE;
+    static constexpr int MAX_MOVES = SQUARES;
+    static constexpr uint16_t FULL = 0x1FF;
+    static constexpr uint16_t LINES[8] = { 0x007, 0x038, 0x1C0,     // rows
+                                           0x049, 0x092, 0x124,     // columns
+                                           0x111, 0x054 };          // diagonals
+
+    uint16_t    marks[2] = { 0, 0 };
+    int         side = 0;
+
+    static constexpr TicTacToeBoard initial() { return TicTacToeBoard(); }
+
+    constexpr uint16_t occupied() const { return marks[0] | marks[1]; }
+    constexpr uint16_t legalMoves() const { return isWon(0) || isWon(1) ? 0 : (uint16_t)(~occupied() & FULL); }
+
+    constexpr bool isWon(int player) const
+    {
+        for (uint16_t line : LINES) {
+            if ((marks[player] & line) == line) return true;
+        }
+        return false;
+    }
+
+    constexpr bool isFull() const { return occupied() == FULL; }
+    constexpr bool isOver() const { return isWon(0) || isWon(1) || isFull(); }
+
+    constexpr void play(int index)
+    {
+        marks[side] |= (uint16_t)(1 << index);
+        side ^= 1;
+    }
+
+    //
+    // GamePosition
+    //
+    int         sideToMove() const { return side; }
+    bool        isTerminal() const { return isOver(); }
+    uint64_t    hash() const { return mixPositionKey(marks[0] | (uint64_t)marks[1] << SQUARES | (uint64_t)side << (2 * SQUARES)); }
+
+    void generateMoves(MoveList<Move, MAX_MOVES> &moves) const
+    {
+        moves.clear();
+        uint16_t legal = legalMoves();
+        while (legal) moves.push(Bitboard::popLowestBit(legal));
+    }
+
+    NoUndo makeMove(Move move)
+    {
+        play(move);
+        return {};
+    }
+
+    void unmakeMove(Move move, NoUndo)
+    {
+        side ^= 1;
+        marks[side] &= (uint16_t)~(1 << move);
+    }
+
+    //
+    // state strings use '0' for empty, '1' for player 0 and '2' for player 1
+    //
+    std::string toString() const
+    {
+        std::string state(SQUARES, '0');
+        for (int i = 0; i < SQUARES; i++) {
+            if (marks[0] & (1 << i)) state[i] = '1';
+            else if (marks[1] & (1 << i)) state[i] = '2';
+        }
+        return state;
+    }
+
+    bool fromString(const std::string &state, int sideToMove)
+    {
+        if ((int)state.length() != SQUARES) return false;
+        marks[0] = marks[1] = 0;
+        for (int i = 0; i < SQUARES; i++) {
+            if (state[i] == '1') marks[0] |= (uint16_t)(1 << i);
+            else if (state[i] == '2') marks[1] |= (uint16_t)(1 << i);
+        }
+        side = sideToMove & 1;
+        return true;
+    }
+};
+
+static_assert(GamePosition<TicTacToeBoard>);
+
+//
+// the 8 symmetries of the 3x3 board, moves are squares
+//
+template <>
+struct Symmetry<TicTacToeBoard>
+{
+    static constexpr int COUNT = SquareSymmetry::COUNT;
+
+    static TicTacToeBoard apply(const TicTacToeBoard &board, int symmetry)
+    {
+        TicTacToeBoard result = board;
+        for (int player = 0; player < 2; player++) {
+            result.marks[player] = SquareSymmetry::mask<uint16_t>(board.marks[player], symmetry, TicTacToeBoard::SIZE);
+        }
+        return result;
+    }
+
+    static int applyMove(int move, int symmetry) { return SquareSymmetry::square(move, symmetry, TicTacToeBoard::SIZE); }
+    static constexpr int inverse(int symmetry) { return SquareSymmetry::inverse(symmetry); }
+};
+
+//
+// SearchEngine traits, the game is small enough to search to the end so there is no evaluation
+//
+struct TicTacToeTraits
+{
+    using Position = TicTacToeBoard;
+    static constexpr int HISTORY_SIZE = TicTacToeBoard::SQUARES;
+
+    static int evaluate(const Position &) { return 0; }
+    static int result(const Position &board) { return board.isWon(board.side) ? 1 : board.isWon(board.side ^ 1) ? -1 : 0; }
+    static int historyIndex(int move) { return move; }
+
+    // MCTS move weights: finish a line, stop one, then centre, corners and edges
+    static float prior(const Position &board, int move)
+    {
+        uint16_t bit = (uint16_t)(1 << move);
+        for (int player : { board.side, board.side ^ 1 }) {
+            for (uint16_t line : TicTacToeBoard::LINES) {
+                if ((line & bit) && ((board.marks[player] | bit) & line) == line) return player == board.side ? 20.0f : 10.0f;
+            }
+        }
+        return move == 4 ? 3.0f : move % 2 == 0 ? 2.0f : 1.0f;
+    }
+};
@@ -0,0 +1,202 @@
+#include "WorkQueue.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <cstdlib>
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+    const char* const PENDING = "pending";
+    const char* const CLAIMED = "claimed";
+    const char* const DONE = "done";
+
+    // temporary files start with a dot and are never taken for units
+    bool isUnitName(const std::string &name)
+    {
+        return !name.empty() && name[0] != '.';
+    }
+
+    bool readFile(const std::string &path, std::string &contents)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return false;
+        std::ostringstream buffer;
+        buffer << in.rdbuf();
+        contents = buffer.str();
+        return true;
+    }
+
+    // writes a temporary file next to path and renames it there, so readers see all of it or nothing
+    bool writeFile(const std::string &path, const std::string &temporaryName, const std::string &contents)
+    {
+        fs::path target(path);
+        std::string temporary = (target.parent_path() / temporaryName).string();
+        FILE *file = fopen(temporary.c_str(), "wb");
+        if (!file) return false;
+        bool ok = fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+        ok = fclose(file) == 0 && ok;
+        std::error_code error;
+        if (ok) fs::rename(temporary, target, error);
+        if (!ok || error) {
+            fs::remove(temporary, error);
+            return false;
+        }
+        return true;
+    }
+
+    size_t countUnits(const std::string &directory)
+    {
+        std::error_code error;
+        size_t count = 0;
+        for (fs::directory_iterator it(directory, error), end; !error && it != end; it.increment(error)) {
+            if (isUnitName(it->path().filename().string())) count++;
+        }
+        return count;
+    }
+}
+
+WorkQueue::WorkQueue(const std::string &directory)
+{
+    _directory = directory;
+}
+
+std::string WorkQueue::path(const char *state, const std::string &name) const
+{
+    return (fs::path(_directory) / state / name).string();
+}
+
+std::string WorkQueue::ownerName(int thread)
+{
+    char host[256] = "host";
+#ifdef _WIN32
+    if (const char *name = std::getenv("COMPUTERNAME")) snprintf(host, sizeof(host), "%s", name);
+    int process = _getpid();
+#else
+    gethostname(host, sizeof(host) - 1);
+    int process = (int)getpid();
+#endif
+    return std::string(host) + "-" + std::to_string(process) + "-" + std::to_string(thread);
+}
+
+bool WorkQueue::create(std::string &error)
+{
+    for (const char *state : { PENDING, CLAIMED, DONE }) {
+        std::error_code code;
+        fs::create_directories(fs::path(_directory) / state, code);
+        if (code) {
+            error = path(state, "") + ": " + code.message();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool WorkQueue::add(const std::string &unit, const std::string &contents)
+{
+    std::error_code error;
+    if (fs::exists(path(DONE, unit), error) || fs::exists(path(PENDING, unit), error)) return true;
+    std::string prefix = unit + "@";
+    for (fs::directory_iterator it(path(CLAIMED, ""), error), end; !error && it != end; it.increment(error)) {
+        if (it->path().filename().string().compare(0, prefix.size(), prefix) == 0) return true;
+    }
+    return writeFile(path(PENDING, unit), "." + unit + "." + ownerName(0), contents);
+}
+
+bool WorkQueue::claim(const std::string &owner, std::string &unit, std::string &contents)
+{
+    std::error_code error;
+    for (fs::directory_iterator it(path(PENDING, ""), error), end; !error && it != end; it.increment(error)) {
+        std::string name = it->path().filename().string();
+        if (!isUnitName(name)) continue;
+        std::string claimed = path(CLAIMED, name + "@" + owner);
+        std::error_code lost;
+        // another process got there first
+        fs::rename(it->path(), claimed, lost);
+        if (lost) continue;
+        heartbeat(name, owner);
+        if (fs::exists(path(DONE, name), lost) || !readFile(claimed, contents)) {
+            fs::remove(claimed, lost);
+            continue;
+        }
+        unit = name;
+        return true;
+    }
+    return false;
+}
+
+void WorkQueue::heartbeat(const std::string &unit, const std::string &owner)
+{
+    std::error_code error;
+    fs::last_write_time(path(CLAIMED, unit + "@" + owner), fs::file_time_type::clock::now(), error);
+}
+
+bool WorkQueue::complete(const std::string &unit, const std::string &owner, const std::string &results)
+{
+    if (!writeFile(path(DONE, unit), "." + unit + "." + owner, results)) return false;
+    std::error_code error;
+    fs::remove(path(CLAIMED, unit + "@" + owner), error);
+    return true;
+}
+
+int WorkQueue::reclaimStale(int seconds)
+{
+    std::error_code error;
+    auto now = fs::file_time_type::clock::now();
+    int reclaimed = 0;
+    std::vector<fs::path> claims;
+    for (fs::directory_iterator it(path(CLAIMED, ""), error), end; !error && it != end; it.increment(error)) {
+        claims.push_back(it->path());
+    }
+    for (const fs::path &claim : claims) {
+        std::string name = claim.filename().string();
+        size_t at = name.rfind('@');
+        if (!isUnitName(name) || at == std::string::npos) continue;
+        std::error_code gone;
+        auto written = fs::last_write_time(claim, gone);
+        if (gone || now - written < std::chrono::seconds(seconds)) continue;
+
+        std::string unit = name.substr(0, at);
+        // the owner finished but didn't get to let go
+        if (fs::exists(path(DONE, unit), gone)) {
+            fs::remove(claim, gone);
+            continue;
+        }
+        fs::rename(claim, path(PENDING, unit), gone);
+        if (!gone) reclaimed++;
+    }
+    return reclaimed;
+}
+
+WorkQueue::Counts WorkQueue::counts() const
+{
+    Counts counts;
+    counts.pending = countUnits(path(PENDING, ""));
+    counts.claimed = countUnits(path(CLAIMED, ""));
+    counts.done = countUnits(path(DONE, ""));
+    return counts;
+}
+
+std::vector<std::string> WorkQueue::doneUnits() const
+{
+    std::vector<std::string> units;
+    std::error_code error;
+    for (fs::directory_iterator it(path(DONE, ""), error), end; !error && it != end; it.increment(error)) {
+        std::string name = it->path().filename().string();
+        if (isUnitName(name)) units.push_back(name);
+    }
+    return units;
+}
+
+bool WorkQueue::readDone(const std::string &unit, std::string &results) const
+{
+    return readFile(path(DONE, unit), results);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+//
+// a queue of work units in a directory, shared by any number of processes on any number of hosts that
+// see the same filesystem. a unit is a file that moves between three subdirectories by rename, which
+// the filesystem does atomically, so exactly one process gets each move:
+//   pending/<unit>                 waiting
+//   claimed/<unit>@<owner>         taken by owner, whose heartbeats keep the file's time current
+//   done/<unit>                    the results, written to a temporary name first
+// a claim whose owner stopped beating (crashed, killed, lost its host) goes back to pending after a
+// timeout, so an interrupted run carries on where it stopped and no unit is lost or done twice over
+//
+class WorkQueue
+{
+public:
+    struct Counts
+    {
+        size_t      pending = 0;
+        size_t      claimed = 0;
+        size_t      done = 0;
+    };
+
+    explicit WorkQueue(const std::string &directory);
+
+    const std::string& directory() const { return _directory; }
+
+    // makes the subdirectories, false with error set when it can't
+    bool            create(std::string &error);
+
+    // queues a unit unless it is already pending, claimed or done
+    bool            add(const std::string &unit, const std::string &contents);
+
+    // takes a pending unit, false when there is none
+    bool            claim(const std::string &owner, std::string &unit, std::string &contents);
+    // tells the others the owner is still working on its unit
+    void            heartbeat(const std::string &unit, const std::string &owner);
+    // stores the unit's results and lets go of the claim
+    bool            complete(const std::string &unit, const std::string &owner, const std::string &results);
+    // puts back the claims nobody has beaten on for seconds, returns how many
+    int             reclaimStale(int seconds);
+
+    Counts          counts() const;
+    std::vector<std::string> doneUnits() const;
+    bool            readDone(const std::string &unit, std::string &results) const;
+
+    // an owner name unique across the hosts sharing the queue: host, process and thread
+    static std::string ownerName(int thread);
+
+private:
+    std::string     path(const char *state, const std::string &name) const;
+
+    std::string     _directory;
+};
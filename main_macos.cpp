@@ -171,6 +171,7 @@ int main(int, char**)
 #ifdef __EMSCRIPTEN__
     EMSCRIPTEN_MAINLOOP_END;
 #endif
+    ClassGame::GameShutDown();
 
     // Cleanup
     ImGui_ImplOpenGL3_Shutdown();
@@ -0,0 +1,580 @@
+//
+// one analysis shared by several processes: the coordinator expands the tree --split plies (1 splits at
+// the root), hands the positions there to worker processes, and backs their scores up to the root.
+// the workers partition a transposition table by hash between them (ShardedTable.h) for the nodes at
+// least --shared-depth plies from their horizon, talking over Unix domain sockets or TCP
+//
+// usage: analysis_cluster [--game tictactoe|connectfour|othello|othello6] [--depth N] [--split N]
+//                         [--processes N | --scale N] [--assign queue|hash] [--transport unix|tcp] [--port N]
+//                         [--shared-depth N] [--table MB] [--state S --side N]
+//                         [--peers A0,A1,... --listen ADDRESS --no-spawn]
+//        analysis_cluster --worker I --coordinator ADDRESS --peers A0,A1,... [--game name] [--table MB]
+//                         [--shared-depth N] [--state S --side N]
+//
+// --assign queue gives a worker the next position whenever it finishes one, hash gives every position
+// to the worker owning its shard of the table. positions that transpose into each other or are
+// symmetric are searched once. --scale runs with 1, 2, 4 ... N processes in turn and reports how the
+// throughput scales with them. everything runs on localhost unless --no-spawn is given: the workers
+// are then started by hand on their hosts with --worker and the addresses from --peers
+//
+#include "../classes/ConnectFourBoard.h"
+#include "../classes/EngineProtocol.h"
+#include "../classes/OthelloBoard.h"
+#include "../classes/Search.h"
+#include "../classes/ShardedTable.h"
+#include "../classes/Symmetry.h"
+#include "../classes/TicTacToeBoard.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Settings
+    {
+        std::string game = "connectfour";
+        int         depth = 14;
+        int         split = 2;
+        int         processes = 0;
+        int         scale = 0;
+        bool        hashAssign = false;
+        bool        tcp = false;
+        int         port = 47100;
+        int         sharedDepth = 4;
+        int         tableMB = 16;
+        std::string state;
+        int         side = 0;
+        bool        spawn = true;
+        std::vector<std::string> peers;
+        std::string listen;
+
+        // a worker's own
+        int         worker = -1;
+        std::string coordinator;
+    };
+
+    struct ClusterStats
+    {
+        double      seconds = 0;
+        uint64_t    nodes = 0;
+        uint64_t    sharedProbes = 0;
+        uint64_t    sharedHits = 0;
+        uint64_t    remoteProbes = 0;
+        int         score = 0;
+        int         bestMove = -1;
+    };
+
+    std::vector<std::string> splitWords(const std::string &line)
+    {
+        std::istringstream stream(line);
+        std::vector<std::string> words;
+        std::string word;
+        while (stream >> word) words.push_back(word);
+        return words;
+    }
+
+    std::string join(const std::vector<std::string> &parts, char separator)
+    {
+        std::string result;
+        for (size_t i = 0; i < parts.size(); i++) result += (i ? std::string(1, separator) : "") + parts[i];
+        return result;
+    }
+
+    //
+    // a line protocol between the coordinator and a worker:
+    //   worker: ready <shard>, done <job> <score> <nodes>, stats <name> <value> ...
+    //   coordinator: job <job> <depth> <move index> ..., quit
+    //
+    struct LineSocket
+    {
+        int         fd = -1;
+        std::string buffer;
+
+        bool send(const std::string &line) const { return ClusterSocket::sendAll(fd, (line + "\n").data(), line.size() + 1); }
+
+        // a complete line already received
+        bool takeLine(std::string &line)
+        {
+            size_t end = buffer.find('\n');
+            if (end == std::string::npos) return false;
+            line = buffer.substr(0, end);
+            buffer.erase(0, end + 1);
+            return true;
+        }
+
+        // false once the other end has gone
+        bool receive()
+        {
+            char chunk[4096];
+            ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) return false;
+            buffer.append(chunk, (size_t)n);
+            return true;
+        }
+
+        bool readLine(std::string &line)
+        {
+            while (!takeLine(line)) {
+                if (!receive()) return false;
+            }
+            return true;
+        }
+    };
+
+    template <class Traits>
+    bool rootPosition(const Settings &settings, typename Traits::Position &position)
+    {
+        position = typename Traits::Position();
+        return settings.state.empty() || position.fromString(settings.state, settings.side);
+    }
+
+    //
+    // a worker: serves its shard of the table and searches the positions it is sent
+    //
+    template <class Traits>
+    int runWorker(const Settings &settings)
+    {
+        using Position = typename Traits::Position;
+
+        Position root;
+        if (!rootPosition<Traits>(settings, root)) {
+            fprintf(stderr, "worker %d: bad state %s\n", settings.worker, settings.state.c_str());
+            return 1;
+        }
+        ShardedTable table(settings.worker, settings.peers, (size_t)settings.tableMB << 20);
+        std::string error;
+        if (!table.start(error)) {
+            fprintf(stderr, "worker %d: %s\n", settings.worker, error.c_str());
+            return 1;
+        }
+        LineSocket coordinator;
+        coordinator.fd = ClusterSocket::connectTo(settings.coordinator, ShardedTable::CONNECT_TIMEOUT_MS, error);
+        if (coordinator.fd < 0) {
+            fprintf(stderr, "worker %d: %s\n", settings.worker, error.c_str());
+            return 1;
+        }
+        coordinator.send("ready " + std::to_string(settings.worker));
+
+        SearchEngine<Traits> engine((size_t)settings.tableMB << 20);
+        engine.setSharedTable(&table, settings.sharedDepth);
+        SearchStats total;
+        std::string line;
+        while (coordinator.readLine(line)) {
+            std::vector<std::string> words = splitWords(line);
+            if (words.empty()) continue;
+            if (words[0] == "quit") {
+                ShardedTableStats stats = table.stats();
+                coordinator.send("stats nodes " + std::to_string(total.nodes) + " shared-probes " + std::to_string(total.sharedProbes) +
+                                 " shared-hits " + std::to_string(total.sharedHits) + " remote-probes " + std::to_string(stats.remoteProbes) +
+                                 " served " + std::to_string(stats.served));
+                break;
+            }
+            if (words[0] != "job" || words.size() < 3) continue;
+
+            Position position = root;
+            for (size_t i = 3; i < words.size(); i++) {
+                MovesOf<Position> moves;
+                position.generateMoves(moves);
+                position.makeMove(moves[std::atoi(words[i].c_str())]);
+            }
+            SearchLimits limits;
+            limits.depth = std::atoi(words[2].c_str());
+            typename SearchEngine<Traits>::Result result = engine.search(position, limits);
+            table.flush();
+            total.nodes += result.stats.nodes;
+            total.sharedProbes += result.stats.sharedProbes;
+            total.sharedHits += result.stats.sharedHits;
+            coordinator.send("done " + words[1] + " " + std::to_string(result.score) + " " + std::to_string(result.stats.nodes));
+        }
+        ClusterSocket::close(coordinator.fd);
+        table.stop();
+        return 0;
+    }
+
+    //
+    // the coordinator's view of the tree down to the split
+    //
+    struct Job
+    {
+        std::vector<int> path;              // move indices from the root
+        uint64_t    key = 0;
+        int         score = 0;
+        bool        done = false;
+    };
+
+    struct TreeNode
+    {
+        std::vector<int> children;
+        int         job = -1;
+        bool        terminal = false;
+        int         value = 0;
+    };
+
+    template <class Traits>
+    class Coordinator
+    {
+    public:
+        using Position = typename Traits::Position;
+        using Engine = SearchEngine<Traits>;
+
+        Coordinator(const Settings &settings, const char *self) : _settings(settings), _self(self) {}
+
+        bool prepare()
+        {
+            Position root;
+            if (!rootPosition<Traits>(_settings, root)) {
+                printf("bad state %s\n", _settings.state.c_str());
+                return false;
+            }
+            std::vector<int> path;
+            std::unordered_map<uint64_t, int> jobIndex;
+            expand(root, 0, path, jobIndex);
+            _jobDepth = std::max(1, _settings.depth - _settings.split);
+            return true;
+        }
+
+        size_t      frontier() const { return _frontier; }
+        size_t      jobs() const { return _jobs.size(); }
+
+        // one analysis with the given number of processes, false when the cluster didn't come up
+        bool run(int processes, ClusterStats &stats)
+        {
+            std::vector<std::string> addresses = _settings.peers;
+            std::string coordinatorAddress = _settings.listen;
+            std::string base = "/tmp/analysis_cluster." + std::to_string(getpid());
+            if (addresses.empty()) {
+                for (int i = 0; i < processes; i++) {
+                    addresses.push_back(_settings.tcp ? "tcp:127.0.0.1:" + std::to_string(_settings.port + 1 + i)
+                                                      : "unix:" + base + "." + std::to_string(i) + ".sock");
+                }
+            }
+            if (coordinatorAddress.empty()) {
+                coordinatorAddress = _settings.tcp ? "tcp:127.0.0.1:" + std::to_string(_settings.port) : "unix:" + base + ".sock";
+            }
+            processes = (int)addresses.size();
+
+            std::string error;
+            int listenFd = ClusterSocket::listenOn(coordinatorAddress, error);
+            if (listenFd < 0) {
+                printf("can't listen: %s\n", error.c_str());
+                return false;
+            }
+
+            std::vector<pid_t> children;
+            for (int i = 0; i < processes; i++) {
+                std::vector<std::string> args = { _self, "--worker", std::to_string(i), "--coordinator", coordinatorAddress,
+                                                  "--peers", join(addresses, ','), "--game", _settings.game,
+                                                  "--table", std::to_string(_settings.tableMB),
+                                                  "--shared-depth", std::to_string(_settings.sharedDepth) };
+                if (!_settings.state.empty()) {
+                    args.insert(args.end(), { "--state", _settings.state, "--side", std::to_string(_settings.side) });
+                }
+                if (!_settings.spawn) {
+                    printf("  start: %s\n", join(args, ' ').c_str());
+                    continue;
+                }
+                pid_t child = fork();
+                if (child == 0) {
+                    std::vector<char*> argv;
+                    for (std::string &arg : args) argv.push_back(arg.data());
+                    argv.push_back(nullptr);
+                    execvp(argv[0], argv.data());
+                    _exit(127);
+                }
+                if (child > 0) children.push_back(child);
+            }
+            if (!_settings.spawn) fflush(stdout);
+
+            std::vector<LineSocket> workers(processes);
+            bool ok = connectWorkers(listenFd, workers);
+            if (ok) ok = analyse(workers, stats);
+
+            for (LineSocket &worker : workers) {
+                std::string line;
+                if (ok && worker.send("quit") && worker.readLine(line)) addWorkerStats(splitWords(line), stats);
+                ClusterSocket::close(worker.fd);
+            }
+            ClusterSocket::close(listenFd, coordinatorAddress);
+            for (pid_t child : children) waitpid(child, nullptr, 0);
+            return ok;
+        }
+
+    private:
+        int expand(Position &position, int ply, std::vector<int> &path, std::unordered_map<uint64_t, int> &jobIndex)
+        {
+            int index = (int)_tree.size();
+            _tree.emplace_back();
+            if (position.isTerminal()) {
+                _tree[index].terminal = true;
+                _tree[index].value = Traits::result(position) * Engine::WIN_SCORE;
+                return index;
+            }
+            if (ply == _settings.split) {
+                _frontier++;
+                uint64_t key = canonicalKey(position);
+                auto found = jobIndex.find(key);
+                if (found == jobIndex.end()) {
+                    found = jobIndex.emplace(key, (int)_jobs.size()).first;
+                    _jobs.push_back({ path, key });
+                }
+                _tree[index].job = found->second;
+                return index;
+            }
+            MovesOf<Position> moves;
+            position.generateMoves(moves);
+            for (int i = 0; i < (int)moves.size(); i++) {
+                auto undo = position.makeMove(moves[i]);
+                path.push_back(i);
+                int child = expand(position, ply + 1, path, jobIndex);
+                path.pop_back();
+                position.unmakeMove(moves[i], undo);
+                _tree[index].children.push_back(child);
+            }
+            return index;
+        }
+
+        // negamax over the tree, a win a ply further away is worth a point less like in the engine
+        int backUp(int index, int *bestChild = nullptr) const
+        {
+            const TreeNode &node = _tree[index];
+            if (node.terminal) return node.value;
+            if (node.job >= 0) return _jobs[node.job].score;
+            int best = -Engine::INFINITE_SCORE;
+            for (size_t i = 0; i < node.children.size(); i++) {
+                int value = -backUp(node.children[i]);
+                if (value > Engine::WIN_SCORE - Engine::MAX_PLY) value--;
+                else if (value < -Engine::WIN_SCORE + Engine::MAX_PLY) value++;
+                if (value > best) {
+                    best = value;
+                    if (bestChild) *bestChild = (int)i;
+                }
+            }
+            return best;
+        }
+
+        bool connectWorkers(int listenFd, std::vector<LineSocket> &workers)
+        {
+            auto deadline = Clock::now() + std::chrono::milliseconds(_settings.spawn ? 2 * ShardedTable::CONNECT_TIMEOUT_MS : 3600 * 1000);
+            int connected = 0;
+            while (connected < (int)workers.size()) {
+                pollfd listener{ listenFd, POLLIN, 0 };
+                if (poll(&listener, 1, 100) <= 0) {
+                    if (Clock::now() < deadline) continue;
+                    printf("only %d of %zu workers came up\n", connected, workers.size());
+                    return false;
+                }
+                LineSocket worker;
+                worker.fd = accept(listenFd, nullptr, nullptr);
+                if (worker.fd < 0) continue;
+                std::string line;
+                std::vector<std::string> words;
+                if (worker.readLine(line)) words = splitWords(line);
+                int shard = words.size() == 2 && words[0] == "ready" ? std::atoi(words[1].c_str()) : -1;
+                if (shard < 0 || shard >= (int)workers.size() || workers[shard].fd >= 0) {
+                    ClusterSocket::close(worker.fd);
+                    continue;
+                }
+                workers[shard] = std::move(worker);
+                connected++;
+            }
+            return true;
+        }
+
+        // hands out the jobs and waits for every score
+        bool analyse(std::vector<LineSocket> &workers, ClusterStats &stats)
+        {
+            int processes = (int)workers.size();
+            // the jobs each worker has still to do, all in one list for the queue
+            std::vector<std::vector<int>> queues(_settings.hashAssign ? processes : 1);
+            for (int i = (int)_jobs.size() - 1; i >= 0; i--) {
+                _jobs[i].done = false;
+                queues[_settings.hashAssign ? ShardedTable::owner(_jobs[i].key, processes) : 0].push_back(i);
+            }
+
+            auto start = Clock::now();
+            auto dispatch = [&](int worker) {
+                std::vector<int> &queue = queues[_settings.hashAssign ? worker : 0];
+                if (queue.empty()) return true;
+                const Job &job = _jobs[queue.back()];
+                std::string line = "job " + std::to_string(queue.back()) + " " + std::to_string(_jobDepth);
+                for (int move : job.path) {
+                    line += ' ';
+                    line += std::to_string(move);
+                }
+                queue.pop_back();
+                return workers[worker].send(line);
+            };
+            for (int i = 0; i < processes; i++) {
+                if (!dispatch(i)) return false;
+            }
+
+            size_t remaining = _jobs.size();
+            std::vector<pollfd> fds(processes);
+            while (remaining > 0) {
+                for (int i = 0; i < processes; i++) fds[i] = { workers[i].fd, POLLIN, 0 };
+                if (poll(fds.data(), fds.size(), 1000) <= 0) continue;
+                for (int i = 0; i < processes; i++) {
+                    if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+                    if (!workers[i].receive()) {
+                        printf("worker %d went away\n", i);
+                        return false;
+                    }
+                    std::string line;
+                    while (workers[i].takeLine(line)) {
+                        std::vector<std::string> words = splitWords(line);
+                        if (words.size() < 3 || words[0] != "done") continue;
+                        Job &job = _jobs[std::atoi(words[1].c_str())];
+                        if (job.done) continue;
+                        job.done = true;
+                        job.score = std::atoi(words[2].c_str());
+                        remaining--;
+                        if (!dispatch(i)) return false;
+                    }
+                }
+            }
+            stats.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            stats.score = backUp(0, &stats.bestMove);
+            return true;
+        }
+
+        static void addWorkerStats(const std::vector<std::string> &words, ClusterStats &stats)
+        {
+            for (size_t i = 1; i + 1 < words.size(); i += 2) {
+                uint64_t value = std::strtoull(words[i + 1].c_str(), nullptr, 10);
+                if (words[i] == "nodes") stats.nodes += value;
+                else if (words[i] == "shared-probes") stats.sharedProbes += value;
+                else if (words[i] == "shared-hits") stats.sharedHits += value;
+                else if (words[i] == "remote-probes") stats.remoteProbes += value;
+            }
+        }
+
+        const Settings&     _settings;
+        std::string         _self;
+        std::vector<TreeNode> _tree;
+        std::vector<Job>    _jobs;
+        size_t              _frontier = 0;
+        int                 _jobDepth = 1;
+    };
+
+    template <class Traits>
+    int runCoordinator(const Settings &settings, const char *self)
+    {
+        Coordinator<Traits> coordinator(settings, self);
+        if (!coordinator.prepare()) return 1;
+
+        std::vector<int> counts;
+        if (!settings.peers.empty()) {
+            counts.push_back((int)settings.peers.size());
+        } else if (settings.scale > 0) {
+            for (int count = 1; count < settings.scale; count *= 2) counts.push_back(count);
+            counts.push_back(settings.scale);
+        } else {
+            counts.push_back(settings.processes > 0 ? settings.processes : std::max(1u, std::thread::hardware_concurrency()));
+        }
+
+        // the root's moves by name, in the order the engine generates them
+        std::unique_ptr<ProtocolGame> names = ProtocolGame::create(settings.game);
+        if (names && !settings.state.empty()) names->setState(settings.state, settings.side);
+        std::vector<std::string> rootMoves = names ? names->legalMoves() : std::vector<std::string>();
+
+        bool tcp = settings.peers.empty() ? settings.tcp : settings.peers[0].compare(0, 4, "tcp:") == 0;
+        printf("%s depth %d, split at %d plies: %zu positions, %zu after transpositions and symmetries, %s assignment over %s\n",
+               settings.game.c_str(), settings.depth, settings.split, coordinator.frontier(), coordinator.jobs(),
+               settings.hashAssign ? "hash" : "queue", tcp ? "tcp" : "unix sockets");
+        printf("%u hardware threads\n", std::thread::hardware_concurrency());
+        printf("processes  seconds    M nodes  M nodes/s  speedup  shared hits  remote probes  score  best\n");
+        fflush(stdout);
+
+        double baseline = 0;
+        for (int count : counts) {
+            ClusterStats stats;
+            if (!coordinator.run(count, stats)) return 1;
+            double rate = stats.nodes / std::max(stats.seconds, 1e-6);
+            if (baseline == 0) baseline = rate;
+            std::string best = stats.bestMove >= 0 && stats.bestMove < (int)rootMoves.size() ? rootMoves[stats.bestMove] : "-";
+            printf("%9d  %7.2f  %9.2f  %9.2f  %7.2f  %10.1f%%  %13llu  %5d  %s\n", count, stats.seconds, stats.nodes / 1e6,
+                   rate / 1e6, rate / baseline, stats.sharedProbes ? 100.0 * stats.sharedHits / stats.sharedProbes : 0.0,
+                   (unsigned long long)stats.remoteProbes, stats.score, best.c_str());
+            fflush(stdout);
+        }
+        return 0;
+    }
+
+    template <class Traits>
+    int run(const Settings &settings, const char *self)
+    {
+        return settings.worker >= 0 ? runWorker<Traits>(settings) : runCoordinator<Traits>(settings, self);
+    }
+
+    std::vector<std::string> splitList(const std::string &list)
+    {
+        std::vector<std::string> parts;
+        std::istringstream stream(list);
+        std::string part;
+        while (std::getline(stream, part, ',')) {
+            if (!part.empty()) parts.push_back(part);
+        }
+        return parts;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Settings settings;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--game") && i + 1 < argc) settings.game = argv[++i];
+        else if (!strcmp(argv[i], "--depth") && i + 1 < argc) settings.depth = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--split") && i + 1 < argc) settings.split = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--processes") && i + 1 < argc) settings.processes = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--scale") && i + 1 < argc) settings.scale = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--assign") && i + 1 < argc) settings.hashAssign = !strcmp(argv[++i], "hash");
+        else if (!strcmp(argv[i], "--transport") && i + 1 < argc) settings.tcp = !strcmp(argv[++i], "tcp");
+        else if (!strcmp(argv[i], "--port") && i + 1 < argc) settings.port = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--shared-depth") && i + 1 < argc) settings.sharedDepth = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--table") && i + 1 < argc) settings.tableMB = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--state") && i + 1 < argc) settings.state = argv[++i];
+        else if (!strcmp(argv[i], "--side") && i + 1 < argc) settings.side = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--peers") && i + 1 < argc) settings.peers = splitList(argv[++i]);
+        else if (!strcmp(argv[i], "--listen") && i + 1 < argc) settings.listen = argv[++i];
+        else if (!strcmp(argv[i], "--no-spawn")) settings.spawn = false;
+        else if (!strcmp(argv[i], "--worker") && i + 1 < argc) settings.worker = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--coordinator") && i + 1 < argc) settings.coordinator = argv[++i];
+        else {
+            printf("usage: %s [--game tictactoe|connectfour|othello|othello6] [--depth N] [--split N]\n"
+                   "       [--processes N | --scale N] [--assign queue|hash] [--transport unix|tcp] [--port N]\n"
+                   "       [--shared-depth N] [--table MB] [--state S --side N] [--peers A0,A1,... --listen ADDRESS --no-spawn]\n"
+                   "   or: %s --worker I --coordinator ADDRESS --peers A0,A1,... [--game name] [--table MB] [--shared-depth N]\n",
+                   argv[0], argv[0]);
+            return 1;
+        }
+    }
+    settings.split = std::max(1, settings.split);
+    settings.tableMB = std::max(1, settings.tableMB);
+    if (settings.worker >= 0 && (settings.coordinator.empty() || settings.worker >= (int)settings.peers.size())) {
+        printf("a worker needs --coordinator and its address in --peers\n");
+        return 1;
+    }
+    if (!settings.spawn && (settings.peers.empty() || settings.listen.empty())) {
+        printf("--no-spawn needs the workers' --peers and the coordinator's --listen address\n");
+        return 1;
+    }
+
+    if (settings.game == "tictactoe") return run<TicTacToeTraits>(settings, argv[0]);
+    if (settings.game == "connectfour") return run<ConnectFourTraits>(settings, argv[0]);
+    if (settings.game == "othello") return run<OthelloTraits<8>>(settings, argv[0]);
+    if (settings.game == "othello6") return run<OthelloTraits<6>>(settings, argv[0]);
+    printf("unknown game %s\n", settings.game.c_str());
+    return 1;
+}
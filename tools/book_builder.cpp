@@ -0,0 +1,452 @@
+//
+// builds an opening book over many processes on many hosts that share a filesystem:
+//   init   expands the opening tree --plies deep and queues the positions there as work units in --dir
+//   work   claims units one at a time and searches their positions --depth plies, any number at once
+//   status counts the units pending, claimed and done
+//   merge  backs the results up the tree and writes the memory-mapped book (OpeningBook.h)
+//
+// usage: book_builder init --dir DIR [--game connectfour|othello|othello6] [--plies N] [--depth N] [--unit-size N]
+//        book_builder work --dir DIR [--threads N] [--table MB] [--stale SECONDS]
+//        book_builder status --dir DIR
+//        book_builder merge --dir DIR [--out FILE] [--partial]
+//
+// positions are kept in their canonical form (Symmetry.h), so transpositions and symmetric positions are
+// queued and searched once. every step can be interrupted and run again: init only queues the units that
+// aren't there yet, a worker's claim goes back to the queue once it has stopped beating for --stale
+// seconds, and merge reads whatever is done. workers stop when nothing is pending or claimed
+// the queue (WorkQueue.h) is DIR/pending, claimed and done, with the settings in DIR/book.cfg
+//
+#include "../classes/ConnectFourBoard.h"
+#include "../classes/EngineProtocol.h"
+#include "../classes/OpeningBook.h"
+#include "../classes/OthelloBoard.h"
+#include "../classes/Search.h"
+#include "../classes/Symmetry.h"
+#include "../classes/WorkQueue.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // what init settles for the whole build, kept in DIR/book.cfg
+    struct BookConfig
+    {
+        std::string game = "connectfour";
+        int         plies = 6;
+        int         depth = 12;
+        int         unitSize = 16;
+    };
+
+    struct Settings
+    {
+        std::string command;
+        std::string directory;
+        BookConfig  config;
+        int         threads = 0;
+        int         tableMB = 16;
+        int         staleSeconds = 600;
+        std::string out;
+        bool        partial = false;
+    };
+
+    std::string configPath(const std::string &directory)
+    {
+        return (std::filesystem::path(directory) / "book.cfg").string();
+    }
+
+    bool readConfig(const std::string &directory, BookConfig &config)
+    {
+        std::ifstream in(configPath(directory));
+        if (!in) return false;
+        std::string name;
+        while (in >> name) {
+            if (name == "game") in >> config.game;
+            else if (name == "plies") in >> config.plies;
+            else if (name == "depth") in >> config.depth;
+            else if (name == "unit-size") in >> config.unitSize;
+        }
+        return true;
+    }
+
+    bool writeConfig(const std::string &directory, const BookConfig &config)
+    {
+        std::string temporary = configPath(directory) + ".tmp";
+        {
+            std::ofstream out(temporary);
+            out << "game " << config.game << "\nplies " << config.plies << "\ndepth " << config.depth
+                << "\nunit-size " << config.unitSize << "\n";
+            if (!out) return false;
+        }
+        std::error_code error;
+        std::filesystem::rename(temporary, configPath(directory), error);
+        return !error;
+    }
+
+    bool sameConfig(const BookConfig &a, const BookConfig &b)
+    {
+        return a.game == b.game && a.plies == b.plies && a.depth == b.depth && a.unitSize == b.unitSize;
+    }
+
+    // a position in a unit: its canonical key, side to move and state string
+    std::string positionLine(uint64_t key, int side, const std::string &state)
+    {
+        char hex[17];
+        snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)key);
+        return std::string(hex) + " " + std::to_string(side) + " " + state + "\n";
+    }
+
+    template <class Traits>
+    class BookBuilder
+    {
+    public:
+        using Position = typename Traits::Position;
+        using Move = typename Position::Move;
+        using Engine = SearchEngine<Traits>;
+
+        BookBuilder(const Settings &settings) : _settings(settings), _queue(settings.directory) {}
+
+        //
+        // every canonical position --plies deep into the queue, unitSize to a unit
+        //
+        int init()
+        {
+            BookConfig existing;
+            if (readConfig(_settings.directory, existing) && !sameConfig(existing, _settings.config)) {
+                printf("%s holds a build of %s %d plies deep at depth %d, not this one\n", _settings.directory.c_str(),
+                       existing.game.c_str(), existing.plies, existing.depth);
+                return 1;
+            }
+            std::string error;
+            if (!_queue.create(error)) {
+                printf("%s\n", error.c_str());
+                return 1;
+            }
+
+            std::vector<Position> frontier;
+            std::unordered_set<uint64_t> seen;
+            expand(canonicalize(Position()).position, 0, seen, frontier);
+
+            const BookConfig &config = _settings.config;
+            int units = 0;
+            for (size_t start = 0; start < frontier.size(); start += config.unitSize, units++) {
+                std::string contents;
+                size_t end = std::min(frontier.size(), start + (size_t)config.unitSize);
+                for (size_t i = start; i < end; i++) {
+                    contents += positionLine(frontier[i].hash(), frontier[i].sideToMove(), frontier[i].toString());
+                }
+                char name[32];
+                snprintf(name, sizeof(name), "unit-%06d", units);
+                if (!_queue.add(name, contents)) {
+                    printf("can't queue %s in %s\n", name, _settings.directory.c_str());
+                    return 1;
+                }
+            }
+            // written last, a build without it was interrupted and init runs again
+            if (!writeConfig(_settings.directory, config)) {
+                printf("can't write %s\n", configPath(_settings.directory).c_str());
+                return 1;
+            }
+            printf("%s: %zu positions %d plies deep, %zu in the tree down to there, in %d units of %d\n", config.game.c_str(),
+                   frontier.size(), config.plies, seen.size(), units, config.unitSize);
+            return status();
+        }
+
+        //
+        // threads claiming and searching units until the queue is empty
+        //
+        int work()
+        {
+            int threads = _settings.threads > 0 ? _settings.threads : std::max(1u, std::thread::hardware_concurrency());
+            printf("%s: searching %d plies deep on %d threads\n", _settings.config.game.c_str(), _settings.config.depth, threads);
+            fflush(stdout);
+
+            auto start = Clock::now();
+            std::vector<std::thread> workers;
+            for (int i = 0; i < threads; i++) workers.emplace_back(&BookBuilder::workLoop, this, i);
+            for (std::thread &worker : workers) worker.join();
+
+            double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            printf("%d units, %llu positions, %.2f M nodes/s\n", _units.load(), (unsigned long long)_positions.load(),
+                   _nodes / std::max(seconds, 1e-6) / 1e6);
+            return _failed ? 1 : status();
+        }
+
+        int status()
+        {
+            WorkQueue::Counts counts = _queue.counts();
+            printf("%zu units pending, %zu claimed, %zu done\n", counts.pending, counts.claimed, counts.done);
+            return 0;
+        }
+
+        //
+        // the searched scores backed up to the root, an entry for every position with a move
+        //
+        int merge()
+        {
+            for (const std::string &unit : _queue.doneUnits()) {
+                std::string contents;
+                if (!_queue.readDone(unit, contents)) continue;
+                std::istringstream lines(contents);
+                std::string hex;
+                int score, move;
+                while (lines >> hex >> score >> move) {
+                    OpeningBookFile::Entry entry = {};
+                    entry.key = std::strtoull(hex.c_str(), nullptr, 16);
+                    entry.score = (int16_t)score;
+                    entry.move = move < 0 ? OpeningBookFile::NO_MOVE : (uint8_t)move;
+                    entry.ply = (uint8_t)_settings.config.plies;
+                    entry.depth = (uint16_t)_settings.config.depth;
+                    _results[entry.key] = entry;
+                }
+            }
+
+            int score = 0;
+            backUp(canonicalize(Position()).position, 0, score);
+            size_t missing = _missing.size();
+            if (missing > 0 && !_settings.partial) {
+                printf("%zu positions at the frontier have no result yet, run more workers or merge with --partial\n", missing);
+                return 1;
+            }
+
+            std::vector<OpeningBookFile::Entry> entries;
+            for (const auto &[key, entry] : _book) {
+                if (entry.move != OpeningBookFile::NO_MOVE) entries.push_back(entry);
+            }
+            std::string out = _settings.out.empty() ? "book/" + _settings.config.game + ".book" : _settings.out;
+            if (!OpeningBookFile::write(out, _settings.config.game, _settings.config.plies, entries)) {
+                printf("can't write %s\n", out.c_str());
+                return 1;
+            }
+
+            OpeningBook book;
+            if (!book.open(out, _settings.config.game)) {
+                printf("%s doesn't read back\n", out.c_str());
+                return 1;
+            }
+            printf("%s: %zu entries from %zu searched positions, %zu missing, score %d, best move %s\n", out.c_str(), book.size(),
+                   _results.size(), missing, score, rootMoveName(book).c_str());
+            return 0;
+        }
+
+    private:
+        // the book's move from the start, named as the protocol names it
+        std::string rootMoveName(const OpeningBook &book) const
+        {
+            Position root;
+            Move best{};
+            if (!book.move(root, best)) return "(none)";
+            MovesOf<Position> moves;
+            root.generateMoves(moves);
+            std::unique_ptr<ProtocolGame> game = ProtocolGame::create(_settings.config.game);
+            std::vector<std::string> names = game ? game->legalMoves() : std::vector<std::string>();
+            for (int i = 0; i < (int)moves.size() && i < (int)names.size(); i++) {
+                if (moves[i] == best) return names[i];
+            }
+            return "(none)";
+        }
+
+        // depth first over canonical positions, each one once
+        void expand(const Position &position, int ply, std::unordered_set<uint64_t> &seen, std::vector<Position> &frontier)
+        {
+            if (!seen.insert(position.hash()).second) return;
+            if (position.isTerminal()) return;
+            if (ply == _settings.config.plies) {
+                frontier.push_back(position);
+                return;
+            }
+            MovesOf<Position> moves;
+            position.generateMoves(moves);
+            for (const Move &move : moves) {
+                Position child = position;
+                child.makeMove(move);
+                expand(canonicalize(child).position, ply + 1, seen, frontier);
+            }
+        }
+
+        // negamax over the canonical positions down to the frontier, false when nothing below has a result
+        bool backUp(const Position &position, int ply, int &score)
+        {
+            uint64_t key = position.hash();
+            auto known = _book.find(key);
+            if (known != _book.end()) {
+                score = known->second.score;
+                return true;
+            }
+            if (_missing.count(key)) return false;
+            OpeningBookFile::Entry entry = {};
+            entry.key = key;
+            entry.move = OpeningBookFile::NO_MOVE;
+            entry.ply = (uint8_t)ply;
+            entry.depth = (uint16_t)(_settings.config.depth + _settings.config.plies - ply);
+
+            if (position.isTerminal()) {
+                entry.score = (int16_t)(Traits::result(position) * Engine::WIN_SCORE);
+            } else if (ply >= _settings.config.plies) {
+                auto result = _results.find(key);
+                if (result == _results.end()) {
+                    _missing.insert(key);
+                    return false;
+                }
+                entry = result->second;
+            } else {
+                MovesOf<Position> moves;
+                position.generateMoves(moves);
+                int best = -Engine::INFINITE_SCORE;
+                for (int i = 0; i < (int)moves.size(); i++) {
+                    Position child = position;
+                    child.makeMove(moves[i]);
+                    int value;
+                    if (!backUp(canonicalize(child).position, ply + 1, value)) continue;
+                    // a win a ply further away is worth a point less, like in the engine
+                    value = -value;
+                    if (value > Engine::WIN_SCORE - Engine::MAX_PLY) value--;
+                    else if (value < -Engine::WIN_SCORE + Engine::MAX_PLY) value++;
+                    if (value > best) {
+                        best = value;
+                        entry.move = (uint8_t)i;
+                    }
+                }
+                if (entry.move == OpeningBookFile::NO_MOVE) {
+                    _missing.insert(key);
+                    return false;
+                }
+                entry.score = (int16_t)best;
+            }
+            _book[key] = entry;
+            score = entry.score;
+            return true;
+        }
+
+        void workLoop(int thread)
+        {
+            std::string owner = WorkQueue::ownerName(thread);
+            Engine engine((size_t)_settings.tableMB << 20);
+            for (;;) {
+                std::string unit, contents;
+                if (!_queue.claim(owner, unit, contents)) {
+                    _queue.reclaimStale(_settings.staleSeconds);
+                    WorkQueue::Counts counts = _queue.counts();
+                    if (counts.pending == 0 && counts.claimed == 0) return;
+                    // the rest is claimed by others, wait for them to finish or go stale
+                    if (counts.pending == 0) std::this_thread::sleep_for(std::chrono::seconds(1));
+                    continue;
+                }
+
+                std::string results;
+                std::istringstream lines(contents);
+                std::string hex, state;
+                int side;
+                bool ok = true;
+                while (ok && lines >> hex >> side >> state) {
+                    uint64_t key = std::strtoull(hex.c_str(), nullptr, 16);
+                    Position position;
+                    ok = position.fromString(state, side) && position.hash() == key;
+                    if (!ok) break;
+
+                    SearchLimits limits;
+                    limits.depth = _settings.config.depth;
+                    typename Engine::Result result = engine.search(position, limits);
+                    MovesOf<Position> moves;
+                    position.generateMoves(moves);
+                    int move = -1;
+                    for (int i = 0; i < (int)moves.size(); i++) {
+                        if (result.hasMove && moves[i] == result.bestMove) move = i;
+                    }
+                    results += hex + " " + std::to_string(result.score) + " " + std::to_string(move) + "\n";
+                    _positions++;
+                    _nodes += result.stats.nodes;
+                    _queue.heartbeat(unit, owner);
+                }
+                if (!ok || !_queue.complete(unit, owner, results)) {
+                    std::lock_guard<std::mutex> lock(_outputMutex);
+                    printf("%s: %s\n", unit.c_str(), ok ? "can't store the results" : "a position doesn't read back");
+                    _failed = true;
+                    return;
+                }
+                _units++;
+                std::lock_guard<std::mutex> lock(_outputMutex);
+                printf("  %s done by %s\n", unit.c_str(), owner.c_str());
+                fflush(stdout);
+            }
+        }
+
+        const Settings&     _settings;
+        WorkQueue           _queue;
+        std::unordered_map<uint64_t, OpeningBookFile::Entry> _results;
+        std::unordered_map<uint64_t, OpeningBookFile::Entry> _book;
+        std::unordered_set<uint64_t> _missing;      // positions with nothing known below them
+
+        std::mutex          _outputMutex;
+        std::atomic<int>    _units{ 0 };
+        std::atomic<uint64_t> _positions{ 0 };
+        std::atomic<uint64_t> _nodes{ 0 };
+        std::atomic<bool>   _failed{ false };
+    };
+
+    template <class Traits>
+    int run(const Settings &settings)
+    {
+        BookBuilder<Traits> builder(settings);
+        if (settings.command == "init") return builder.init();
+        if (settings.command == "work") return builder.work();
+        if (settings.command == "status") return builder.status();
+        return builder.merge();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Settings settings;
+    if (argc >= 2) settings.command = argv[1];
+    for (int i = 2; i < argc; i++) {
+        if (!strcmp(argv[i], "--dir") && i + 1 < argc) settings.directory = argv[++i];
+        else if (!strcmp(argv[i], "--game") && i + 1 < argc) settings.config.game = argv[++i];
+        else if (!strcmp(argv[i], "--plies") && i + 1 < argc) settings.config.plies = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--depth") && i + 1 < argc) settings.config.depth = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--unit-size") && i + 1 < argc) settings.config.unitSize = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc) settings.threads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--table") && i + 1 < argc) settings.tableMB = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--stale") && i + 1 < argc) settings.staleSeconds = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--out") && i + 1 < argc) settings.out = argv[++i];
+        else if (!strcmp(argv[i], "--partial")) settings.partial = true;
+        else {
+            settings.command.clear();
+            break;
+        }
+    }
+    bool known = settings.command == "init" || settings.command == "work" || settings.command == "status" || settings.command == "merge";
+    if (!known || settings.directory.empty()) {
+        printf("usage: %s init --dir DIR [--game connectfour|othello|othello6] [--plies N] [--depth N] [--unit-size N]\n"
+               "       %s work --dir DIR [--threads N] [--table MB] [--stale SECONDS]\n"
+               "       %s status --dir DIR\n"
+               "       %s merge --dir DIR [--out FILE] [--partial]\n", argv[0], argv[0], argv[0], argv[0]);
+        return 1;
+    }
+    // everything but init works on the build init set up
+    if (settings.command != "init" && !readConfig(settings.directory, settings.config)) {
+        printf("%s has no book build, run init first\n", settings.directory.c_str());
+        return 1;
+    }
+    settings.config.plies = std::max(0, settings.config.plies);
+    settings.config.depth = std::max(1, settings.config.depth);
+    settings.config.unitSize = std::max(1, settings.config.unitSize);
+
+    if (settings.config.game == "connectfour") return run<ConnectFourTraits>(settings);
+    if (settings.config.game == "othello") return run<OthelloTraits<8>>(settings);
+    if (settings.config.game == "othello6") return run<OthelloTraits<6>>(settings);
+    printf("unknown game %s\n", settings.config.game.c_str());
+    return 1;
+}
@@ -0,0 +1,221 @@
+//
+// offline generator for the checkers endgame database
+//
+// usage: checkers_egdb [--pieces N] [--out directory]
+//
+// slices are solved in order of piece count and then number of men, so every capture or
+// promotion leads into a slice that is already on disk. a slice and its colour-flipped
+// twin depend on each other through quiet moves and are solved together by retrograde
+// analysis: every position is scored once by its captures and promotions and counts its
+// quiet moves, then the decided positions are walked back through un-moves, a loss making
+// every predecessor a win and a win taking one move off each predecessor's count until a
+// predecessor with none left is lost. the positions never decided are draws
+//
+#include "../classes/CheckersDatabase.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <set>
+
+namespace {
+    // the low bits of a position's state count its quiet moves not yet known to lose
+    const uint8_t MOVES_LEFT = 0x7F;
+    // a capture or promotion leads to a draw, so running out of quiet moves is no loss
+    const uint8_t DRAW_EXIT = 0x80;
+    // a queued position is its slice (one of at most two) in the top bit and its index
+    const uint64_t SLICE_BIT = 1ull << 63;
+
+    struct WorkSlice
+    {
+        CheckersMaterial        material;
+        std::vector<uint8_t>    values;
+        std::vector<uint8_t>    state;
+    };
+
+    int sliceOf(const CheckersMaterial &material, const std::vector<WorkSlice> &work)
+    {
+        return work[0].material == material ? 0 : 1;
+    }
+
+    //
+    // every position one quiet move before board inside the slices being solved. board has red to
+    // move, so yellow made the move: a step back for one of its pieces, men only backwards, as long
+    // as yellow had nothing to take then. the predecessors are stored with red to move, flipped
+    //
+    int predecessors(const CheckersBoard &board, const std::vector<WorkSlice> &work, uint64_t *out)
+    {
+        const int YELLOW = CheckersBoard::YELLOW;
+        int n = 0;
+        for (int king = 0; king < 2; king++) {
+            uint32_t pieces = king ? board.kings(YELLOW) : board.men(YELLOW);
+            while (pieces) {
+                int square = Bitboard::popLowestBit(pieces);
+                for (int direction = 0; direction < 4; direction++) {
+                    if (!king && !CheckersBoard::forward(YELLOW, direction)) continue;
+                    uint32_t origin = CheckersBoard::step(1u << square, CheckersBoard::opposite(direction));
+                    if (!origin || (origin & board.occupied())) continue;
+
+                    CheckersBoard previous = board;
+                    previous.setPiece(square, CheckersBoard::EMPTY);
+                    previous.setPiece(Bitboard::lowestBit(origin), king ? CheckersBoard::YELLOW_KING : CheckersBoard::YELLOW_PIECE);
+                    previous.setSideToMove(YELLOW);
+                    if (previous.hasCapture()) continue;
+
+                    CheckersBoard stored = previous.flipped();
+                    int slice = sliceOf(CheckersMaterial::of(stored), work);
+                    out[n++] = (slice ? SLICE_BIT : 0) | CheckersDatabase::indexOf(stored);
+                }
+            }
+        }
+        return n;
+    }
+
+    bool solve(std::vector<WorkSlice> &work, const CheckersDatabase &database)
+    {
+        CheckersMove moves[CheckersBoard::MAX_MOVES];
+        std::vector<uint64_t> decided;
+
+        // score the moves leaving the slices and count the rest
+        for (int s = 0; s < (int)work.size(); s++) {
+            WorkSlice &slice = work[s];
+            uint64_t size = slice.values.size();
+            slice.state.assign(size, 0);
+            for (uint64_t index = 0; index < size; index++) {
+                CheckersBoard board = CheckersDatabase::positionAt(slice.material, index);
+                int count = board.generateMoves(moves);
+                int inside = 0;
+                bool win = false;
+                bool drawExit = false;
+                for (int i = 0; i < count && !win; i++) {
+                    CheckersBoard child = board;
+                    child.makeMove(moves[i]);
+                    if (!moves[i].isCapture() && CheckersMaterial::of(child) == slice.material) {
+                        inside++;
+                        continue;
+                    }
+                    // the child has yellow to move, its value is for yellow
+                    CheckersDatabase::Value value = database.probe(child);
+                    if (value == CheckersDatabase::UNKNOWN) {
+                        printf("  missing slice %s\n", CheckersMaterial::of(child.flipped()).name().c_str());
+                        return false;
+                    }
+                    if (value == CheckersDatabase::LOSS) win = true;
+                    else if (value == CheckersDatabase::DRAW) drawExit = true;
+                }
+
+                if (win || !inside) {
+                    // no quiet move left includes positions with no legal move at all
+                    slice.values[index] = win ? CheckersDatabase::WIN : drawExit ? CheckersDatabase::DRAW : CheckersDatabase::LOSS;
+                    if (slice.values[index] != CheckersDatabase::DRAW) decided.push_back((s ? SLICE_BIT : 0) | index);
+                } else {
+                    slice.state[index] = (uint8_t)(inside | (drawExit ? DRAW_EXIT : 0));
+                }
+            }
+        }
+
+        // a lost position wins every predecessor, a won one takes a move off theirs
+        uint64_t previous[4 * CheckersBoard::SQUARES];
+        uint64_t walked = 0;
+        while (!decided.empty()) {
+            uint64_t entry = decided.back();
+            decided.pop_back();
+            const WorkSlice &slice = work[(entry & SLICE_BIT) ? 1 : 0];
+            uint64_t index = entry & ~SLICE_BIT;
+            bool lost = slice.values[index] == CheckersDatabase::LOSS;
+            walked++;
+
+            int count = predecessors(CheckersDatabase::positionAt(slice.material, index), work, previous);
+            for (int i = 0; i < count; i++) {
+                WorkSlice &parent = work[(previous[i] & SLICE_BIT) ? 1 : 0];
+                uint64_t parentIndex = previous[i] & ~SLICE_BIT;
+                if (parent.values[parentIndex] != CheckersDatabase::UNKNOWN) continue;
+
+                if (lost) {
+                    parent.values[parentIndex] = CheckersDatabase::WIN;
+                    decided.push_back(previous[i]);
+                    continue;
+                }
+                uint8_t &state = parent.state[parentIndex];
+                state--;
+                if (state & MOVES_LEFT) continue;
+                if (state & DRAW_EXIT) {
+                    parent.values[parentIndex] = CheckersDatabase::DRAW;
+                } else {
+                    parent.values[parentIndex] = CheckersDatabase::LOSS;
+                    decided.push_back(previous[i]);
+                }
+            }
+        }
+
+        for (WorkSlice &slice : work) {
+            std::replace(slice.values.begin(), slice.values.end(), (uint8_t)CheckersDatabase::UNKNOWN, (uint8_t)CheckersDatabase::DRAW);
+            slice.state = std::vector<uint8_t>();
+        }
+        printf("  %llu decided positions walked back\n", (unsigned long long)walked);
+        return true;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int maxPieces = 4;
+    std::string directory = "egdb/checkers";
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--pieces") && i + 1 < argc) maxPieces = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--out") && i + 1 < argc) directory = argv[++i];
+        else {
+            printf("usage: %s [--pieces N] [--out directory]\n", argv[0]);
+            return 1;
+        }
+    }
+    maxPieces = std::clamp(maxPieces, 2, (int)CheckersDatabase::MAX_PIECES);
+
+    auto start = std::chrono::steady_clock::now();
+    CheckersDatabase database;
+    database.open(directory, maxPieces);
+
+    for (int pieces = 2; pieces <= maxPieces; pieces++) {
+        std::vector<CheckersMaterial> slices = CheckersDatabase::slicesWith(pieces);
+        std::stable_sort(slices.begin(), slices.end(), [](const CheckersMaterial &a, const CheckersMaterial &b) {
+            return a.redMen + a.yellowMen < b.redMen + b.yellowMen;
+        });
+
+        std::set<int> done;
+        for (const CheckersMaterial &material : slices) {
+            if (done.count(material.key())) continue;
+
+            std::vector<WorkSlice> work;
+            work.push_back({ material, {}, {} });
+            if (!(material.flipped() == material)) work.push_back({ material.flipped(), {}, {} });
+
+            for (WorkSlice &slice : work) {
+                done.insert(slice.material.key());
+                slice.values.assign(CheckersDatabase::sliceSize(slice.material), CheckersDatabase::UNKNOWN);
+                printf("slice %s: %llu positions\n", slice.material.name().c_str(), (unsigned long long)slice.values.size());
+            }
+
+            if (!solve(work, database)) return 1;
+
+            for (WorkSlice &slice : work) {
+                uint64_t counts[4] = { 0, 0, 0, 0 };
+                for (uint8_t value : slice.values) counts[value]++;
+                printf("  %s: %llu wins, %llu losses, %llu draws\n", slice.material.name().c_str(),
+                       (unsigned long long)counts[CheckersDatabase::WIN], (unsigned long long)counts[CheckersDatabase::LOSS],
+                       (unsigned long long)counts[CheckersDatabase::DRAW]);
+                if (!CheckersDatabase::writeSlice(directory, slice.material, slice.values)) {
+                    printf("failed to write %s\n", CheckersDatabase::slicePath(directory, slice.material).c_str());
+                    return 1;
+                }
+            }
+
+            // make the finished slices visible to the ones that depend on them
+            database.open(directory, maxPieces);
+        }
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - start).count();
+    printf("database complete up to %d pieces in %s (%lld s)\n", database.maxPieces(), directory.c_str(), (long long)elapsed);
+    return 0;
+}
@@ -0,0 +1,96 @@
+//
+// search benchmark for the chess engine
+//
+// usage: chess_bench [--threads N] [--time MS] [--depth D] [--fen FEN] [--tablebase directory]
+//
+// searches a handful of middlegame and endgame positions (or the one given) and prints the depth
+// reached, nodes, nodes per second, the best move and the principal variation of each
+// tablebases are used when the directory (egdb/chess by default) has any
+//
+#include "../classes/ChessEngine.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    const char* const POSITIONS[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",            // back rank mate in one
+        "8/8/8/4k3/8/8/8/4K2Q w - - 0 1",                   // king and queen against king
+        "8/8/8/8/8/2k5/8/K5QR w - - 0 1",                   // four pieces, tablebase territory
+        "8/8/1k6/8/8/3K4/3P4/8 w - - 0 1",                  // king and pawn against king
+    };
+
+    uint64_t searchPosition(ChessEngine &engine, const std::string &fen, const ChessSearchLimits &limits)
+    {
+        ChessBoard board;
+        if (!board.fromFen(fen)) {
+            printf("bad fen: %s\n", fen.c_str());
+            return 0;
+        }
+
+        engine.clearTable();
+        ChessSearchResult result = engine.search(board, limits);
+
+        std::string score = ChessEngine::isMateScore(result.score)
+            ? "mate " + std::to_string(result.score > 0 ? (ChessEngine::MATE_SCORE - result.score + 1) / 2 : -(ChessEngine::MATE_SCORE + result.score) / 2)
+            : "cp " + std::to_string(result.score);
+        std::string pv;
+        for (const ChessMove &move : result.pv) {
+            pv += ' ';
+            pv += move.toString();
+        }
+
+        printf("%s\n  depth %d score %s nodes %llu time %d ms nps %llu tbhits %llu bestmove %s pv%s\n", fen.c_str(), result.depth,
+               score.c_str(), (unsigned long long)result.nodes, result.timeMs, (unsigned long long)result.nodesPerSecond,
+               (unsigned long long)result.tableHits,
+               result.hasMove ? result.bestMove.toString().c_str() : "none", pv.c_str());
+        return result.nodes;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ChessSearchLimits limits;
+    limits.threads = std::max(1, (int)std::thread::hardware_concurrency());
+    limits.timeMs = 2000;
+    std::string fen;
+    std::string tablebaseDirectory = "egdb/chess";
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--threads") && i + 1 < argc) limits.threads = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--time") && i + 1 < argc) limits.timeMs = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--depth") && i + 1 < argc) limits.maxDepth = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--fen") && i + 1 < argc) fen = argv[++i];
+        else if (!strcmp(argv[i], "--tablebase") && i + 1 < argc) tablebaseDirectory = argv[++i];
+        else {
+            printf("usage: %s [--threads N] [--time MS] [--depth D] [--fen FEN] [--tablebase directory]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("%d threads, %d ms per position\n", limits.threads, limits.timeMs);
+    ChessEngine engine(128);
+    ChessTablebase tablebase;
+    if (tablebase.open(tablebaseDirectory) > 0) {
+        engine.setTablebase(&tablebase);
+        printf("%d tablebases, complete up to %d pieces\n", tablebase.tableCount(), tablebase.maxPieces());
+    }
+    if (!fen.empty()) {
+        searchPosition(engine, fen, limits);
+        return 0;
+    }
+
+    uint64_t nodes = 0;
+    for (const char* position : POSITIONS) {
+        nodes += searchPosition(engine, position, limits);
+    }
+    printf("total: %llu nodes\n", (unsigned long long)nodes);
+    return 0;
+}
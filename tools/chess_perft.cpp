@@ -0,0 +1,141 @@
+//
+// multi-threaded perft for the chess move generator
+//
+// usage: chess_perft [--threads N] [--fen FEN --depth D]
+//
+// without a fen the standard test positions are run and checked against their published node
+// counts, the exit code is non-zero when any count is wrong. the tree is split two plies below
+// the root and the subtrees are handed to the worker threads from a shared counter
+//
+#include "../classes/ChessBoard.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    struct PerftCase
+    {
+        const char* fen;
+        int         depth;
+        uint64_t    nodes;
+    };
+
+    const PerftCase SUITE[] = {
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 6, 119060324ull },
+        { "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 5, 193690690ull },
+        { "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 7, 178633661ull },
+        { "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 5, 15833292ull },
+        { "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 5, 89941194ull },
+        { "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 5, 164075551ull },
+    };
+
+    // leaf moves are counted, not made
+    uint64_t perft(const ChessBoard &board, int depth)
+    {
+        ChessMove moves[ChessBoard::MAX_MOVES];
+        int count = board.generateMoves(moves);
+        if (depth <= 1) return (uint64_t)count;
+
+        uint64_t total = 0;
+        for (int i = 0; i < count; i++) {
+            ChessBoard child = board;
+            child.makeMove(moves[i]);
+            total += perft(child, depth - 1);
+        }
+        return total;
+    }
+
+    uint64_t parallelPerft(const ChessBoard &board, int depth, int threads)
+    {
+        if (depth <= 2 || threads <= 1) return perft(board, depth);
+
+        // every position two plies down is one job
+        std::vector<ChessBoard> jobs;
+        ChessMove moves[ChessBoard::MAX_MOVES];
+        ChessMove replies[ChessBoard::MAX_MOVES];
+        int count = board.generateMoves(moves);
+        for (int i = 0; i < count; i++) {
+            ChessBoard child = board;
+            child.makeMove(moves[i]);
+            int replyCount = child.generateMoves(replies);
+            for (int j = 0; j < replyCount; j++) {
+                jobs.push_back(child);
+                jobs.back().makeMove(replies[j]);
+            }
+        }
+
+        std::atomic<size_t> next{ 0 };
+        std::atomic<uint64_t> total{ 0 };
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back([&]() {
+                uint64_t nodes = 0;
+                for (size_t job = next++; job < jobs.size(); job = next++) {
+                    nodes += perft(jobs[job], depth - 2);
+                }
+                total += nodes;
+            });
+        }
+        for (std::thread &worker : workers) worker.join();
+        return total;
+    }
+
+    bool run(const std::string &fen, int depth, uint64_t expected, int threads)
+    {
+        ChessBoard board;
+        if (!board.fromFen(fen)) {
+            printf("bad fen: %s\n", fen.c_str());
+            return false;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        uint64_t nodes = parallelPerft(board, depth, threads);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        bool ok = expected == 0 || nodes == expected;
+        printf("%s depth %d: %12llu nodes %8.3f s %8.1f Mnps  %s\n", fen.c_str(), depth, (unsigned long long)nodes, seconds,
+               seconds > 0 ? nodes / seconds / 1e6 : 0.0, expected == 0 ? "" : (ok ? "ok" : "MISMATCH"));
+        if (!ok) printf("  expected %llu\n", (unsigned long long)expected);
+        return ok;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int threads = std::max(1, (int)std::thread::hardware_concurrency());
+    int depth = 0;
+    std::string fen;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--threads") && i + 1 < argc) threads = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--depth") && i + 1 < argc) depth = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--fen") && i + 1 < argc) fen = argv[++i];
+        else {
+            printf("usage: %s [--threads N] [--fen FEN --depth D]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("%d threads\n", threads);
+    if (!fen.empty()) {
+        return run(fen, depth > 0 ? depth : 5, 0, threads) ? 0 : 1;
+    }
+
+    bool ok = true;
+    auto start = std::chrono::steady_clock::now();
+    uint64_t nodes = 0;
+    for (const PerftCase &test : SUITE) {
+        int testDepth = depth > 0 ? std::min(depth, test.depth) : test.depth;
+        ok = run(test.fen, testDepth, testDepth == test.depth ? test.nodes : 0, threads) && ok;
+        nodes += test.nodes;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (depth == 0) printf("suite: %llu nodes in %.3f s, %.1f Mnps\n", (unsigned long long)nodes, seconds, nodes / seconds / 1e6);
+    printf(ok ? "all counts match\n" : "perft FAILED\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,325 @@
+//
+// offline generator for the chess distance to mate tablebases
+//
+// usage: chess_tablebase [--pieces N] [--out directory] [--table KQKR]
+//
+// tables are built in order of piece count and then number of pawns, so every capture or
+// promotion leads into a table that is already on disk. each table is solved on a full
+// unreduced index (side, both kings and every piece on any square) by retrograde analysis:
+// first every position is scored by its moves that leave the table and counts the ones that
+// stay, then positions are resolved one ply at a time by walking un-moves back from the
+// positions decided at the previous ply. the result is written symmetry reduced
+//
+// en passant is ignored inside the table, a double push is scored as an ordinary move
+//
+#include "../classes/ChessTablebase.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+    const uint8_t RESOLVED = 0x80;
+    const uint8_t MOVES_LEFT = 0x7F;
+    // unresolved positions with a drawing way out of the table, can never lose
+    const uint8_t DRAW_EXIT = 253;
+    const int MAX_PLIES = 250;
+
+    //
+    // full index: side to move, white king, black king and then the pieces in table order,
+    // six bits each. identical pieces only in ascending order
+    //
+    struct FullLayout
+    {
+        int         colors[8];
+        int         pieces[8];
+        int         count;
+        int         bits;
+
+        explicit FullLayout(const ChessMaterial &material)
+        {
+            count = 0;
+            for (int color = 0; color < 2; color++) {
+                for (int piece = ChessBoard::QUEEN; piece >= ChessBoard::PAWN; piece--) {
+                    for (int i = 0; i < material.counts[color][piece]; i++) {
+                        colors[count] = color;
+                        pieces[count] = piece;
+                        count++;
+                    }
+                }
+            }
+            bits = 1 + 6 * (count + 2);
+        }
+
+        uint64_t size() const { return 1ull << bits; }
+
+        uint64_t indexOf(const ChessBoard &board) const
+        {
+            uint64_t index = (uint64_t)board.sideToMove();
+            index = (index << 6) | board.kingSquare(ChessBoard::WHITE);
+            index = (index << 6) | board.kingSquare(ChessBoard::BLACK);
+            int i = 0;
+            while (i < count) {
+                // squares come out of the bitboard lowest first
+                uint64_t bits = board.pieces(colors[i], pieces[i]);
+                while (bits) {
+                    index = (index << 6) | Bitboard::popLowestBit(bits);
+                    i++;
+                }
+            }
+            return index;
+        }
+
+        bool positionAt(uint64_t index, ChessBoard &board) const
+        {
+            int squares[8];
+            for (int i = count - 1; i >= 0; i--) {
+                squares[i] = (int)(index & 63);
+                index >>= 6;
+            }
+            int blackKing = (int)(index & 63);
+            int whiteKing = (int)((index >> 6) & 63);
+            int side = (int)(index >> 12);
+            if (whiteKing == blackKing) return false;
+
+            board = ChessBoard();
+            board.setPiece(whiteKing, ChessBoard::WHITE, ChessBoard::KING);
+            board.setPiece(blackKing, ChessBoard::BLACK, ChessBoard::KING);
+            for (int i = 0; i < count; i++) {
+                if (!board.isEmpty(squares[i])) return false;
+                if (pieces[i] == ChessBoard::PAWN && (squares[i] < 8 || squares[i] >= 56)) return false;
+                if (i > 0 && colors[i] == colors[i - 1] && pieces[i] == pieces[i - 1] && squares[i] < squares[i - 1]) return false;
+                board.setPiece(squares[i], colors[i], pieces[i]);
+            }
+            board.setSideToMove(side);
+            return !board.isAttacked(board.kingSquare(side ^ 1), side);
+        }
+    };
+
+    //
+    // every legal position one quiet move before board, the moves that stay inside the table
+    //
+    int predecessors(const ChessBoard &board, const FullLayout &layout, uint64_t *out)
+    {
+        int mover = board.sideToMove() ^ 1;
+        uint64_t occupied = board.occupied();
+        int n = 0;
+
+        for (int piece = ChessBoard::PAWN; piece <= ChessBoard::KING; piece++) {
+            uint64_t pieces = board.pieces(mover, piece);
+            while (pieces) {
+                int square = Bitboard::popLowestBit(pieces);
+                uint64_t from = 0;
+                switch (piece) {
+                case ChessBoard::PAWN:
+                    if (mover == ChessBoard::WHITE) {
+                        if (square >= 16 && !(occupied & (1ull << (square - 8)))) {
+                            from |= 1ull << (square - 8);
+                            if (ChessBoard::rankOf(square) == 3 && !(occupied & (1ull << (square - 16)))) from |= 1ull << (square - 16);
+                        }
+                    } else {
+                        if (square < 48 && !(occupied & (1ull << (square + 8)))) {
+                            from |= 1ull << (square + 8);
+                            if (ChessBoard::rankOf(square) == 4 && !(occupied & (1ull << (square + 16)))) from |= 1ull << (square + 16);
+                        }
+                    }
+                    break;
+                case ChessBoard::KNIGHT: from = ChessBoard::knightAttacks(square) & ~occupied; break;
+                case ChessBoard::BISHOP: from = ChessBoard::bishopAttacks(square, occupied) & ~occupied; break;
+                case ChessBoard::ROOK: from = ChessBoard::rookAttacks(square, occupied) & ~occupied; break;
+                case ChessBoard::QUEEN: from = ChessBoard::queenAttacks(square, occupied) & ~occupied; break;
+                case ChessBoard::KING: from = ChessBoard::kingAttacks(square) & ~occupied; break;
+                }
+
+                while (from) {
+                    int origin = Bitboard::popLowestBit(from);
+                    ChessBoard previous = board;
+                    previous.clearSquare(square);
+                    previous.setPiece(origin, mover, piece);
+                    previous.setSideToMove(mover);
+                    // the side not to move can't be in check before the move either
+                    if (previous.isAttacked(previous.kingSquare(mover ^ 1), mover)) continue;
+                    out[n++] = layout.indexOf(previous);
+                }
+            }
+        }
+        return n;
+    }
+
+    bool solve(const ChessMaterial &material, const ChessTablebase &tablebase, std::vector<uint8_t> &values)
+    {
+        FullLayout layout(material);
+        uint64_t size = layout.size();
+        std::vector<uint8_t> value(size, ChessTablebase::INVALID);
+        std::vector<uint8_t> state(size, RESOLVED);
+        ChessMove moves[ChessBoard::MAX_MOVES];
+        ChessBoard board;
+        int lastPly = 0;
+
+        // score the moves leaving the table and count the rest
+        for (uint64_t index = 0; index < size; index++) {
+            if (!layout.positionAt(index, board)) continue;
+
+            int count = board.generateMoves(moves);
+            if (count == 0) {
+                value[index] = board.inCheck() ? ChessTablebase::loss(0) : ChessTablebase::DRAW;
+                continue;
+            }
+
+            int inside = 0;
+            int exitWin = INT_MAX;
+            int exitLoss = -1;
+            bool exitDraw = false;
+            for (int i = 0; i < count; i++) {
+                if (!moves[i].isCapture() && !moves[i].isPromotion()) {
+                    inside++;
+                    continue;
+                }
+                ChessBoard child = board;
+                child.makeMove(moves[i]);
+                uint8_t result;
+                if (!tablebase.probe(child, result)) {
+                    printf("  missing table %s\n", ChessMaterial::of(child).name().c_str());
+                    return false;
+                }
+                if (result == ChessTablebase::DRAW) exitDraw = true;
+                else if (ChessTablebase::isLoss(result)) exitWin = std::min(exitWin, ChessTablebase::plies(result) + 1);
+                else exitLoss = std::max(exitLoss, ChessTablebase::plies(result) + 1);
+            }
+
+            // unresolved positions keep the best exit in their value until the retrograde pass reaches it
+            if (exitWin != INT_MAX) {
+                value[index] = ChessTablebase::win(exitWin);
+                lastPly = std::max(lastPly, exitWin);
+            } else if (exitDraw) {
+                value[index] = inside ? DRAW_EXIT : ChessTablebase::DRAW;
+            } else if (exitLoss >= 0) {
+                value[index] = ChessTablebase::loss(exitLoss);
+                if (!inside) lastPly = std::max(lastPly, exitLoss);
+            } else {
+                value[index] = ChessTablebase::DRAW;
+            }
+            if (inside || exitWin != INT_MAX) state[index] = (uint8_t)inside;
+        }
+
+        // positions decided at ply n decide their predecessors at ply n + 1
+        uint64_t previous[ChessBoard::MAX_MOVES];
+        for (int ply = 0; ply <= lastPly && ply <= MAX_PLIES; ply++) {
+            bool winning = ply & 1;
+            uint8_t target = winning ? ChessTablebase::win(ply) : ChessTablebase::loss(ply);
+
+            for (uint64_t index = 0; index < size; index++) {
+                if (value[index] != target) continue;
+                if (!(state[index] & RESOLVED)) {
+                    // a win through an exit, or only the worst exit of a position still undecided
+                    if (!winning) continue;
+                    state[index] = RESOLVED;
+                }
+
+                layout.positionAt(index, board);
+                int count = predecessors(board, layout, previous);
+                for (int i = 0; i < count; i++) {
+                    uint64_t parent = previous[i];
+                    if (state[parent] & RESOLVED) continue;
+
+                    if (!winning) {
+                        value[parent] = ChessTablebase::win(ply + 1);
+                        state[parent] = RESOLVED;
+                        lastPly = std::max(lastPly, ply + 1);
+                        continue;
+                    }
+
+                    int left = (state[parent] & MOVES_LEFT) - 1;
+                    state[parent] = (uint8_t)left;
+                    if (left > 0) continue;
+
+                    uint8_t best = value[parent];
+                    if (best == DRAW_EXIT) {
+                        value[parent] = ChessTablebase::DRAW;
+                        state[parent] = RESOLVED;
+                    } else if (!ChessTablebase::isWin(best)) {
+                        // every move loses, as slowly as possible
+                        int plies = ChessTablebase::isLoss(best) ? std::max(ply + 1, ChessTablebase::plies(best)) : ply + 1;
+                        value[parent] = ChessTablebase::loss(plies);
+                        state[parent] = RESOLVED;
+                        lastPly = std::max(lastPly, plies);
+                    }
+                }
+            }
+        }
+        if (lastPly > MAX_PLIES) {
+            printf("  longest mate is over %d plies\n", MAX_PLIES);
+            return false;
+        }
+
+        // anything never decided is a draw
+        for (uint64_t index = 0; index < size; index++) {
+            if (!(state[index] & RESOLVED)) value[index] = ChessTablebase::DRAW;
+        }
+
+        values.assign(ChessTablebase::tableSize(material), ChessTablebase::INVALID);
+        for (uint64_t index = 0; index < values.size(); index++) {
+            if (ChessTablebase::positionAt(material, index, board)) values[index] = value[layout.indexOf(board)];
+        }
+        return true;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int maxPieces = ChessTablebase::MAX_PIECES;
+    std::string directory = "egdb/chess";
+    std::string only;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--pieces") && i + 1 < argc) maxPieces = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--out") && i + 1 < argc) directory = argv[++i];
+        else if (!strcmp(argv[i], "--table") && i + 1 < argc) only = argv[++i];
+        else {
+            printf("usage: %s [--pieces N] [--out directory] [--table KQKR]\n", argv[0]);
+            return 1;
+        }
+    }
+    maxPieces = std::clamp(maxPieces, 3, (int)ChessTablebase::MAX_PIECES);
+
+    auto start = std::chrono::steady_clock::now();
+    ChessTablebase tablebase;
+    tablebase.open(directory, maxPieces);
+
+    for (int pieces = 3; pieces <= maxPieces; pieces++) {
+        for (const ChessMaterial &material : ChessTablebase::tablesWith(pieces)) {
+            if (!only.empty() && material.name() != only) continue;
+
+            auto tableStart = std::chrono::steady_clock::now();
+            printf("table %s: %llu positions\n", material.name().c_str(), (unsigned long long)ChessTablebase::tableSize(material));
+            std::vector<uint8_t> values;
+            if (!solve(material, tablebase, values)) return 1;
+
+            uint64_t wins = 0, losses = 0, draws = 0;
+            int longest = 0;
+            for (uint8_t value : values) {
+                if (value == ChessTablebase::INVALID) continue;
+                if (value == ChessTablebase::DRAW) draws++;
+                else if (ChessTablebase::isWin(value)) wins++;
+                else losses++;
+                if (value != ChessTablebase::DRAW && ChessTablebase::isWin(value)) longest = std::max(longest, ChessTablebase::plies(value));
+            }
+            auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - tableStart).count();
+            printf("  %llu wins, %llu losses, %llu draws, longest mate %d plies (%.1f s)\n", (unsigned long long)wins,
+                   (unsigned long long)losses, (unsigned long long)draws, longest, seconds);
+
+            if (!ChessTablebase::writeTable(directory, material, values)) {
+                printf("failed to write %s\n", ChessTablebase::tablePath(directory, material).c_str());
+                return 1;
+            }
+
+            // make the finished table visible to the ones that depend on it
+            tablebase.open(directory, maxPieces);
+        }
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - start).count();
+    printf("tablebase complete up to %d pieces in %s (%lld s)\n", tablebase.maxPieces(), directory.c_str(), (long long)elapsed);
+    return 0;
+}
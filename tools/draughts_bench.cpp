@@ -0,0 +1,108 @@
+//
+// move generator and search benchmark shared by the draughts variants
+//
+// usage: draughts_bench [--variant checkers|international|both] [--perft N] [--time ms]
+//
+// perft counts leaf positions of the legal move tree from the start position and checks them
+// against the published counts, the exit code is non-zero when any is wrong. the search part
+// runs the engine for a fixed time and reports depth, nodes and nodes per second, then does the
+// same with the generic SearchEngine on the engine's evaluation for comparison
+//
+#include "../classes/CheckersEngine.h"
+#include "../classes/DraughtsPosition.h"
+#include "../classes/Search.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace {
+    // from the start position, depth 1 first
+    const uint64_t CHECKERS_PERFT[] = { 7, 49, 302, 1469, 7361, 36768, 179740, 845931, 3963680, 18391564, 85242128 };
+    const uint64_t INTERNATIONAL_PERFT[] = { 9, 81, 658, 4265, 27117, 167140, 1049442, 6483961, 41022423, 258895763 };
+
+    template <class Board>
+    uint64_t perft(const Board &board, int depth)
+    {
+        typename Board::Move moves[Board::MAX_MOVES];
+        int count = board.generateMoves(moves);
+        if (depth <= 1) return (uint64_t)count;
+
+        uint64_t total = 0;
+        for (int i = 0; i < count; i++) {
+            Board child = board;
+            child.makeMove(moves[i]);
+            total += perft(child, depth - 1);
+        }
+        return total;
+    }
+
+    // false when a perft count differs from the known one, deeper counts are only reported
+    template <class Board, size_t KNOWN>
+    bool bench(const char *name, const uint64_t (&known)[KNOWN], int perftDepth, int timeMs)
+    {
+        printf("%s\n", name);
+        Board board = Board::initial();
+        bool ok = true;
+
+        for (int depth = 1; depth <= perftDepth; depth++) {
+            auto start = std::chrono::steady_clock::now();
+            uint64_t nodes = perft(board, depth);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            bool checked = depth <= (int)KNOWN;
+            bool right = !checked || nodes == known[depth - 1];
+            printf("  perft %2d: %12llu  %8.3f s  %6.1f Mnps%s\n", depth, (unsigned long long)nodes, seconds,
+                   seconds > 0 ? nodes / seconds / 1e6 : 0.0, !checked ? "" : right ? "  ok" : "  WRONG");
+            if (!right) {
+                printf("  expected %llu\n", (unsigned long long)known[depth - 1]);
+                ok = false;
+            }
+        }
+
+        DraughtsEngine<Board> engine;
+        CheckersSearchLimits limits;
+        limits.timeMs = timeMs;
+        auto result = engine.search(board, limits);
+        int elapsed = result.timeMs > 0 ? result.timeMs : 1;
+        printf("  search: depth %d  score %d  nodes %llu  %d ms  %llu nps\n", result.depth, result.score,
+               (unsigned long long)result.nodes, result.timeMs, (unsigned long long)(result.nodes * 1000 / elapsed));
+
+        SearchEngine<DraughtsTraits<Board>> generic(16 << 20);
+        SearchLimits genericLimits;
+        genericLimits.timeMs = timeMs;
+        auto genericResult = generic.search(DraughtsPosition<Board>(), genericLimits);
+        const SearchStats &stats = genericResult.stats;
+        elapsed = stats.timeMs > 0 ? stats.timeMs : 1;
+        printf("  generic: depth %d  score %d  nodes %llu  %d ms  %llu nps  table hits %.1f%%  first move cutoffs %.1f%%\n",
+               genericResult.depth, genericResult.score, (unsigned long long)stats.nodes, stats.timeMs,
+               (unsigned long long)(stats.nodes * 1000 / elapsed), stats.tableProbes ? 100.0 * stats.tableHits / stats.tableProbes : 0.0,
+               stats.cutoffs ? 100.0 * stats.firstMoveCutoffs / stats.cutoffs : 0.0);
+        return ok;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string variant = "both";
+    int perftDepth = 8;
+    int timeMs = 2000;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--variant") && i + 1 < argc) variant = argv[++i];
+        else if (!strcmp(argv[i], "--perft") && i + 1 < argc) perftDepth = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--time") && i + 1 < argc) timeMs = atoi(argv[++i]);
+        else {
+            printf("usage: %s [--variant checkers|international|both] [--perft N] [--time ms]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    bool ok = true;
+    if (variant == "checkers" || variant == "both") {
+        ok = bench<CheckersBoard>("checkers 8x8", CHECKERS_PERFT, perftDepth, timeMs) && ok;
+    }
+    if (variant == "international" || variant == "both") {
+        ok = bench<InternationalBoard>("international draughts 10x10", INTERNATIONAL_PERFT, perftDepth, timeMs) && ok;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+//
+// repetition draw check for the draughts games, run by ctest
+//
+// usage: draughts_repetition
+//
+// two kings shuffle back and forth on an otherwise empty board: the start position is seen for the
+// third time after two rounds of four plies and is a draw then, not before. a man move in between
+// starts the count over
+//
+#include "../classes/DraughtsPosition.h"
+#include <cstdio>
+
+namespace {
+    const int DRAW_REPETITIONS = 3;
+
+    // a move that takes nothing from one square to the other
+    template <class Board>
+    bool findMove(const Board &board, int from, int to, typename Board::Move &found)
+    {
+        typename Board::Move moves[Board::MAX_MOVES];
+        int count = board.generateMoves(moves);
+        for (int i = 0; i < count; i++) {
+            if (moves[i].from == from && moves[i].to() == to && !moves[i].captured) {
+                found = moves[i];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template <class Board>
+    bool play(DraughtsRepetitions<Board> &repetitions, Board &board, int from, int to)
+    {
+        typename Board::Move move;
+        if (!findMove(board, from, to, move)) {
+            printf("  no move %d-%d\n", from, to);
+            return false;
+        }
+        repetitions.play(board, move);
+        return true;
+    }
+
+    // one king on each side near opposite corners, a yellow man out of the way
+    template <class Board>
+    bool shuffle(const char *name)
+    {
+        int redFrom = Board::squareAt(1, 0), redTo = Board::squareAt(2, 1);
+        int yellowFrom = Board::squareAt(Board::WIDTH - 2, Board::WIDTH - 1), yellowTo = Board::squareAt(Board::WIDTH - 3, Board::WIDTH - 2);
+        int man = Board::squareAt(0, Board::WIDTH - 1);
+
+        Board board;
+        board.setPiece(redFrom, Board::RED_KING);
+        board.setPiece(yellowFrom, Board::YELLOW_KING);
+        board.setPiece(man, Board::YELLOW_PIECE);
+        board.setSideToMove(Board::RED);
+
+        DraughtsRepetitions<Board> repetitions;
+        repetitions.reset(board);
+        Board start = board;
+        bool ok = true;
+
+        for (int round = 1; round <= 2 && ok; round++) {
+            ok = play(repetitions, board, redFrom, redTo) && play(repetitions, board, yellowFrom, yellowTo) &&
+                 play(repetitions, board, redTo, redFrom) && play(repetitions, board, yellowTo, yellowFrom);
+            if (!ok) break;
+            // asking twice must not change the answer
+            repetitions.occurrences(board);
+            int seen = repetitions.occurrences(board);
+            bool draw = seen >= DRAW_REPETITIONS;
+            if (board.hash() != start.hash() || seen != round + 1 || draw != (round == 2)) {
+                printf("  round %d: seen %d times, draw %d\n", round, seen, (int)draw);
+                ok = false;
+            }
+        }
+
+        // the same pieces with the other side to move are a different position
+        Board otherSide = start;
+        otherSide.setSideToMove(Board::YELLOW);
+        if (ok && repetitions.occurrences(otherSide) != 0) {
+            printf("  the other side to move counted as a repetition\n");
+            ok = false;
+        }
+
+        // a man move can't be undone, nothing before it repeats
+        if (ok) {
+            ok = play(repetitions, board, redFrom, redTo);
+            ok = ok && play(repetitions, board, man, Board::squareAt(1, Board::WIDTH - 2));
+            if (ok && repetitions.occurrences(board) != 1) {
+                printf("  the history survived a man move\n");
+                ok = false;
+            }
+        }
+
+        printf("%s: %s\n", name, ok ? "ok" : "FAILED");
+        return ok;
+    }
+}
+
+int main()
+{
+    bool ok = shuffle<CheckersBoard>("checkers");
+    ok = shuffle<InternationalBoard>("international") && ok;
+    return ok ? 0 : 1;
+}
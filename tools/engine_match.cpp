@@ -0,0 +1,113 @@
+//
+// plays the MCTS engine against the alpha-beta SearchEngine on the same traits
+//
+// usage: engine_match [--game tictactoe|connectfour|othello|checkers] [--games N] [--time ms]
+//                     [--threads N] [--uct|--puct] [--random-rollouts]
+//
+// the engines swap sides every game and the first two plies are random so the games differ.
+// reports the MCTS score, its playouts per second and how much of each tree the next move reused
+//
+#include "../classes/ConnectFourBoard.h"
+#include "../classes/DraughtsPosition.h"
+#include "../classes/Mcts.h"
+#include "../classes/OthelloBoard.h"
+#include "../classes/Search.h"
+#include "../classes/TicTacToeBoard.h"
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+
+namespace {
+    struct MatchSettings
+    {
+        int         games = 10;
+        int         timeMs = 200;
+        MctsOptions options;
+    };
+
+    template <class Traits>
+    void match(const char *name, const MatchSettings &settings)
+    {
+        using Position = typename Traits::Position;
+        std::mt19937 random(1);
+        int wins = 0, draws = 0, losses = 0;
+        uint64_t playouts = 0, reused = 0, nodes = 0, searchMs = 0;
+
+        for (int game = 0; game < settings.games; game++) {
+            MctsEngine<Traits> mcts(settings.options);
+            SearchEngine<Traits> alphaBeta(16 << 20);
+            int mctsSide = game & 1;
+
+            Position position;
+            int ply = 0;
+            while (!position.isTerminal() && ply < 400) {
+                MovesOf<Position> moves;
+                position.generateMoves(moves);
+                typename Position::Move move;
+                if (ply < 2) {
+                    move = moves[(int)(random() % (unsigned)moves.size())];
+                } else if (position.sideToMove() == mctsSide) {
+                    MctsLimits limits;
+                    limits.timeMs = settings.timeMs;
+                    auto result = mcts.search(position, limits);
+                    move = result.bestMove;
+                    playouts += result.playouts;
+                    reused += result.reusedNodes;
+                    nodes += result.nodes;
+                    searchMs += (uint64_t)result.timeMs;
+                } else {
+                    SearchLimits limits;
+                    limits.timeMs = settings.timeMs;
+                    move = alphaBeta.search(position, limits).bestMove;
+                }
+                position.makeMove(move);
+                ply++;
+            }
+
+            int result = position.isTerminal() ? Traits::result(position) : 0;
+            int winner = result > 0 ? position.sideToMove() : result < 0 ? position.sideToMove() ^ 1 : -1;
+            if (winner < 0) draws++;
+            else if (winner == mctsSide) wins++;
+            else losses++;
+            printf("  game %2d: mcts as %s, %s\n", game + 1, mctsSide == 0 ? "first" : "second",
+                   winner < 0 ? "draw" : winner == mctsSide ? "mcts won" : "alpha-beta won");
+        }
+
+        printf("%s: mcts +%d =%d -%d  %.0f playouts/s  %.1f%% of each tree reused\n", name, wins, draws, losses,
+               searchMs ? playouts * 1000.0 / searchMs : 0.0, nodes ? 100.0 * reused / nodes : 0.0);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string game = "connectfour";
+    MatchSettings settings;
+    settings.options.lightRollouts = true;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--game") && i + 1 < argc) game = argv[++i];
+        else if (!strcmp(argv[i], "--games") && i + 1 < argc) settings.games = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--time") && i + 1 < argc) settings.timeMs = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc) settings.options.threads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--uct")) settings.options.selection = MctsOptions::UCT;
+        else if (!strcmp(argv[i], "--puct")) settings.options.selection = MctsOptions::PUCT;
+        else if (!strcmp(argv[i], "--random-rollouts")) settings.options.lightRollouts = false;
+        else {
+            printf("usage: %s [--game tictactoe|connectfour|othello|checkers] [--games N] [--time ms]\n"
+                   "          [--threads N] [--uct|--puct] [--random-rollouts]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (settings.options.selection == MctsOptions::PUCT) settings.options.exploration = 1.5f;
+
+    if (game == "tictactoe") match<TicTacToeTraits>("tic tac toe", settings);
+    else if (game == "connectfour") match<ConnectFourTraits>("connect four", settings);
+    else if (game == "othello") match<OthelloTraits<8>>("othello", settings);
+    else if (game == "checkers") match<DraughtsTraits<CheckersBoard>>("checkers", settings);
+    else {
+        printf("unknown game %s\n", game.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,34 @@
+//
+// headless engine for the board games speaking a UCI-like protocol on stdin and stdout
+//
+// usage: game_engine [--game tictactoe|connectfour|othello|othello6|othello10|checkers|international]
+//
+// see EngineProtocol.h for the commands, e.g.
+//   position startpos moves d c
+//   go movetime 1000
+//
+#include "../classes/EngineProtocol.h"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+int main(int argc, char **argv)
+{
+    std::string game = "connectfour";
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--game") && i + 1 < argc) game = argv[++i];
+        else {
+            printf("usage: %s [--game name]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (!ProtocolGame::create(game)) {
+        printf("unknown game %s\n", game.c_str());
+        return 1;
+    }
+
+    std::ios::sync_with_stdio(false);
+    EngineProtocol protocol(game, std::cout);
+    protocol.run(std::cin);
+    return 0;
+}
@@ -0,0 +1,60 @@
+//
+// hosts games for many clients at once on a Unix domain socket, see GameServer.h for the protocol
+//
+// usage: game_server [--socket path] [--workers N] [--sessions N] [--memory KB] [--max-time MS]
+//
+// runs until interrupted, then prints the move throughput and latency
+//
+#include "../classes/GameServer.h"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+
+namespace {
+    std::atomic<bool> interrupted(false);
+
+    void onSignal(int)
+    {
+        interrupted = true;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    GameServerOptions options;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--socket") && i + 1 < argc) options.socketPath = argv[++i];
+        else if (!strcmp(argv[i], "--workers") && i + 1 < argc) options.workers = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--sessions") && i + 1 < argc) options.maxSessions = (size_t)atoll(argv[++i]);
+        else if (!strcmp(argv[i], "--memory") && i + 1 < argc) options.sessionMemory = (size_t)atoll(argv[++i]) * 1024;
+        else if (!strcmp(argv[i], "--max-time") && i + 1 < argc) options.maxMoveTimeMs = atoi(argv[++i]);
+        else {
+            printf("usage: %s [--socket path] [--workers N] [--sessions N] [--memory KB] [--max-time MS]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    GameServer server(options);
+    std::string error;
+    if (!server.start(error)) {
+        printf("can't start: %s\n", error.c_str());
+        return 1;
+    }
+    printf("listening on %s, %zu KB per session\n", options.socketPath.c_str(), options.sessionMemory / 1024);
+    fflush(stdout);
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    while (!interrupted) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    SchedulerStats stats = server.scheduler().stats();
+    server.stop();
+    printf("%llu moves, %.1f moves/sec, p50 %d us, p99 %d us, max %d us, %llu missed deadlines\n",
+           (unsigned long long)stats.completed, stats.movesPerSecond, stats.p50Us, stats.p99Us, stats.maxUs,
+           (unsigned long long)stats.missedDeadlines);
+    return 0;
+}
@@ -0,0 +1,138 @@
+//
+// evaluations per second of the NNUE evaluation against the handcrafted ones
+//
+// usage: nnue_bench [--game connectfour|othello] [--positions N] [--depth N]
+//
+// handcrafted is ConnectFourTraits::evaluate (the bitboard form of ConnectFour::evaluate) or
+// OthelloTraits::evaluate. the network is timed from scratch (a full accumulator refresh per position),
+// incrementally (make, evaluate, unmake over every move of every position) with each kernel the CPU has,
+// and inside a fixed depth search. without a weights file a random network is used, which is as fast
+//
+#include "../classes/Nnue.h"
+#include "../classes/Search.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    double seconds(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    template <class Features, class BaseTraits>
+    void bench(const char *name, int count, int depth)
+    {
+        using Position = typename Features::Position;
+        using Network = NnueNetwork<Features::SQUARES>;
+        using NnuePos = NnuePosition<Features>;
+        using Traits = NnueTraits<Features, BaseTraits>;
+
+        std::mt19937_64 random(1);
+        std::unique_ptr<Network> randomNetwork;
+        if (!sharedNetwork<Features>()) {
+            randomNetwork = std::make_unique<Network>();
+            std::uniform_int_distribution<int> small(-40, 40);
+            for (auto &row : randomNetwork->featureWeights) for (int16_t &w : row) w = (int16_t)small(random);
+            for (int16_t &b : randomNetwork->featureBias) b = (int16_t)(small(random) + 60);
+            for (auto &row : randomNetwork->layers.hiddenWeights) for (int8_t &w : row) w = (int8_t)small(random);
+            for (int8_t &w : randomNetwork->layers.outputWeights) w = (int8_t)small(random);
+            setSharedNetwork<Features>(randomNetwork.get());
+            printf("%s: no %s, using a random network\n", name, Features::WEIGHTS_FILE);
+        }
+
+        // positions from random games
+        std::vector<Position> positions;
+        while ((int)positions.size() < count) {
+            Position position;
+            while (!position.isTerminal() && (int)positions.size() < count) {
+                positions.push_back(position);
+                MovesOf<Position> moves;
+                position.generateMoves(moves);
+                position.makeMove(moves[(int)(random() % (uint64_t)moves.size())]);
+            }
+        }
+
+        int64_t checksum = 0;
+        auto start = Clock::now();
+        for (const Position &position : positions) checksum += BaseTraits::evaluate(position);
+        double handcrafted = count / seconds(start);
+        printf("%s handcrafted: %8.2f M evals/s\n", name, handcrafted / 1e6);
+
+        start = Clock::now();
+        for (const Position &position : positions) checksum += Traits::evaluate(NnuePos(position));
+        printf("%s nnue full refresh: %8.2f M evals/s\n", name, count / seconds(start) / 1e6);
+
+        // what a search does: make, evaluate, unmake
+        Nnue::Kernel best = Nnue::kernel();
+        for (Nnue::Kernel kernel : { Nnue::SCALAR, Nnue::SSSE3, Nnue::AVX2 }) {
+            if (!Nnue::setKernel(kernel)) continue;
+            uint64_t evaluations = 0;
+            start = Clock::now();
+            for (const Position &position : positions) {
+                NnuePos nnue(position);
+                MovesOf<NnuePos> moves;
+                nnue.generateMoves(moves);
+                for (auto move : moves) {
+                    auto undo = nnue.makeMove(move);
+                    checksum += Traits::evaluate(nnue);
+                    nnue.unmakeMove(move, undo);
+                    evaluations++;
+                }
+            }
+            double rate = evaluations / seconds(start);
+            printf("%s nnue incremental (%s): %8.2f M evals/s, %.2fx handcrafted\n", name, Nnue::kernelName(kernel),
+                   rate / 1e6, rate / handcrafted);
+        }
+        Nnue::setKernel(best);
+
+        SearchLimits limits;
+        limits.depth = depth;
+        uint64_t handcraftedNodes = 0, nnueNodes = 0;
+        double handcraftedTime = 0, nnueTime = 0;
+        for (int i = 0; i < 20 && i < (int)positions.size(); i++) {
+            const Position &position = positions[i * (positions.size() / 20)];
+            SearchEngine<BaseTraits> handcraftedEngine(4 << 20);
+            start = Clock::now();
+            handcraftedNodes += handcraftedEngine.search(position, limits).stats.nodes;
+            handcraftedTime += seconds(start);
+
+            SearchEngine<Traits> nnueEngine(4 << 20);
+            start = Clock::now();
+            nnueNodes += nnueEngine.search(NnuePos(position), limits).stats.nodes;
+            nnueTime += seconds(start);
+        }
+        printf("%s depth %d search: handcrafted %.2f M nodes/s, nnue %.2f M nodes/s\n", name, depth,
+               handcraftedNodes / handcraftedTime / 1e6, nnueNodes / nnueTime / 1e6);
+        printf("(checksum %lld)\n", (long long)checksum);
+        setSharedNetwork<Features>(sharedNetwork<Features>() == randomNetwork.get() ? nullptr : sharedNetwork<Features>());
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string game = "both";
+    int positions = 200000;
+    int depth = 8;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--game") && i + 1 < argc) game = argv[++i];
+        else if (!strcmp(argv[i], "--positions") && i + 1 < argc) positions = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--depth") && i + 1 < argc) depth = atoi(argv[++i]);
+        else {
+            printf("usage: %s [--game connectfour|othello|both] [--positions N] [--depth N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("best kernel: %s\n", Nnue::kernelName(Nnue::kernel()));
+    if (game == "connectfour" || game == "both") bench<ConnectFourFeatures, ConnectFourTraits>("connect four", positions, depth);
+    if (game == "othello" || game == "both") bench<OthelloFeatures<8>, OthelloTraits<8>>("othello", positions, depth - 2);
+    return 0;
+}
@@ -0,0 +1,311 @@
+//
+// trains a network for the NNUE evaluation and writes its weights file
+//
+// usage: nnue_train [--game connectfour|othello|othello6] [--positions N] [--epochs N] [--depth N]
+//                   [--seed N] [--out file]
+//
+// positions come from random games, each labelled with a fixed depth search on the game's own
+// evaluation, so the network starts out as a distillation of the handcrafted one plus some lookahead.
+// training is float with Adam, then the weights are quantized the way the Nnue layers expect them
+// and the held out error is reported for both, in evaluation units
+//
+#include "../classes/Nnue.h"
+#include "../classes/Search.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    using Nnue::HIDDEN;
+    using Nnue::HIDDEN2;
+
+    // int8 weights top out at 127 / QB, the int16 accumulator must not overflow with every square taken
+    const float MAX_OUTPUT_WEIGHT = 127.0f / Nnue::QB;
+
+    struct TrainSettings
+    {
+        int             positions = 200000;
+        int             epochs = 10;
+        int             depth = 4;
+        uint64_t        seed = 1;
+        std::string     out;
+    };
+
+    struct Sample
+    {
+        std::vector<int> features[2];   // active features from player 0's and player 1's point of view
+        int             side;
+        float           target;
+    };
+
+    //
+    // the float network, the same shape as NnueNetwork
+    //
+    template <int SQUARES>
+    struct FloatNetwork
+    {
+        static constexpr int FEATURES = 2 * SQUARES;
+        static constexpr int PARAMETERS = FEATURES * HIDDEN + HIDDEN + HIDDEN2 * 2 * HIDDEN + HIDDEN2 + HIDDEN2 + 1;
+
+        std::vector<float> values = std::vector<float>(PARAMETERS);
+
+        float* featureWeights(int feature) { return &values[feature * HIDDEN]; }
+        float* featureBias() { return &values[FEATURES * HIDDEN]; }
+        float* hiddenWeights(int j) { return &values[FEATURES * HIDDEN + HIDDEN + j * 2 * HIDDEN]; }
+        float* hiddenBias() { return &values[FEATURES * HIDDEN + HIDDEN + HIDDEN2 * 2 * HIDDEN]; }
+        float* outputWeights() { return hiddenBias() + HIDDEN2; }
+        float* outputBias() { return outputWeights() + HIDDEN2; }
+    };
+
+    template <int SQUARES>
+    struct Activations
+    {
+        float accumulator[2][HIDDEN];
+        float input[2 * HIDDEN];
+        float hidden[HIDDEN2];
+        float output;
+    };
+
+    template <int SQUARES>
+    void forward(FloatNetwork<SQUARES> &network, const Sample &sample, Activations<SQUARES> &a)
+    {
+        for (int perspective = 0; perspective < 2; perspective++) {
+            std::copy(network.featureBias(), network.featureBias() + HIDDEN, a.accumulator[perspective]);
+            for (int feature : sample.features[perspective]) {
+                const float *row = network.featureWeights(feature);
+                for (int i = 0; i < HIDDEN; i++) a.accumulator[perspective][i] += row[i];
+            }
+        }
+        for (int i = 0; i < HIDDEN; i++) {
+            a.input[i] = std::clamp(a.accumulator[sample.side][i], 0.0f, 1.0f);
+            a.input[HIDDEN + i] = std::clamp(a.accumulator[sample.side ^ 1][i], 0.0f, 1.0f);
+        }
+        a.output = *network.outputBias();
+        for (int j = 0; j < HIDDEN2; j++) {
+            float sum = network.hiddenBias()[j];
+            const float *weights = network.hiddenWeights(j);
+            for (int i = 0; i < 2 * HIDDEN; i++) sum += weights[i] * a.input[i];
+            a.hidden[j] = std::clamp(sum, 0.0f, 1.0f);
+            a.output += network.outputWeights()[j] * a.hidden[j];
+        }
+    }
+
+    // adds the gradient of (output - target)^2 to gradient, returns the squared error
+    template <int SQUARES>
+    float backward(FloatNetwork<SQUARES> &network, const Sample &sample, FloatNetwork<SQUARES> &gradient)
+    {
+        Activations<SQUARES> a;
+        forward(network, sample, a);
+        float error = a.output - sample.target;
+        float dOutput = 2.0f * error;
+
+        float dInput[2 * HIDDEN] = {};
+        *gradient.outputBias() += dOutput;
+        for (int j = 0; j < HIDDEN2; j++) {
+            gradient.outputWeights()[j] += dOutput * a.hidden[j];
+            if (a.hidden[j] <= 0.0f || a.hidden[j] >= 1.0f) continue;
+            float dHidden = dOutput * network.outputWeights()[j];
+            gradient.hiddenBias()[j] += dHidden;
+            float *weightGradient = gradient.hiddenWeights(j);
+            const float *weights = network.hiddenWeights(j);
+            for (int i = 0; i < 2 * HIDDEN; i++) {
+                weightGradient[i] += dHidden * a.input[i];
+                dInput[i] += dHidden * weights[i];
+            }
+        }
+
+        for (int half = 0; half < 2; half++) {
+            int perspective = half == 0 ? sample.side : sample.side ^ 1;
+            float dAccumulator[HIDDEN];
+            for (int i = 0; i < HIDDEN; i++) {
+                float value = a.accumulator[perspective][i];
+                dAccumulator[i] = value > 0.0f && value < 1.0f ? dInput[half * HIDDEN + i] : 0.0f;
+                gradient.featureBias()[i] += dAccumulator[i];
+            }
+            for (int feature : sample.features[perspective]) {
+                float *row = gradient.featureWeights(feature);
+                for (int i = 0; i < HIDDEN; i++) row[i] += dAccumulator[i];
+            }
+        }
+        return error * error;
+    }
+
+    template <class Features>
+    std::vector<Sample> generate(const TrainSettings &settings, float scale, float clip, std::mt19937_64 &random)
+    {
+        using Position = typename Features::Position;
+        using Traits = std::conditional_t<std::is_same_v<Features, ConnectFourFeatures>, ConnectFourTraits, OthelloTraits<Features::SQUARES == 36 ? 6 : 8>>;
+
+        SearchEngine<Traits> engine(4 << 20);
+        SearchLimits limits;
+        limits.depth = settings.depth;
+
+        std::vector<Sample> samples;
+        while ((int)samples.size() < settings.positions) {
+            Position position;
+            while (!position.isTerminal() && (int)samples.size() < settings.positions) {
+                Sample sample;
+                sample.side = position.sideToMove();
+                for (int perspective = 0; perspective < 2; perspective++) {
+                    for (int color = 0; color < 2; color++) {
+                        auto discs = Features::discs(position, color);
+                        while (discs) {
+                            int square = Bitboard::popLowestBit(discs);
+                            sample.features[perspective].push_back(NnueNetwork<Features::SQUARES>::feature(perspective, color, square));
+                        }
+                    }
+                }
+                int score = engine.search(position, limits).score;
+                sample.target = std::clamp((float)score, -clip, clip) / scale;
+                samples.push_back(std::move(sample));
+
+                MovesOf<Position> moves;
+                position.generateMoves(moves);
+                position.makeMove(moves[(int)(random() % (uint64_t)moves.size())]);
+            }
+        }
+        return samples;
+    }
+
+    template <int SQUARES>
+    void quantize(FloatNetwork<SQUARES> &network, NnueNetwork<SQUARES> &quantized, int scale)
+    {
+        auto round = [](float value, float factor, float limit) { return (int32_t)std::lround(std::clamp(value * factor, -limit, limit)); };
+        const float QA = Nnue::QA, QB = Nnue::QB;
+        for (int f = 0; f < 2 * SQUARES; f++) {
+            for (int i = 0; i < HIDDEN; i++) quantized.featureWeights[f][i] = (int16_t)round(network.featureWeights(f)[i], QA, 32767);
+        }
+        for (int i = 0; i < HIDDEN; i++) quantized.featureBias[i] = (int16_t)round(network.featureBias()[i], QA, 32767);
+        for (int j = 0; j < HIDDEN2; j++) {
+            for (int i = 0; i < 2 * HIDDEN; i++) quantized.layers.hiddenWeights[j][i] = (int8_t)round(network.hiddenWeights(j)[i], QB, 127);
+            quantized.layers.hiddenBias[j] = round(network.hiddenBias()[j], QA * QB, 1e9f);
+            quantized.layers.outputWeights[j] = (int8_t)round(network.outputWeights()[j], QB, 127);
+        }
+        quantized.layers.outputBias = round(*network.outputBias(), QA * QB, 1e9f);
+        quantized.outputScale = scale;
+    }
+
+    template <class Features>
+    int train(const TrainSettings &settings, int scale, float clip)
+    {
+        constexpr int SQUARES = Features::SQUARES;
+        using Clock = std::chrono::steady_clock;
+        std::mt19937_64 random(settings.seed);
+
+        auto start = Clock::now();
+        std::vector<Sample> samples = generate<Features>(settings, (float)scale, clip, random);
+        std::shuffle(samples.begin(), samples.end(), random);
+        size_t validation = samples.size() / 20;
+        printf("%zu positions labelled at depth %d in %.1f s\n", samples.size(), settings.depth,
+               std::chrono::duration<double>(Clock::now() - start).count());
+
+        // every disc on the board has to fit the int16 accumulator
+        const float maxFeatureWeight = 32000.0f / Nnue::QA / (SQUARES + 1);
+
+        FloatNetwork<SQUARES> network, gradient, moment, velocity;
+        std::normal_distribution<float> normal(0.0f, 1.0f);
+        for (int f = 0; f < 2 * SQUARES; f++) {
+            for (int i = 0; i < HIDDEN; i++) network.featureWeights(f)[i] = normal(random) * 0.1f;
+        }
+        for (int i = 0; i < HIDDEN; i++) network.featureBias()[i] = 0.5f;
+        for (int j = 0; j < HIDDEN2; j++) {
+            for (int i = 0; i < 2 * HIDDEN; i++) network.hiddenWeights(j)[i] = normal(random) * 0.1f;
+            network.hiddenBias()[j] = 0.1f;
+            network.outputWeights()[j] = normal(random) * 0.1f;
+        }
+
+        const int BATCH = 256;
+        const float RATE = 0.001f, BETA1 = 0.9f, BETA2 = 0.999f;
+        int step = 0;
+        for (int epoch = 1; epoch <= settings.epochs; epoch++) {
+            std::shuffle(samples.begin() + validation, samples.end(), random);
+            double loss = 0.0;
+            for (size_t first = validation; first < samples.size(); first += BATCH) {
+                size_t last = std::min(samples.size(), first + BATCH);
+                std::fill(gradient.values.begin(), gradient.values.end(), 0.0f);
+                for (size_t s = first; s < last; s++) loss += backward(network, samples[s], gradient);
+
+                step++;
+                float correction1 = 1.0f - std::pow(BETA1, (float)step);
+                float correction2 = 1.0f - std::pow(BETA2, (float)step);
+                for (int p = 0; p < FloatNetwork<SQUARES>::PARAMETERS; p++) {
+                    float g = gradient.values[p] / (float)(last - first);
+                    moment.values[p] = BETA1 * moment.values[p] + (1 - BETA1) * g;
+                    velocity.values[p] = BETA2 * velocity.values[p] + (1 - BETA2) * g * g;
+                    network.values[p] -= RATE * (moment.values[p] / correction1) / (std::sqrt(velocity.values[p] / correction2) + 1e-8f);
+                }
+                for (int p = 0; p < 2 * SQUARES * HIDDEN; p++) network.values[p] = std::clamp(network.values[p], -maxFeatureWeight, maxFeatureWeight);
+                for (int j = 0; j < HIDDEN2; j++) {
+                    for (int i = 0; i < 2 * HIDDEN; i++) network.hiddenWeights(j)[i] = std::clamp(network.hiddenWeights(j)[i], -MAX_OUTPUT_WEIGHT, MAX_OUTPUT_WEIGHT);
+                    network.outputWeights()[j] = std::clamp(network.outputWeights()[j], -MAX_OUTPUT_WEIGHT, MAX_OUTPUT_WEIGHT);
+                }
+            }
+            printf("epoch %2d: training rms error %.1f\n", epoch, std::sqrt(loss / (samples.size() - validation)) * scale);
+        }
+
+        auto quantized = std::make_unique<NnueNetwork<SQUARES>>();
+        quantize(network, *quantized, scale);
+        double floatLoss = 0.0, quantizedLoss = 0.0;
+        for (size_t s = 0; s < validation; s++) {
+            Activations<SQUARES> a;
+            forward(network, samples[s], a);
+            floatLoss += (a.output - samples[s].target) * (a.output - samples[s].target);
+
+            NnueAccumulator accumulator;
+            for (int perspective = 0; perspective < 2; perspective++) {
+                std::copy(quantized->featureBias, quantized->featureBias + HIDDEN, accumulator.values[perspective]);
+                for (int feature : samples[s].features[perspective]) {
+                    for (int i = 0; i < HIDDEN; i++) accumulator.values[perspective][i] += quantized->featureWeights[feature][i];
+                }
+            }
+            float error = quantized->evaluate(accumulator, samples[s].side) - samples[s].target * scale;
+            quantizedLoss += error * error;
+        }
+        printf("held out rms error: float %.1f, quantized %.1f\n", std::sqrt(floatLoss / std::max<size_t>(validation, 1)) * scale,
+               std::sqrt(quantizedLoss / std::max<size_t>(validation, 1)));
+
+        std::string out = settings.out.empty() ? Features::WEIGHTS_FILE : settings.out;
+        std::filesystem::path parent = std::filesystem::path(out).parent_path();
+        if (!parent.empty()) std::filesystem::create_directories(parent);
+        if (!quantized->save(out)) {
+            printf("can't write %s\n", out.c_str());
+            return 1;
+        }
+        printf("wrote %s\n", out.c_str());
+        return 0;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string game = "connectfour";
+    TrainSettings settings;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--game") && i + 1 < argc) game = argv[++i];
+        else if (!strcmp(argv[i], "--positions") && i + 1 < argc) settings.positions = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--epochs") && i + 1 < argc) settings.epochs = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--depth") && i + 1 < argc) settings.depth = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) settings.seed = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--out") && i + 1 < argc) settings.out = argv[++i];
+        else {
+            printf("usage: %s [--game connectfour|othello|othello6] [--positions N] [--epochs N] [--depth N]\n"
+                   "          [--seed N] [--out file]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // the output scale is roughly each evaluation's typical size, wins are clipped to a few times it
+    if (game == "connectfour") return train<ConnectFourFeatures>(settings, 100, 300.0f);
+    if (game == "othello") return train<OthelloFeatures<8>>(settings, 200, 600.0f);
+    if (game == "othello6") return train<OthelloFeatures<6>>(settings, 200, 600.0f);
+    printf("unknown game %s\n", game.c_str());
+    return 1;
+}
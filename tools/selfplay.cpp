@@ -0,0 +1,256 @@
+//
+// headless self-play: plays games against itself and writes every searched position with its score and
+// how the game ended, training data for the evaluation tuners
+//
+// usage: selfplay [--game tictactoe|connectfour|othello|othello6] [--games N] [--threads N]
+//                 [--per-thread N] [--depth N] [--random-plies N] [--seed N] [--out FILE]
+//
+// every thread keeps --per-thread games going at once and moves them in turn, so a core is never idle
+// between one game ending and its records being written. each game opens with between --random-plies
+// and twice that many random moves. finished games go to the output a chunk at a time (SelfPlayData.h),
+// an existing file for the same game is appended to. reports games per hour and positions per second
+//
+#include "../classes/ConnectFourBoard.h"
+#include "../classes/OthelloBoard.h"
+#include "../classes/Search.h"
+#include "../classes/SelfPlayData.h"
+#include "../classes/TicTacToeBoard.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Settings
+    {
+        int         games = 1000;
+        int         threads = 0;
+        int         perThread = 4;
+        int         depth = 0;
+        int         randomPlies = -1;
+        uint64_t    seed = 1;
+        std::string out;
+    };
+
+    // the players' discs as stored in a record
+    void recordBoard(const TicTacToeBoard &board, SelfPlayRecord &record)
+    {
+        record.discs[0] = board.marks[0];
+        record.discs[1] = board.marks[1];
+    }
+
+    void recordBoard(const ConnectFourBoard &board, SelfPlayRecord &record)
+    {
+        record.discs[0] = board.discs[0];
+        record.discs[1] = board.discs[1];
+    }
+
+    template <int N>
+    void recordBoard(const OthelloPosition<N> &position, SelfPlayRecord &record)
+    {
+        record.discs[0] = position.board.discs[0];
+        record.discs[1] = position.board.discs[1];
+    }
+
+    struct Shared
+    {
+        SelfPlayWriter          writer;
+        std::mutex              mutex;
+        std::atomic<int>        started{ 0 };
+        std::atomic<int>        finished{ 0 };
+        std::atomic<uint64_t>   positions{ 0 };
+        std::atomic<uint64_t>   nodes{ 0 };
+    };
+
+    template <class Traits>
+    class Worker
+    {
+    public:
+        using Position = typename Traits::Position;
+
+        Worker(const Settings &settings, Shared &shared, uint64_t seed) :
+            _settings(settings), _shared(shared), _random(seed), _slots(settings.perThread) {}
+
+        void run()
+        {
+            for (Slot &slot : _slots) start(slot);
+            bool playing = true;
+            while (playing) {
+                playing = false;
+                for (Slot &slot : _slots) {
+                    if (!slot.active) continue;
+                    step(slot);
+                    playing |= slot.active;
+                }
+            }
+        }
+
+    private:
+        struct Slot
+        {
+            SearchEngine<Traits>        engine{ 4 << 20 };
+            Position                    position;
+            std::vector<SelfPlayRecord> records;
+            int                         randomPlies = 0;
+            int                         ply = 0;
+            bool                        active = false;
+        };
+
+        void start(Slot &slot)
+        {
+            slot.active = _shared.started.fetch_add(1) < _settings.games;
+            if (!slot.active) return;
+            slot.position = Position();
+            slot.records.clear();
+            slot.randomPlies = _settings.randomPlies + (int)(_random() % (uint64_t)(_settings.randomPlies + 1));
+            slot.ply = 0;
+        }
+
+        // one move of one game
+        void step(Slot &slot)
+        {
+            Position &position = slot.position;
+            if (position.isTerminal()) {
+                finish(slot);
+                return;
+            }
+
+            MovesOf<Position> moves;
+            position.generateMoves(moves);
+            typename Position::Move move;
+            if (slot.ply < slot.randomPlies) {
+                move = moves[(int)(_random() % (uint64_t)moves.size())];
+            } else {
+                SearchLimits limits;
+                limits.depth = _settings.depth;
+                auto result = slot.engine.search(position, limits);
+                move = result.bestMove;
+                _shared.nodes += result.stats.nodes;
+
+                SelfPlayRecord record = {};
+                recordBoard(position, record);
+                record.score = (int16_t)std::clamp(result.score, -32767, 32767);
+                record.side = (uint8_t)position.sideToMove();
+                record.ply = (uint16_t)slot.ply;
+                slot.records.push_back(record);
+            }
+            position.makeMove(move);
+            slot.ply++;
+        }
+
+        void finish(Slot &slot)
+        {
+            int result = Traits::result(slot.position);
+            int winner = result > 0 ? slot.position.sideToMove() : result < 0 ? slot.position.sideToMove() ^ 1 : -1;
+            for (SelfPlayRecord &record : slot.records) {
+                record.result = (int8_t)(winner < 0 ? 0 : winner == record.side ? 1 : -1);
+            }
+            {
+                std::lock_guard<std::mutex> lock(_shared.mutex);
+                for (const SelfPlayRecord &record : slot.records) _shared.writer.add(record);
+            }
+            _shared.positions += slot.records.size();
+            _shared.finished++;
+            start(slot);
+        }
+
+        const Settings&     _settings;
+        Shared&             _shared;
+        std::mt19937_64     _random;
+        std::vector<Slot>   _slots;
+    };
+
+    template <class Traits>
+    bool generate(const char *game, Settings settings, int defaultDepth, int defaultRandomPlies)
+    {
+        if (settings.depth <= 0) settings.depth = defaultDepth;
+        if (settings.randomPlies < 0) settings.randomPlies = defaultRandomPlies;
+        if (settings.out.empty()) settings.out = std::string(game) + ".spd";
+
+        Shared shared;
+        if (!shared.writer.open(settings.out, game)) {
+            printf("can't write %s (or it holds another game's data)\n", settings.out.c_str());
+            return false;
+        }
+
+        printf("%s: %d games on %d threads, %d at a time each, depth %d, %d-%d random plies, to %s\n", game,
+               settings.games, settings.threads, settings.perThread, settings.depth, settings.randomPlies,
+               2 * settings.randomPlies, settings.out.c_str());
+
+        auto start = Clock::now();
+        std::vector<std::thread> threads;
+        std::vector<std::unique_ptr<Worker<Traits>>> workers;
+        for (int i = 0; i < settings.threads; i++) {
+            workers.push_back(std::make_unique<Worker<Traits>>(settings, shared, settings.seed * 0x9E3779B97F4A7C15ull + i));
+            threads.emplace_back(&Worker<Traits>::run, workers.back().get());
+        }
+
+        auto report = [&](const char *label) {
+            double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            int finished = shared.finished;
+            uint64_t positions = shared.positions;
+            printf("%s%d/%d games  %llu positions  %.0f games/hour  %.0f positions/s  %.2f M nodes/s\n", label,
+                   finished, settings.games, (unsigned long long)positions, finished * 3600.0 / seconds,
+                   positions / seconds, shared.nodes / seconds / 1e6);
+        };
+
+        auto nextReport = Clock::now() + std::chrono::seconds(5);
+        while (shared.finished < settings.games) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            if (Clock::now() >= nextReport) {
+                report("  ");
+                nextReport += std::chrono::seconds(5);
+            }
+        }
+        for (std::thread &thread : threads) thread.join();
+
+        bool ok = shared.writer.close();
+        report("");
+        printf("%llu records written%s\n", (unsigned long long)shared.writer.written(), ok ? "" : ", write failed");
+        return ok;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string game = "connectfour";
+    Settings settings;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--game") && i + 1 < argc) game = argv[++i];
+        else if (!strcmp(argv[i], "--games") && i + 1 < argc) settings.games = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc) settings.threads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--per-thread") && i + 1 < argc) settings.perThread = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--depth") && i + 1 < argc) settings.depth = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--random-plies") && i + 1 < argc) settings.randomPlies = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) settings.seed = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--out") && i + 1 < argc) settings.out = argv[++i];
+        else {
+            printf("usage: %s [--game tictactoe|connectfour|othello|othello6] [--games N] [--threads N]\n"
+                   "       [--per-thread N] [--depth N] [--random-plies N] [--seed N] [--out FILE]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (settings.threads <= 0) settings.threads = std::max(1u, std::thread::hardware_concurrency());
+    settings.perThread = std::max(1, settings.perThread);
+
+    bool ok;
+    if (game == "tictactoe") ok = generate<TicTacToeTraits>("tictactoe", settings, 9, 1);
+    else if (game == "connectfour") ok = generate<ConnectFourTraits>("connectfour", settings, 8, 4);
+    else if (game == "othello") ok = generate<OthelloTraits<8>>("othello", settings, 5, 6);
+    else if (game == "othello6") ok = generate<OthelloTraits<6>>("othello6", settings, 6, 4);
+    else {
+        printf("unknown game %s\n", game.c_str());
+        return 1;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,313 @@
+//
+// synthetic load for game_server: many AI-vs-AI and human-vs-AI games played as fast as the server goes
+//
+// usage: server_load [--socket path] [--spawn] [--workers N] [--connections N] [--sessions N]
+//                    [--game name|mixed] [--movetime MS] [--depth D] [--human PERCENT] [--memory KB] [--seconds S]
+//                    [--max-moves N]
+//
+// every connection keeps its sessions busy: a finished game (or one past --max-moves) is closed and a new one started. the
+// human side of a human-vs-AI game plays random legal moves. prints the AI moves per second and the
+// p50/p99 move latency seen by the clients, then the server's own stats
+// --spawn runs the server in this process instead of connecting to one
+//
+#include "../classes/GameServer.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    const char* const MIXED_GAMES[] = { "tictactoe", "connectfour", "othello", "checkers" };
+
+    struct LoadOptions
+    {
+        std::string socketPath = "/tmp/boardgames.sock";
+        int         connections = 4;
+        int         sessions = 64;
+        std::string game = "connectfour";
+        int         moveTimeMs = 20;
+        int         depth = 0;
+        int         humanPercent = 25;
+        int         memoryKB = 0;
+        int         seconds = 10;
+        int         maxMoves = 300;     // draughts can shuffle kings forever
+    };
+
+    struct ClientResult
+    {
+        std::vector<int>    latenciesUs;
+        uint64_t            games = 0;
+        uint64_t            errors = 0;
+    };
+
+    class Client
+    {
+    public:
+        Client(const LoadOptions &options, int seed) : _options(options), _random(seed) {}
+
+        ~Client()
+        {
+            if (_fd >= 0) close(_fd);
+        }
+
+        bool connectTo()
+        {
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            strncpy(address.sun_path, _options.socketPath.c_str(), sizeof(address.sun_path) - 1);
+            _fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            return _fd >= 0 && connect(_fd, (sockaddr*)&address, sizeof(address)) == 0;
+        }
+
+        // requests are queued and written while waiting for replies, a client blocked in send while
+        // the server is blocked sending to it would never get out again
+        void send(const std::string &line)
+        {
+            _outgoing += line;
+            _outgoing += '\n';
+        }
+
+        // false at end of input or when nothing comes before the deadline
+        bool readLine(std::string &line, Clock::time_point deadline)
+        {
+            for (;;) {
+                size_t end = _buffer.find('\n');
+                if (end != std::string::npos) {
+                    line = _buffer.substr(0, end);
+                    _buffer.erase(0, end + 1);
+                    return true;
+                }
+
+                int waitMs = (int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+                pollfd socket{ _fd, (short)(POLLIN | (_outgoing.empty() ? 0 : POLLOUT)), 0 };
+                if (waitMs <= 0 || poll(&socket, 1, waitMs) <= 0) return false;
+
+                if ((socket.revents & POLLOUT) && !_outgoing.empty()) {
+                    ssize_t n = ::send(_fd, _outgoing.data(), _outgoing.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+                    if (n > 0) _outgoing.erase(0, (size_t)n);
+                }
+                if (socket.revents & (POLLIN | POLLHUP)) {
+                    char chunk[4096];
+                    ssize_t n = recv(_fd, chunk, sizeof(chunk), MSG_DONTWAIT);
+                    if (n == 0) return false;
+                    if (n > 0) _buffer.append(chunk, (size_t)n);
+                }
+            }
+        }
+
+        void run(Clock::time_point end, ClientResult &result)
+        {
+            for (int i = 0; i < _options.sessions; i++) startGame();
+
+            std::string line;
+            while (readLine(line, end)) {
+                std::istringstream words(line);
+                std::string reply;
+                uint64_t id = 0;
+                words >> reply;
+
+                if (reply == "session") {
+                    words >> id;
+                    Game game = _pending.front();
+                    _pending.pop_front();
+                    _games[id] = game;
+                    // a human with the first move starts off, everyone else waits for the AI
+                    if (game.human && game.humanSide == 0) send("moves " + std::to_string(id));
+                    else go(id);
+                } else if (reply == "bestmove") {
+                    std::string move, label;
+                    int over = 0;
+                    words >> id >> move;
+                    while (words >> label) {
+                        if (label == "over") words >> over;
+                    }
+                    auto game = _games.find(id);
+                    if (game == _games.end()) continue;
+                    if (move != "(none)") {
+                        result.latenciesUs.push_back((int)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - game->second.sent).count());
+                    }
+                    if (over || move == "(none)" || ++game->second.moves >= _options.maxMoves) {
+                        finishGame(id, result);
+                    } else if (game->second.human) {
+                        send("moves " + std::to_string(id));
+                    } else {
+                        go(id);
+                    }
+                } else if (reply == "moves") {
+                    words >> id;
+                    std::vector<std::string> moves;
+                    std::string move;
+                    while (words >> move) moves.push_back(move);
+                    if (moves.empty()) finishGame(id, result);
+                    else send("move " + std::to_string(id) + " " + moves[_random() % moves.size()]);
+                } else if (reply == "ok") {
+                    words >> id;
+                    if (++_games[id].moves >= _options.maxMoves) finishGame(id, result);
+                    else go(id);
+                } else if (reply == "error") {
+                    result.errors++;
+                    if (words >> id) finishGame(id, result);
+                    else if (!_pending.empty()) {
+                        // a refused new game
+                        _pending.pop_front();
+                    }
+                }
+            }
+            shutdown(_fd, SHUT_RDWR);
+        }
+
+    private:
+        struct Game
+        {
+            bool                human = false;
+            int                 humanSide = 0;
+            int                 moves = 0;
+            Clock::time_point   sent;
+        };
+
+        void startGame()
+        {
+            Game game;
+            game.human = (int)(_random() % 100) < _options.humanPercent;
+            game.humanSide = (int)(_random() % 2);
+            _pending.push_back(game);
+
+            std::string name = _options.game;
+            if (name == "mixed") name = MIXED_GAMES[_random() % (sizeof(MIXED_GAMES) / sizeof(MIXED_GAMES[0]))];
+            send("new " + name + (_options.memoryKB ? " memory " + std::to_string(_options.memoryKB) : ""));
+        }
+
+        void finishGame(uint64_t id, ClientResult &result)
+        {
+            if (!_games.erase(id)) return;
+            result.games++;
+            send("close " + std::to_string(id));
+            startGame();
+        }
+
+        void go(uint64_t id)
+        {
+            _games[id].sent = Clock::now();
+            std::string request = "go " + std::to_string(id);
+            if (_options.moveTimeMs) request += " movetime " + std::to_string(_options.moveTimeMs);
+            if (_options.depth) request += " depth " + std::to_string(_options.depth);
+            send(request);
+        }
+
+        const LoadOptions&  _options;
+        std::mt19937_64     _random;
+        int                 _fd = -1;
+        std::string         _buffer;
+        std::string         _outgoing;
+        std::deque<Game>    _pending;
+        std::unordered_map<uint64_t, Game> _games;
+    };
+
+    void printUsage(const char *program)
+    {
+        printf("usage: %s [--socket path] [--spawn] [--workers N] [--connections N] [--sessions N]\n"
+               "          [--game name|mixed] [--movetime MS] [--depth D] [--human PERCENT] [--memory KB] [--seconds S]\n"
+               "          [--max-moves N]\n", program);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    LoadOptions options;
+    bool spawn = false;
+    int workers = 0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--socket") && i + 1 < argc) options.socketPath = argv[++i];
+        else if (!strcmp(argv[i], "--spawn")) spawn = true;
+        else if (!strcmp(argv[i], "--workers") && i + 1 < argc) workers = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--connections") && i + 1 < argc) options.connections = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--sessions") && i + 1 < argc) options.sessions = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--game") && i + 1 < argc) options.game = argv[++i];
+        else if (!strcmp(argv[i], "--movetime") && i + 1 < argc) options.moveTimeMs = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--depth") && i + 1 < argc) options.depth = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--human") && i + 1 < argc) options.humanPercent = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--memory") && i + 1 < argc) options.memoryKB = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) options.seconds = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--max-moves") && i + 1 < argc) options.maxMoves = std::max(1, atoi(argv[++i]));
+        else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::unique_ptr<GameServer> server;
+    if (spawn) {
+        GameServerOptions serverOptions;
+        serverOptions.socketPath = options.socketPath;
+        serverOptions.workers = workers;
+        serverOptions.maxSessions = (size_t)options.connections * options.sessions * 2;
+        server = std::make_unique<GameServer>(serverOptions);
+        std::string error;
+        if (!server->start(error)) {
+            printf("can't start the server: %s\n", error.c_str());
+            return 1;
+        }
+    }
+
+    printf("%d connections x %d sessions of %s, %d%% human, movetime %d ms, %d s\n", options.connections, options.sessions,
+           options.game.c_str(), options.humanPercent, options.moveTimeMs, options.seconds);
+
+    std::vector<std::unique_ptr<Client>> clients;
+    for (int i = 0; i < options.connections; i++) {
+        clients.push_back(std::make_unique<Client>(options, i + 1));
+        if (!clients.back()->connectTo()) {
+            printf("can't connect to %s\n", options.socketPath.c_str());
+            return 1;
+        }
+    }
+
+    Clock::time_point start = Clock::now();
+    Clock::time_point end = start + std::chrono::seconds(options.seconds);
+    std::vector<ClientResult> results(options.connections);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < options.connections; i++) {
+        threads.emplace_back([&, i] { clients[i]->run(end, results[i]); });
+    }
+    for (std::thread &thread : threads) thread.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<int> latencies;
+    uint64_t games = 0, errors = 0;
+    for (const ClientResult &result : results) {
+        latencies.insert(latencies.end(), result.latenciesUs.begin(), result.latenciesUs.end());
+        games += result.games;
+        errors += result.errors;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](int p) { return latencies.empty() ? 0 : latencies[std::min(latencies.size() - 1, latencies.size() * p / 100)]; };
+
+    printf("%zu AI moves in %.1f s: %.1f moves/sec, %llu games finished, %llu errors\n", latencies.size(), seconds,
+           latencies.size() / seconds, (unsigned long long)games, (unsigned long long)errors);
+    printf("latency p50 %.2f ms, p99 %.2f ms, max %.2f ms\n", percentile(50) / 1000.0, percentile(99) / 1000.0,
+           (latencies.empty() ? 0 : latencies.back()) / 1000.0);
+
+    // the server's view, from a fresh connection
+    Client statsClient(options, 0);
+    std::string line;
+    if (statsClient.connectTo()) {
+        statsClient.send("stats");
+        if (statsClient.readLine(line, Clock::now() + std::chrono::seconds(5))) printf("server: %s\n", line.c_str());
+    }
+    if (server) server->stop();
+    return 0;
+}
@@ -0,0 +1,492 @@
+//
+// fits the handcrafted evaluation weights to self-play games, texel style, and writes a weights file
+//
+// usage: texel_tune [--threads N] [--lambda L] [--iterations N] [--scalar] [--out file] data.spd...
+//
+// the data files are selfplay output for connectfour, othello or othello6, read in place from memory
+// mappings. each position's evaluation terms (OthelloTraits::terms, ConnectFourTraits::terms) are taken
+// once, after that the evaluation is a dot product with the weights. the loss is the mean squared
+// difference between sigmoid(K * evaluation) and the target, the game result blended with the
+// sigmoid of the search score by --lambda (1 is the result alone). K is fitted to the current weights
+// first so the tuned weights stay on the same scale, then the weights by Levenberg-Marquardt steps.
+// the loss and its derivatives are summed over the positions on every thread, 8 at a time with AVX2
+//
+#include "../classes/ConnectFourBoard.h"
+#include "../classes/OthelloBoard.h"
+#include "../classes/SelfPlayData.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define TEXEL_X86_KERNEL
+#include <immintrin.h>
+#endif
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    const int MAX_TERMS = 4;
+
+    struct TuneSettings
+    {
+        int                         threads = 0;
+        double                      lambda = 1.0;
+        int                         iterations = 50;
+        bool                        scalar = false;
+        std::string                 out;
+        std::vector<std::string>    inputs;
+    };
+
+    //
+    // the positions as columns: a term per weight, the game result and the search score
+    //
+    struct Dataset
+    {
+        int                 count = 0;
+        size_t              size = 0;
+        std::vector<float>  terms[MAX_TERMS];
+        std::vector<float>  result;         // 1, 0.5 or 0 for the side to move
+        std::vector<float>  score;
+        std::vector<float>  target;         // what the loss compares the evaluation with
+    };
+
+    // the loss and its first and (Gauss-Newton) second derivatives in the weights
+    struct Sums
+    {
+        double  loss = 0;
+        double  gradient[MAX_TERMS] = {};
+        double  hessian[MAX_TERMS][MAX_TERMS] = {};
+
+        void add(const Sums &other)
+        {
+            loss += other.loss;
+            for (int k = 0; k < MAX_TERMS; k++) {
+                gradient[k] += other.gradient[k];
+                for (int l = 0; l < MAX_TERMS; l++) hessian[k][l] += other.hessian[k][l];
+            }
+        }
+    };
+
+    void positionOf(const SelfPlayRecord &record, ConnectFourBoard &board)
+    {
+        board.discs[0] = record.discs[0];
+        board.discs[1] = record.discs[1];
+        board.side = record.side;
+        board.moves = Bitboard::popCount(board.occupied());
+    }
+
+    template <int N>
+    void positionOf(const SelfPlayRecord &record, OthelloPosition<N> &position)
+    {
+        position.board.discs[0] = record.discs[0];
+        position.board.discs[1] = record.discs[1];
+        position.side = record.side;
+    }
+
+    //
+    // the kernels sum over [begin, end) with the weights applied and the evaluation scaled by k
+    //
+    void sumsScalar(const Dataset &data, const float *weights, float k, size_t begin, size_t end, Sums &sums)
+    {
+        for (size_t i = begin; i < end; i++) {
+            float evaluation = 0;
+            for (int t = 0; t < data.count; t++) evaluation += weights[t] * data.terms[t][i];
+            float predicted = 1.0f / (1.0f + std::exp(-k * evaluation));
+            float residual = predicted - data.target[i];
+            float slope = k * predicted * (1.0f - predicted);
+            sums.loss += residual * residual;
+            for (int t = 0; t < data.count; t++) {
+                float derivative = slope * data.terms[t][i];
+                sums.gradient[t] += residual * derivative;
+                for (int u = 0; u <= t; u++) sums.hessian[t][u] += derivative * slope * data.terms[u][i];
+            }
+        }
+    }
+
+#ifdef TEXEL_X86_KERNEL
+    // exp by 2^n times a polynomial for 2^f, f in [-0.5, 0.5], about 2e-7 relative error
+    __attribute__((target("avx2")))
+    __m256 exp256(__m256 x)
+    {
+        x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-87.0f)), _mm256_set1_ps(87.0f));
+        __m256 t = _mm256_mul_ps(x, _mm256_set1_ps(1.44269504f));
+        __m256 n = _mm256_round_ps(t, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256 f = _mm256_sub_ps(t, n);
+        __m256 p = _mm256_set1_ps(1.3333558e-3f);
+        p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(9.6181291e-3f));
+        p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(5.5504109e-2f));
+        p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(2.4022651e-1f));
+        p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(6.9314718e-1f));
+        p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(1.0f));
+        __m256i exponent = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+        return _mm256_mul_ps(p, _mm256_castsi256_ps(exponent));
+    }
+
+    __attribute__((target("avx2")))
+    double horizontal(__m256 v)
+    {
+        alignas(32) float lanes[8];
+        _mm256_store_ps(lanes, v);
+        double sum = 0;
+        for (float lane : lanes) sum += lane;
+        return sum;
+    }
+
+    // float lanes are folded into the double sums every BLOCK positions so big sets lose no precision
+    __attribute__((target("avx2")))
+    void sumsAvx2(const Dataset &data, const float *weights, float k, size_t begin, size_t end, Sums &sums)
+    {
+        const size_t BLOCK = 1024;
+        const int count = data.count;
+        __m256 w[MAX_TERMS];
+        for (int t = 0; t < count; t++) w[t] = _mm256_set1_ps(weights[t]);
+        const __m256 negativeK = _mm256_set1_ps(-k), kv = _mm256_set1_ps(k), one = _mm256_set1_ps(1.0f);
+
+        size_t i = begin;
+        while (i + 8 <= end) {
+            size_t blockEnd = std::min(end, i + BLOCK);
+            __m256 loss = _mm256_setzero_ps();
+            __m256 gradient[MAX_TERMS], hessian[MAX_TERMS][MAX_TERMS];
+            for (int t = 0; t < count; t++) {
+                gradient[t] = _mm256_setzero_ps();
+                for (int u = 0; u <= t; u++) hessian[t][u] = _mm256_setzero_ps();
+            }
+            for (; i + 8 <= blockEnd; i += 8) {
+                __m256 terms[MAX_TERMS];
+                __m256 evaluation = _mm256_setzero_ps();
+                for (int t = 0; t < count; t++) {
+                    terms[t] = _mm256_loadu_ps(&data.terms[t][i]);
+                    evaluation = _mm256_add_ps(evaluation, _mm256_mul_ps(w[t], terms[t]));
+                }
+                __m256 predicted = _mm256_div_ps(one, _mm256_add_ps(one, exp256(_mm256_mul_ps(negativeK, evaluation))));
+                __m256 residual = _mm256_sub_ps(predicted, _mm256_loadu_ps(&data.target[i]));
+                __m256 slope = _mm256_mul_ps(kv, _mm256_mul_ps(predicted, _mm256_sub_ps(one, predicted)));
+                loss = _mm256_add_ps(loss, _mm256_mul_ps(residual, residual));
+                for (int t = 0; t < count; t++) {
+                    __m256 derivative = _mm256_mul_ps(slope, terms[t]);
+                    gradient[t] = _mm256_add_ps(gradient[t], _mm256_mul_ps(residual, derivative));
+                    for (int u = 0; u <= t; u++) {
+                        hessian[t][u] = _mm256_add_ps(hessian[t][u], _mm256_mul_ps(derivative, _mm256_mul_ps(slope, terms[u])));
+                    }
+                }
+            }
+            sums.loss += horizontal(loss);
+            for (int t = 0; t < count; t++) {
+                sums.gradient[t] += horizontal(gradient[t]);
+                for (int u = 0; u <= t; u++) sums.hessian[t][u] += horizontal(hessian[t][u]);
+            }
+        }
+        sumsScalar(data, weights, k, i, end, sums);
+    }
+#endif
+
+    using SumsFunction = void (*)(const Dataset &, const float *, float, size_t, size_t, Sums &);
+
+    SumsFunction kernelFor(bool scalar)
+    {
+#ifdef TEXEL_X86_KERNEL
+        if (!scalar && __builtin_cpu_supports("avx2")) return sumsAvx2;
+#endif
+        (void)scalar;
+        return sumsScalar;
+    }
+
+    class Tuner
+    {
+    public:
+        Tuner(const Dataset &data, int threads, bool scalar) : _data(data), _threads(threads), _kernel(kernelFor(scalar)) {}
+
+        const char* kernelName() const { return _kernel == sumsScalar ? "scalar" : "avx2"; }
+        uint64_t    evaluated() const { return _evaluated; }
+
+        // mean loss and derivatives over the whole set, split across the threads
+        Sums sums(const double *weights, double k)
+        {
+            float w[MAX_TERMS] = {};
+            for (int t = 0; t < _data.count; t++) w[t] = (float)weights[t];
+
+            std::vector<Sums> partial(_threads);
+            std::vector<std::thread> threads;
+            size_t share = (_data.size + _threads - 1) / _threads;
+            for (int i = 0; i < _threads; i++) {
+                size_t begin = std::min(_data.size, i * share);
+                size_t end = std::min(_data.size, begin + share);
+                threads.emplace_back([&, i, begin, end] { _kernel(_data, w, (float)k, begin, end, partial[i]); });
+            }
+            Sums total;
+            for (int i = 0; i < _threads; i++) {
+                threads[i].join();
+                total.add(partial[i]);
+            }
+            _evaluated += _data.size;
+
+            double n = (double)std::max<size_t>(_data.size, 1);
+            total.loss /= n;
+            for (int t = 0; t < _data.count; t++) {
+                total.gradient[t] /= n;
+                for (int u = 0; u <= t; u++) total.hessian[u][t] = total.hessian[t][u] /= n;
+            }
+            return total;
+        }
+
+        double loss(const double *weights, double k) { return sums(weights, k).loss; }
+
+        // golden section search on log K, the loss is unimodal in it
+        double fitK(const double *weights)
+        {
+            const double ratio = 0.6180339887;
+            double low = std::log(1e-5), high = std::log(1.0);
+            double a = high - ratio * (high - low), b = low + ratio * (high - low);
+            double lossA = loss(weights, std::exp(a)), lossB = loss(weights, std::exp(b));
+            for (int i = 0; i < 40; i++) {
+                if (lossA < lossB) {
+                    high = b;
+                    b = a;
+                    lossB = lossA;
+                    a = high - ratio * (high - low);
+                    lossA = loss(weights, std::exp(a));
+                } else {
+                    low = a;
+                    a = b;
+                    lossA = lossB;
+                    b = low + ratio * (high - low);
+                    lossB = loss(weights, std::exp(b));
+                }
+            }
+            return std::exp((low + high) / 2);
+        }
+
+        // Levenberg-Marquardt on the weights with K held, returns the final loss
+        double fitWeights(double *weights, double k, int iterations)
+        {
+            const int count = _data.count;
+            double damping = 1e-3;
+            Sums current = sums(weights, k);
+            for (int iteration = 0; iteration < iterations; iteration++) {
+                double step[MAX_TERMS];
+                if (!solve(current, damping, step)) {
+                    damping *= 10;
+                    continue;
+                }
+                // converged once the step no longer moves any weight by a useful amount
+                double largest = 0;
+                for (int t = 0; t < count; t++) largest = std::max(largest, std::fabs(step[t]) / std::max(std::fabs(weights[t]), 1.0));
+                if (largest < 1e-4) break;
+
+                double trial[MAX_TERMS];
+                for (int t = 0; t < count; t++) trial[t] = weights[t] + step[t];
+                Sums next = sums(trial, k);
+                printf("  iteration %2d: loss %.7f -> %.7f", iteration + 1, current.loss, next.loss);
+                for (int t = 0; t < count; t++) printf(" %.3f", trial[t]);
+                printf("\n");
+
+                if (next.loss < current.loss) {
+                    std::copy(trial, trial + count, weights);
+                    current = next;
+                    damping = std::max(damping / 3, 1e-9);
+                } else {
+                    damping *= 4;
+                    if (damping > 1e6) break;
+                }
+            }
+            return current.loss;
+        }
+
+    private:
+        // (H + damping * diag(H)) step = -gradient by Gaussian elimination with partial pivoting
+        bool solve(const Sums &sums, double damping, double *step) const
+        {
+            const int count = _data.count;
+            double matrix[MAX_TERMS][MAX_TERMS + 1];
+            for (int t = 0; t < count; t++) {
+                for (int u = 0; u < count; u++) matrix[t][u] = sums.hessian[t][u];
+                matrix[t][t] += damping * sums.hessian[t][t] + 1e-12;
+                matrix[t][count] = -sums.gradient[t];
+            }
+            for (int column = 0; column < count; column++) {
+                int pivot = column;
+                for (int row = column + 1; row < count; row++) {
+                    if (std::fabs(matrix[row][column]) > std::fabs(matrix[pivot][column])) pivot = row;
+                }
+                if (std::fabs(matrix[pivot][column]) < 1e-300) return false;
+                std::swap(matrix[pivot], matrix[column]);
+                for (int row = column + 1; row < count; row++) {
+                    double factor = matrix[row][column] / matrix[column][column];
+                    for (int c = column; c <= count; c++) matrix[row][c] -= factor * matrix[column][c];
+                }
+            }
+            for (int row = count - 1; row >= 0; row--) {
+                double value = matrix[row][count];
+                for (int c = row + 1; c < count; c++) value -= matrix[row][c] * step[c];
+                step[row] = value / matrix[row][row];
+            }
+            return true;
+        }
+
+        const Dataset&  _data;
+        int             _threads;
+        SumsFunction    _kernel;
+        uint64_t        _evaluated = 0;
+    };
+
+    // every position's terms, result and score, the chunks shared out among the threads
+    template <class Traits>
+    bool load(const std::vector<SelfPlayReader> &readers, int threadCount, Dataset &data)
+    {
+        using Weights = typename Traits::Weights;
+        struct Span
+        {
+            const SelfPlayReader::Chunk*    chunk;
+            size_t                          first;
+        };
+        std::vector<Span> spans;
+        for (const SelfPlayReader &reader : readers) {
+            for (const SelfPlayReader::Chunk &chunk : reader.chunks()) {
+                spans.push_back({ &chunk, data.size });
+                data.size += chunk.count;
+            }
+        }
+
+        data.count = Weights::COUNT;
+        for (int t = 0; t < data.count; t++) data.terms[t].resize(data.size);
+        data.result.resize(data.size);
+        data.score.resize(data.size);
+
+        std::atomic<size_t> next{ 0 };
+        std::vector<std::thread> threads;
+        for (int i = 0; i < threadCount; i++) {
+            threads.emplace_back([&] {
+                for (size_t s; (s = next++) < spans.size();) {
+                    const SelfPlayReader::Chunk &chunk = *spans[s].chunk;
+                    for (uint32_t r = 0; r < chunk.count; r++) {
+                        const SelfPlayRecord &record = chunk.records[r];
+                        size_t index = spans[s].first + r;
+                        typename Traits::Position position;
+                        positionOf(record, position);
+                        int values[Weights::COUNT];
+                        Traits::terms(position, values);
+                        for (int t = 0; t < data.count; t++) data.terms[t][index] = (float)values[t];
+                        data.result[index] = 0.5f + 0.5f * record.result;
+                        data.score[index] = record.score;
+                    }
+                }
+            });
+        }
+        for (std::thread &thread : threads) thread.join();
+        return data.size > 0;
+    }
+
+    double seconds(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    template <class Traits>
+    int tune(const char *game, const std::vector<SelfPlayReader> &readers, const TuneSettings &settings)
+    {
+        using Weights = typename Traits::Weights;
+        auto start = Clock::now();
+        Dataset data;
+        if (!load<Traits>(readers, settings.threads, data)) {
+            printf("no positions\n");
+            return 1;
+        }
+        printf("%s: %zu positions, %d weights, terms taken in %.2fs\n", game, data.size, data.count, seconds(start));
+
+        // start from what the games use now, the built-in weights or an earlier tuned file
+        const Weights &current = evalWeights<Weights>();
+        double weights[MAX_TERMS] = {};
+        for (int t = 0; t < data.count; t++) weights[t] = current.values[t];
+
+        Tuner tuner(data, settings.threads, settings.scalar);
+        start = Clock::now();
+        data.target = data.result;
+        double k = tuner.fitK(weights);
+
+        // the search scores as probabilities on the same K, blended in
+        for (size_t i = 0; i < data.size; i++) {
+            double predicted = 1.0 / (1.0 + std::exp(-k * data.score[i]));
+            data.target[i] = (float)(settings.lambda * data.result[i] + (1.0 - settings.lambda) * predicted);
+        }
+        double before = tuner.loss(weights, k);
+        printf("K %.6f, loss with the current weights %.7f\n", k, before);
+
+        tuner.fitWeights(weights, k, settings.iterations);
+
+        Weights tuned;
+        for (int t = 0; t < data.count; t++) tuned.values[t] = (int)std::lround(weights[t]);
+        double rounded[MAX_TERMS] = {};
+        for (int t = 0; t < data.count; t++) rounded[t] = tuned.values[t];
+        double after = tuner.loss(rounded, k);
+
+        double elapsed = seconds(start);
+        printf("%llu positions evaluated in %.2fs, %.1f M positions/s with the %s kernel on %d threads\n",
+               (unsigned long long)tuner.evaluated(), elapsed, tuner.evaluated() / elapsed / 1e6, tuner.kernelName(),
+               settings.threads);
+        printf("loss %.7f -> %.7f\n", before, after);
+        for (int t = 0; t < data.count; t++) {
+            printf("  %-10s %5d -> %5d  (%.3f)\n", Weights::NAMES[t], current.values[t], tuned.values[t], weights[t]);
+        }
+
+        std::string out = settings.out.empty() ? Weights::WEIGHTS_FILE : settings.out;
+        std::filesystem::path parent = std::filesystem::path(out).parent_path();
+        if (!parent.empty()) std::filesystem::create_directories(parent);
+        if (!saveEvalWeights(out, tuned)) {
+            printf("can't write %s\n", out.c_str());
+            return 1;
+        }
+        printf("wrote %s\n", out.c_str());
+        return 0;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    TuneSettings settings;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--threads") && i + 1 < argc) settings.threads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--lambda") && i + 1 < argc) settings.lambda = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--iterations") && i + 1 < argc) settings.iterations = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--scalar")) settings.scalar = true;
+        else if (!strcmp(argv[i], "--out") && i + 1 < argc) settings.out = argv[++i];
+        else if (argv[i][0] != '-') settings.inputs.push_back(argv[i]);
+        else {
+            settings.inputs.clear();
+            break;
+        }
+    }
+    if (settings.inputs.empty()) {
+        printf("usage: %s [--threads N] [--lambda L] [--iterations N] [--scalar] [--out file] data.spd...\n", argv[0]);
+        return 1;
+    }
+    if (settings.threads <= 0) settings.threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<SelfPlayReader> readers(settings.inputs.size());
+    for (size_t i = 0; i < readers.size(); i++) {
+        if (!readers[i].open(settings.inputs[i], true)) {
+            printf("can't read %s\n", settings.inputs[i].c_str());
+            return 1;
+        }
+        if (readers[i].game() != readers[0].game()) {
+            printf("%s holds %s positions, %s holds %s\n", settings.inputs[i].c_str(), readers[i].game().c_str(),
+                   settings.inputs[0].c_str(), readers[0].game().c_str());
+            return 1;
+        }
+    }
+
+    const std::string &game = readers[0].game();
+    if (game == "connectfour") return tune<ConnectFourTraits>("connectfour", readers, settings);
+    if (game == "othello") return tune<OthelloTraits<8>>("othello", readers, settings);
+    if (game == "othello6") return tune<OthelloTraits<6>>("othello6", readers, settings);
+    printf("no tunable evaluation for %s\n", game.c_str());
+    return 1;
+}